@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+
+#include "behaviortree_cpp/bt_factory.h"
+
+namespace BT::Benchmark
+{
+
+/**
+ * @brief XML of a tree with a single control node and "children" leaves.
+ *
+ * @param control  ID of the control node, for instance "Sequence"
+ * @param leaf     ID of the leaves, for instance "AlwaysSuccess"
+ */
+inline std::string FlatTreeXML(const std::string& control, const std::string& leaf,
+                               size_t children)
+{
+  std::string xml = "<root BTCPP_format=\"4\"><BehaviorTree ID=\"Main\"><" + control + ">";
+  xml.reserve(xml.size() + children * (leaf.size() + 4) + 64);
+  for (size_t i = 0; i < children; i++)
+  {
+    xml += "<" + leaf + "/>";
+  }
+  xml += "</" + control + "></BehaviorTree></root>";
+  return xml;
+}
+
+/**
+ * @brief XML of a balanced tree of Sequences, with "fanout" children each,
+ * and about "nodes" nodes in total.
+ */
+inline std::string NestedTreeXML(size_t nodes, size_t fanout = 4)
+{
+  std::string body;
+  // recursive lambda, building the tree depth-first
+  auto build = [&](auto& self, size_t budget) -> void {
+    if (budget <= 1)
+    {
+      body += "<AlwaysSuccess/>";
+      return;
+    }
+    body += "<Sequence>";
+    const size_t remaining = budget - 1;
+    const size_t children = std::min(fanout, remaining);
+    for (size_t i = 0; i < children; i++)
+    {
+      const size_t share = remaining / children + (i < remaining % children ? 1 : 0);
+      self(self, share);
+    }
+    body += "</Sequence>";
+  };
+  build(build, nodes);
+  return "<root BTCPP_format=\"4\"><BehaviorTree ID=\"Main\">" + body +
+         "</BehaviorTree></root>";
+}
+
+/**
+ * @brief XML of a chain of "depth" Sequences, each with a leaf and the next
+ * Sequence as children: about 2 * depth nodes, "depth" levels of recursion.
+ */
+inline std::string DeepTreeXML(size_t depth)
+{
+  std::string xml = "<root BTCPP_format=\"4\"><BehaviorTree ID=\"Main\">";
+  xml.reserve(xml.size() + depth * 54 + 64);
+  for (size_t i = 0; i < depth; i++)
+  {
+    xml += "<Sequence><AlwaysSuccess/>";
+  }
+  xml += "<AlwaysSuccess/>";
+  for (size_t i = 0; i < depth; i++)
+  {
+    xml += "</Sequence>";
+  }
+  xml += "</BehaviorTree></root>";
+  return xml;
+}
+
+}   // namespace BT::Benchmark
@@ -0,0 +1,183 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <memory>
+
+#include "behaviortree_cpp/blackboard_cells.h"
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/frozen_blackboard.h"
+
+using namespace BT;
+
+namespace
+{
+
+// Contention on a single read-mostly entry: the thread 0 writes it, all the
+// others read it, as many ThreadedAction reading the same pose.
+// Run with --benchmark_filter=Contended to compare the four policies.
+
+struct Pose
+{
+  double x = 0;
+  double y = 0;
+  double theta = 0;
+};
+
+using Path = std::array<Pose, 64>;
+
+// Blackboard::get<T>() and set(), that lock Entry::entry_mutex
+void BM_BlackboardContended(benchmark::State& state)
+{
+  static const auto blackboard = [] {
+    auto bb = Blackboard::create();
+    bb->set("counter", 0);
+    return bb;
+  }();
+  const bool writer = state.thread_index() == 0;
+  int value = 0;
+  for (auto _ : state)
+  {
+    if (writer)
+    {
+      blackboard->set("counter", ++value);
+    }
+    else
+    {
+      benchmark::DoNotOptimize(blackboard->get<int>("counter"));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// the entry pointer is cached, as a node would do in its constructor
+void BM_BlackboardEntryContended(benchmark::State& state)
+{
+  static const auto entry = [] {
+    auto bb = Blackboard::create();
+    bb->set("counter", 0);
+    return bb->getEntry("counter");
+  }();
+  const bool writer = state.thread_index() == 0;
+  int value = 0;
+  for (auto _ : state)
+  {
+    std::scoped_lock lk(entry->entry_mutex);
+    if (writer)
+    {
+      entry->value = Any(++value);
+    }
+    else
+    {
+      benchmark::DoNotOptimize(entry->value.cast<int>());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// a counter, as the entries of the scalar type declared by the ports
+void BM_AtomicCellContended(benchmark::State& state)
+{
+  static const auto cell = [] {
+    auto bb = Blackboard::create();
+    return GetOrCreateCell<AtomicCell<int>>(*bb, "counter");
+  }();
+  const bool writer = state.thread_index() == 0;
+  int value = 0;
+  for (auto _ : state)
+  {
+    if (writer)
+    {
+      cell->store(++value);
+    }
+    else
+    {
+      benchmark::DoNotOptimize(cell->load());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SeqLockCellContended(benchmark::State& state)
+{
+  static const auto cell = [] {
+    auto bb = Blackboard::create();
+    return GetOrCreateCell<SeqLockCell<Pose>>(*bb, "pose");
+  }();
+  const bool writer = state.thread_index() == 0;
+  Pose pose;
+  for (auto _ : state)
+  {
+    if (writer)
+    {
+      pose.x += 1.0;
+      cell->store(pose);
+    }
+    else
+    {
+      benchmark::DoNotOptimize(cell->load());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RcuCellContended(benchmark::State& state)
+{
+  static const auto cell = [] {
+    auto bb = Blackboard::create();
+    auto path_cell = GetOrCreateCell<RcuCell<Path>>(*bb, "path");
+    path_cell->store(Path{});
+    return path_cell;
+  }();
+  const bool writer = state.thread_index() == 0;
+  for (auto _ : state)
+  {
+    if (writer)
+    {
+      cell->update([](Path& path) { path[0].x += 1.0; });
+    }
+    else
+    {
+      benchmark::DoNotOptimize(cell->load());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// only readers, as many trees sharing the same configuration
+void BM_BlackboardShared(benchmark::State& state)
+{
+  static const auto blackboard = [] {
+    auto bb = Blackboard::create();
+    bb->set("path", Path{});
+    return bb;
+  }();
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(blackboard->getAnyLocked("path").get()->castPtr<Path>());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_FrozenBlackboardShared(benchmark::State& state)
+{
+  static const auto frozen = [] {
+    auto bb = Blackboard::create();
+    bb->set("path", Path{});
+    return FrozenBlackboard::create(*bb);
+  }();
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(&frozen->get<Path>("path"));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_BlackboardContended)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_BlackboardEntryContended)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_AtomicCellContended)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_SeqLockCellContended)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_RcuCellContended)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_BlackboardShared)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+BENCHMARK(BM_FrozenBlackboardShared)->Threads(1)->Threads(2)->Threads(4)->Threads(8)->UseRealTime();
+
+}   // namespace
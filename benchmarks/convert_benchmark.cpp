@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "behaviortree_cpp/basic_types.h"
+#include "behaviortree_cpp/decorators/loop_node.h"
+#include "behaviortree_cpp/utils/parse_numbers.hpp"
+
+using namespace BT;
+
+namespace
+{
+
+// convertFromString() against the allocation-free parsers of parse_numbers.hpp
+
+const std::string kInteger = "-123456";
+const std::string kReal = "3.14159265358979";
+
+std::string VectorString(size_t size)
+{
+  std::string str;
+  for (size_t i = 0; i < size; i++)
+  {
+    str += (i == 0 ? "" : ";") + std::to_string(double(i) * 0.5);
+  }
+  return str;
+}
+
+void BM_ConvertFromStringInt(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(convertFromString<int>(kInteger));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ParseNumberInt(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(ParseNumber<int>(kInteger));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ConvertFromStringDouble(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(convertFromString<double>(kReal));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ParseNumberDouble(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(ParseNumber<double>(kReal));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ConvertFromStringVector(benchmark::State& state)
+{
+  const auto str = VectorString(size_t(state.range(0)));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(convertFromString<std::vector<double>>(str));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ParseNumbersVector(benchmark::State& state)
+{
+  const auto str = VectorString(size_t(state.range(0)));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(ParseNumbers<double>(str));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ConvertFromStringQueue(benchmark::State& state)
+{
+  const auto str = VectorString(size_t(state.range(0)));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(convertFromString<SharedQueue<double>>(str));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_ParseNumbersQueue(benchmark::State& state)
+{
+  const auto str = VectorString(size_t(state.range(0)));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(ParseNumbersQueue<double>(str));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_ConvertFromStringInt);
+BENCHMARK(BM_ParseNumberInt);
+BENCHMARK(BM_ConvertFromStringDouble);
+BENCHMARK(BM_ParseNumberDouble);
+BENCHMARK(BM_ConvertFromStringVector)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_ParseNumbersVector)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_ConvertFromStringQueue)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(BM_ParseNumbersQueue)->RangeMultiplier(10)->Range(1, 1000);
+
+}   // namespace
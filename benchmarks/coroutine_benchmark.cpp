@@ -0,0 +1,138 @@
+#include <benchmark/benchmark.h>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/co_await_action_node.h"
+#include "bench_trees.h"
+
+using namespace BT;
+
+// compared only if CoAwaitActionNode is available (C++20 coroutines)
+#ifdef BTCPP_HAS_COAWAIT_ACTION_NODE
+
+namespace
+{
+
+// yields "yields" times, then succeeds
+class CoroYield : public CoroActionNode
+{
+public:
+  CoroYield(const std::string& name, const NodeConfig& config, int yields) :
+    CoroActionNode(name, config), yields_(yields)
+  {}
+
+  NodeStatus tick() override
+  {
+    for (int i = 0; i < yields_; i++)
+    {
+      setStatusRunningAndYield();
+    }
+    return NodeStatus::SUCCESS;
+  }
+
+  static PortsList providedPorts()
+  {
+    return {};
+  }
+
+private:
+  int yields_;
+};
+
+class CoAwaitYield : public CoAwaitActionNode
+{
+public:
+  CoAwaitYield(const std::string& name, const NodeConfig& config, CoroFramePool::Ptr pool,
+               int yields) :
+    CoAwaitActionNode(name, config, std::move(pool)), yields_(yields)
+  {}
+
+  CoTask run() override
+  {
+    for (int i = 0; i < yields_; i++)
+    {
+      co_await yieldRunning();
+    }
+    co_return NodeStatus::SUCCESS;
+  }
+
+  static PortsList providedPorts()
+  {
+    return {};
+  }
+
+private:
+  int yields_;
+};
+
+// cost of a suspension and resumption: each tick resumes the coroutine once
+template <typename Register>
+void TickSwitch(benchmark::State& state, Register register_node)
+{
+  BehaviorTreeFactory factory;
+  register_node(factory, 1000);
+  auto tree = factory.createTreeFromText(Benchmark::FlatTreeXML("Sequence", "Yield", 1));
+  // a new coroutine is started every 1000 switches
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// create a tree of range(0) coroutines and run each of them to completion once
+template <typename Register>
+void RunMany(benchmark::State& state, Register register_node)
+{
+  const auto nodes = size_t(state.range(0));
+  BehaviorTreeFactory factory;
+  register_node(factory, 1);
+  const auto xml = Benchmark::FlatTreeXML("Sequence", "Yield", nodes);
+  for (auto _ : state)
+  {
+    auto tree = factory.createTreeFromText(xml);
+    benchmark::DoNotOptimize(tree.tickWhileRunning(std::chrono::milliseconds(0)));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_CoroActionNodeSwitch(benchmark::State& state)
+{
+  TickSwitch(state, [](BehaviorTreeFactory& factory, int yields) {
+    factory.registerNodeType<CoroYield>("Yield", yields);
+  });
+}
+
+void BM_CoAwaitActionNodeSwitch(benchmark::State& state)
+{
+  TickSwitch(state, [](BehaviorTreeFactory& factory, int yields) {
+    factory.registerNodeType<CoAwaitYield>("Yield", std::make_shared<CoroFramePool>(), yields);
+  });
+}
+
+void BM_CoroActionNodeRunMany(benchmark::State& state)
+{
+  RunMany(state, [](BehaviorTreeFactory& factory, int yields) {
+    factory.registerNodeType<CoroYield>("Yield", yields);
+  });
+}
+
+void BM_CoAwaitActionNodeRunMany(benchmark::State& state)
+{
+  auto pool = std::make_shared<CoroFramePool>();
+  RunMany(state, [&](BehaviorTreeFactory& factory, int yields) {
+    factory.registerNodeType<CoAwaitYield>("Yield", pool, yields);
+  });
+  // the frames are recycled: this is the memory of the coroutines alive at the same time
+  const auto stats = pool->statistics();
+  state.counters["frame_bytes"] = double(stats.bytes_reserved);
+  state.counters["frame_allocations"] = double(stats.allocations);
+}
+
+BENCHMARK(BM_CoroActionNodeSwitch);
+BENCHMARK(BM_CoAwaitActionNodeSwitch);
+BENCHMARK(BM_CoroActionNodeRunMany)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK(BM_CoAwaitActionNodeRunMany)->RangeMultiplier(10)->Range(10, 1000);
+
+}   // namespace
+
+#endif
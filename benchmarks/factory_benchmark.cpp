@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/factory_extensions.h"
+#include "bench_trees.h"
+
+using namespace BT;
+
+namespace
+{
+
+// parse the XML and instantiate the tree, every iteration
+void BM_CreateTreeFromText(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  const auto xml = Benchmark::NestedTreeXML(size_t(state.range(0)));
+  for (auto _ : state)
+  {
+    auto tree = factory.createTreeFromText(xml);
+    benchmark::DoNotOptimize(tree.rootNode());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// the XML is registered once: only the instantiation is measured
+void BM_CreateRegisteredTree(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  factory.registerBehaviorTreeFromText(Benchmark::NestedTreeXML(size_t(state.range(0))));
+  for (auto _ : state)
+  {
+    auto tree = factory.createTree("Main");
+    benchmark::DoNotOptimize(tree.rootNode());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// "count" files in a temporary directory, each with a tree of 100 nodes
+std::vector<std::filesystem::path> WriteTreeFiles(size_t count)
+{
+  const auto directory = std::filesystem::temp_directory_path() / "btcpp_factory_benchmark";
+  std::filesystem::create_directories(directory);
+  const std::string xml = Benchmark::NestedTreeXML(100);
+  std::vector<std::filesystem::path> files;
+  for (size_t i = 0; i < count; i++)
+  {
+    std::string text = xml;
+    const std::string ID = "Tree_" + std::to_string(i);
+    text.replace(text.find("\"Main\""), 6, "\"" + ID + "\"");
+    files.push_back(directory / (ID + ".xml"));
+    std::ofstream(files.back()) << text;
+  }
+  return files;
+}
+
+// one registerBehaviorTreeFromFile() per file
+void BM_RegisterTreeFromFile(benchmark::State& state)
+{
+  const auto files = WriteTreeFiles(size_t(state.range(0)));
+  for (auto _ : state)
+  {
+    BehaviorTreeFactory factory;
+    for (const auto& file : files)
+    {
+      factory.registerBehaviorTreeFromFile(file);
+    }
+    benchmark::DoNotOptimize(factory.registeredBehaviorTrees());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// the files are read in parallel and parsed as a single document
+void BM_RegisterTreesFromFiles(benchmark::State& state)
+{
+  const auto files = WriteTreeFiles(size_t(state.range(0)));
+  for (auto _ : state)
+  {
+    BehaviorTreeFactory factory;
+    FactoryExtensions extensions(factory);
+    extensions.registerBehaviorTreesFromFiles(files);
+    benchmark::DoNotOptimize(factory.registeredBehaviorTrees());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_CreateTreeFromText)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CreateRegisteredTree)->RangeMultiplier(10)->Range(10, 10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_RegisterTreeFromFile)->RangeMultiplier(4)->Range(4, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RegisterTreesFromFiles)->RangeMultiplier(4)->Range(4, 256)->Unit(benchmark::kMillisecond);
+
+}   // namespace
@@ -0,0 +1,66 @@
+#include <benchmark/benchmark.h>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/flat_tree_engine.h"
+#include "bench_trees.h"
+
+using namespace BT;
+
+namespace
+{
+
+// Tree::tickOnce() against FlatTreeEngine::tickOnce() on the same trees:
+// the items processed are the ticks of the root (ticks per second).
+
+void BM_TreeTickDeep(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(Benchmark::DeepTreeXML(size_t(state.range(0))));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_FlatEngineTickDeep(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(Benchmark::DeepTreeXML(size_t(state.range(0))));
+  FlatTreeEngine engine(tree);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(engine.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_TreeTickNested(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(Benchmark::NestedTreeXML(size_t(state.range(0))));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_FlatEngineTickNested(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(Benchmark::NestedTreeXML(size_t(state.range(0))));
+  FlatTreeEngine engine(tree);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(engine.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_TreeTickDeep)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK(BM_FlatEngineTickDeep)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK(BM_TreeTickNested)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK(BM_FlatEngineTickNested)->RangeMultiplier(10)->Range(10, 10000);
+
+}   // namespace
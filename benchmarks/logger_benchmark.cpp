@@ -0,0 +1,76 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <memory>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/loggers/bt_file_logger_v2.h"
+#include "behaviortree_cpp/loggers/bt_minitrace_logger.h"
+#include "behaviortree_cpp/loggers/bt_observer.h"
+#include "behaviortree_cpp/loggers/bt_statistics_observer.h"
+#include "bench_trees.h"
+
+using namespace BT;
+
+namespace
+{
+
+std::string TempFile(const std::string& name)
+{
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// tick a Sequence of range(0) leaves, while the logger created by "attach" is active
+template <typename Attach>
+void TickWithLogger(benchmark::State& state, Attach attach)
+{
+  BehaviorTreeFactory factory;
+  const auto children = size_t(state.range(0));
+  auto tree = factory.createTreeFromText(Benchmark::FlatTreeXML("Sequence", "AlwaysSuccess", children));
+  [[maybe_unused]] auto logger = attach(tree);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  // each tick produces two transitions per node (IDLE->SUCCESS and back)
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_NoLogger(benchmark::State& state)
+{
+  TickWithLogger(state, [](Tree&) { return 0; });
+}
+
+void BM_TreeObserver(benchmark::State& state)
+{
+  TickWithLogger(state, [](Tree& tree) { return std::make_unique<TreeObserver>(tree); });
+}
+
+void BM_StatisticsObserver(benchmark::State& state)
+{
+  TickWithLogger(state,
+                 [](Tree& tree) { return std::make_unique<StatisticsObserver>(tree); });
+}
+
+void BM_FileLogger2(benchmark::State& state)
+{
+  const auto path = TempFile("btcpp_benchmark.btlog");
+  TickWithLogger(state, [&](Tree& tree) { return std::make_unique<FileLogger2>(tree, path); });
+  std::filesystem::remove(path);
+}
+
+void BM_MinitraceLogger(benchmark::State& state)
+{
+  const auto path = TempFile("btcpp_benchmark.json");
+  TickWithLogger(state,
+                 [&](Tree& tree) { return std::make_unique<MinitraceLogger>(tree, path.c_str()); });
+  std::filesystem::remove(path);
+}
+
+BENCHMARK(BM_NoLogger)->Arg(10)->Arg(1000);
+BENCHMARK(BM_TreeObserver)->Arg(10)->Arg(1000);
+BENCHMARK(BM_StatisticsObserver)->Arg(10)->Arg(1000);
+BENCHMARK(BM_FileLogger2)->Arg(10)->Arg(1000);
+BENCHMARK(BM_MinitraceLogger)->Arg(10)->Arg(1000);
+
+}   // namespace
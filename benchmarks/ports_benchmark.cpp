@@ -0,0 +1,190 @@
+#include <benchmark/benchmark.h>
+
+#include "behaviortree_cpp/bt_factory.h"
+
+using namespace BT;
+
+namespace
+{
+
+template <typename T>
+T SampleValue();
+
+template <>
+int SampleValue<int>()
+{
+  return 42;
+}
+
+template <>
+double SampleValue<double>()
+{
+  return 3.14;
+}
+
+template <>
+std::string SampleValue<std::string>()
+{
+  return "the quick brown fox jumps over the lazy dog";
+}
+
+template <typename T>
+class WriteValue : public SyncActionNode
+{
+public:
+  WriteValue(const std::string& name, const NodeConfig& config) :
+    SyncActionNode(name, config), value_(SampleValue<T>())
+  {}
+
+  NodeStatus tick() override
+  {
+    setOutput("out", value_);
+    return NodeStatus::SUCCESS;
+  }
+
+  static PortsList providedPorts()
+  {
+    return {OutputPort<T>("out")};
+  }
+
+private:
+  T value_;
+};
+
+template <typename T>
+class ReadValue : public SyncActionNode
+{
+public:
+  ReadValue(const std::string& name, const NodeConfig& config) : SyncActionNode(name, config)
+  {}
+
+  NodeStatus tick() override
+  {
+    T value;
+    if (!getInput("in", value))
+    {
+      throw RuntimeError("ReadValue: missing input [in]");
+    }
+    benchmark::DoNotOptimize(value);
+    return NodeStatus::SUCCESS;
+  }
+
+  static PortsList providedPorts()
+  {
+    return {InputPort<T>("in")};
+  }
+};
+
+template <typename T>
+Tree CreatePortTree(BehaviorTreeFactory& factory, const std::string& leaf)
+{
+  factory.registerNodeType<WriteValue<T>>("WriteValue");
+  factory.registerNodeType<ReadValue<T>>("ReadValue");
+  auto tree = factory.createTreeFromText("<root BTCPP_format=\"4\"><BehaviorTree ID=\"Main\">" +
+                                         leaf + "</BehaviorTree></root>");
+  tree.rootBlackboard()->set("value", SampleValue<T>());
+  return tree;
+}
+
+// setOutput() to a blackboard entry
+template <typename T>
+void BM_SetOutput(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = CreatePortTree<T>(factory, "<WriteValue out=\"{value}\"/>");
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// getInput() from a blackboard entry
+template <typename T>
+void BM_GetInputEntry(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = CreatePortTree<T>(factory, "<ReadValue in=\"{value}\"/>");
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// getInput() of a literal, converted from string
+template <typename T>
+void BM_GetInputLiteral(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = CreatePortTree<T>(factory, "<ReadValue in=\"42\"/>");
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Blackboard::set() and get(), without the nodes
+template <typename T>
+void BM_BlackboardSet(benchmark::State& state)
+{
+  auto blackboard = Blackboard::create();
+  const T value = SampleValue<T>();
+  blackboard->set("value", value);
+  for (auto _ : state)
+  {
+    blackboard->set("value", value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <typename T>
+void BM_BlackboardGet(benchmark::State& state)
+{
+  auto blackboard = Blackboard::create();
+  blackboard->set("value", SampleValue<T>());
+  T value;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(blackboard->get("value", value));
+    benchmark::DoNotOptimize(value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// a value overwritten in a blackboard with many keys
+void BM_BlackboardSetManyKeys(benchmark::State& state)
+{
+  auto blackboard = Blackboard::create();
+  const auto keys = size_t(state.range(0));
+  for (size_t i = 0; i < keys; i++)
+  {
+    blackboard->set("key_" + std::to_string(i), int(i));
+  }
+  const std::string key = "key_" + std::to_string(keys / 2);
+  for (auto _ : state)
+  {
+    blackboard->set(key, 7);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_SetOutput, int);
+BENCHMARK_TEMPLATE(BM_SetOutput, double);
+BENCHMARK_TEMPLATE(BM_SetOutput, std::string);
+BENCHMARK_TEMPLATE(BM_GetInputEntry, int);
+BENCHMARK_TEMPLATE(BM_GetInputEntry, double);
+BENCHMARK_TEMPLATE(BM_GetInputEntry, std::string);
+BENCHMARK_TEMPLATE(BM_GetInputLiteral, int);
+BENCHMARK_TEMPLATE(BM_GetInputLiteral, double);
+BENCHMARK_TEMPLATE(BM_GetInputLiteral, std::string);
+BENCHMARK_TEMPLATE(BM_BlackboardSet, int);
+BENCHMARK_TEMPLATE(BM_BlackboardSet, double);
+BENCHMARK_TEMPLATE(BM_BlackboardSet, std::string);
+BENCHMARK_TEMPLATE(BM_BlackboardGet, int);
+BENCHMARK_TEMPLATE(BM_BlackboardGet, double);
+BENCHMARK_TEMPLATE(BM_BlackboardGet, std::string);
+BENCHMARK(BM_BlackboardSetManyKeys)->RangeMultiplier(10)->Range(10, 10000);
+
+}   // namespace
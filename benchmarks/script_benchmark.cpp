@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include "behaviortree_cpp/blackboard.h"
+#include "behaviortree_cpp/scripting/script_parser.hpp"
+
+using namespace BT;
+
+namespace
+{
+
+const char* kScripts[] = {
+  "A := 42",
+  "A + B * 2 > 10 && C != 'done'",
+  "A = (B + 1) * (A - 3) / 2; C = (A > 100) ? 'high' : 'low'",
+};
+
+Ast::Environment CreateEnvironment()
+{
+  Ast::Environment env = {Blackboard::create(), std::make_shared<EnumsTable>()};
+  env.vars->set("A", 7);
+  env.vars->set("B", 3.5);
+  env.vars->set("C", std::string("running"));
+  return env;
+}
+
+void BM_ParseScript(benchmark::State& state)
+{
+  const std::string script = kScripts[state.range(0)];
+  for (auto _ : state)
+  {
+    auto executor = ParseScript(script);
+    benchmark::DoNotOptimize(executor);
+  }
+  state.SetLabel(script);
+}
+
+// the script is parsed once: only the evaluation is measured
+void BM_EvaluateScript(benchmark::State& state)
+{
+  const std::string script = kScripts[state.range(0)];
+  auto env = CreateEnvironment();
+  auto executor = ParseScript(script);
+  if (!executor)
+  {
+    state.SkipWithError(executor.error().c_str());
+    return;
+  }
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(executor.value()(env));
+  }
+  state.SetLabel(script);
+}
+
+void BM_ParseAndExecuteScript(benchmark::State& state)
+{
+  const std::string script = kScripts[state.range(0)];
+  auto env = CreateEnvironment();
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(ParseScriptAndExecute(env, script));
+  }
+  state.SetLabel(script);
+}
+
+BENCHMARK(BM_ParseScript)->DenseRange(0, 2);
+BENCHMARK(BM_EvaluateScript)->DenseRange(0, 2);
+BENCHMARK(BM_ParseAndExecuteScript)->DenseRange(0, 2);
+
+}   // namespace
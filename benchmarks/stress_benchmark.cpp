@@ -0,0 +1,144 @@
+#include <benchmark/benchmark.h>
+
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "bench_trees.h"
+
+using namespace BT;
+
+/*
+ * Scalability of very large trees: for each shape and size, the creation of
+ * the tree from XML, its memory, the latency of a tick, haltTree() and
+ * applyVisitor(). Each benchmark reports the counters per node, so a growth
+ * faster than linear is visible as a per-node cost that increases with the size.
+ *
+ * The UIDs of the nodes are 16 bits (see TreeNode::UID()): the largest trees
+ * are close to, but below, Tree::kMaxNodes.
+ */
+
+namespace
+{
+
+enum class Shape
+{
+  WIDE,
+  DEEP,
+  BALANCED
+};
+
+std::string GenerateXML(Shape shape, size_t nodes)
+{
+  switch (shape)
+  {
+    case Shape::WIDE:
+      return Benchmark::FlatTreeXML("Sequence", "AlwaysSuccess", nodes - 1);
+    case Shape::DEEP:
+      // keep the recursion of parsing and ticking within the stack
+      return Benchmark::DeepTreeXML(std::min<size_t>(nodes / 2, 2000));
+    case Shape::BALANCED:
+      return Benchmark::NestedTreeXML(nodes, 8);
+  }
+  return {};
+}
+
+size_t CountNodes(const Tree& tree)
+{
+  size_t count = 0;
+  for (const auto& subtree : tree.subtrees)
+  {
+    count += subtree->nodes.size();
+  }
+  return count;
+}
+
+void SetPerNodeCounters(benchmark::State& state, size_t nodes)
+{
+  state.counters["nodes"] = double(nodes);
+  // average time per node of each iteration
+  state.counters["per_node"] = benchmark::Counter(
+      double(state.iterations()) * double(nodes),
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+void BM_StressCreate(benchmark::State& state, Shape shape)
+{
+  BehaviorTreeFactory factory;
+  factory.registerBehaviorTreeFromText(GenerateXML(shape, size_t(state.range(0))));
+  size_t nodes = 0;
+  size_t memory = 0;
+  for (auto _ : state)
+  {
+    auto tree = factory.createTree("Main");
+    state.PauseTiming();
+    nodes = CountNodes(tree);
+    memory = tree.memoryStats().total();
+    // the destruction is not measured
+    {
+      Tree destroyed = std::move(tree);
+    }
+    state.ResumeTiming();
+  }
+  SetPerNodeCounters(state, nodes);
+  state.counters["memory_bytes"] = double(memory);
+  state.counters["bytes_per_node"] = nodes ? double(memory) / double(nodes) : 0;
+}
+
+void BM_StressTick(benchmark::State& state, Shape shape)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(GenerateXML(shape, size_t(state.range(0))));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  SetPerNodeCounters(state, CountNodes(tree));
+}
+
+void BM_StressHalt(benchmark::State& state, Shape shape)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(GenerateXML(shape, size_t(state.range(0))));
+  for (auto _ : state)
+  {
+    tree.haltTree();
+  }
+  SetPerNodeCounters(state, CountNodes(tree));
+}
+
+void BM_StressVisit(benchmark::State& state, Shape shape)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(GenerateXML(shape, size_t(state.range(0))));
+  size_t visited = 0;
+  const std::function<void(const TreeNode*)> visitor = [&visited](const TreeNode*) {
+    visited++;
+  };
+  for (auto _ : state)
+  {
+    tree.applyVisitor(visitor);
+  }
+  benchmark::DoNotOptimize(visited);
+  SetPerNodeCounters(state, CountNodes(tree));
+}
+
+void StressSizes(benchmark::internal::Benchmark* bench)
+{
+  for (int64_t nodes : { 1000, 4000, 16000, 32000, 60000 })
+  {
+    bench->Arg(nodes);
+  }
+  bench->Unit(benchmark::kMillisecond);
+}
+
+BENCHMARK_CAPTURE(BM_StressCreate, wide, Shape::WIDE)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressCreate, deep, Shape::DEEP)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressCreate, balanced, Shape::BALANCED)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressTick, wide, Shape::WIDE)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressTick, deep, Shape::DEEP)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressTick, balanced, Shape::BALANCED)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressHalt, wide, Shape::WIDE)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressHalt, balanced, Shape::BALANCED)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressVisit, wide, Shape::WIDE)->Apply(StressSizes);
+BENCHMARK_CAPTURE(BM_StressVisit, balanced, Shape::BALANCED)->Apply(StressSizes);
+
+}   // namespace
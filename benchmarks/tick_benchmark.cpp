@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "bench_trees.h"
+
+using namespace BT;
+
+namespace
+{
+
+// overhead of a single SyncActionNode, ticked through the Tree
+void BM_TickSingleNode(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(Benchmark::FlatTreeXML("Sequence", "AlwaysSuccess", 1));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TickSingleNode);
+
+// all the children are ticked: the leaves succeed in a Sequence and fail in a Fallback
+void TickFlatTree(benchmark::State& state, const std::string& control, const std::string& leaf)
+{
+  BehaviorTreeFactory factory;
+  const auto children = size_t(state.range(0));
+  auto tree = factory.createTreeFromText(Benchmark::FlatTreeXML(control, leaf, children));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["nodes"] = double(children + 1);
+}
+
+void BM_TickSequence(benchmark::State& state)
+{
+  TickFlatTree(state, "Sequence", "AlwaysSuccess");
+}
+
+void BM_TickFallback(benchmark::State& state)
+{
+  TickFlatTree(state, "Fallback", "AlwaysFailure");
+}
+
+void BM_TickReactiveSequence(benchmark::State& state)
+{
+  TickFlatTree(state, "ReactiveSequence", "AlwaysSuccess");
+}
+
+void BM_TickReactiveFallback(benchmark::State& state)
+{
+  TickFlatTree(state, "ReactiveFallback", "AlwaysFailure");
+}
+
+void BM_TickNestedSequences(benchmark::State& state)
+{
+  BehaviorTreeFactory factory;
+  auto tree = factory.createTreeFromText(Benchmark::NestedTreeXML(size_t(state.range(0))));
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(tree.tickOnce());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_TickSequence)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK(BM_TickFallback)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK(BM_TickReactiveSequence)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK(BM_TickReactiveFallback)->RangeMultiplier(10)->Range(10, 10000);
+BENCHMARK(BM_TickNestedSequences)->RangeMultiplier(10)->Range(10, 10000);
+
+}   // namespace
@@ -0,0 +1,71 @@
+# btcpp_compile_tree(<target> <tree.xml>...
+#                    [INDEX <nodes.btindex>...]
+#                    [TREES <ID>...]
+#                    [FUNCTION <name>])
+#
+# Validate the behavior trees of the XML files at build time and add to <target>
+# a generated source with the trees precompiled, that defines
+#
+#   void <name>(BT::FactoryExtensions& extensions);
+#
+# declared in the generated header "<name>.h". It registers the trees in the
+# extensions of the factory without parsing the XML; they are created with
+# FactoryExtensions::createPrecompiledTree().
+#
+# INDEX    manifests of the nodes that are not builtin, in the format written by
+#          FactoryExtensions::writePluginIndex()
+# TREES    IDs of the trees to compile. Default: all the trees of the files
+# FUNCTION name of the registration function. Default: register_<first XML name>
+#
+# The files included by the XML with <include> are not dependencies of the
+# generated source: list them among the XML files to rebuild when they change.
+#
+# The target btcpp_tree_compiler (tools/btcpp_tree_compiler.cpp) must exist.
+
+function(btcpp_compile_tree target)
+    cmake_parse_arguments(ARG "" "FUNCTION" "INDEX;TREES" ${ARGN})
+    set(xml_files ${ARG_UNPARSED_ARGUMENTS})
+    if(NOT xml_files)
+        message(FATAL_ERROR "btcpp_compile_tree: no XML file for the target ${target}")
+    endif()
+    if(NOT TARGET btcpp_tree_compiler)
+        message(FATAL_ERROR "btcpp_compile_tree: the target btcpp_tree_compiler is missing")
+    endif()
+
+    if(NOT ARG_FUNCTION)
+        list(GET xml_files 0 first_xml)
+        get_filename_component(stem ${first_xml} NAME_WE)
+        string(MAKE_C_IDENTIFIER "register_${stem}" ARG_FUNCTION)
+    endif()
+
+    set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/btcpp_compiled_trees)
+    set(source ${out_dir}/${ARG_FUNCTION}.cpp)
+    set(header ${out_dir}/${ARG_FUNCTION}.h)
+
+    set(args --output ${source} --header ${header} --function ${ARG_FUNCTION})
+    set(depends)
+    foreach(index ${ARG_INDEX})
+        get_filename_component(index ${index} ABSOLUTE)
+        list(APPEND args --index ${index})
+        list(APPEND depends ${index})
+    endforeach()
+    foreach(tree_ID ${ARG_TREES})
+        list(APPEND args --tree ${tree_ID})
+    endforeach()
+    foreach(xml ${xml_files})
+        get_filename_component(xml ${xml} ABSOLUTE)
+        list(APPEND args ${xml})
+        list(APPEND depends ${xml})
+    endforeach()
+
+    add_custom_command(
+        OUTPUT ${source} ${header}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${out_dir}
+        COMMAND btcpp_tree_compiler ${args}
+        DEPENDS btcpp_tree_compiler ${depends}
+        COMMENT "Compiling the behavior trees of ${target}"
+        VERBATIM)
+
+    target_sources(${target} PRIVATE ${source} ${header})
+    target_include_directories(${target} PRIVATE ${out_dir})
+endfunction()
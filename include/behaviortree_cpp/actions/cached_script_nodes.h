@@ -0,0 +1,112 @@
+#pragma once
+
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/condition_node.h"
+#include "behaviortree_cpp/scripting/script_cache.hpp"
+
+namespace BT
+{
+namespace details
+{
+// parse the port "code" of the node with the cache, if it changed
+inline void LoadCachedScript(const TreeNode& node, ScriptCache& cache, std::string& script,
+                             ScriptFunction& executor)
+{
+  std::string code;
+  if (!node.getInput("code", code))
+  {
+    throw RuntimeError("Missing port [code] in ", node.registrationName());
+  }
+  if (code == script && executor)
+  {
+    return;
+  }
+  auto parsed = cache.get(code);
+  if (!parsed)
+  {
+    throw RuntimeError(parsed.error());
+  }
+  executor = parsed.value();
+  script = std::move(code);
+}
+}   // namespace details
+
+/**
+ * @brief Same as ScriptNode, but the script is parsed by a ScriptCache:
+ * the nodes with the same code share the parsed function.
+ *
+ * Registered by FactoryExtensions::registerCachedScriptNodes() as
+ * "CachedScript", with the cache of the extensions.
+ */
+class CachedScriptNode : public SyncActionNode
+{
+public:
+  CachedScriptNode(const std::string& name, const NodeConfig& config,
+                   ScriptCache::Ptr cache) :
+    SyncActionNode(name, config), cache_(std::move(cache))
+  {
+    if (!cache_)
+    {
+      throw RuntimeError("CachedScriptNode: invalid cache");
+    }
+    details::LoadCachedScript(*this, *cache_, script_, executor_);
+  }
+
+  static PortsList providedPorts()
+  {
+    return {InputPort("code", "Piece of code that can be parsed")};
+  }
+
+private:
+  ScriptCache::Ptr cache_;
+  std::string script_;
+  ScriptFunction executor_;
+
+  NodeStatus tick() override
+  {
+    details::LoadCachedScript(*this, *cache_, script_, executor_);
+    Ast::Environment env = {config().blackboard, config().enums};
+    executor_(env);
+    return NodeStatus::SUCCESS;
+  }
+};
+
+/**
+ * @brief Same as ScriptCondition, but the script is parsed by a ScriptCache.
+ *
+ * Registered by FactoryExtensions::registerCachedScriptNodes() as
+ * "CachedScriptCondition".
+ */
+class CachedScriptCondition : public ConditionNode
+{
+public:
+  CachedScriptCondition(const std::string& name, const NodeConfig& config,
+                        ScriptCache::Ptr cache) :
+    ConditionNode(name, config), cache_(std::move(cache))
+  {
+    if (!cache_)
+    {
+      throw RuntimeError("CachedScriptCondition: invalid cache");
+    }
+    details::LoadCachedScript(*this, *cache_, script_, executor_);
+  }
+
+  static PortsList providedPorts()
+  {
+    return {InputPort("code", "Piece of code that can be parsed. Must return false or true")};
+  }
+
+private:
+  ScriptCache::Ptr cache_;
+  std::string script_;
+  ScriptFunction executor_;
+
+  NodeStatus tick() override
+  {
+    details::LoadCachedScript(*this, *cache_, script_, executor_);
+    Ast::Environment env = {config().blackboard, config().enums};
+    return executor_(env).cast<bool>() ? NodeStatus::SUCCESS : NodeStatus::FAILURE;
+  }
+};
+
+}   // namespace BT
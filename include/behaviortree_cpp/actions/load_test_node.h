@@ -0,0 +1,291 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/utils/timer_wheel.h"
+
+namespace BT
+{
+
+/**
+ * @brief Distribution of a duration: fixed, uniform in [min, max], or
+ * log-normal with a given median (the typical shape of the latencies of
+ * services and drivers). The samples are clamped to [min, max], if max > 0.
+ */
+struct LoadDistribution
+{
+  enum class Type
+  {
+    FIXED,
+    UNIFORM,
+    LOG_NORMAL
+  };
+
+  Type type = Type::FIXED;
+  /// FIXED: the value. LOG_NORMAL: the median
+  std::chrono::microseconds value = {};
+  std::chrono::microseconds min = {};
+  std::chrono::microseconds max = {};
+  /// LOG_NORMAL: standard deviation of the logarithm
+  double sigma = 0.5;
+
+  static LoadDistribution Fixed(std::chrono::microseconds value)
+  {
+    LoadDistribution out;
+    out.value = value;
+    return out;
+  }
+
+  static LoadDistribution Uniform(std::chrono::microseconds min, std::chrono::microseconds max)
+  {
+    LoadDistribution out;
+    out.type = Type::UNIFORM;
+    out.min = min;
+    out.max = max;
+    return out;
+  }
+
+  static LoadDistribution LogNormal(std::chrono::microseconds median, double sigma,
+                                    std::chrono::microseconds max = {})
+  {
+    LoadDistribution out;
+    out.type = Type::LOG_NORMAL;
+    out.value = median;
+    out.sigma = sigma;
+    out.max = max;
+    return out;
+  }
+
+  [[nodiscard]] bool isZero() const
+  {
+    return value.count() <= 0 && max.count() <= 0;
+  }
+
+  template <typename Generator>
+  [[nodiscard]] std::chrono::microseconds sample(Generator& generator) const
+  {
+    double usec = 0;
+    switch (type)
+    {
+      case Type::FIXED:
+        usec = double(value.count());
+        break;
+      case Type::UNIFORM:
+        usec = std::uniform_real_distribution<double>(double(min.count()),
+                                                      double(max.count()))(generator);
+        break;
+      case Type::LOG_NORMAL:
+        if (value.count() > 0)
+        {
+          usec = std::lognormal_distribution<double>(std::log(double(value.count())),
+                                                     sigma)(generator);
+        }
+        break;
+    }
+    usec = std::max(usec, double(min.count()));
+    if (max.count() > 0)
+    {
+      usec = std::min(usec, double(max.count()));
+    }
+    return std::chrono::microseconds(int64_t(usec));
+  }
+};
+
+/// Workload of a LoadTestNode, at each execution.
+struct LoadTestConfig
+{
+  /// status to return when the action is completed
+  NodeStatus return_status = NodeStatus::SUCCESS;
+  /// probability of returning FAILURE instead of return_status
+  double failure_probability = 0.0;
+
+  /// busy loop, in the thread that ticks the tree
+  LoadDistribution cpu_burn;
+  /// blocking sleep, in the thread that ticks the tree
+  LoadDistribution sleep;
+  /// the node is RUNNING for this time, without blocking the thread
+  LoadDistribution latency;
+
+  /// number of blackboard entries written at each execution
+  size_t churn_keys = 0;
+  /// the entries are std::string of this size, or int if 0
+  size_t churn_value_size = 0;
+  /// keys of the entries: prefix + index
+  std::string churn_prefix = "load_";
+
+  /// seed of the random generator, combined with the path of the node. 0: random
+  uint64_t seed = 0;
+};
+
+/**
+ * @brief LoadTestNode replaces, like TestNode, the leaves of a production tree
+ * (see RegisterLoadTestRules), to measure the limits of a host with a
+ * synthetic load: CPU time, blocking and asynchronous latencies, and
+ * writes to the blackboard, with configurable distributions.
+ */
+class LoadTestNode : public StatefulActionNode
+{
+public:
+  LoadTestNode(const std::string& name, const NodeConfig& config, LoadTestConfig load) :
+    StatefulActionNode(name, config), load_(std::move(load))
+  {
+    const uint64_t seed = (load_.seed != 0) ?
+                              load_.seed ^ std::hash<std::string>()(config.path) :
+                              std::random_device()();
+    generator_.seed(seed);
+    for (size_t i = 0; i < load_.churn_keys; i++)
+    {
+      churn_keys_.push_back(load_.churn_prefix + std::to_string(i));
+    }
+    churn_value_.assign(load_.churn_value_size, 'x');
+  }
+
+  static PortsList providedPorts()
+  {
+    return {};
+  }
+
+  [[nodiscard]] const LoadTestConfig& loadConfig() const
+  {
+    return load_;
+  }
+
+private:
+  NodeStatus onStart() override
+  {
+    using Clock = std::chrono::steady_clock;
+    if (!load_.cpu_burn.isZero())
+    {
+      const auto until = Clock::now() + load_.cpu_burn.sample(generator_);
+      while (Clock::now() < until)
+      {
+        // busy loop
+      }
+    }
+    if (!load_.sleep.isZero())
+    {
+      std::this_thread::sleep_for(load_.sleep.sample(generator_));
+    }
+    churn();
+
+    completed_ = false;
+    if (!load_.latency.isZero())
+    {
+      const auto latency = load_.latency.sample(generator_);
+      if (latency.count() > 0)
+      {
+        deadline_ = Clock::now() + latency;
+        // wake up the tree at the end of the latency (the timers have 1 ms resolution)
+        const auto msec = std::chrono::ceil<std::chrono::milliseconds>(latency);
+        timer_id_ = timer_.add(msec, [this](bool aborted) {
+          if (!aborted)
+          {
+            completed_ = true;
+            emitWakeUpSignal();
+          }
+        });
+        return NodeStatus::RUNNING;
+      }
+    }
+    return result();
+  }
+
+  NodeStatus onRunning() override
+  {
+    if (completed_ || std::chrono::steady_clock::now() >= deadline_)
+    {
+      timer_.cancel(timer_id_);
+      return result();
+    }
+    return NodeStatus::RUNNING;
+  }
+
+  void onHalted() override
+  {
+    timer_.cancel(timer_id_);
+  }
+
+  NodeStatus result()
+  {
+    if (load_.failure_probability > 0 &&
+        std::uniform_real_distribution<double>(0, 1)(generator_) < load_.failure_probability)
+    {
+      return NodeStatus::FAILURE;
+    }
+    return load_.return_status;
+  }
+
+  void churn()
+  {
+    if (churn_keys_.empty())
+    {
+      return;
+    }
+    counter_++;
+    auto& blackboard = config().blackboard;
+    for (const auto& key : churn_keys_)
+    {
+      if (churn_value_.empty())
+      {
+        blackboard->set(key, int(counter_));
+      }
+      else
+      {
+        // same size at each write: the entry reuses its storage
+        churn_value_[counter_ % churn_value_.size()]++;
+        blackboard->set(key, churn_value_);
+      }
+    }
+  }
+
+  LoadTestConfig load_;
+  std::mt19937_64 generator_;
+  std::vector<std::string> churn_keys_;
+  std::string churn_value_;
+  uint64_t counter_ = 0;
+
+  std::chrono::steady_clock::time_point deadline_;
+  std::atomic<bool> completed_ = false;
+  uint64_t timer_id_ = 0;
+  SharedTimerQueue timer_;
+};
+
+/**
+ * @brief Replace the nodes whose path matches each filter (see addSubstitutionRule)
+ * with a LoadTestNode, registered in the factory as "LoadTestNode_<index>":
+ *
+ *   LoadTestConfig planner;
+ *   planner.cpu_burn = LoadDistribution::LogNormal(std::chrono::milliseconds(2), 0.4);
+ *   LoadTestConfig drivers;
+ *   drivers.latency = LoadDistribution::Uniform(std::chrono::milliseconds(5),
+ *                                               std::chrono::milliseconds(20));
+ *   RegisterLoadTestRules(factory, { { "*Plan*", planner }, { "*Move*", drivers } });
+ *   auto tree = factory.createTree("MainTree");
+ *
+ * Call it before creating the trees. The nodes replaced must be leaves.
+ */
+inline void RegisterLoadTestRules(BehaviorTreeFactory& factory,
+                                  const std::vector<std::pair<std::string, LoadTestConfig>>& rules)
+{
+  for (size_t i = 0; i < rules.size(); i++)
+  {
+    const std::string ID = "LoadTestNode_" + std::to_string(i);
+    if (factory.manifests().count(ID) != 0)
+    {
+      factory.unregisterBuilder(ID);
+    }
+    factory.registerNodeType<LoadTestNode>(ID, rules[i].second);
+    factory.addSubstitutionRule(rules[i].first, ID);
+  }
+}
+
+}   // namespace BT
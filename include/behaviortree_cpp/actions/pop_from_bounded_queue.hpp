@@ -0,0 +1,80 @@
+#pragma once
+
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/utils/bounded_queue.hpp"
+
+/**
+ * Same as PopFromQueue and QueueSize, but the queue is a SharedBoundedQueue<T>,
+ * that other threads can fill: popping an element takes no lock.
+ *
+ *   factory.registerNodeType<PopFromBoundedQueue<Pose>>("PopPose");
+ */
+namespace BT
+{
+
+template <typename T>
+class PopFromBoundedQueue : public SyncActionNode
+{
+  public:
+    PopFromBoundedQueue(const std::string& name, const NodeConfig& config)
+      : SyncActionNode(name, config)
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        SharedBoundedQueue<T> queue;
+        if( getInput("queue", queue) && queue )
+        {
+            T val;
+            if( !queue->tryPop(val) )
+            {
+                return NodeStatus::FAILURE;
+            }
+            setOutput("popped_item", val);
+            return NodeStatus::SUCCESS;
+        }
+        return NodeStatus::FAILURE;
+    }
+
+    static PortsList providedPorts()
+    {
+        return { InputPort<SharedBoundedQueue<T>>("queue"),
+                 OutputPort<T>("popped_item")};
+    }
+};
+
+/// Write the number of elements in "size"; return FAILURE if the queue is empty.
+template <typename T>
+class BoundedQueueSize : public SyncActionNode
+{
+  public:
+    BoundedQueueSize(const std::string& name, const NodeConfig& config)
+      : SyncActionNode(name, config)
+    {
+    }
+
+    NodeStatus tick() override
+    {
+        SharedBoundedQueue<T> queue;
+        if( getInput("queue", queue) && queue )
+        {
+            const size_t count = queue->size();
+            if( count == 0 )
+            {
+                return NodeStatus::FAILURE;
+            }
+            setOutput("size", int(count) );
+            return NodeStatus::SUCCESS;
+        }
+        return NodeStatus::FAILURE;
+    }
+
+    static PortsList providedPorts()
+    {
+        return { InputPort<SharedBoundedQueue<T>>("queue"),
+                 OutputPort<int>("size")};
+    }
+};
+
+}   // namespace BT
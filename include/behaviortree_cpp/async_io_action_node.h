@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/tree_executor.h"
+#include "behaviortree_cpp/utils/cancellation_token.hpp"
+#include "behaviortree_cpp/utils/io_reactor.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief AsyncIoActionNode is an action that waits for I/O (a socket, a pipe,
+ * the completion of an asynchronous client) without blocking a thread and
+ * without polling: it registers its file descriptors, or a completion
+ * callback, with an IoReactor, and it is woken up with emitWakeUpSignal()
+ * when they are ready.
+ *
+ * - onStart() starts the operation. It returns RUNNING after registering the
+ *   handlers with waitFor() and/or passing the callback completer() to an
+ *   asynchronous API, or SUCCESS/FAILURE if it completed immediately.
+ * - the handlers of waitFor() are executed by IoReactor::poll() and return
+ *   the new status of the node: RUNNING to keep waiting (they may call
+ *   waitFor() again), otherwise the node completes.
+ * - onHalted() is invoked when the node is halted while RUNNING;
+ *   the handlers not executed yet are removed and late completions ignored.
+ *   Before that, cancellationToken() is cancelled: an asynchronous client
+ *   can use its onCancel() callbacks to abort the request immediately.
+ *
+ * The reactor is passed to the constructor, for instance:
+ *
+ *   auto reactor = std::make_shared<IoReactor>();
+ *   factory.registerNodeType<ReadSocket>("ReadSocket", reactor);
+ *   auto tree = factory.createTree("MainTree");
+ *   TreeExecutor executor(tree);
+ *   AttachIoReactor(executor, reactor);
+ *   executor.run();   // a single thread for the tree and all the I/O
+ *
+ * Linux only, see IoReactor.
+ */
+class AsyncIoActionNode : public ActionNodeBase
+{
+public:
+  using IoHandler = std::function<NodeStatus(uint32_t events)>;
+
+  AsyncIoActionNode(const std::string& name, const NodeConfig& config,
+                    std::shared_ptr<IoReactor> reactor) :
+    ActionNodeBase(name, config), reactor_(std::move(reactor)),
+    state_(std::make_shared<State>())
+  {
+    if (!reactor_)
+    {
+      throw RuntimeError("AsyncIoActionNode: invalid reactor");
+    }
+    state_->node = this;
+  }
+
+  ~AsyncIoActionNode() override
+  {
+    cancelWatches();
+    cancellation_.cancel();
+    std::scoped_lock lk(state_->mutex);
+    state_->node = nullptr;
+  }
+
+  /// Start the operation. See the description of the class.
+  virtual NodeStatus onStart() = 0;
+
+  /// Invoked when the node is halted while RUNNING.
+  virtual void onHalted()
+  {}
+
+  [[nodiscard]] const std::shared_ptr<IoReactor>& reactor() const
+  {
+    return reactor_;
+  }
+
+protected:
+  /// Invoke the handler, from IoReactor::poll(), when the file descriptor is
+  /// ready for the events (EPOLLIN, EPOLLOUT, ...).
+  void waitFor(int fd, uint32_t events, IoHandler handler)
+  {
+    const uint64_t generation = state_->generation.load();
+    std::weak_ptr<State> weak_state = state_;
+    // assigned with watches_mutex_ locked, read by forgetWatch()
+    auto id = std::make_shared<uint64_t>(0);
+    std::scoped_lock lk(watches_mutex_);
+    *id = reactor_->watchOnce(fd, events,
+                              [weak_state, generation, id_ptr = id, handler = std::move(handler)](
+                                  uint32_t ev) {
+                                auto state = weak_state.lock();
+                                if (!state || state->generation != generation)
+                                {
+                                  return;
+                                }
+                                AsyncIoActionNode* node = nullptr;
+                                {
+                                  std::scoped_lock lk(state->mutex);
+                                  node = state->node;
+                                }
+                                if (!node)
+                                {
+                                  return;
+                                }
+                                node->forgetWatch(*id_ptr);
+                                const NodeStatus status = handler(ev);
+                                if (status != NodeStatus::RUNNING)
+                                {
+                                  complete(*state, generation, status);
+                                }
+                              });
+    watches_.push_back(*id);
+  }
+
+  /// Token of the current activation, cancelled when the node is halted.
+  [[nodiscard]] CancellationToken cancellationToken() const
+  {
+    return cancellation_.token();
+  }
+
+  /**
+   * @brief Callback that completes the current activation of the node with
+   * the given status (SUCCESS or FAILURE). It can be invoked from any thread
+   * and may outlive the node: calls after a halt, or after the destruction
+   * of the node, are ignored.
+   */
+  [[nodiscard]] std::function<void(NodeStatus)> completer()
+  {
+    const uint64_t generation = state_->generation.load();
+    std::weak_ptr<State> weak_state = state_;
+    return [weak_state, generation](NodeStatus status) {
+      if (auto state = weak_state.lock())
+      {
+        complete(*state, generation, status);
+      }
+    };
+  }
+
+private:
+  struct State
+  {
+    std::mutex mutex;
+    AsyncIoActionNode* node = nullptr;
+    // incremented at each activation and halt
+    std::atomic<uint64_t> generation = 0;
+    std::atomic<NodeStatus> result = NodeStatus::IDLE;
+  };
+
+  std::shared_ptr<IoReactor> reactor_;
+  std::shared_ptr<State> state_;
+  CancellationSource cancellation_;
+  std::mutex watches_mutex_;
+  std::vector<uint64_t> watches_;
+
+  static void complete(State& state, uint64_t generation, NodeStatus status)
+  {
+    if (!isStatusCompleted(status))
+    {
+      return;
+    }
+    std::scoped_lock lk(state.mutex);
+    NodeStatus expected = NodeStatus::RUNNING;
+    if (state.node && state.generation == generation &&
+        state.result.compare_exchange_strong(expected, status))
+    {
+      // the Tree, and the reactor that may be waiting instead of Tree::sleep()
+      state.node->emitWakeUpSignal();
+      state.node->reactor_->notify();
+    }
+  }
+
+  void forgetWatch(const uint64_t& id)
+  {
+    std::scoped_lock lk(watches_mutex_);
+    watches_.erase(std::remove(watches_.begin(), watches_.end(), id), watches_.end());
+  }
+
+  void cancelWatches()
+  {
+    std::vector<uint64_t> watches;
+    {
+      std::scoped_lock lk(watches_mutex_);
+      watches.swap(watches_);
+    }
+    for (uint64_t id : watches)
+    {
+      reactor_->cancel(id);
+    }
+  }
+
+  NodeStatus tick() override final
+  {
+    if (status() == NodeStatus::IDLE)
+    {
+      state_->generation++;
+      state_->result = NodeStatus::RUNNING;
+      cancellation_ = CancellationSource();
+      const NodeStatus start_status = onStart();
+      if (start_status != NodeStatus::RUNNING)
+      {
+        state_->generation++;
+        cancelWatches();
+        return start_status;
+      }
+    }
+    const NodeStatus result = state_->result.load();
+    if (result != NodeStatus::RUNNING)
+    {
+      cancelWatches();
+    }
+    return result;
+  }
+
+  void halt() override final
+  {
+    if (status() == NodeStatus::RUNNING)
+    {
+      state_->generation++;
+      cancelWatches();
+      cancellation_.cancel();
+      onHalted();
+    }
+    resetStatus();
+  }
+};
+
+/**
+ * @brief Let the TreeExecutor wait in IoReactor::poll() between two ticks,
+ * so that its thread executes the I/O handlers, and consider the
+ * AsyncIoActionNodes of the tree event-driven.
+ *
+ * The AsyncIoActionNodes interrupt the poll when they complete. Other nodes
+ * that call emitWakeUpSignal() must also call IoReactor::notify(), otherwise
+ * the next tick happens when the timeout of the poll expires.
+ * The reactor must outlive the executor.
+ */
+inline void AttachIoReactor(TreeExecutor& executor, std::shared_ptr<IoReactor> reactor)
+{
+  Tree& tree = executor.tree();
+  for (const auto& subtree : tree.subtrees)
+  {
+    for (const auto& node : subtree->nodes)
+    {
+      if (dynamic_cast<const AsyncIoActionNode*>(node.get()))
+      {
+        executor.markEventDriven(node->registrationName());
+      }
+    }
+  }
+  std::shared_ptr<WakeUpSignal> wake_up = tree.wakeUpSignal();
+  executor.setWaitFunction([reactor, wake_up](std::chrono::milliseconds timeout) {
+    // a wake-up signal emitted before the poll
+    if (wake_up->waitFor(std::chrono::system_clock::duration::zero()))
+    {
+      reactor->poll(std::chrono::milliseconds(0));
+      return true;
+    }
+    const bool woken_up = reactor->poll(timeout);
+    // the next tick consumes the wake-up signals received so far
+    wake_up->waitFor(std::chrono::system_clock::duration::zero());
+    return woken_up;
+  });
+}
+
+}   // namespace BT
@@ -14,6 +14,7 @@
 #include <optional>
 
 #include "behaviortree_cpp/utils/safe_any.hpp"
+#include "behaviortree_cpp/utils/type_id.hpp"
 #include "behaviortree_cpp/exceptions.h"
 #include "behaviortree_cpp/contrib/expected.hpp"
 
@@ -278,6 +279,13 @@ public:
 
   [[nodiscard]] const std::string& typeName() const;
 
+  /// The TypeID of type(), looked up in the registry of the types at each call:
+  /// to compare types in a hot path, prefer type()
+  [[nodiscard]] TypeID typeID() const
+  {
+    return TypeID::of(type_info_);
+  }
+
   [[nodiscard]] Any parseString(const char* str) const;
 
   [[nodiscard]] Any parseString(const std::string& str) const;
@@ -426,15 +434,44 @@ struct has_static_method_description<
 {
 };
 
+/// True if T declares its ports at compile time, see StaticPortsList
+template <typename T, typename = void>
+struct has_static_ports_spec : std::false_type
+{
+};
+
+template <typename T>
+struct has_static_ports_spec<
+    T, typename std::enable_if<
+           std::is_same<decltype(T::ports.toPortsList()), PortsList>::value>::type>
+  : std::true_type
+{
+};
+
+template <typename T>
+struct has_provided_ports
+  : std::disjunction<has_static_method_providedPorts<T>, has_static_ports_spec<T>>
+{
+};
+
 template <typename T> [[nodiscard]]
-inline PortsList getProvidedPorts(enable_if<has_static_method_providedPorts<T>> = nullptr)
+inline PortsList getProvidedPorts(enable_if<has_provided_ports<T>> = nullptr)
 {
-  return T::providedPorts();
+  if constexpr (has_static_ports_spec<T>::value)
+  {
+    // converted once per type
+    static const PortsList ports = T::ports.toPortsList();
+    return ports;
+  }
+  else
+  {
+    return T::providedPorts();
+  }
 }
 
 template <typename T> [[nodiscard]]
 inline PortsList
-    getProvidedPorts(enable_if_not<has_static_method_providedPorts<T>> = nullptr)
+    getProvidedPorts(enable_if_not<has_provided_ports<T>> = nullptr)
 {
   return {};
 }
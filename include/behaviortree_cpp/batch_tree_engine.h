@@ -0,0 +1,706 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/utils/type_id.hpp"
+
+namespace BT
+{
+
+/*
+ * Batched execution of one tree definition for many entities (agents),
+ * see BatchTreeEngine.
+ */
+
+using EntityId = uint32_t;
+
+/// Read-only view of a list of entities.
+class EntitySpan
+{
+public:
+  EntitySpan(const EntityId* data, size_t size) : data_(data), size_(size)
+  {}
+
+  EntitySpan(const std::vector<EntityId>& ids) : data_(ids.data()), size_(ids.size())
+  {}
+
+  [[nodiscard]] const EntityId* begin() const
+  {
+    return data_;
+  }
+  [[nodiscard]] const EntityId* end() const
+  {
+    return data_ + size_;
+  }
+  [[nodiscard]] size_t size() const
+  {
+    return size_;
+  }
+  [[nodiscard]] bool empty() const
+  {
+    return size_ == 0;
+  }
+  EntityId operator[](size_t index) const
+  {
+    return data_[index];
+  }
+
+private:
+  const EntityId* data_;
+  size_t size_;
+};
+
+/**
+ * @brief EntityColumns is the blackboard of a batch of entities, stored as
+ * a structure of arrays: each key is a column with one value per entity,
+ * indexed by EntityId.
+ *
+ * Columns hold trivially copyable values (numbers, enums, small structs),
+ * so that the leaves can process them with loops that the compiler can
+ * vectorize. Columns are never resized: the pointers remain valid.
+ */
+class EntityColumns
+{
+public:
+  explicit EntityColumns(size_t entities_count) : size_(entities_count)
+  {}
+
+  EntityColumns(const EntityColumns&) = delete;
+  EntityColumns& operator=(const EntityColumns&) = delete;
+
+  [[nodiscard]] size_t size() const
+  {
+    return size_;
+  }
+
+  /// Create a column (or return the existing one, if it has the same type).
+  template <typename T>
+  T* add(const std::string& key, const T& initial_value = {})
+  {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "EntityColumns: the values must be trivially copyable");
+    auto it = columns_.find(key);
+    if (it != columns_.end())
+    {
+      return cast<T>(key, it->second);
+    }
+    auto values = std::make_shared<std::vector<T>>(size_, initial_value);
+    T* data = values->data();
+    columns_.emplace(key, Column{ TypeID::of<T>(), std::move(values), data });
+    return data;
+  }
+
+  /// Pointer to the values of a column. Throws if it doesn't exist or has another type.
+  template <typename T>
+  [[nodiscard]] T* get(const std::string& key) const
+  {
+    auto it = columns_.find(key);
+    if (it == columns_.end())
+    {
+      throw RuntimeError("EntityColumns: the column [", key, "] doesn't exist");
+    }
+    return cast<T>(key, it->second);
+  }
+
+  [[nodiscard]] bool contains(const std::string& key) const
+  {
+    return columns_.count(key) != 0;
+  }
+
+private:
+  struct Column
+  {
+    TypeID type;
+    std::shared_ptr<void> storage;
+    void* data;
+  };
+
+  template <typename T>
+  static T* cast(const std::string& key, const Column& column)
+  {
+    if (column.type != TypeID::of<T>())
+    {
+      throw RuntimeError("EntityColumns: the column [", key, "] has type [",
+                         column.type.name(), "], not [", TypeID::of<T>().name(), "]");
+    }
+    return static_cast<T*>(column.data);
+  }
+
+  size_t size_;
+  std::unordered_map<std::string, Column> columns_;
+};
+
+/**
+ * @brief BatchLeaf is the interface of the leaves executed by a
+ * BatchTreeEngine: they are ticked once for all the entities that reached
+ * them in the current tick, instead of once per entity.
+ */
+class BatchLeaf
+{
+public:
+  virtual ~BatchLeaf() = default;
+
+  /**
+   * @brief Tick the leaf for a list of entities.
+   *
+   * @param statuses  output, the status of entities[i] is statuses[i]:
+   *                  SUCCESS, FAILURE, RUNNING or SKIPPED.
+   */
+  virtual void tickBatch(EntitySpan entities, NodeStatus* statuses) = 0;
+
+  /// Halt the entities for which the last tickBatch() returned RUNNING.
+  virtual void haltBatch(EntitySpan /*entities*/)
+  {}
+
+protected:
+  [[nodiscard]] EntityColumns& columns() const
+  {
+    if (!columns_)
+    {
+      throw LogicError("BatchLeaf: the node is not used by a BatchTreeEngine");
+    }
+    return *columns_;
+  }
+
+  /// The column remapped to a port of the node, i.e. port="{column_name}".
+  template <typename T>
+  [[nodiscard]] T* portColumn(const std::string& port) const
+  {
+    StringView key = node_->getRawPortValue(port);
+    StringView stripped;
+    if (TreeNode::isBlackboardPointer(key, &stripped))
+    {
+      key = stripped;
+    }
+    return columns().get<T>(std::string(key));
+  }
+
+private:
+  friend class BatchTreeEngine;
+  EntityColumns* columns_ = nullptr;
+  const TreeNode* node_ = nullptr;
+};
+
+/// An action that is ticked only by a BatchTreeEngine.
+class BatchActionNode : public ActionNodeBase, public BatchLeaf
+{
+public:
+  using ActionNodeBase::ActionNodeBase;
+
+private:
+  NodeStatus tick() override
+  {
+    throw LogicError("The node [", name(), "] can be ticked only by a BatchTreeEngine");
+  }
+
+  void halt() override
+  {}
+};
+
+/// A condition that is ticked only by a BatchTreeEngine.
+class BatchConditionNode : public ConditionNode, public BatchLeaf
+{
+public:
+  using ConditionNode::ConditionNode;
+
+private:
+  NodeStatus tick() override
+  {
+    throw LogicError("The node [", name(), "] can be ticked only by a BatchTreeEngine");
+  }
+};
+
+/**
+ * @brief BatchTreeEngine ticks the same tree for N entities at once.
+ *
+ * The tree is created once (the prototype) and flattened like in
+ * FlatTreeEngine. The state of the controls of each entity (status and
+ * current child) is stored in arrays, one per node, and the values of the
+ * entities in EntityColumns. At each tick, every node is visited once for
+ * all the entities that reached it, so the control-flow decisions are
+ * taken in tight loops and each leaf receives its entities in a single
+ * BatchLeaf::tickBatch() call.
+ *
+ * Supported nodes: Sequence, Fallback, Inverter, ForceSuccess, ForceFailure,
+ * SubTree, AlwaysSuccess, AlwaysFailure and the leaves that derive from
+ * BatchLeaf; the constructor throws if the tree contains other nodes.
+ * The semantic of the controls is the same of FlatTreeEngine.
+ *
+ *   Tree prototype = factory.createTree("Agent");
+ *   EntityColumns columns(10000);
+ *   columns.add<float>("battery", 1.0f);
+ *   BatchTreeEngine engine(prototype, columns);
+ *   engine.tick();   // all the entities
+ */
+class BatchTreeEngine
+{
+public:
+  BatchTreeEngine(Tree& prototype, EntityColumns& columns) :
+    columns_(columns), entities_count_(columns.size())
+  {
+    TreeNode* root = prototype.rootNode();
+    if (!root)
+    {
+      throw RuntimeError("BatchTreeEngine: empty tree");
+    }
+    compile(root);
+    const size_t cells = instructions_.size() * entities_count_;
+    status_.assign(cells, NodeStatus::IDLE);
+    current_child_.assign(cells, 0);
+    all_skipped_.assign(cells, 1);
+    result_.assign(entities_count_, NodeStatus::IDLE);
+    all_entities_.resize(entities_count_);
+    for (size_t i = 0; i < entities_count_; i++)
+    {
+      all_entities_[i] = EntityId(i);
+    }
+  }
+
+  BatchTreeEngine(const BatchTreeEngine&) = delete;
+  BatchTreeEngine& operator=(const BatchTreeEngine&) = delete;
+
+  /// Tick all the entities. See result().
+  void tick()
+  {
+    tick(all_entities_);
+  }
+
+  /// Tick some entities (each one at most once). See result().
+  void tick(EntitySpan entities)
+  {
+    tickInstr(0, entities);
+    completed_.clear();
+    for (EntityId entity : entities)
+    {
+      const NodeStatus status = statusOf(0, entity);
+      result_[entity] = status;
+      if (isStatusCompleted(status))
+      {
+        completed_.push_back(entity);
+      }
+    }
+    // like Tree::tickOnce(), the root is reset when completed
+    resetInstr(0, completed_);
+  }
+
+  /// Status returned by the root for each entity, at its last tick.
+  [[nodiscard]] const std::vector<NodeStatus>& result() const
+  {
+    return result_;
+  }
+
+  /// Halt the running nodes of some entities.
+  void halt(EntitySpan entities)
+  {
+    haltInstr(0, entities);
+  }
+
+  void halt()
+  {
+    halt(all_entities_);
+  }
+
+  [[nodiscard]] size_t entitiesCount() const
+  {
+    return entities_count_;
+  }
+
+private:
+  enum class Op : uint8_t
+  {
+    LEAF,
+    SEQUENCE,
+    FALLBACK,
+    INVERTER,
+    FORCE_SUCCESS,
+    FORCE_FAILURE,
+    FORWARD,
+    ALWAYS_SUCCESS,
+    ALWAYS_FAILURE
+  };
+
+  struct Instruction
+  {
+    Op op = Op::LEAF;
+    TreeNode* node = nullptr;
+    BatchLeaf* leaf = nullptr;
+    uint32_t children_begin = 0;
+    uint32_t children_end = 0;
+    // scratch lists, reused at each tick: a node is never re-entered
+    std::vector<std::vector<EntityId>> buckets;
+    std::vector<EntityId> stopped;
+    std::vector<EntityId> done;
+    std::vector<NodeStatus> leaf_statuses;
+  };
+
+  EntityColumns& columns_;
+  size_t entities_count_;
+  std::vector<Instruction> instructions_;
+  std::vector<uint32_t> children_;
+  // indexed by instruction * entities_count_ + entity
+  std::vector<NodeStatus> status_;
+  std::vector<uint32_t> current_child_;
+  std::vector<uint8_t> all_skipped_;
+
+  std::vector<NodeStatus> result_;
+  std::vector<EntityId> all_entities_;
+  std::vector<EntityId> completed_;
+
+  size_t cell(uint32_t index, EntityId entity) const
+  {
+    return size_t(index) * entities_count_ + entity;
+  }
+
+  NodeStatus& statusOf(uint32_t index, EntityId entity)
+  {
+    return status_[cell(index, entity)];
+  }
+
+  static Op opcode(TreeNode* node)
+  {
+    const auto& conf = node->config();
+    const std::string& ID = node->registrationName();
+    if (!conf.pre_conditions.empty() || !conf.post_conditions.empty())
+    {
+      throw RuntimeError("BatchTreeEngine: the node [", node->fullPath(),
+                         "] has pre or post conditions, that are not supported");
+    }
+    if (ID == "Sequence" && dynamic_cast<SequenceNode*>(node))
+    {
+      return Op::SEQUENCE;
+    }
+    if (ID == "Fallback" && dynamic_cast<FallbackNode*>(node))
+    {
+      return Op::FALLBACK;
+    }
+    if (ID == "Inverter" && dynamic_cast<InverterNode*>(node))
+    {
+      return Op::INVERTER;
+    }
+    if (ID == "ForceSuccess" && dynamic_cast<ForceSuccessNode*>(node))
+    {
+      return Op::FORCE_SUCCESS;
+    }
+    if (ID == "ForceFailure" && dynamic_cast<ForceFailureNode*>(node))
+    {
+      return Op::FORCE_FAILURE;
+    }
+    if (ID == "SubTree" && dynamic_cast<SubTreeNode*>(node))
+    {
+      return Op::FORWARD;
+    }
+    if (ID == "AlwaysSuccess" && dynamic_cast<AlwaysSuccessNode*>(node))
+    {
+      return Op::ALWAYS_SUCCESS;
+    }
+    if (ID == "AlwaysFailure" && dynamic_cast<AlwaysFailureNode*>(node))
+    {
+      return Op::ALWAYS_FAILURE;
+    }
+    if (dynamic_cast<BatchLeaf*>(node))
+    {
+      return Op::LEAF;
+    }
+    throw RuntimeError("BatchTreeEngine: the node [", node->fullPath(), "] (",
+                       ID, ") can't be executed in batch");
+  }
+
+  uint32_t compile(TreeNode* node)
+  {
+    const auto index = uint32_t(instructions_.size());
+    instructions_.emplace_back();
+    const Op op = opcode(node);
+    instructions_[index].op = op;
+    instructions_[index].node = node;
+    if (op == Op::LEAF)
+    {
+      auto* leaf = dynamic_cast<BatchLeaf*>(node);
+      leaf->columns_ = &columns_;
+      leaf->node_ = node;
+      instructions_[index].leaf = leaf;
+      return index;
+    }
+
+    std::vector<TreeNode*> children;
+    if (auto control = dynamic_cast<ControlNode*>(node))
+    {
+      children = control->children();
+    }
+    else if (auto decorator = dynamic_cast<DecoratorNode*>(node))
+    {
+      if (decorator->child())
+      {
+        children.push_back(decorator->child());
+      }
+    }
+    if (children.empty() && op != Op::ALWAYS_SUCCESS && op != Op::ALWAYS_FAILURE)
+    {
+      throw RuntimeError("BatchTreeEngine: the node [", node->fullPath(),
+                         "] has no children");
+    }
+    std::vector<uint32_t> compiled;
+    for (auto* child : children)
+    {
+      compiled.push_back(compile(child));
+    }
+    Instruction& instr = instructions_[index];
+    instr.children_begin = uint32_t(children_.size());
+    children_.insert(children_.end(), compiled.begin(), compiled.end());
+    instr.children_end = uint32_t(children_.size());
+    instr.buckets.resize(compiled.size());
+    return index;
+  }
+
+  [[noreturn]] static void throwIdleChild(const Instruction& instr)
+  {
+    throw LogicError("[", instr.node->name(), "]: A children should not return IDLE");
+  }
+
+  // ControlNode::haltChild() for a list of entities
+  void resetInstr(uint32_t index, EntitySpan entities)
+  {
+    if (entities.empty())
+    {
+      return;
+    }
+    std::vector<EntityId> running;
+    for (EntityId entity : entities)
+    {
+      if (statusOf(index, entity) == NodeStatus::RUNNING)
+      {
+        running.push_back(entity);
+      }
+    }
+    if (!running.empty())
+    {
+      haltInstr(index, running);
+    }
+    for (EntityId entity : entities)
+    {
+      statusOf(index, entity) = NodeStatus::IDLE;
+    }
+  }
+
+  void resetChildren(uint32_t index, EntitySpan entities)
+  {
+    const Instruction& instr = instructions_[index];
+    for (uint32_t c = instr.children_begin; c < instr.children_end; c++)
+    {
+      resetInstr(children_[c], entities);
+    }
+  }
+
+  void haltInstr(uint32_t index, EntitySpan entities)
+  {
+    Instruction& instr = instructions_[index];
+    if (instr.op == Op::LEAF)
+    {
+      std::vector<EntityId> running;
+      for (EntityId entity : entities)
+      {
+        if (statusOf(index, entity) == NodeStatus::RUNNING)
+        {
+          running.push_back(entity);
+        }
+      }
+      if (!running.empty())
+      {
+        instr.leaf->haltBatch(running);
+      }
+    }
+    else
+    {
+      for (EntityId entity : entities)
+      {
+        current_child_[cell(index, entity)] = 0;
+      }
+      resetChildren(index, entities);
+    }
+    for (EntityId entity : entities)
+    {
+      statusOf(index, entity) = NodeStatus::IDLE;
+    }
+  }
+
+  // the status of each entity is written in status_
+  void tickInstr(uint32_t index, EntitySpan entities)
+  {
+    Instruction& instr = instructions_[index];
+    switch (instr.op)
+    {
+      case Op::LEAF: {
+        instr.leaf_statuses.assign(entities.size(), NodeStatus::IDLE);
+        instr.leaf->tickBatch(entities, instr.leaf_statuses.data());
+        for (size_t i = 0; i < entities.size(); i++)
+        {
+          statusOf(index, entities[i]) = instr.leaf_statuses[i];
+        }
+        return;
+      }
+
+      case Op::ALWAYS_SUCCESS:
+      case Op::ALWAYS_FAILURE: {
+        const NodeStatus status = (instr.op == Op::ALWAYS_SUCCESS) ? NodeStatus::SUCCESS :
+                                                                     NodeStatus::FAILURE;
+        for (EntityId entity : entities)
+        {
+          statusOf(index, entity) = status;
+        }
+        return;
+      }
+
+      case Op::SEQUENCE:
+      case Op::FALLBACK:
+        tickSequenceOrFallback(index, entities);
+        return;
+
+      default:
+        tickDecorator(index, entities);
+        return;
+    }
+  }
+
+  // SequenceNode::tick() and FallbackNode::tick(): the entities are grouped
+  // by current child, and move only forward, so one pass over the children
+  // is enough.
+  void tickSequenceOrFallback(uint32_t index, EntitySpan entities)
+  {
+    Instruction& instr = instructions_[index];
+    const bool is_sequence = (instr.op == Op::SEQUENCE);
+    const NodeStatus stop_status = is_sequence ? NodeStatus::FAILURE : NodeStatus::SUCCESS;
+    const NodeStatus done_status = is_sequence ? NodeStatus::SUCCESS : NodeStatus::FAILURE;
+    const uint32_t children_count = instr.children_end - instr.children_begin;
+
+    // not empty only if the previous tick threw
+    for (auto& bucket : instr.buckets)
+    {
+      bucket.clear();
+    }
+    instr.done.clear();
+    for (EntityId entity : entities)
+    {
+      const size_t c = cell(index, entity);
+      if (status_[c] == NodeStatus::IDLE)
+      {
+        all_skipped_[c] = 1;
+      }
+      status_[c] = NodeStatus::RUNNING;
+      instr.buckets[current_child_[c]].push_back(entity);
+    }
+
+    for (uint32_t k = 0; k < children_count; k++)
+    {
+      auto& bucket = instr.buckets[k];
+      if (bucket.empty())
+      {
+        continue;
+      }
+      const uint32_t child = children_[instr.children_begin + k];
+      tickInstr(child, bucket);
+
+      instr.stopped.clear();
+      for (EntityId entity : bucket)
+      {
+        const size_t c = cell(index, entity);
+        const NodeStatus child_status = statusOf(child, entity);
+        all_skipped_[c] &= uint8_t(child_status == NodeStatus::SKIPPED);
+        if (child_status == NodeStatus::RUNNING)
+        {
+          continue;
+        }
+        if (child_status == NodeStatus::IDLE)
+        {
+          throwIdleChild(instr);
+        }
+        if (child_status == stop_status)
+        {
+          instr.stopped.push_back(entity);
+          continue;
+        }
+        current_child_[c]++;
+        if (k + 1 < children_count)
+        {
+          instr.buckets[k + 1].push_back(entity);
+        }
+        else
+        {
+          instr.done.push_back(entity);
+        }
+      }
+      bucket.clear();
+
+      resetChildren(index, instr.stopped);
+      for (EntityId entity : instr.stopped)
+      {
+        const size_t c = cell(index, entity);
+        current_child_[c] = 0;
+        status_[c] = stop_status;
+      }
+    }
+
+    resetChildren(index, instr.done);
+    for (EntityId entity : instr.done)
+    {
+      const size_t c = cell(index, entity);
+      current_child_[c] = 0;
+      status_[c] = all_skipped_[c] ? NodeStatus::SKIPPED : done_status;
+    }
+  }
+
+  void tickDecorator(uint32_t index, EntitySpan entities)
+  {
+    Instruction& instr = instructions_[index];
+    const uint32_t child = children_[instr.children_begin];
+    for (EntityId entity : entities)
+    {
+      NodeStatus& status = statusOf(index, entity);
+      if (instr.op != Op::FORWARD || status == NodeStatus::IDLE)
+      {
+        status = NodeStatus::RUNNING;
+      }
+    }
+    tickInstr(child, entities);
+
+    instr.done.clear();
+    for (EntityId entity : entities)
+    {
+      const NodeStatus child_status = statusOf(child, entity);
+      NodeStatus& status = statusOf(index, entity);
+      if (child_status == NodeStatus::IDLE)
+      {
+        throwIdleChild(instr);
+      }
+      if (!isStatusCompleted(child_status))
+      {
+        status = child_status;
+        continue;
+      }
+      instr.done.push_back(entity);
+      switch (instr.op)
+      {
+        case Op::INVERTER:
+          status = (child_status == NodeStatus::SUCCESS) ? NodeStatus::FAILURE :
+                                                           NodeStatus::SUCCESS;
+          break;
+        case Op::FORCE_SUCCESS:
+          status = NodeStatus::SUCCESS;
+          break;
+        case Op::FORCE_FAILURE:
+          status = NodeStatus::FAILURE;
+          break;
+        default:
+          status = child_status;
+          break;
+      }
+    }
+    resetInstr(child, instr.done);
+  }
+};
+
+}   // namespace BT
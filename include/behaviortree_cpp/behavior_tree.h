@@ -15,12 +15,14 @@
 
 #include "behaviortree_cpp/controls/parallel_node.h"
 #include "behaviortree_cpp/controls/parallel_all_node.h"
+#include "behaviortree_cpp/controls/concurrent_parallel_node.h"
 #include "behaviortree_cpp/controls/reactive_sequence.h"
 #include "behaviortree_cpp/controls/reactive_fallback.h"
 #include "behaviortree_cpp/controls/fallback_node.h"
 #include "behaviortree_cpp/controls/sequence_node.h"
 #include "behaviortree_cpp/controls/sequence_star_node.h"
 #include "behaviortree_cpp/controls/switch_node.h"
+#include "behaviortree_cpp/controls/typed_switch_node.h"
 #include "behaviortree_cpp/controls/if_then_else_node.h"
 #include "behaviortree_cpp/controls/while_do_else_node.h"
 
@@ -48,6 +50,7 @@
 #include "behaviortree_cpp/decorators/script_precondition.h"
 #include "behaviortree_cpp/decorators/timeout_node.h"
 #include "behaviortree_cpp/decorators/delay_node.h"
+#include "behaviortree_cpp/decorators/budget_yield_node.h"
 
 #include <iostream>
 
@@ -142,6 +142,21 @@ public:
       Any& previous_any = entry.value;
       const PortInfo& port_info = entry.port_info;
 
+      // fast path: same type, the value can be assigned in place,
+      // reusing the storage (and the capacity) of the previous one.
+      if constexpr (std::is_copy_assignable<T>::value)
+      {
+        if (port_info.isStronglyTyped() &&
+            port_info.type() == std::type_index(typeid(T)))
+        {
+          if (T* previous_ptr = previous_any.castPtr<T>())
+          {
+            *previous_ptr = value;
+            return;
+          }
+        }
+      }
+
       Any new_value(value);
 
       // special case: entry exists but it is not strongly typed... yet
@@ -161,7 +176,7 @@ public:
           previous_type != new_value.type())
       {
         bool mismatching = true;
-        if (std::is_constructible<StringView, T>::value)
+        if constexpr (std::is_constructible<StringView, T>::value)
         {
           Any any_from_string = port_info.parseString(value);
           if (any_from_string.empty() == false)
@@ -196,6 +211,109 @@ public:
     }
   }
 
+  /**
+   * @brief Version of set() that moves the value into the entry.
+   *
+   * If the entry already exists and contains an object of type T,
+   * the new value is move-assigned into it; no temporary Any is created.
+   * In any other case, it behaves exactly like set(key, const T&).
+   */
+  template <typename T,
+            typename = typename std::enable_if<!std::is_lvalue_reference<T>::value>::type>
+  void set(const std::string& key, T&& value)
+  {
+    std::unique_lock lock(mutex_);
+    auto it = storage_.find(key);
+    if (it != storage_.end())
+    {
+      std::shared_ptr<Entry> entry = it->second;
+      lock.unlock();
+
+      if constexpr (std::is_move_assignable<T>::value)
+      {
+        std::unique_lock entry_lock(entry->entry_mutex);
+        const PortInfo& port_info = entry->port_info;
+        if (port_info.isStronglyTyped() &&
+            port_info.type() == std::type_index(typeid(T)))
+        {
+          if (T* previous_ptr = entry->value.castPtr<T>())
+          {
+            *previous_ptr = std::move(value);
+            return;
+          }
+        }
+      }
+    }
+    else
+    {
+      lock.unlock();
+    }
+    set(key, static_cast<const T&>(value));
+  }
+
+  /**
+   * @brief Publish an immutable value, shared with the readers instead of
+   * being copied into the entry. The entry is declared with type T.
+   *
+   * Readers use getShared<T>() or TreeNode::getInputShared<T>(), that return
+   * the reference-counted view (and a copy, for the values stored with set()).
+   * get<T>() and TreeNode::getInput<T>() don't unwrap the pointer: they fail
+   * on a shared entry. A new call to setShared() (or set()) replaces the value
+   * atomically: readers that hold the previous pointer keep it alive.
+   */
+  template <typename T>
+  void setShared(const std::string& key, std::shared_ptr<const T> value)
+  {
+    if (!value)
+    {
+      throw RuntimeError("Blackboard::setShared(", key, "): the pointer is null");
+    }
+    auto entry = getEntry(key);
+    if (!entry)
+    {
+      createEntry(key, PortInfo(PortDirection::INOUT, typeid(T), GetAnyFromStringFunctor<T>()));
+      entry = getEntry(key);
+    }
+    std::scoped_lock lock(entry->entry_mutex);
+    const PortInfo& port_info = entry->port_info;
+    if (!port_info.isStronglyTyped())
+    {
+      entry->port_info = PortInfo(port_info.direction(), typeid(T), port_info.converter());
+    }
+    else if (port_info.type() != std::type_index(typeid(T)))
+    {
+      throw LogicError("Blackboard::setShared(", key, "): once declared, "
+                       "the type of a port shall not change. "
+                       "Previously declared type [", port_info.typeName(),
+                       "], current type [", TypeID::of<T>().name(), "]");
+    }
+    entry->value = Any(value);
+  }
+
+  /**
+   * @brief Value of an entry published with setShared(), without copying it.
+   * If the entry contains a value of type T stored with set(), a copy is returned.
+   *
+   * @return nullptr if the entry doesn't exist or is empty.
+   */
+  template <typename T> [[nodiscard]]
+  std::shared_ptr<const T> getShared(const std::string& key) const
+  {
+    if (auto entry = getEntry(key))
+    {
+      std::scoped_lock lock(entry->entry_mutex);
+      if (auto shared = entry->value.castPtr<std::shared_ptr<const T>>())
+      {
+        return *shared;
+      }
+      if (!entry->value.empty())
+      {
+        return std::make_shared<const T>(entry->value.cast<T>());
+      }
+    }
+    return {};
+  }
+
    [[nodiscard]] const PortInfo* portInfo(const std::string& key);
 
   void addSubtreeRemapping(StringView internal, StringView external);
@@ -212,6 +330,10 @@ public:
   void createEntry(const std::string& key, const PortInfo& info);
 
 private:
+  friend class TreeTemplate;
+  friend class BlackboardSnapshot;
+  friend class Tree;
+
   mutable std::mutex mutex_;
   mutable std::recursive_mutex entry_mutex_;
   std::unordered_map<std::string, std::shared_ptr<Entry>> storage_;
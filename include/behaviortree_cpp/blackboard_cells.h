@@ -0,0 +1,69 @@
+#pragma once
+
+#include "behaviortree_cpp/blackboard.h"
+#include "behaviortree_cpp/utils/read_mostly_cell.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief Opt-in concurrency policy for read-mostly entries of the Blackboard.
+ *
+ * The entry [key] contains a std::shared_ptr<CellT>, where CellT is
+ * AtomicCell<T> (scalars), SeqLockCell<T> (trivially copyable values)
+ * or RcuCell<T> (large values).
+ * The cell is created the first time this function is called, and every
+ * caller gets the same instance.
+ *
+ * The blackboard entry (and its mutex) is accessed only here: nodes should
+ * call this function once (for instance in their constructor) and keep
+ * the pointer. After that, reads and writes go through the cell and never
+ * serialize on Blackboard::Entry::entry_mutex.
+ *
+ *    // in the constructor
+ *    pose_ = GetOrCreateCell<SeqLockCell<Pose2D>>(*config.blackboard, "pose");
+ *    // in tick()
+ *    Pose2D pose = pose_->load();
+ *
+ * Throws if the entry exists, but contains a different type.
+ */
+template <typename CellT>
+inline std::shared_ptr<CellT> GetOrCreateCell(Blackboard& blackboard,
+                                              const std::string& key)
+{
+  using CellPtr = std::shared_ptr<CellT>;
+
+  auto entry = blackboard.getEntry(key);
+  if (!entry)
+  {
+    // createEntry doesn't overwrite an entry created concurrently
+    blackboard.createEntry(key, PortInfo(PortDirection::INOUT, typeid(CellPtr), {}));
+    entry = blackboard.getEntry(key);
+    if (!entry)
+    {
+      throw RuntimeError("GetOrCreateCell: can't create the entry [", key, "]");
+    }
+  }
+
+  std::scoped_lock lk(entry->entry_mutex);
+  if (entry->value.empty())
+  {
+    if (entry->port_info.isStronglyTyped() &&
+        entry->port_info.type() != std::type_index(typeid(CellPtr)))
+    {
+      throw LogicError("GetOrCreateCell: the entry [", key, "] has type [",
+                       entry->port_info.typeName(), "]");
+    }
+    auto cell = std::make_shared<CellT>();
+    entry->value = Any(cell);
+    return cell;
+  }
+  if (auto cell_ptr = entry->value.castPtr<CellPtr>())
+  {
+    return *cell_ptr;
+  }
+  throw LogicError("GetOrCreateCell: the entry [", key, "] contains the type [",
+                   DemangledName(entry->value.type()), "]");
+}
+
+}   // namespace BT
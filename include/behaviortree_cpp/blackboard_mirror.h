@@ -0,0 +1,562 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp/blackboard_snapshot.h"
+#include "behaviortree_cpp/json_export.h"
+
+namespace BT
+{
+
+namespace details
+{
+// message of the BlackboardMirrorPublisher:
+//
+//  - "BM", format version (uint8), flags (uint8, bit 0: full snapshot)
+//  - varints: session, sequence number, number of entries
+//  - for each entry: key, varint version, kind (uint8), type name, data
+//
+// strings are prefixed by their length (varint).
+enum class MirrorValueKind : uint8_t
+{
+  CODEC = 0,     // encoded with the BlackboardCodecs of the type name
+  MSGPACK = 1,   // JsonExporter, then MessagePack
+  NONE = 2,      // empty, or no way to serialize it
+};
+
+struct MirrorReader
+{
+  StringView buffer;
+  size_t pos = 0;
+
+  StringView bytes(size_t size)
+  {
+    if (size > buffer.size() - pos)
+    {
+      throw RuntimeError("BlackboardMirror: the message is truncated");
+    }
+    StringView out = buffer.substr(pos, size);
+    pos += size;
+    return out;
+  }
+
+  uint8_t byte()
+  {
+    return uint8_t(bytes(1)[0]);
+  }
+
+  uint64_t varint()
+  {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+      const uint8_t c = byte();
+      value |= uint64_t(c & 0x7F) << shift;
+      if ((c & 0x80) == 0)
+      {
+        return value;
+      }
+    }
+    throw RuntimeError("BlackboardMirror: invalid varint");
+  }
+
+  StringView string()
+  {
+    return bytes(varint());
+  }
+};
+
+inline void MirrorWriteVarint(std::string& out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(char((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(char(value));
+}
+
+inline void MirrorWriteString(std::string& out, StringView str)
+{
+  MirrorWriteVarint(out, str.size());
+  out.append(str.data(), str.size());
+}
+
+constexpr uint8_t kMirrorFormatVersion = 1;
+}   // namespace details
+
+/**
+ * @brief BlackboardMirrorPublisher streams the changes of a blackboard to a
+ * remote BlackboardMirror, for instance a supervisory process.
+ *
+ * At each poll, the entries are encoded and compared with the encoding sent
+ * last time: only the entries that changed are sent, with a version counted
+ * by the publisher. The bandwidth is proportional to the rate of the changes,
+ * not to the size of the blackboard (the CPU time of poll() still is). The
+ * changes of the same key are coalesced: a key that changes at 1 kHz is sent
+ * at most once per key_interval, with its latest value.
+ *
+ * Values are encoded with the BlackboardCodecs (see BlackboardSnapshot) or,
+ * if the type has no codec, with JsonExporter and MessagePack.
+ *
+ * The transport is a callback that sends a message, for instance on a ZMQ
+ * PUB socket. A full snapshot is sent first, when requested by the receiver
+ * (see BlackboardMirror::needsSnapshot()) and, optionally, periodically.
+ */
+class BlackboardMirrorPublisher
+{
+public:
+  using Transport = std::function<void(const std::string& message)>;
+  using Clock = std::chrono::steady_clock;
+
+  struct Options
+  {
+    /// minimum time between two messages
+    std::chrono::milliseconds interval = std::chrono::milliseconds(50);
+    /// minimum time between two messages containing the same key
+    std::chrono::milliseconds key_interval = std::chrono::milliseconds(100);
+    /// zero: a snapshot is sent only when requested
+    std::chrono::milliseconds snapshot_interval = {};
+    /// a message is split when it exceeds this size
+    size_t max_message_size = 64 * 1024;
+    /// if false, call poll() periodically instead
+    bool background_thread = true;
+  };
+
+  struct Statistics
+  {
+    uint64_t messages = 0;
+    uint64_t bytes = 0;
+    uint64_t snapshots = 0;
+    /// entries found modified by poll()
+    uint64_t changes = 0;
+    /// entries sent in the messages
+    uint64_t entries_sent = 0;
+  };
+
+  BlackboardMirrorPublisher(Blackboard::Ptr blackboard, Transport transport) :
+    BlackboardMirrorPublisher(std::move(blackboard), std::move(transport), Options())
+  {}
+
+  BlackboardMirrorPublisher(Blackboard::Ptr blackboard, Transport transport,
+                            Options options) :
+    blackboard_(std::move(blackboard)), transport_(std::move(transport)),
+    options_(options), session_(std::random_device{}())
+  {
+    if (!blackboard_ || !transport_)
+    {
+      throw RuntimeError("BlackboardMirrorPublisher: invalid blackboard or transport");
+    }
+    if (options_.background_thread)
+    {
+      thread_ = std::thread([this] { loop(); });
+    }
+  }
+
+  ~BlackboardMirrorPublisher()
+  {
+    {
+      std::scoped_lock lk(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+
+  BlackboardMirrorPublisher(const BlackboardMirrorPublisher&) = delete;
+  BlackboardMirrorPublisher& operator=(const BlackboardMirrorPublisher&) = delete;
+
+  /// The next message will be a full snapshot.
+  void requestSnapshot()
+  {
+    {
+      std::scoped_lock lk(mutex_);
+      snapshot_requested_ = true;
+    }
+    cv_.notify_all();
+  }
+
+  /**
+   * @brief Send the pending changes (or the snapshot), if any, respecting
+   * the key_interval. Called by the background thread, if enabled.
+   * @return the number of entries sent.
+   */
+  size_t poll()
+  {
+    std::scoped_lock poll_lock(poll_mutex_);
+    const auto now = Clock::now();
+    bool snapshot = false;
+    {
+      std::scoped_lock lk(mutex_);
+      snapshot = snapshot_requested_ ||
+                 (options_.snapshot_interval.count() > 0 &&
+                  now - last_snapshot_ >= options_.snapshot_interval);
+      snapshot_requested_ = false;
+    }
+
+    Message message(*this, snapshot);
+    size_t sent = 0;
+    for (const auto& key_view : blackboard_->getKeys())
+    {
+      const std::string key(key_view);
+      auto entry = blackboard_->getEntry(key);
+      if (!entry)
+      {
+        continue;
+      }
+      // used by poll() only: no need to lock mutex_
+      auto sent_it = last_sent_.find(key);
+      const bool known = sent_it != last_sent_.end();
+      Sent record = known ? sent_it->second : Sent();
+      // changes within key_interval are coalesced with the next ones
+      const bool coalesce = known && now - record.time < options_.key_interval;
+      if (!message.append(key, *entry, snapshot, coalesce, record))
+      {
+        continue;
+      }
+      sent++;
+      record.time = now;
+      last_sent_[key] = record;
+      if (message.size() >= options_.max_message_size)
+      {
+        message.send();
+      }
+    }
+    // an empty snapshot is sent anyway: the receiver waits for it
+    if (message.count() > 0 || message.isSnapshot())
+    {
+      message.send();
+    }
+    if (snapshot)
+    {
+      std::scoped_lock lk(mutex_);
+      last_snapshot_ = now;
+      stats_.snapshots++;
+    }
+    return sent;
+  }
+
+  [[nodiscard]] Statistics statistics() const
+  {
+    std::scoped_lock lk(mutex_);
+    return stats_;
+  }
+
+private:
+  struct Sent
+  {
+    Clock::time_point time;
+    uint64_t version = 0;
+    // of the type and of the encoded value
+    size_t hash = 0;
+  };
+
+  // builds one message; send() starts the next one
+  class Message
+  {
+  public:
+    Message(BlackboardMirrorPublisher& publisher, bool snapshot) :
+      publisher_(publisher), snapshot_(snapshot)
+    {}
+
+    size_t size() const
+    {
+      return body_.size();
+    }
+
+    size_t count() const
+    {
+      return count_;
+    }
+
+    bool isSnapshot() const
+    {
+      return snapshot_;
+    }
+
+    /**
+     * False if the entry is not sent: it didn't change since the last time
+     * it was sent (see the hash of last), or coalesce is true. Unless force
+     * is true. If sent, last contains its new version and hash.
+     */
+    bool append(const std::string& key, const Blackboard::Entry& entry, bool force,
+                bool coalesce, Sent& last)
+    {
+      auto kind = details::MirrorValueKind::NONE;
+      std::string type_name;
+      data_.clear();
+      {
+        std::unique_lock lk(entry.entry_mutex);
+        type_name = entry.port_info.typeName();
+        const auto* codec = BlackboardCodecs::get().find(entry.port_info.typeID());
+        nlohmann::json json;
+        if (entry.value.empty())
+        {
+          kind = details::MirrorValueKind::NONE;
+        }
+        else if (codec)
+        {
+          codec->encode(entry.value, data_);
+          kind = details::MirrorValueKind::CODEC;
+        }
+        else if (JsonExporter::get().toJson(entry.value, json))
+        {
+          const auto bytes = nlohmann::json::to_msgpack(json);
+          data_.assign(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+          kind = details::MirrorValueKind::MSGPACK;
+        }
+      }
+      const size_t hash = std::hash<std::string>()(data_) ^
+                          (std::hash<std::string>()(type_name) * 31 + size_t(kind));
+      const bool changed = last.version == 0 || hash != last.hash;
+      if (changed)
+      {
+        std::scoped_lock lk(publisher_.mutex_);
+        publisher_.stats_.changes++;
+      }
+      if (!force && (!changed || coalesce))
+      {
+        return false;
+      }
+      if (changed)
+      {
+        last.version++;
+        last.hash = hash;
+      }
+      const uint64_t version = last.version;
+      details::MirrorWriteString(body_, key);
+      details::MirrorWriteVarint(body_, version);
+      body_.push_back(char(kind));
+      details::MirrorWriteString(body_, type_name);
+      details::MirrorWriteString(body_, data_);
+      count_++;
+      return true;
+    }
+
+    void send()
+    {
+      std::string message = { 'B', 'M', char(details::kMirrorFormatVersion),
+                              char(snapshot_ ? 1 : 0) };
+      details::MirrorWriteVarint(message, publisher_.session_);
+      details::MirrorWriteVarint(message, ++publisher_.sequence_);
+      details::MirrorWriteVarint(message, count_);
+      message.append(body_);
+      publisher_.transport_(message);
+      {
+        std::scoped_lock lk(publisher_.mutex_);
+        publisher_.stats_.messages++;
+        publisher_.stats_.bytes += message.size();
+        publisher_.stats_.entries_sent += count_;
+      }
+      body_.clear();
+      count_ = 0;
+      // the following parts of a snapshot are normal deltas
+      snapshot_ = false;
+    }
+
+  private:
+    BlackboardMirrorPublisher& publisher_;
+    bool snapshot_;
+    std::string body_;
+    std::string data_;
+    size_t count_ = 0;
+  };
+
+  Blackboard::Ptr blackboard_;
+  Transport transport_;
+  Options options_;
+  const uint64_t session_;
+  // used by poll() only, protected by poll_mutex_
+  uint64_t sequence_ = 0;
+  std::unordered_map<std::string, Sent> last_sent_;
+  std::mutex poll_mutex_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  bool snapshot_requested_ = true;
+  Clock::time_point last_snapshot_;
+  bool stopping_ = false;
+  Statistics stats_;
+
+  std::thread thread_;
+
+  void loop()
+  {
+    std::unique_lock lk(mutex_);
+    while (!stopping_)
+    {
+      lk.unlock();
+      poll();
+      lk.lock();
+      cv_.wait_for(lk, options_.interval, [this] { return stopping_ || snapshot_requested_; });
+    }
+  }
+};
+
+/**
+ * @brief BlackboardMirror receives the messages of a BlackboardMirrorPublisher
+ * and keeps the last value of each entry. If a target blackboard is given,
+ * the values decoded with the BlackboardCodecs are also written into it.
+ *
+ * A message lost by the transport, or a publisher restarted, makes
+ * needsSnapshot() true: the application should forward that to the
+ * publisher (requestSnapshot()), or wait for the periodic snapshot.
+ */
+class BlackboardMirror
+{
+public:
+  struct MirroredEntry
+  {
+    uint64_t version = 0;
+    std::string type_name;
+    /// decoded with the BlackboardCodecs, if the type has a codec
+    Any value;
+    /// the value, if it was encoded with JsonExporter
+    nlohmann::json json;
+  };
+
+  explicit BlackboardMirror(Blackboard::Ptr target = {}) : target_(std::move(target))
+  {}
+
+  /**
+   * @brief Apply a message. The entries older than the ones already received
+   * are ignored. Throws if the message is malformed.
+   */
+  void apply(StringView message)
+  {
+    details::MirrorReader reader{ message };
+    if (reader.bytes(2) != "BM" || reader.byte() != details::kMirrorFormatVersion)
+    {
+      throw RuntimeError("BlackboardMirror: not a message of BlackboardMirrorPublisher");
+    }
+    const bool snapshot = (reader.byte() & 1) != 0;
+    const uint64_t session = reader.varint();
+    const uint64_t sequence = reader.varint();
+    const uint64_t count = reader.varint();
+
+    std::scoped_lock lk(mutex_);
+    if (snapshot)
+    {
+      if (session != session_)
+      {
+        entries_.clear();
+      }
+      needs_snapshot_ = false;
+    }
+    else if (session != session_ || sequence != sequence_ + 1)
+    {
+      needs_snapshot_ = true;
+    }
+    session_ = session;
+    sequence_ = sequence;
+    messages_++;
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+      const std::string key(reader.string());
+      const uint64_t version = reader.varint();
+      const auto kind = static_cast<details::MirrorValueKind>(reader.byte());
+      const StringView type_name = reader.string();
+      const StringView data = reader.string();
+
+      MirroredEntry& entry = entries_[key];
+      if (!snapshot && version <= entry.version && entry.version != 0)
+      {
+        continue;
+      }
+      entry.version = version;
+      entry.type_name = std::string(type_name);
+      entry.value = {};
+      entry.json = {};
+      if (kind == details::MirrorValueKind::CODEC)
+      {
+        if (const auto* codec = BlackboardCodecs::get().find(entry.type_name))
+        {
+          entry.value = codec->decode(data);
+          if (target_)
+          {
+            writeTarget(key, *codec, entry.value);
+          }
+        }
+      }
+      else if (kind == details::MirrorValueKind::MSGPACK)
+      {
+        entry.json = nlohmann::json::from_msgpack(data.begin(), data.end());
+      }
+    }
+  }
+
+  [[nodiscard]] bool needsSnapshot() const
+  {
+    std::scoped_lock lk(mutex_);
+    return needs_snapshot_;
+  }
+
+  /// Copy of the entry, or nullptr if it was never received
+  [[nodiscard]] std::unique_ptr<MirroredEntry> entry(const std::string& key) const
+  {
+    std::scoped_lock lk(mutex_);
+    auto it = entries_.find(key);
+    return it == entries_.end() ? nullptr : std::make_unique<MirroredEntry>(it->second);
+  }
+
+  [[nodiscard]] std::vector<std::string> keys() const
+  {
+    std::scoped_lock lk(mutex_);
+    std::vector<std::string> out;
+    out.reserve(entries_.size());
+    for (const auto& [key, entry] : entries_)
+    {
+      out.push_back(key);
+    }
+    return out;
+  }
+
+  [[nodiscard]] uint64_t messagesCount() const
+  {
+    std::scoped_lock lk(mutex_);
+    return messages_;
+  }
+
+private:
+  Blackboard::Ptr target_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, MirroredEntry> entries_;
+  uint64_t session_ = 0;
+  uint64_t sequence_ = 0;
+  uint64_t messages_ = 0;
+  bool needs_snapshot_ = true;
+
+  void writeTarget(const std::string& key, const BlackboardCodecs::Codec& codec,
+                   const Any& value)
+  {
+    auto entry = target_->getEntry(key);
+    if (!entry)
+    {
+      target_->createEntry(key, PortInfo(PortDirection::INOUT, codec.type, codec.converter));
+      entry = target_->getEntry(key);
+    }
+    std::scoped_lock lk(entry->entry_mutex);
+    if (entry->port_info.isStronglyTyped() && entry->port_info.type() != codec.type)
+    {
+      throw LogicError("BlackboardMirror: the entry [", key, "] has type [",
+                       entry->port_info.typeName(), "], but the mirror received [",
+                       BT::demangle(codec.type), "]");
+    }
+    entry->value = value;
+  }
+};
+
+}   // namespace BT
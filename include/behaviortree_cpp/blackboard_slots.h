@@ -0,0 +1,331 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp/blackboard.h"
+
+namespace BT
+{
+
+/**
+ * @brief BlackboardKey is the interned version of the string used as key
+ * in the Blackboard.
+ *
+ * Keys are interned in a process-wide registry and converted into a
+ * dense integer ID. The same string will always produce the same ID,
+ * and interning the same key twice is cheap, but it still requires a
+ * hash lookup: do it once, when the tree (or the node) is created.
+ */
+class BlackboardKey
+{
+public:
+  using IdType = uint32_t;
+  static constexpr IdType INVALID_ID = std::numeric_limits<IdType>::max();
+
+  BlackboardKey() = default;
+
+  explicit BlackboardKey(StringView name) : id_(intern(name))
+  {}
+
+  [[nodiscard]] IdType id() const
+  {
+    return id_;
+  }
+
+  [[nodiscard]] bool valid() const
+  {
+    return id_ != INVALID_ID;
+  }
+
+  /// The original string. The reference is valid for the entire
+  /// lifetime of the process.
+  [[nodiscard]] const std::string& name() const
+  {
+    return nameOf(id_);
+  }
+
+  bool operator==(const BlackboardKey& other) const
+  {
+    return id_ == other.id_;
+  }
+
+  bool operator!=(const BlackboardKey& other) const
+  {
+    return id_ != other.id_;
+  }
+
+  /// Number of keys interned, so far.
+  [[nodiscard]] static size_t registeredCount()
+  {
+    auto& reg = registry();
+    std::scoped_lock lk(reg.mutex);
+    return reg.names.size();
+  }
+
+private:
+  IdType id_ = INVALID_ID;
+
+  struct Registry
+  {
+    std::mutex mutex;
+    std::unordered_map<std::string, IdType> ids;
+    // std::deque never invalidates references to its elements on push_back
+    std::deque<std::string> names;
+  };
+
+  static Registry& registry()
+  {
+    static Registry reg;
+    return reg;
+  }
+
+  static IdType intern(StringView name)
+  {
+    auto& reg = registry();
+    std::scoped_lock lk(reg.mutex);
+    std::string name_str(name);
+    auto it = reg.ids.find(name_str);
+    if (it != reg.ids.end())
+    {
+      return it->second;
+    }
+    const auto id = static_cast<IdType>(reg.names.size());
+    reg.names.push_back(name_str);
+    reg.ids.insert({std::move(name_str), id});
+    return id;
+  }
+
+  static const std::string& nameOf(IdType id)
+  {
+    auto& reg = registry();
+    std::scoped_lock lk(reg.mutex);
+    if (id >= reg.names.size())
+    {
+      throw LogicError("BlackboardKey: invalid ID");
+    }
+    return reg.names[id];
+  }
+};
+
+/**
+ * @brief BlackboardSlots is an alternative access path to a Blackboard,
+ * where entries are addressed using a BlackboardKey, instead of a string.
+ *
+ * The entries are still owned by the Blackboard, therefore they remain
+ * visible to the string-based API (used by scripts, loggers and Groot).
+ * Each BlackboardSlots keeps a contiguous array of pointers to those entries,
+ * indexed by the ID of the key; after the first access, get() and set()
+ * are O(1) array accesses, without hashing and without locking the Blackboard.
+ *
+ * Reading the slots is lock-free and thread-safe.
+ *
+ * NOTE: Blackboard::clear() invalidates the cached entries. Call reset()
+ * after it.
+ */
+class BlackboardSlots
+{
+public:
+  using Ptr = std::shared_ptr<BlackboardSlots>;
+
+  explicit BlackboardSlots(Blackboard::Ptr blackboard) : blackboard_(std::move(blackboard))
+  {
+    if (!blackboard_)
+    {
+      throw RuntimeError("BlackboardSlots: invalid Blackboard");
+    }
+  }
+
+  BlackboardSlots(const BlackboardSlots&) = delete;
+  BlackboardSlots& operator=(const BlackboardSlots&) = delete;
+
+  [[nodiscard]] const Blackboard::Ptr& blackboard() const
+  {
+    return blackboard_;
+  }
+
+  /**
+   * @brief Return the entry associated to the key, nullptr if it doesn't exist.
+   * If the key is found, the result is cached.
+   */
+  [[nodiscard]] Blackboard::Entry* getEntry(const BlackboardKey& key) const
+  {
+    if (auto entry = cachedEntry(key))
+    {
+      return entry;
+    }
+    return resolveEntry(key);
+  }
+
+  /// Same as Blackboard::getAnyLocked(key)
+  [[nodiscard]] AnyPtrLocked getAnyLocked(const BlackboardKey& key) const
+  {
+    if (auto entry = getEntry(key))
+    {
+      return AnyPtrLocked(&entry->value, &entry->entry_mutex);
+    }
+    return {};
+  }
+
+  /// Same as Blackboard::get(key, value)
+  template <typename T> [[nodiscard]]
+  bool get(const BlackboardKey& key, T& value) const
+  {
+    if (auto entry = getEntry(key))
+    {
+      std::unique_lock lk(entry->entry_mutex);
+      value = entry->value.cast<T>();
+      return true;
+    }
+    return false;
+  }
+
+  /// Same as Blackboard::get(key)
+  template <typename T> [[nodiscard]]
+  T get(const BlackboardKey& key) const
+  {
+    if (auto entry = getEntry(key))
+    {
+      std::unique_lock lk(entry->entry_mutex);
+      if (entry->value.empty())
+      {
+        throw RuntimeError("BlackboardSlots::get() error. Entry [", key.name(),
+                           "] hasn't been initialized, yet");
+      }
+      return entry->value.cast<T>();
+    }
+    throw RuntimeError("BlackboardSlots::get() error. Missing key [", key.name(), "]");
+  }
+
+  /**
+   * @brief Same as Blackboard::set(key, value).
+   *
+   * If the entry exists and its type is T, the value is written directly.
+   * Otherwise, we fallback to Blackboard::set(), that takes care of creating
+   * the entry and of the type conversions.
+   */
+  template <typename T>
+  void set(const BlackboardKey& key, const T& value)
+  {
+    if (auto entry = getEntry(key))
+    {
+      std::unique_lock lk(entry->entry_mutex);
+      if (entry->port_info.isStronglyTyped() &&
+          entry->port_info.type() == std::type_index(typeid(T)))
+      {
+        Any(value).copyInto(entry->value);
+        return;
+      }
+    }
+    blackboard_->set(key.name(), value);
+  }
+
+  /// Forget the cached entries.
+  void reset()
+  {
+    std::scoped_lock lk(mutex_);
+    for (auto& chunk : chunks_)
+    {
+      if (auto ptr = chunk.load(std::memory_order_acquire))
+      {
+        for (auto& slot : ptr->slots)
+        {
+          slot.store(nullptr, std::memory_order_release);
+        }
+      }
+    }
+    owned_entries_.clear();
+  }
+
+private:
+  static constexpr size_t CHUNK_SIZE = 64;
+  static constexpr size_t MAX_CHUNKS = 1024;
+
+  struct Chunk
+  {
+    std::array<std::atomic<Blackboard::Entry*>, CHUNK_SIZE> slots = {};
+  };
+
+  Blackboard::Ptr blackboard_;
+
+  // Two levels array: it grows without moving the slots that have
+  // been already allocated, therefore readers never need a lock.
+  mutable std::array<std::atomic<Chunk*>, MAX_CHUNKS> chunks_ = {};
+  mutable std::vector<std::unique_ptr<Chunk>> owned_chunks_;
+  mutable std::vector<std::shared_ptr<Blackboard::Entry>> owned_entries_;
+  mutable std::mutex mutex_;
+
+  Blackboard::Entry* cachedEntry(const BlackboardKey& key) const
+  {
+    const auto id = key.id();
+    if (id / CHUNK_SIZE >= MAX_CHUNKS)
+    {
+      return nullptr;
+    }
+    if (auto chunk = chunks_[id / CHUNK_SIZE].load(std::memory_order_acquire))
+    {
+      return chunk->slots[id % CHUNK_SIZE].load(std::memory_order_acquire);
+    }
+    return nullptr;
+  }
+
+  Blackboard::Entry* resolveEntry(const BlackboardKey& key) const
+  {
+    if (!key.valid())
+    {
+      return nullptr;
+    }
+    auto entry = blackboard_->getEntry(key.name());
+    if (!entry)
+    {
+      return nullptr;
+    }
+    const auto id = key.id();
+    if (id / CHUNK_SIZE >= MAX_CHUNKS)
+    {
+      // can't be cached. Keep it alive anyway, because we return a raw pointer
+      std::scoped_lock lk(mutex_);
+      owned_entries_.push_back(entry);
+      return entry.get();
+    }
+
+    std::scoped_lock lk(mutex_);
+    auto& chunk_ptr = chunks_[id / CHUNK_SIZE];
+    Chunk* chunk = chunk_ptr.load(std::memory_order_acquire);
+    if (!chunk)
+    {
+      owned_chunks_.push_back(std::make_unique<Chunk>());
+      chunk = owned_chunks_.back().get();
+      chunk_ptr.store(chunk, std::memory_order_release);
+    }
+    auto& slot = chunk->slots[id % CHUNK_SIZE];
+    if (auto existing = slot.load(std::memory_order_acquire))
+    {
+      return existing;
+    }
+    owned_entries_.push_back(entry);
+    slot.store(entry.get(), std::memory_order_release);
+    return entry.get();
+  }
+};
+
+}   // namespace BT
+
+namespace std
+{
+template <>
+struct hash<BT::BlackboardKey>
+{
+  size_t operator()(const BT::BlackboardKey& key) const noexcept
+  {
+    return std::hash<BT::BlackboardKey::IdType>()(key.id());
+  }
+};
+}   // namespace std
@@ -0,0 +1,541 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BT_SNAPSHOT_MMAP
+#endif
+
+#include "behaviortree_cpp/blackboard.h"
+
+namespace BT
+{
+
+/**
+*  Binary codecs used by BlackboardSnapshot, registered once per type,
+*  similarly to JsonExporter:
+*
+*   BlackboardCodecs::get().addCodec<Pose2D>();   // trivially copyable type
+*
+*   BlackboardCodecs::get().addCodec<Path>(
+*       [](const Path& path, std::string& dst) { ... append bytes to dst ... },
+*       [](StringView src) -> Path { ... });
+*
+*  Numbers, std::string and std::vector of numbers are registered by default.
+*/
+class BlackboardCodecs
+{
+public:
+  static BlackboardCodecs& get()
+  {
+    static BlackboardCodecs global_instance;
+    return global_instance;
+  }
+
+  struct Codec
+  {
+    std::type_index type = typeid(void);
+    std::function<void(const Any&, std::string&)> encode;
+    std::function<Any(StringView)> decode;
+    StringConverter converter;
+  };
+
+  /// Register the codec of T, that must be std::string, trivially copyable or
+  /// a std::vector of a trivially copyable type.
+  template <typename T>
+  void addCodec()
+  {
+    if constexpr (std::is_same_v<T, std::string>)
+    {
+      addCodec<T>([](const T& str, std::string& dst) { dst.append(str); },
+                  [](StringView src) { return T(src); });
+    }
+    else if constexpr (IsVectorOfTrivial<T>::value)
+    {
+      using ValueT = typename T::value_type;
+      addCodec<T>(
+          [](const T& vect, std::string& dst) {
+            dst.append(reinterpret_cast<const char*>(vect.data()),
+                       vect.size() * sizeof(ValueT));
+          },
+          [](StringView src) {
+            if (src.size() % sizeof(ValueT) != 0)
+            {
+              throw RuntimeError("BlackboardCodecs: wrong size of the vector");
+            }
+            T vect(src.size() / sizeof(ValueT));
+            std::memcpy(vect.data(), src.data(), src.size());
+            return vect;
+          });
+    }
+    else
+    {
+      static_assert(std::is_trivially_copyable_v<T>,
+                    "addCodec<T>() without arguments requires a trivially copyable "
+                    "type; provide your own encode and decode functions");
+      addCodec<T>(
+          [](const T& value, std::string& dst) {
+            dst.append(reinterpret_cast<const char*>(&value), sizeof(T));
+          },
+          [](StringView src) {
+            if (src.size() != sizeof(T))
+            {
+              throw RuntimeError("BlackboardCodecs: wrong size of [",
+                                 TypeID::of<T>().name(), "]");
+            }
+            T value;
+            std::memcpy(&value, src.data(), sizeof(T));
+            return value;
+          });
+    }
+  }
+
+  /// Register directly your own codec.
+  template <typename T>
+  void addCodec(std::function<void(const T&, std::string&)> encode,
+                std::function<T(StringView)> decode)
+  {
+    Codec codec;
+    codec.type = typeid(T);
+    codec.encode = [encode](const Any& any, std::string& dst) {
+      if (auto shared = any.castPtr<std::shared_ptr<const T>>())
+      {
+        encode(**shared, dst);
+      }
+      else if (auto ptr = any.castPtr<T>())
+      {
+        encode(*ptr, dst);
+      }
+      else
+      {
+        encode(any.cast<T>(), dst);
+      }
+    };
+    codec.decode = [decode](StringView src) { return Any(decode(src)); };
+    codec.converter = GetAnyFromStringFunctor<T>();
+    const TypeID id = TypeID::of<T>();
+    names_.insert_or_assign(id.name(), id);
+    codecs_.insert_or_assign(id, std::move(codec));
+  }
+
+  [[nodiscard]] const Codec* find(TypeID type) const
+  {
+    auto it = codecs_.find(type);
+    return (it != codecs_.end()) ? &it->second : nullptr;
+  }
+
+  [[nodiscard]] const Codec* find(const std::string& type_name) const
+  {
+    auto it = names_.find(type_name);
+    return (it != names_.end()) ? find(it->second) : nullptr;
+  }
+
+private:
+  template <typename T>
+  struct IsVectorOfTrivial : std::false_type
+  {
+  };
+
+  template <typename T>
+  struct IsVectorOfTrivial<std::vector<T>>
+    : std::bool_constant<std::is_trivially_copyable_v<T> && !std::is_same_v<T, bool>>
+  {
+  };
+
+  BlackboardCodecs()
+  {
+    addCodec<bool>();
+    addCodec<char>();
+    addCodec<int8_t>();
+    addCodec<uint8_t>();
+    addCodec<int16_t>();
+    addCodec<uint16_t>();
+    addCodec<int32_t>();
+    addCodec<uint32_t>();
+    addCodec<int64_t>();
+    addCodec<uint64_t>();
+    addCodec<float>();
+    addCodec<double>();
+    addCodec<std::string>();
+    addCodec<std::vector<int>>();
+    addCodec<std::vector<double>>();
+    addCodec<NodeStatus>();
+  }
+
+  std::unordered_map<TypeID, Codec> codecs_;
+  std::unordered_map<std::string, TypeID> names_;
+};
+
+/**
+ * @brief BlackboardSnapshot is a binary copy of the entries of a blackboard,
+ * of its parents and of their subtree remappings, used for checkpoints.
+ *
+ *   std::string data = BlackboardSnapshot::save(*blackboard);
+ *   ...
+ *   BlackboardSnapshot::fromString(data).restore(*blackboard);
+ *
+ * The format is a sequence of length-prefixed records; integers are stored
+ * in the native byte order, that is checked when the snapshot is opened.
+ * Opening a snapshot builds only an index of the records: values are decoded
+ * when they are requested with value() or restore(). open() memory-maps the file.
+ *
+ * Values are encoded with the BlackboardCodecs; the entries that have a type
+ * without codec are saved without value and ignored by restore().
+ */
+class BlackboardSnapshot
+{
+public:
+  struct EntryRecord
+  {
+    StringView key;
+    StringView type_name;
+    bool has_value = false;
+    StringView data;
+  };
+
+  struct LevelRecord
+  {
+    bool autoremapping = false;
+    std::vector<std::pair<StringView, StringView>> remappings;
+    std::vector<EntryRecord> entries;
+  };
+
+  /// Serialize the blackboard and its parents.
+  [[nodiscard]] static std::string save(const Blackboard& blackboard)
+  {
+    std::string out;
+    out.append(MAGIC, sizeof(MAGIC));
+    writeInt<uint32_t>(out, BYTE_ORDER_MARK);
+    writeInt<uint32_t>(out, FORMAT_VERSION);
+
+    std::vector<std::shared_ptr<Blackboard>> parents;
+    for (auto bb = blackboard.parent_bb_.lock(); bb; bb = bb->parent_bb_.lock())
+    {
+      parents.push_back(bb);
+    }
+    writeInt<uint32_t>(out, uint32_t(parents.size() + 1));
+    saveLevel(blackboard, out);
+    for (const auto& bb : parents)
+    {
+      saveLevel(*bb, out);
+    }
+    return out;
+  }
+
+  static void saveToFile(const Blackboard& blackboard, const std::string& filename)
+  {
+    const std::string data = save(blackboard);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.write(data.data(), std::streamsize(data.size())))
+    {
+      throw RuntimeError("BlackboardSnapshot: can't write the file [", filename, "]");
+    }
+  }
+
+  /// Snapshot whose data is NOT copied: the buffer must outlive it.
+  [[nodiscard]] static BlackboardSnapshot fromBuffer(StringView buffer)
+  {
+    return BlackboardSnapshot(buffer, {});
+  }
+
+  [[nodiscard]] static BlackboardSnapshot fromString(std::string data)
+  {
+    auto owned = std::make_shared<const std::string>(std::move(data));
+    return BlackboardSnapshot(StringView(*owned), owned);
+  }
+
+  /// Open a file written by saveToFile()
+  [[nodiscard]] static BlackboardSnapshot open(const std::string& filename)
+  {
+#if defined(BT_SNAPSHOT_MMAP)
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      throw RuntimeError("BlackboardSnapshot: can't open the file [", filename, "]");
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+      ::close(fd);
+      throw RuntimeError("BlackboardSnapshot: can't read the file [", filename, "]");
+    }
+    const size_t size = size_t(info.st_size);
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+    {
+      throw RuntimeError("BlackboardSnapshot: can't map the file [", filename, "]");
+    }
+    std::shared_ptr<const void> mapping(address,
+                                        [size](const void* ptr) {
+                                          ::munmap(const_cast<void*>(ptr), size);
+                                        });
+    return BlackboardSnapshot(StringView(static_cast<const char*>(address), size),
+                              std::move(mapping));
+#else
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+      throw RuntimeError("BlackboardSnapshot: can't open the file [", filename, "]");
+    }
+    std::string data((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    return fromString(std::move(data));
+#endif
+  }
+
+  /// Level 0 is the blackboard that was saved, level 1 its parent and so on.
+  [[nodiscard]] const std::vector<LevelRecord>& levels() const
+  {
+    return levels_;
+  }
+
+  /// Decode the value of an entry. Empty if not found or if it has no value.
+  [[nodiscard]] Any value(StringView key, size_t level = 0) const
+  {
+    if (level < levels_.size())
+    {
+      for (const auto& entry : levels_[level].entries)
+      {
+        if (entry.key == key)
+        {
+          return decode(entry).second;
+        }
+      }
+    }
+    return {};
+  }
+
+  /**
+   * @brief Write the saved values into the blackboard and into its parents,
+   * as many as both the snapshot and the chain of blackboards have.
+   * Missing entries and subtree remappings are created.
+   */
+  void restore(Blackboard& blackboard) const
+  {
+    Blackboard* bb = &blackboard;
+    std::shared_ptr<Blackboard> parent;
+    for (const auto& level : levels_)
+    {
+      restoreLevel(level, *bb);
+      parent = bb->parent_bb_.lock();
+      if (!parent)
+      {
+        break;
+      }
+      bb = parent.get();
+    }
+  }
+
+private:
+  static constexpr char MAGIC[4] = {'B', 'T', 'B', 'B'};
+  static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+  static constexpr uint32_t FORMAT_VERSION = 1;
+
+  StringView buffer_;
+  std::shared_ptr<const void> owner_;
+  std::vector<LevelRecord> levels_;
+
+  BlackboardSnapshot(StringView buffer, std::shared_ptr<const void> owner) :
+    buffer_(buffer), owner_(std::move(owner))
+  {
+    buildIndex();
+  }
+
+  template <typename T>
+  static void writeInt(std::string& out, T value)
+  {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  static void writeString(std::string& out, StringView str)
+  {
+    writeInt<uint32_t>(out, uint32_t(str.size()));
+    out.append(str.data(), str.size());
+  }
+
+  static void saveLevel(const Blackboard& bb, std::string& out)
+  {
+    std::vector<std::pair<std::string, std::shared_ptr<Blackboard::Entry>>> entries;
+    {
+      std::unique_lock lk(bb.mutex_);
+      writeInt<uint8_t>(out, bb.autoremapping_ ? 1 : 0);
+      writeInt<uint32_t>(out, uint32_t(bb.internal_to_external_.size()));
+      for (const auto& [internal, external] : bb.internal_to_external_)
+      {
+        writeString(out, internal);
+        writeString(out, external);
+      }
+      entries.assign(bb.storage_.begin(), bb.storage_.end());
+    }
+
+    writeInt<uint32_t>(out, uint32_t(entries.size()));
+    std::string data;
+    for (const auto& [key, entry] : entries)
+    {
+      data.clear();
+      bool has_value = false;
+      std::string type_name;
+      {
+        std::scoped_lock lk(entry->entry_mutex);
+        type_name = entry->port_info.typeName();
+        if (const auto* codec = BlackboardCodecs::get().find(entry->port_info.typeID());
+            codec && !entry->value.empty())
+        {
+          codec->encode(entry->value, data);
+          has_value = true;
+        }
+      }
+      writeString(out, key);
+      writeString(out, type_name);
+      writeInt<uint8_t>(out, has_value ? 1 : 0);
+      writeString(out, data);
+    }
+  }
+
+  // Cursor used to build the index; it throws if the buffer is truncated.
+  struct Reader
+  {
+    StringView buffer;
+    size_t pos = 0;
+
+    StringView bytes(size_t size)
+    {
+      if (size > buffer.size() - pos)
+      {
+        throw RuntimeError("BlackboardSnapshot: the data is truncated");
+      }
+      StringView out = buffer.substr(pos, size);
+      pos += size;
+      return out;
+    }
+
+    template <typename T>
+    T readInt()
+    {
+      T value;
+      std::memcpy(&value, bytes(sizeof(T)).data(), sizeof(T));
+      return value;
+    }
+
+    StringView readString()
+    {
+      return bytes(readInt<uint32_t>());
+    }
+  };
+
+  void buildIndex()
+  {
+    Reader reader{buffer_};
+    if (reader.bytes(sizeof(MAGIC)) != StringView(MAGIC, sizeof(MAGIC)))
+    {
+      throw RuntimeError("BlackboardSnapshot: the data is not a snapshot");
+    }
+    if (reader.readInt<uint32_t>() != BYTE_ORDER_MARK)
+    {
+      throw RuntimeError("BlackboardSnapshot: the snapshot was saved with a "
+                         "different byte order");
+    }
+    if (const auto version = reader.readInt<uint32_t>(); version != FORMAT_VERSION)
+    {
+      throw RuntimeError("BlackboardSnapshot: unsupported version [", std::to_string(version),
+                         "]");
+    }
+    levels_.resize(reader.readInt<uint32_t>());
+    for (auto& level : levels_)
+    {
+      level.autoremapping = reader.readInt<uint8_t>() != 0;
+      level.remappings.resize(reader.readInt<uint32_t>());
+      for (auto& [internal, external] : level.remappings)
+      {
+        internal = reader.readString();
+        external = reader.readString();
+      }
+      level.entries.resize(reader.readInt<uint32_t>());
+      for (auto& entry : level.entries)
+      {
+        entry.key = reader.readString();
+        entry.type_name = reader.readString();
+        entry.has_value = reader.readInt<uint8_t>() != 0;
+        entry.data = reader.readString();
+      }
+    }
+  }
+
+  static std::pair<const BlackboardCodecs::Codec*, Any> decode(const EntryRecord& entry)
+  {
+    if (!entry.has_value)
+    {
+      return {nullptr, {}};
+    }
+    const auto* codec = BlackboardCodecs::get().find(std::string(entry.type_name));
+    if (!codec)
+    {
+      return {nullptr, {}};
+    }
+    return {codec, codec->decode(entry.data)};
+  }
+
+  static void restoreLevel(const LevelRecord& level, Blackboard& bb)
+  {
+    bb.enableAutoRemapping(level.autoremapping);
+    for (const auto& [internal, external] : level.remappings)
+    {
+      bb.addSubtreeRemapping(internal, external);
+    }
+    for (const auto& record : level.entries)
+    {
+      auto [codec, value] = decode(record);
+      if (!codec)
+      {
+        continue;
+      }
+      const std::string key(record.key);
+      std::shared_ptr<Blackboard::Entry> entry;
+      {
+        std::unique_lock lk(bb.mutex_);
+        auto it = bb.storage_.find(key);
+        if (it != bb.storage_.end())
+        {
+          entry = it->second;
+        }
+      }
+      if (!entry)
+      {
+        bb.createEntry(key, PortInfo(PortDirection::INOUT, codec->type, codec->converter));
+        std::unique_lock lk(bb.mutex_);
+        entry = bb.storage_.at(key);
+      }
+
+      std::scoped_lock lk(entry->entry_mutex);
+      const PortInfo& info = entry->port_info;
+      if (!info.isStronglyTyped())
+      {
+        entry->port_info = PortInfo(info.direction(), codec->type, codec->converter);
+      }
+      else if (info.type() != codec->type)
+      {
+        throw LogicError("BlackboardSnapshot: the entry [", key, "] has type [",
+                         info.typeName(), "], but the snapshot contains the type [",
+                         record.type_name, "]");
+      }
+      entry->value = std::move(value);
+    }
+  }
+};
+
+}   // namespace BT
+
+#undef BT_SNAPSHOT_MMAP
@@ -18,16 +18,26 @@
 #include <cstring>
 #include <filesystem>
 #include <functional>
+#include <limits>
+#include <map>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <set>
+#include <variant>
 
 #include "behaviortree_cpp/contrib/magic_enum.hpp"
 #include "behaviortree_cpp/behavior_tree.h"
+#include "behaviortree_cpp/running_frontier.h"
+#include "behaviortree_cpp/utils/frozen_enums.hpp"
+#include "behaviortree_cpp/utils/memory_usage.hpp"
+#include "behaviortree_cpp/utils/tick_budget.hpp"
 
 namespace BT
 {
+class TreeTemplate;
+
 /// The term "Builder" refers to the Builder Pattern (https://en.wikipedia.org/wiki/Builder_pattern)
 using NodeBuilder =
     std::function<std::unique_ptr<TreeNode>(const std::string&, const NodeConfig&)>;
@@ -88,6 +98,36 @@ constexpr const char* PLUGIN_SYMBOL = "BT_RegisterNodesFromPlugin";
 
 bool WildcardMatch(const std::string &str, StringView filter);
 
+/// The manifests of a BehaviorTreeFactory, immutable and reference counted:
+/// the trees created from a TreeTemplate share them instead of copying them
+/// in Tree::manifests. See NodeManifests().
+using SharedManifests =
+    std::shared_ptr<const std::unordered_map<std::string, TreeNodeManifest>>;
+
+namespace details
+{
+inline bool SameManifest(const TreeNodeManifest& a, const TreeNodeManifest& b)
+{
+  if (a.type != b.type || a.registration_ID != b.registration_ID ||
+      a.description != b.description || a.ports.size() != b.ports.size())
+  {
+    return false;
+  }
+  for (const auto& [name, port] : a.ports)
+  {
+    auto it = b.ports.find(name);
+    if (it == b.ports.end() || it->second.direction() != port.direction() ||
+        it->second.type() != port.type() ||
+        it->second.defaultValueString() != port.defaultValueString() ||
+        it->second.description() != port.description())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+}   // namespace details
+
 /**
  * @brief Struct used to store a tree.
  * If this object goes out of scope, the tree is destroyed.
@@ -127,6 +167,12 @@ public:
   /// TreeNode::emitWakeUpSignal()
   void sleep(std::chrono::system_clock::duration timeout);
 
+  /// The signal used by TreeNode::emitWakeUpSignal() and sleep().
+  [[nodiscard]] const std::shared_ptr<WakeUpSignal>& wakeUpSignal() const
+  {
+    return wake_up_;
+  }
+
   ~Tree();
 
   /// Tick the root of the tree once, even if a node invoked
@@ -140,6 +186,18 @@ public:
    */
   NodeStatus tickOnce();
 
+  /**
+   * @brief Same as tickOnce(), with a deadline: the nodes can query the
+   * time left with TickBudget::remaining(), BudgetYieldNode postpones its
+   * child when it passed and StatisticsObserver counts the overruns of each node.
+   * The tick is not interrupted: the deadline is cooperative.
+   */
+  NodeStatus tickOnce(TickBudget::Clock::time_point deadline)
+  {
+    TickBudget::Scope budget(deadline);
+    return tickOnce();
+  }
+
   /// Call tickOnce until the status is different from RUNNING.
   /// Note that between one tick and the following one,
   /// a Tree::sleep() is used
@@ -156,11 +214,231 @@ public:
 
   [[nodiscard]] uint16_t getUID();
 
+  /// TreeNode::UID() is 16 bits, as the node IDs of the logs and of the
+  /// Groot2 protocol: this is the maximum number of nodes of a tree.
+  /// TreeTemplate, FactoryExtensions and reload() reject the larger trees.
+  static constexpr size_t kMaxNodes = size_t(std::numeric_limits<uint16_t>::max()) + 1;
+
+  struct ReloadStats
+  {
+    // subtrees (and their nodes) of the old tree used by the new one
+    size_t reused_subtrees = 0;
+    size_t reused_nodes = 0;
+    // subtrees taken from the new tree
+    size_t rebuilt_subtrees = 0;
+    size_t rebuilt_nodes = 0;
+    // nodes that were running and had to be halted
+    size_t halted_nodes = 0;
+  };
+
+  /**
+   * @brief Replace this tree with new_tree, usually created from a modified XML
+   * with the same root blackboard, keeping the instances of the subtrees that
+   * did not change: their nodes, status and blackboard are preserved.
+   *
+   * Subtrees are matched by instance name (the path of the SubTree node, give
+   * a name to the SubTrees) and are unchanged if their nodes, ports, conditions
+   * and remappings are the same. A modified subtree is taken from new_tree and
+   * the values of its blackboard with the same key and type are copied from
+   * the old one. A reused subtree keeps its running state only if all its
+   * ancestors are reused too; otherwise it is halted.
+   *
+   * Invoke it between two ticks, from the thread that ticks the tree.
+   * The UIDs of the nodes are assigned again: loggers and observers that use
+   * them must be created again. new_tree is left empty.
+   */
+  ReloadStats reload(Tree&& new_tree);
+
+  /// Estimate of the memory used by a tree, by category. See memoryStats().
+  struct MemoryStats
+  {
+    size_t nodes = 0;
+    size_t subtrees = 0;
+    size_t blackboard_entries = 0;
+
+    /// sizeof(TreeNode) and the name of each node. A lower bound: the size of
+    /// the derived classes and their own allocations are unknown.
+    size_t nodes_bytes = 0;
+    /// NodeConfig of each node, with its ports remapping and conditions
+    size_t config_bytes = 0;
+    /// part of config_bytes used by the ports remapping
+    size_t remapping_bytes = 0;
+    /// manifests owned by the tree
+    size_t manifests_bytes = 0;
+    /// manifests of the nodes shared with the factory and the other trees of
+    /// a TreeTemplate (not included in total())
+    size_t shared_manifests_bytes = 0;
+    /// entries of all the blackboards of the tree: keys, ports info and values
+    size_t blackboard_bytes = 0;
+    /// source code and parsed functions of the conditions and of the Script nodes
+    size_t scripts_bytes = 0;
+    /// buffers reported by MemoryStatsOptions::buffers, e.g. the loggers
+    size_t buffers_bytes = 0;
+
+    /// blackboard_bytes by type of the entry. Filled only if
+    /// MemoryStatsOptions::blackboard_by_type is true
+    std::map<std::string, size_t> blackboard_bytes_by_type;
+
+    [[nodiscard]] size_t total() const
+    {
+      return nodes_bytes + config_bytes + manifests_bytes + blackboard_bytes +
+             scripts_bytes + buffers_bytes;
+    }
+  };
+
+  struct MemoryStatsOptions
+  {
+    /// Heap memory used by a value of the blackboard, given its type.
+    /// Without a sizer, only std::string and the types stored inline in Any
+    /// are measured exactly.
+    using ValueSizer = std::function<size_t(const Any&)>;
+    std::unordered_map<std::type_index, ValueSizer> value_sizers;
+
+    bool blackboard_by_type = false;
+
+    /// Memory used by objects attached to the tree, for instance:
+    ///   options.buffers.push_back([&logger] { return logger.bufferedBytes(); });
+    std::vector<std::function<size_t()>> buffers;
+  };
+
+  /**
+   * @brief Estimate the memory used by the tree and its blackboards.
+   *
+   * It visits all the nodes and the entries of the blackboards, locking each
+   * entry for a moment; it allocates only to track the visited entries.
+   * It is cheap enough to be sampled periodically, for instance by
+   * MetricsExporter::addMemoryStats().
+   */
+  [[nodiscard]] MemoryStats memoryStats() const
+  {
+    return memoryStats(MemoryStatsOptions());
+  }
+
+  [[nodiscard]] MemoryStats memoryStats(const MemoryStatsOptions& options) const
+  {
+    MemoryStats stats;
+    stats.subtrees = subtrees.size();
+
+    auto manifest_bytes = [](const TreeNodeManifest& manifest) {
+      size_t bytes = sizeof(TreeNodeManifest) + HeapBytes(manifest.registration_ID) +
+                     HeapBytes(manifest.description);
+      for (const auto& [name, port] : manifest.ports)
+      {
+        bytes += sizeof(std::pair<const std::string, PortInfo>) + HeapBytes(name) +
+                 HeapBytes(port.description()) + HeapBytes(port.defaultValueString()) +
+                 HeapBytes(port.typeName());
+      }
+      return bytes;
+    };
+    for (const auto& [id, manifest] : manifests)
+    {
+      stats.manifests_bytes += HeapBytes(id) + manifest_bytes(manifest);
+    }
+    // the nodes created by a TreeTemplate point to the manifests it shares
+    auto ownsManifest = [this](const TreeNodeManifest* manifest) {
+      auto it = manifests.find(manifest->registration_ID);
+      return it != manifests.end() && &it->second == manifest;
+    };
+    std::unordered_set<const TreeNodeManifest*> shared_manifests;
+
+    // the remapped entries are shared by more than one blackboard
+    std::unordered_set<const Blackboard::Entry*> visited_entries;
+
+    for (const auto& subtree : subtrees)
+    {
+      stats.nodes += subtree->nodes.size();
+      stats.nodes_bytes += sizeof(Subtree) + HeapBytes(subtree->instance_name) +
+                           HeapBytes(subtree->tree_ID) +
+                           subtree->nodes.capacity() * sizeof(TreeNode::Ptr);
+
+      for (const auto& node : subtree->nodes)
+      {
+        stats.nodes_bytes += sizeof(TreeNode) + HeapBytes(node->name());
+
+        const NodeConfig& config = node->config();
+        if (config.manifest && !ownsManifest(config.manifest) &&
+            shared_manifests.insert(config.manifest).second)
+        {
+          stats.shared_manifests_bytes += HeapBytes(config.manifest->registration_ID) +
+                                          manifest_bytes(*config.manifest);
+        }
+        const size_t remapping = HeapBytes(config.input_ports) +
+                                 HeapBytes(config.output_ports);
+        const size_t conditions = HeapBytes(config.pre_conditions) +
+                                  HeapBytes(config.post_conditions);
+        stats.remapping_bytes += remapping;
+        stats.config_bytes += sizeof(NodeConfig) + remapping + HeapBytes(config.path);
+
+        // the text of the conditions, and the functions parsed from it
+        stats.scripts_bytes += conditions;
+        for (const auto& script : node->preConditionsScripts())
+        {
+          stats.scripts_bytes += script ? sizeof(ScriptFunction) : 0;
+        }
+        for (const auto& script : node->postConditionsScripts())
+        {
+          stats.scripts_bytes += script ? sizeof(ScriptFunction) : 0;
+        }
+        if (config.manifest && config.manifest->ports.count("code"))
+        {
+          auto code = config.input_ports.find("code");
+          if (code != config.input_ports.end())
+          {
+            stats.scripts_bytes += sizeof(ScriptFunction) + HeapBytes(code->second);
+          }
+        }
+      }
+
+      if (!subtree->blackboard)
+      {
+        continue;
+      }
+      std::unique_lock lk(subtree->blackboard->mutex_);
+      for (const auto& [key, entry] : subtree->blackboard->storage_)
+      {
+        size_t bytes = HeapBytes(key) + sizeof(std::pair<const std::string, Blackboard::Entry*>);
+        if (!visited_entries.insert(entry.get()).second)
+        {
+          // remapped: the entry was counted in the blackboard that owns it
+          stats.blackboard_bytes += bytes;
+          continue;
+        }
+        stats.blackboard_entries++;
+        bytes += sizeof(Blackboard::Entry);
+        {
+          std::unique_lock entry_lock(entry->entry_mutex);
+          auto sizer = options.value_sizers.find(entry->port_info.type());
+          if (sizer != options.value_sizers.end() && sizer->second)
+          {
+            bytes += sizer->second(entry->value);
+          }
+          else if (const auto* str = entry->value.castPtr<SafeAny::SimpleString>())
+          {
+            // Any stores the strings as SimpleString: inline up to 15 characters
+            bytes += str->isSOO() ? 0 : str->size() + 1;
+          }
+        }
+        stats.blackboard_bytes += bytes;
+        if (options.blackboard_by_type)
+        {
+          stats.blackboard_bytes_by_type[entry->port_info.typeName()] += bytes;
+        }
+      }
+    }
+
+    for (const auto& buffer : options.buffers)
+    {
+      stats.buffers_bytes += buffer ? buffer() : 0;
+    }
+    return stats;
+  }
+
   /// Get a list of nodes which fullPath() match a wildcard filter and
   /// a given path. Example:
   ///
   /// move_nodes = tree.getNodesByPath<MoveBaseNode>("move_*");
   ///
+  /// See TreeIndex to look them up without visiting all the nodes.
   template <typename NodeType = BT::TreeNode> [[nodiscard]]
   std::vector<const TreeNode*> getNodesByPath(StringView wildcard_filter) {
     std::vector<const TreeNode*> nodes;
@@ -176,8 +454,10 @@ public:
     return nodes;
   }
 
-
 private:
+  // it creates the nodes of the tree without the factory
+  friend class TreeTemplate;
+
   std::shared_ptr<WakeUpSignal> wake_up_;
 
   enum TickOption
@@ -192,6 +472,77 @@ private:
   uint16_t uid_counter_ = 0;
 };
 
+namespace details
+{
+// see Tree::kMaxNodes; `where` is the prefix of the error message
+inline void CheckMaxNodes(size_t nodes_count, const char* where)
+{
+  if (nodes_count > Tree::kMaxNodes)
+  {
+    throw RuntimeError(where, ": the tree has ", std::to_string(nodes_count),
+                       " nodes; the maximum is ", std::to_string(Tree::kMaxNodes),
+                       ", because TreeNode::UID() is 16 bits");
+  }
+}
+
+inline size_t CountNodes(const Tree& tree)
+{
+  size_t count = 0;
+  for (const auto& subtree : tree.subtrees)
+  {
+    count += subtree->nodes.size();
+  }
+  return count;
+}
+}   // namespace details
+
+/**
+ * @brief Make an immutable copy of the scripting enums of the nodes of a
+ * tree (FrozenEnumsTable), that is faster to search when a string is
+ * converted to an enum, for instance by LiteralPortsTable.
+ *
+ * Invoke it once all the enums have been registered: enums registered in
+ * the factory afterward are not in the index.
+ */
+[[nodiscard]] inline FrozenEnumsIndex FreezeScriptingEnums(const Tree& tree)
+{
+  FrozenEnumsIndex index;
+  for (auto const& subtree : tree.subtrees)
+  {
+    for (auto const& node : subtree->nodes)
+    {
+      index.add(node.get(), std::as_const(*node).config().enums);
+    }
+  }
+  return index;
+}
+
+/**
+ * @brief The manifests of the nodes of a tree: Tree::manifests, or the manifests
+ * pointed by the nodes if they are shared, as in the trees created by a
+ * TreeTemplate, that leave Tree::manifests empty.
+ */
+[[nodiscard]] inline std::unordered_map<std::string, TreeNodeManifest>
+NodeManifests(const Tree& tree)
+{
+  if (!tree.manifests.empty())
+  {
+    return tree.manifests;
+  }
+  std::unordered_map<std::string, TreeNodeManifest> manifests;
+  for (auto const& subtree : tree.subtrees)
+  {
+    for (auto const& node : subtree->nodes)
+    {
+      if (const TreeNodeManifest* manifest = std::as_const(*node).config().manifest)
+      {
+        manifests.emplace(manifest->registration_ID, *manifest);
+      }
+    }
+  }
+  return manifests;
+}
+
 class Parser;
 
 /**
@@ -364,12 +715,13 @@ public:
 
     constexpr bool param_constructable =
         std::is_constructible<T, const std::string&, const NodeConfig&, ExtraArgs...>::value;
-    constexpr bool has_static_ports_list = has_static_method_providedPorts<T>::value;
+    constexpr bool has_static_ports_list = has_provided_ports<T>::value;
 
     // clang-format off
     static_assert(!(param_constructable && !has_static_ports_list),
                   "[registerNode]: you MUST implement the static method:\n"
-                  "  PortsList providedPorts();\n");
+                  "  PortsList providedPorts();\n"
+                  "or declare the member: static constexpr auto ports = make_ports(...);\n");
 
     static_assert(!(has_static_ports_list && !param_constructable),
                   "[registerNode]: since you have a static method providedPorts(),\n"
@@ -425,6 +777,22 @@ public:
   Tree createTree(const std::string& tree_name,
                   Blackboard::Ptr blackboard = Blackboard::create());
 
+  /**
+   * @brief Create the tree of the XML, using the root blackboard of the given tree,
+   * and replace the given tree with it (see Tree::reload()).
+   * Invoke it between two ticks, from the thread that ticks the tree.
+   */
+  Tree::ReloadStats reloadTreeFromText(Tree& tree, const std::string& text)
+  {
+    return tree.reload(createTreeFromText(text, tree.rootBlackboard()));
+  }
+
+  /// Same as reloadTreeFromText(), reading the XML from a file.
+  Tree::ReloadStats reloadTreeFromFile(Tree& tree, const std::filesystem::path& file_path)
+  {
+    return tree.reload(createTreeFromFile(file_path, tree.rootBlackboard()));
+  }
+
   /// Add a description to a specific manifest. This description will be added
   /// to <TreeNodesModel> with the function writeTreeNodesModelXML()
   void addDescriptionToManifest(const std::string& node_id,
@@ -505,4 +873,7 @@ private:
 
 }   // namespace BT
 
+// definition of Tree::reload()
+#include "behaviortree_cpp/tree_reload.h"
+
 #endif   // BT_FACTORY_H
@@ -0,0 +1,537 @@
+#pragma once
+
+// CoAwaitActionNode requires C++20 coroutines.
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#define BTCPP_HAS_COAWAIT_ACTION_NODE 1
+
+#include <array>
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/utils/timer_wheel.h"
+
+namespace BT
+{
+
+/**
+ * @brief CoroFramePool recycles the memory of the frames of stackless coroutines.
+ *
+ * Frames are grouped by size class; a frame released by a coroutine that
+ * completed is reused by the next one of similar size, so a CoAwaitActionNode
+ * that is activated over and over doesn't allocate memory after the first time.
+ *
+ * A pool can be shared (for instance, by all the nodes of a Tree) and it is
+ * thread-safe.
+ */
+class CoroFramePool
+{
+public:
+  using Ptr = std::shared_ptr<CoroFramePool>;
+
+  static constexpr size_t GRANULARITY = 64;
+  static constexpr size_t NUM_SIZE_CLASSES = 32;
+  /// Frames larger than this are not pooled.
+  static constexpr size_t MAX_POOLED_SIZE = GRANULARITY * NUM_SIZE_CLASSES;
+
+  struct Statistics
+  {
+    size_t allocations = 0;
+    size_t reused = 0;
+    size_t bytes_reserved = 0;
+  };
+
+  CoroFramePool() = default;
+  CoroFramePool(const CoroFramePool&) = delete;
+  CoroFramePool& operator=(const CoroFramePool&) = delete;
+
+  ~CoroFramePool()
+  {
+    for (auto& list : free_lists_)
+    {
+      for (void* ptr : list)
+      {
+        ::operator delete(ptr);
+      }
+    }
+  }
+
+  /// Pool used by the nodes that don't specify one.
+  static const Ptr& defaultPool()
+  {
+    static Ptr pool = std::make_shared<CoroFramePool>();
+    return pool;
+  }
+
+  /// Memory returned is prefixed by a small header that remembers the pool.
+  static void* allocateFrame(size_t size, CoroFramePool* pool)
+  {
+    const size_t total = size + sizeof(Header);
+    void* raw = nullptr;
+    if (pool && total <= MAX_POOLED_SIZE)
+    {
+      raw = pool->allocate(total);
+    }
+    else
+    {
+      pool = nullptr;
+      raw = ::operator new(total);
+    }
+    auto header = static_cast<Header*>(raw);
+    header->pool = pool;
+    header->size = total;
+    return header + 1;
+  }
+
+  static void deallocateFrame(void* ptr) noexcept
+  {
+    auto header = static_cast<Header*>(ptr) - 1;
+    if (header->pool)
+    {
+      header->pool->deallocate(header, header->size);
+    }
+    else
+    {
+      ::operator delete(header);
+    }
+  }
+
+  [[nodiscard]] Statistics statistics() const
+  {
+    std::scoped_lock lk(mutex_);
+    return stats_;
+  }
+
+private:
+  struct alignas(std::max_align_t) Header
+  {
+    CoroFramePool* pool;
+    size_t size;
+  };
+
+  mutable std::mutex mutex_;
+  std::array<std::vector<void*>, NUM_SIZE_CLASSES> free_lists_;
+  Statistics stats_;
+
+  static size_t sizeClass(size_t size)
+  {
+    return (size - 1) / GRANULARITY;
+  }
+
+  void* allocate(size_t size)
+  {
+    const size_t index = sizeClass(size);
+    std::scoped_lock lk(mutex_);
+    stats_.allocations++;
+    auto& list = free_lists_[index];
+    if (!list.empty())
+    {
+      void* ptr = list.back();
+      list.pop_back();
+      stats_.reused++;
+      return ptr;
+    }
+    stats_.bytes_reserved += (index + 1) * GRANULARITY;
+    return ::operator new((index + 1) * GRANULARITY);
+  }
+
+  void deallocate(void* ptr, size_t size) noexcept
+  {
+    std::scoped_lock lk(mutex_);
+    auto& list = free_lists_[sizeClass(size)];
+    try
+    {
+      list.push_back(ptr);
+    }
+    catch (...)
+    {
+      ::operator delete(ptr);
+    }
+  }
+};
+
+/**
+ * @brief Return type of the coroutine CoAwaitActionNode::run().
+ * It owns the coroutine frame.
+ */
+class CoTask
+{
+public:
+  struct promise_type
+  {
+    NodeStatus result = NodeStatus::IDLE;
+    std::exception_ptr exception;
+
+    CoTask get_return_object()
+    {
+      return CoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept
+    {
+      return {};
+    }
+    std::suspend_always final_suspend() noexcept
+    {
+      return {};
+    }
+    void return_value(NodeStatus status)
+    {
+      result = status;
+    }
+    void unhandled_exception()
+    {
+      exception = std::current_exception();
+    }
+
+    // Used when the coroutine is a member function of a class that
+    // provides a CoroFramePool (i.e. CoAwaitActionNode)
+    template <typename NodeT, typename... Args,
+              typename = decltype(std::declval<NodeT&>().coroFramePool())>
+    static void* operator new(std::size_t size, NodeT& node, Args&...)
+    {
+      return CoroFramePool::allocateFrame(size, node.coroFramePool().get());
+    }
+
+    static void* operator new(std::size_t size)
+    {
+      return CoroFramePool::allocateFrame(size, nullptr);
+    }
+
+    static void operator delete(void* ptr) noexcept
+    {
+      CoroFramePool::deallocateFrame(ptr);
+    }
+  };
+
+  using Handle = std::coroutine_handle<promise_type>;
+
+  CoTask() = default;
+  explicit CoTask(Handle handle) : handle_(handle)
+  {}
+
+  CoTask(const CoTask&) = delete;
+  CoTask& operator=(const CoTask&) = delete;
+
+  CoTask(CoTask&& other) noexcept : handle_(std::exchange(other.handle_, {}))
+  {}
+
+  CoTask& operator=(CoTask&& other) noexcept
+  {
+    if (this != &other)
+    {
+      reset();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+
+  ~CoTask()
+  {
+    reset();
+  }
+
+  [[nodiscard]] bool valid() const
+  {
+    return bool(handle_);
+  }
+
+  [[nodiscard]] bool done() const
+  {
+    return handle_ && handle_.done();
+  }
+
+  void resume()
+  {
+    handle_.resume();
+  }
+
+  [[nodiscard]] promise_type& promise()
+  {
+    return handle_.promise();
+  }
+
+  void reset()
+  {
+    if (handle_)
+    {
+      handle_.destroy();
+      handle_ = {};
+    }
+  }
+
+private:
+  Handle handle_;
+};
+
+/**
+ * @brief CoAwaitActionNode is an asynchronous action written as a
+ * C++20 stackless coroutine. Compared with CoroActionNode, there is no
+ * stack to reserve (the frame contains only the variables that live across
+ * a suspension point) and the frames are recycled by a CoroFramePool.
+ *
+ * Override run() and use co_await to suspend the action; the node returns
+ * RUNNING until the coroutine completes with co_return:
+ *
+ *    CoTask run() override
+ *    {
+ *      co_await sleepFor(std::chrono::milliseconds(100));
+ *      while(!goalReached())
+ *      {
+ *        co_await yieldRunning();
+ *      }
+ *      co_return NodeStatus::SUCCESS;
+ *    }
+ *
+ * Awaitable conditions:
+ *
+ * - yieldRunning(): resume at the next tick.
+ * - sleepFor(duration): resume at the first tick after the timeout; the tree
+ *   is woken up with emitWakeUpSignal().
+ * - waitEvent(): resume after notifyEvent() (thread-safe) was called.
+ * - waitUntil(predicate): the predicate is checked at each tick.
+ *
+ * When the node is halted, the coroutine is destroyed and onHalted() invoked.
+ */
+class CoAwaitActionNode : public ActionNodeBase
+{
+public:
+  CoAwaitActionNode(const std::string& name, const NodeConfig& config) :
+    CoAwaitActionNode(name, config, CoroFramePool::defaultPool())
+  {}
+
+  CoAwaitActionNode(const std::string& name, const NodeConfig& config,
+                    CoroFramePool::Ptr pool) :
+    ActionNodeBase(name, config), pool_(pool ? std::move(pool) : CoroFramePool::defaultPool())
+  {}
+
+  ~CoAwaitActionNode() override
+  {
+    destroyCoroutine();
+  }
+
+  /// The coroutine implemented by the user.
+  virtual CoTask run() = 0;
+
+  /// Invoked by halt(), after the coroutine has been destroyed.
+  virtual void onHalted()
+  {}
+
+  /// Wake up the coroutine waiting in waitEvent(). Thread-safe.
+  void notifyEvent()
+  {
+    events_.fetch_add(1, std::memory_order_acq_rel);
+    emitWakeUpSignal();
+  }
+
+  const CoroFramePool::Ptr& coroFramePool() const
+  {
+    return pool_;
+  }
+
+  // Do NOT remove the "final" keyword.
+  NodeStatus tick() override final
+  {
+    if (!task_.valid())
+    {
+      task_ = run();
+      wait_ = {};
+    }
+    else if (!isReady())
+    {
+      return NodeStatus::RUNNING;
+    }
+
+    wait_ = {};
+    task_.resume();
+
+    if (task_.done())
+    {
+      auto& promise = task_.promise();
+      const auto exception = promise.exception;
+      const auto result = promise.result;
+      destroyCoroutine();
+      if (exception)
+      {
+        std::rethrow_exception(exception);
+      }
+      if (!isStatusCompleted(result))
+      {
+        throw LogicError("CoAwaitActionNode [", name(),
+                         "]: co_return must return SUCCESS or FAILURE");
+      }
+      return result;
+    }
+    return NodeStatus::RUNNING;
+  }
+
+  void halt() override final
+  {
+    destroyCoroutine();
+    onHalted();
+  }
+
+protected:
+  /// Awaitable: resume at the next tick
+  auto yieldRunning()
+  {
+    return Awaiter{this, WaitKind::YIELD};
+  }
+
+  /// Awaitable: resume when the timeout expires
+  template <class Rep, class Period>
+  auto sleepFor(std::chrono::duration<Rep, Period> timeout)
+  {
+    Awaiter awaiter{this, WaitKind::TIMER};
+    awaiter.timeout = std::chrono::duration_cast<std::chrono::milliseconds>(timeout);
+    return awaiter;
+  }
+
+  /// Awaitable: resume when notifyEvent() is called
+  auto waitEvent()
+  {
+    return Awaiter{this, WaitKind::EVENT};
+  }
+
+  /// Awaitable: resume as soon as predicate() returns true
+  auto waitUntil(std::function<bool()> predicate)
+  {
+    Awaiter awaiter{this, WaitKind::PREDICATE};
+    awaiter.predicate = std::move(predicate);
+    return awaiter;
+  }
+
+private:
+  enum class WaitKind
+  {
+    NONE,
+    YIELD,
+    TIMER,
+    EVENT,
+    PREDICATE
+  };
+
+  // shared with the handler of the timer, that may outlive this node
+  struct TimerState
+  {
+    std::mutex mutex;
+    CoAwaitActionNode* node = nullptr;
+    std::atomic_bool fired = false;
+    uint64_t timer_id = 0;
+  };
+
+  struct WaitState
+  {
+    WaitKind kind = WaitKind::NONE;
+    uint64_t event_count = 0;
+    std::shared_ptr<TimerState> timer;
+    std::function<bool()> predicate;
+  };
+
+  struct Awaiter
+  {
+    Awaiter(CoAwaitActionNode* node_ptr, WaitKind wait_kind) : node(node_ptr), kind(wait_kind)
+    {}
+
+    CoAwaitActionNode* node;
+    WaitKind kind;
+    std::chrono::milliseconds timeout = {};
+    std::function<bool()> predicate;
+
+    bool await_ready() const noexcept
+    {
+      return kind == WaitKind::TIMER && timeout.count() <= 0;
+    }
+
+    void await_suspend(std::coroutine_handle<>)
+    {
+      node->suspend(*this);
+    }
+
+    void await_resume() const noexcept
+    {}
+  };
+
+  CoroFramePool::Ptr pool_;
+  CoTask task_;
+  WaitState wait_;
+  std::atomic<uint64_t> events_ = 0;
+
+  static SharedTimerQueue& timerQueue()
+  {
+    static SharedTimerQueue queue(TimerWheel::global());
+    return queue;
+  }
+
+  void suspend(Awaiter& awaiter)
+  {
+    wait_ = {};
+    wait_.kind = awaiter.kind;
+    switch (awaiter.kind)
+    {
+      case WaitKind::TIMER: {
+        auto state = std::make_shared<TimerState>();
+        state->node = this;
+        wait_.timer = state;
+        state->timer_id = timerQueue().add(awaiter.timeout, [state](bool aborted) {
+          if (aborted)
+          {
+            return;
+          }
+          std::scoped_lock lk(state->mutex);
+          state->fired = true;
+          if (state->node)
+          {
+            state->node->emitWakeUpSignal();
+          }
+        });
+      }
+      break;
+      case WaitKind::EVENT:
+        wait_.event_count = events_.load(std::memory_order_acquire);
+        break;
+      case WaitKind::PREDICATE:
+        wait_.predicate = std::move(awaiter.predicate);
+        break;
+      default:
+        break;
+    }
+  }
+
+  bool isReady() const
+  {
+    switch (wait_.kind)
+    {
+      case WaitKind::TIMER:
+        return wait_.timer->fired.load();
+      case WaitKind::EVENT:
+        return events_.load(std::memory_order_acquire) != wait_.event_count;
+      case WaitKind::PREDICATE:
+        return wait_.predicate();
+      default:
+        return true;
+    }
+  }
+
+  void destroyCoroutine()
+  {
+    if (wait_.timer)
+    {
+      std::scoped_lock lk(wait_.timer->mutex);
+      wait_.timer->node = nullptr;
+      timerQueue().cancel(wait_.timer->timer_id);
+    }
+    wait_ = {};
+    task_.reset();
+  }
+};
+
+}   // namespace BT
+
+#endif
@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "behaviortree_cpp/control_node.h"
+#include "behaviortree_cpp/utils/executor.hpp"
+
+namespace BT
+{
+/**
+ * @brief ConcurrentParallelNode has the same ports and thresholds of
+ * ParallelNode, but the children that are not completed yet are ticked
+ * __at the same time__, in the threads of an Executor. The tick returns
+ * when all of them returned (join at the tick boundary), therefore it is
+ * useful when the children are synchronous and CPU-heavy.
+ *
+ * One of the children is ticked by the calling thread, that also ticks the
+ * children not yet started by the executor when it finishes: a
+ * ConcurrentParallel never waits for a free worker, even when it is
+ * nested or the executor is busy.
+ *
+ * The statuses are accumulated in the order of the children, after the join,
+ * with the same rules of ParallelNode. The only difference is that all
+ * the pending children are ticked, even if the first ones already reached
+ * a threshold; they are halted afterwards.
+ *
+ * Rules for the children, since they are executed concurrently:
+ *
+ * - Blackboard::get/set and the ports are thread-safe, but two children
+ *   must not write the same entry, nor read an entry written by a sibling:
+ *   the order of these accesses is undefined. Use different keys and
+ *   combine the results after the parallel node.
+ * - getLockedPortContent() locks the entry: don't hold it while waiting
+ *   for something that a sibling does.
+ * - the callbacks subscribed to the status of the children (loggers,
+ *   observers) are invoked by the worker threads.
+ * - halt() is always called by the thread that ticks the tree,
+ *   never while the children are running.
+ *
+ * This node is not registered by default:
+ *
+ *   factory.registerNodeType<ConcurrentParallelNode>("ConcurrentParallel");
+ *
+ * The executor can be passed as an extra argument of registerNodeType,
+ * otherwise DefaultExecutor() is used.
+ */
+class ConcurrentParallelNode : public ControlNode
+{
+public:
+  ConcurrentParallelNode(const std::string& name, const NodeConfig& config) :
+    ConcurrentParallelNode(name, config, DefaultExecutor())
+  {}
+
+  ConcurrentParallelNode(const std::string& name, const NodeConfig& config,
+                         Executor::Ptr executor) :
+    ControlNode(name, config), executor_(std::move(executor))
+  {
+    if (!executor_)
+    {
+      throw RuntimeError("ConcurrentParallelNode: invalid executor");
+    }
+    setRegistrationID("ConcurrentParallel");
+  }
+
+  ~ConcurrentParallelNode() override = default;
+
+  static PortsList providedPorts()
+  {
+    return {InputPort<int>(THRESHOLD_SUCCESS, -1,
+                           "number of children which need to succeed to trigger a "
+                           "SUCCESS"),
+            InputPort<int>(THRESHOLD_FAILURE, 1,
+                           "number of children which need to fail to trigger a FAILURE")};
+  }
+
+  void halt() override
+  {
+    clear();
+    ControlNode::halt();
+  }
+
+  [[nodiscard]] size_t successThreshold() const
+  {
+    return resolveThreshold(success_threshold_);
+  }
+
+  [[nodiscard]] size_t failureThreshold() const
+  {
+    return resolveThreshold(failure_threshold_);
+  }
+
+  const Executor::Ptr& executor() const
+  {
+    return executor_;
+  }
+
+private:
+  static constexpr const char* THRESHOLD_SUCCESS = "success_count";
+  static constexpr const char* THRESHOLD_FAILURE = "failure_count";
+
+  // the children ticked by one tick(), shared with the tasks of the executor
+  struct Batch
+  {
+    explicit Batch(std::vector<TreeNode*> nodes) :
+      children(std::move(nodes))
+      , claimed(std::make_unique<std::atomic_bool[]>(children.size()))
+      , statuses(children.size(), NodeStatus::IDLE)
+      , errors(children.size())
+      , remaining(children.size())
+    {}
+
+    std::vector<TreeNode*> children;
+    std::unique_ptr<std::atomic_bool[]> claimed;
+    // each element is written by the thread that claimed the child
+    std::vector<NodeStatus> statuses;
+    std::vector<std::exception_ptr> errors;
+
+    std::atomic<size_t> remaining;
+    std::mutex mutex;
+    std::condition_variable done;
+
+    // tick the child k, unless another thread did it already
+    void run(size_t k)
+    {
+      if (claimed[k].exchange(true))
+      {
+        return;
+      }
+      try
+      {
+        statuses[k] = children[k]->executeTick();
+      }
+      catch (...)
+      {
+        errors[k] = std::current_exception();
+      }
+      if (remaining.fetch_sub(1) == 1)
+      {
+        std::scoped_lock lk(mutex);
+        done.notify_all();
+      }
+    }
+
+    void join()
+    {
+      std::unique_lock lk(mutex);
+      done.wait(lk, [this] { return remaining.load() == 0; });
+    }
+  };
+
+  Executor::Ptr executor_;
+  int success_threshold_ = -1;
+  int failure_threshold_ = 1;
+
+  // packed: one bit for each child
+  std::vector<bool> completed_;
+  size_t success_count_ = 0;
+  size_t failure_count_ = 0;
+
+  size_t resolveThreshold(int threshold) const
+  {
+    if (threshold < 0)
+    {
+      return size_t(std::max(int(children_nodes_.size()) + threshold + 1, 0));
+    }
+    return size_t(threshold);
+  }
+
+  void clear()
+  {
+    completed_.assign(children_nodes_.size(), false);
+    success_count_ = 0;
+    failure_count_ = 0;
+  }
+
+  NodeStatus tick() override
+  {
+    if (!getInput(THRESHOLD_SUCCESS, success_threshold_))
+    {
+      throw RuntimeError("Missing parameter [", THRESHOLD_SUCCESS,
+                         "] in ConcurrentParallelNode");
+    }
+    if (!getInput(THRESHOLD_FAILURE, failure_threshold_))
+    {
+      throw RuntimeError("Missing parameter [", THRESHOLD_FAILURE,
+                         "] in ConcurrentParallelNode");
+    }
+
+    const size_t children_count = children_nodes_.size();
+    if (children_count < successThreshold())
+    {
+      throw LogicError("Number of children is less than threshold. Can never succeed.");
+    }
+    if (children_count < failureThreshold())
+    {
+      throw LogicError("Number of children is less than threshold. Can never fail.");
+    }
+    if (completed_.size() != children_count)
+    {
+      clear();
+    }
+    setStatus(NodeStatus::RUNNING);
+
+    std::vector<size_t> indices;
+    std::vector<TreeNode*> pending;
+    for (size_t i = 0; i < children_count; i++)
+    {
+      if (!completed_[i])
+      {
+        indices.push_back(i);
+        pending.push_back(children_nodes_[i]);
+      }
+    }
+
+    auto batch = std::make_shared<Batch>(std::move(pending));
+    // the tasks keep the batch alive: they may start after the join,
+    // when the child was already ticked by this thread
+    for (size_t k = 1; k < indices.size(); k++)
+    {
+      executor_->execute([batch, k]() { batch->run(k); });
+    }
+    for (size_t k = 0; k < indices.size(); k++)
+    {
+      batch->run(k);
+    }
+    batch->join();
+
+    for (const auto& error : batch->errors)
+    {
+      if (error)
+      {
+        clear();
+        resetChildren();
+        std::rethrow_exception(error);
+      }
+    }
+
+    size_t skipped_count = 0;
+    const size_t required_success_count = successThreshold();
+    for (size_t k = 0; k < indices.size(); k++)
+    {
+      switch (batch->statuses[k])
+      {
+        case NodeStatus::SKIPPED:
+          skipped_count++;
+          break;
+        case NodeStatus::SUCCESS:
+          completed_[indices[k]] = true;
+          success_count_++;
+          break;
+        case NodeStatus::FAILURE:
+          completed_[indices[k]] = true;
+          failure_count_++;
+          break;
+        case NodeStatus::RUNNING:
+          break;
+        case NodeStatus::IDLE:
+          throw LogicError("[", name(), "]: A children should not return IDLE");
+      }
+
+      if (success_count_ >= required_success_count ||
+          (success_threshold_ < 0 &&
+           (success_count_ + skipped_count) >= required_success_count))
+      {
+        clear();
+        resetChildren();
+        return NodeStatus::SUCCESS;
+      }
+      // It fails if it is not possible to succeed anymore or if
+      // number of failures are equal to failure_threshold_
+      if (((children_count - failure_count_) < required_success_count) ||
+          (failure_count_ == failureThreshold()))
+      {
+        clear();
+        resetChildren();
+        return NodeStatus::FAILURE;
+      }
+    }
+    // Skip if ALL the nodes have been skipped
+    return (skipped_count == children_count) ? NodeStatus::SKIPPED : NodeStatus::RUNNING;
+  }
+};
+
+}   // namespace BT
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp/controls/switch_node.h"
+#include "behaviortree_cpp/utils/parse_numbers.hpp"
+
+namespace BT
+{
+/**
+ * @brief TypedSwitchNode has the same ports and behavior of SwitchNode,
+ * but the cases are converted once, into a table, instead of being read
+ * and compared as strings at each tick.
+ *
+ * Cases and variable are compared as integers when they are numbers or
+ * the names of scripting enums, otherwise as strings. For this reason
+ * it works with integer and enum variables without any string conversion:
+ *
+ * <TypedSwitch3 variable="{mission_state}" case_1="IDLE" case_2="MOVING" case_3="42">
+ *
+ * The table is built when the node is created; cases that contain a
+ * blackboard pointer are still read at each tick.
+ * This node is not registered by default:
+ *
+ *   factory.registerNodeType<TypedSwitchNode<20>>("TypedSwitch20");
+ */
+template <size_t NUM_CASES>
+class TypedSwitchNode : public ControlNode
+{
+public:
+  TypedSwitchNode(const std::string& name, const BT::NodeConfig& config) :
+    ControlNode::ControlNode(name, config)
+  {
+    setRegistrationID("TypedSwitch");
+    buildTable();
+  }
+
+  ~TypedSwitchNode() override = default;
+
+  void halt() override
+  {
+    running_child_ = -1;
+    ControlNode::halt();
+  }
+
+  static PortsList providedPorts()
+  {
+    return SwitchNode<NUM_CASES>::providedPorts();
+  }
+
+private:
+  // value of a case or of the variable
+  struct Key
+  {
+    bool is_integer = false;
+    int64_t integer = 0;
+    std::string text;
+
+    bool operator==(const Key& other) const
+    {
+      return is_integer == other.is_integer &&
+             (is_integer ? integer == other.integer : text == other.text);
+    }
+  };
+
+  int running_child_ = -1;
+
+  // jump table, used when the integer cases are close to each other
+  std::vector<int> jump_table_;
+  int64_t jump_offset_ = 0;
+  std::unordered_map<int64_t, int> integer_cases_;
+  std::unordered_map<std::string, int> string_cases_;
+  // cases that contain a blackboard pointer, in increasing order
+  std::vector<int> dynamic_cases_;
+
+  static std::string caseKey(int index)
+  {
+    return "case_" + std::to_string(index + 1);
+  }
+
+  Key makeKey(const std::string& str) const
+  {
+    Key key;
+    const int* enum_value = nullptr;
+    if (config().enums)
+    {
+      auto it = config().enums->find(str);
+      enum_value = (it != config().enums->end()) ? &it->second : nullptr;
+    }
+    if (enum_value)
+    {
+      key.is_integer = true;
+      key.integer = *enum_value;
+    }
+    else if (auto number = ParseNumber<int64_t>(str))
+    {
+      key.is_integer = true;
+      key.integer = number.value();
+    }
+    else
+    {
+      key.text = str;
+    }
+    return key;
+  }
+
+  void buildTable()
+  {
+    for (int index = 0; index < int(NUM_CASES); index++)
+    {
+      auto it = config().input_ports.find(caseKey(index));
+      if (it == config().input_ports.end())
+      {
+        continue;
+      }
+      if (isBlackboardPointer(it->second))
+      {
+        dynamic_cases_.push_back(index);
+        continue;
+      }
+      // as in SwitchNode, the first matching case wins
+      const Key key = makeKey(it->second);
+      if (key.is_integer)
+      {
+        integer_cases_.emplace(key.integer, index);
+      }
+      else
+      {
+        string_cases_.emplace(key.text, index);
+      }
+    }
+
+    if (!integer_cases_.empty())
+    {
+      auto [min_it, max_it] =
+          std::minmax_element(integer_cases_.begin(), integer_cases_.end(),
+                              [](const auto& a, const auto& b) { return a.first < b.first; });
+      const uint64_t range = uint64_t(max_it->first) - uint64_t(min_it->first);
+      if (range < 4 * NUM_CASES)
+      {
+        jump_offset_ = min_it->first;
+        jump_table_.assign(size_t(range + 1), -1);
+        for (const auto& [value, index] : integer_cases_)
+        {
+          jump_table_[size_t(value - jump_offset_)] = index;
+        }
+      }
+    }
+  }
+
+  std::optional<Key> readVariable()
+  {
+    auto it = config().input_ports.find("variable");
+    if (it == config().input_ports.end())
+    {
+      return std::nullopt;
+    }
+    if (!isBlackboardPointer(it->second))
+    {
+      return makeKey(it->second);
+    }
+
+    AnyPtrLocked any_ref = getLockedPortContent("variable");
+    if (!any_ref || any_ref.get()->empty())
+    {
+      return std::nullopt;
+    }
+    const Any& any = *any_ref.get();
+    if (auto integer = any.castPtr<int64_t>())
+    {
+      return Key{true, *integer, {}};
+    }
+    if (auto uinteger = any.castPtr<uint64_t>())
+    {
+      return Key{true, int64_t(*uinteger), {}};
+    }
+    if (auto real = any.castPtr<double>())
+    {
+      // only integral values can match a case
+      if (!(std::abs(*real) < 9.2e18) || std::trunc(*real) != *real)
+      {
+        return std::nullopt;
+      }
+      return Key{true, int64_t(*real), {}};
+    }
+    try
+    {
+      return makeKey(any.cast<std::string>());
+    }
+    catch (std::exception&)
+    {
+      return std::nullopt;
+    }
+  }
+
+  int staticMatch(const Key& key) const
+  {
+    if (!key.is_integer)
+    {
+      auto it = string_cases_.find(key.text);
+      return (it != string_cases_.end()) ? it->second : int(NUM_CASES);
+    }
+    if (!jump_table_.empty())
+    {
+      const uint64_t offset = uint64_t(key.integer) - uint64_t(jump_offset_);
+      if (offset < jump_table_.size() && jump_table_[size_t(offset)] >= 0)
+      {
+        return jump_table_[size_t(offset)];
+      }
+      return int(NUM_CASES);
+    }
+    auto it = integer_cases_.find(key.integer);
+    return (it != integer_cases_.end()) ? it->second : int(NUM_CASES);
+  }
+
+  int matchIndex()
+  {
+    auto key = readVariable();
+    if (!key)
+    {
+      return int(NUM_CASES);
+    }
+    int match_index = staticMatch(*key);
+    for (int index : dynamic_cases_)
+    {
+      if (index >= match_index)
+      {
+        break;
+      }
+      auto value = getInput<std::string>(caseKey(index));
+      if (value && makeKey(value.value()) == *key)
+      {
+        match_index = index;
+        break;
+      }
+    }
+    return match_index;
+  }
+
+  NodeStatus tick() override
+  {
+    if (childrenCount() != NUM_CASES + 1)
+    {
+      throw LogicError("Wrong number of children in TypedSwitchNode; "
+                       "must be (num_cases + default)");
+    }
+
+    const int match_index = matchIndex();
+
+    // if another one was running earlier, halt it
+    if (running_child_ != -1 && running_child_ != match_index)
+    {
+      haltChild(running_child_);
+    }
+
+    auto& selected_child = children_nodes_[match_index];
+    NodeStatus ret = selected_child->executeTick();
+    if (ret == NodeStatus::SKIPPED)
+    {
+      running_child_ = -1;
+      return NodeStatus::SKIPPED;
+    }
+    else if (ret == NodeStatus::RUNNING)
+    {
+      running_child_ = match_index;
+    }
+    else
+    {
+      resetChildren();
+      running_child_ = -1;
+    }
+    return ret;
+  }
+};
+
+}   // namespace BT
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+#include "behaviortree_cpp/control_node.h"
+#include "behaviortree_cpp/scripting/script_cache.hpp"
+
+namespace BT
+{
+/**
+ * @brief The UtilitySelector executes the child with the highest score.
+ * The score of each child is a script (or a blackboard entry, or a number)
+ * that returns a number:
+ *
+<UtilitySelector3 score_1="battery_low ? 100 : 0" score_2="{explore_utility}"
+                  score_3="10" hysteresis="5">
+   <GoCharging/>
+   <Explore/>
+   <Idle/>
+</UtilitySelector3>
+ *
+ * The scores are parsed once, on the first tick, and evaluated at every tick.
+ * If a ScriptCache is passed to the constructor, the nodes with the same
+ * scores share the parsed functions.
+ *
+ * While a child is RUNNING, it is interrupted only if another one has a
+ * score higher by more than "hysteresis". Ties are won by the first child.
+ * The node returns the status of the selected child, as SwitchNode does.
+ *
+ * This node is not registered by default:
+ *
+ *   factory.registerNodeType<UtilitySelectorNode<3>>("UtilitySelector3");
+ *   // or, sharing the scripts
+ *   extensions.registerNodeType<UtilitySelectorNode<3>>("UtilitySelector3",
+ *                                                       extensions.scriptCache());
+ */
+template <size_t NUM_CHILDREN>
+class UtilitySelectorNode : public ControlNode
+{
+public:
+  UtilitySelectorNode(const std::string& name, const BT::NodeConfig& config,
+                      ScriptCache::Ptr cache = {}) :
+    ControlNode::ControlNode(name, config), cache_(std::move(cache))
+  {
+    setRegistrationID("UtilitySelector");
+  }
+
+  ~UtilitySelectorNode() override = default;
+
+  void halt() override
+  {
+    running_child_ = -1;
+    ControlNode::halt();
+  }
+
+  static PortsList providedPorts()
+  {
+    PortsList ports;
+    ports.insert(BT::InputPort<double>("hysteresis", 0.0,
+                                       "margin needed to interrupt the RUNNING child"));
+    for (unsigned i = 0; i < NUM_CHILDREN; i++)
+    {
+      char score_str[20];
+      snprintf(score_str, sizeof(score_str), "score_%u", i + 1);
+      ports.insert(BT::InputPort<std::string>(score_str, "script returning the score "
+                                                         "of the child"));
+    }
+    return ports;
+  }
+
+  /// Scores computed by the last tick.
+  [[nodiscard]] const std::array<double, NUM_CHILDREN>& scores() const
+  {
+    return scores_;
+  }
+
+private:
+  ScriptCache::Ptr cache_;
+  int running_child_ = -1;
+  bool compiled_ = false;
+  std::array<ScriptFunction, NUM_CHILDREN> score_scripts_;
+  std::array<double, NUM_CHILDREN> scores_ = {};
+
+  void compileScores()
+  {
+    for (unsigned i = 0; i < NUM_CHILDREN; i++)
+    {
+      char score_key[20];
+      snprintf(score_key, sizeof(score_key), "score_%u", i + 1);
+      StringView code = getRawPortValue(score_key);
+      // "{key}" is the same of the script "key"
+      StringView stripped;
+      if (isBlackboardPointer(code, &stripped))
+      {
+        code = stripped;
+      }
+      if (code.empty())
+      {
+        throw RuntimeError("UtilitySelector [", name(), "]: missing port [", score_key, "]");
+      }
+      auto executor = cache_ ? cache_->get(std::string(code)) : ParseScript(std::string(code));
+      if (!executor)
+      {
+        throw RuntimeError("UtilitySelector [", name(), "]: error in [", score_key,
+                           "]: ", executor.error());
+      }
+      score_scripts_[i] = executor.value();
+    }
+    compiled_ = true;
+  }
+
+  virtual BT::NodeStatus tick() override;
+};
+
+template <size_t NUM_CHILDREN>
+inline NodeStatus UtilitySelectorNode<NUM_CHILDREN>::tick()
+{
+  if (childrenCount() != NUM_CHILDREN)
+  {
+    throw LogicError("Wrong number of children in UtilitySelector; "
+                     "must be equal to the number of scores");
+  }
+  if (!compiled_)
+  {
+    compileScores();
+  }
+
+  Ast::Environment env = {config().blackboard, config().enums};
+  int best = 0;
+  for (size_t i = 0; i < NUM_CHILDREN; i++)
+  {
+    scores_[i] = score_scripts_[i](env).template cast<double>();
+    if (scores_[i] > scores_[best])
+    {
+      best = int(i);
+    }
+  }
+
+  if (running_child_ != -1 && running_child_ != best)
+  {
+    const double hysteresis = getInput<double>("hysteresis").value();
+    if (scores_[best] > scores_[running_child_] + hysteresis)
+    {
+      haltChild(running_child_);
+    }
+    else
+    {
+      best = running_child_;
+    }
+  }
+
+  setStatus(NodeStatus::RUNNING);
+  NodeStatus ret = children_nodes_[best]->executeTick();
+  if (ret == NodeStatus::RUNNING)
+  {
+    running_child_ = best;
+  }
+  else
+  {
+    resetChildren();
+    running_child_ = -1;
+  }
+  return ret;
+}
+
+}   // namespace BT
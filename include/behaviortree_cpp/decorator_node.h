@@ -8,6 +8,9 @@ namespace BT
 class DecoratorNode : public TreeNode
 {
 protected:
+  // Tree::reload() moves the subtrees
+  friend class Tree;
+
   TreeNode* child_node_;
 
 public:
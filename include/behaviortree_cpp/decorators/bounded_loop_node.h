@@ -0,0 +1,110 @@
+#pragma once
+
+#include "behaviortree_cpp/decorators/loop_node.h"
+#include "behaviortree_cpp/utils/bounded_queue.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief Same as LoopNode, but the queue is a SharedBoundedQueue<T>:
+ * producers running in other threads may push into it while the loop
+ * consumes it, and popping an element takes no lock.
+ *
+ * If the port "queue" is a string, it is converted with
+ * convertFromString<SharedQueue<T>> and copied into a BoundedQueue.
+ *
+ * Not registered by the factory, register it with the type you need:
+ *
+ *   factory.registerNodeType<BoundedLoopNode<Pose>>("BoundedLoopPose");
+ */
+template <typename T = Any>
+class BoundedLoopNode : public DecoratorNode
+{
+  bool child_running_ = false;
+  SharedBoundedQueue<T> static_queue_;
+  SharedBoundedQueue<T> current_queue_;
+
+public:
+  BoundedLoopNode(const std::string& name, const NodeConfig& config) :
+    DecoratorNode(name, config)
+  {
+    auto raw_port = getRawPortValue("queue");
+    if(!isBlackboardPointer(raw_port))
+    {
+      auto items = convertFromString<SharedQueue<T>>(raw_port);
+      static_queue_ = std::make_shared<BoundedQueue<T>>(items->size());
+      for(auto& item : *items)
+      {
+        static_queue_->tryPush(std::move(item));
+      }
+    }
+  }
+
+  NodeStatus tick() override
+  {
+    bool popped = false;
+    if(status() == NodeStatus::IDLE)
+    {
+      child_running_ = false;
+      if(static_queue_)
+      {
+        current_queue_ = static_queue_;
+      }
+    }
+
+    // Pop value from queue, if the child is not RUNNING.
+    // The queue is thread-safe: the port doesn't need to stay locked
+    if(!child_running_)
+    {
+      if(!static_queue_)
+      {
+        if(auto queue = getInput<SharedBoundedQueue<T>>("queue"))
+        {
+          current_queue_ = std::move(queue.value());
+        }
+      }
+      T value;
+      if(current_queue_ && current_queue_->tryPop(value))
+      {
+        popped = true;
+        setOutput("value", value);
+      }
+    }
+
+    if(!popped && !child_running_)
+    {
+      return getInput<NodeStatus>("if_empty").value();
+    }
+
+    if(status() == NodeStatus::IDLE)
+    {
+      setStatus(NodeStatus::RUNNING);
+    }
+
+    NodeStatus child_state = child_node_->executeTick();
+    child_running_ = (child_state == NodeStatus::RUNNING);
+
+    if(isStatusCompleted(child_state))
+    {
+      resetChild();
+    }
+
+    if(child_state == NodeStatus::FAILURE)
+    {
+      return NodeStatus::FAILURE;
+    }
+    return NodeStatus::RUNNING;
+  }
+
+  static PortsList providedPorts()
+  {
+    return {BidirectionalPort<SharedBoundedQueue<T>>("queue"),
+            InputPort<NodeStatus>("if_empty", NodeStatus::SUCCESS,
+                                  "Status to return if queue is empty: "
+                                  "SUCCESS, FAILURE, SKIPPED"),
+            OutputPort<T>("value")};
+  }
+};
+
+}   // namespace BT
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "behaviortree_cpp/decorator_node.h"
+#include "behaviortree_cpp/utils/tick_budget.hpp"
+
+namespace BT
+{
+/**
+ * @brief The BudgetYieldNode is a yield point: when the TickBudget of the
+ * current tick is spent, it returns RUNNING instead of starting its child,
+ * that will be started by one of the following ticks.
+ *
+ * A child that is already RUNNING is always ticked.
+ * Inside a Sequence, the work after the yield point is postponed:
+ *
+ *  <Sequence>
+ *     <ComputePath/>
+ *     <BudgetYield>
+ *        <SmoothPath/>
+ *     </BudgetYield>
+ *  </Sequence>
+ *
+ * It doesn't call emitWakeUpSignal(): it is meant for trees ticked
+ * periodically, for instance by TreeExecutor::runAtFixedRate() or by
+ * a control loop that calls Tree::tickOnce(deadline).
+ *
+ * This node is not registered by default:
+ *
+ *   factory.registerNodeType<BudgetYieldNode>("BudgetYield");
+ */
+class BudgetYieldNode : public DecoratorNode
+{
+public:
+  BudgetYieldNode(const std::string& name, const NodeConfig& config) :
+    DecoratorNode(name, config)
+  {
+    setRegistrationID("BudgetYield");
+  }
+
+  static PortsList providedPorts()
+  {
+    return {};
+  }
+
+  /// Number of times the child was postponed.
+  [[nodiscard]] uint64_t yieldsCount() const
+  {
+    return yields_;
+  }
+
+private:
+  uint64_t yields_ = 0;
+
+  virtual BT::NodeStatus tick() override;
+};
+
+//------------ implementation ----------------------------
+
+inline NodeStatus BudgetYieldNode::tick()
+{
+  if(child_node_->status() != NodeStatus::RUNNING && TickBudget::expired())
+  {
+    yields_++;
+    return NodeStatus::RUNNING;
+  }
+
+  setStatus(NodeStatus::RUNNING);
+
+  const NodeStatus child_status = child_node_->executeTick();
+
+  if(isStatusCompleted(child_status))
+  {
+    resetChild();
+  }
+  return child_status;
+}
+}   // namespace BT
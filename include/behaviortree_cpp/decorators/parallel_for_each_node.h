@@ -0,0 +1,373 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/decorators/loop_node.h"
+#include "behaviortree_cpp/utils/executor.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief ParallelForEachNode pops the elements of a SharedQueue<T>, like
+ * LoopNode, but processes up to "max_concurrency" of them at the same time.
+ *
+ * The child must be a SubTree: it is the prototype of the trees that
+ * process the items, and it is never ticked. Up to "max_concurrency" copies
+ * of that subtree are created (and reused for the following items), each one
+ * with its own blackboard, where the item is written at the key "item".
+ * The other ports of the SubTree are remapped as usual, _autoremap included.
+ * The copies are ticked until completion by the threads of an Executor.
+ *
+ *  <ParallelForEach queue="{targets}" item="target" max_concurrency="4">
+ *     <SubTree ID="Inspect" report="{report}"/>
+ *  </ParallelForEach>
+ *
+ * The node returns RUNNING until:
+ *
+ * - the number of FAILURE exceeds "max_failures" (a negative value: never):
+ *   the other copies are halted, and the node returns FAILURE;
+ * - "success_count" items succeeded (if greater than 0): the other copies
+ *   are halted, the remaining items are left in the queue and the node
+ *   returns SUCCESS;
+ * - all the items were processed: the node returns SUCCESS.
+ *
+ * The copies share the parent blackboard through the remapping: they must
+ * not write the same entries (see ConcurrentParallelNode). Each copy blocks
+ * a thread of the executor while it runs; use a dedicated Executor if the
+ * items take a long time.
+ *
+ * The node needs the factory to create the copies:
+ *
+ *   factory.registerNodeType<ParallelForEachNode<Pose2D>>("ParallelForEach", &factory);
+ *
+ * The Executor can be passed after the factory, otherwise DefaultExecutor() is used.
+ */
+template <typename T = Any>
+class ParallelForEachNode : public DecoratorNode
+{
+public:
+  ParallelForEachNode(const std::string& name, const NodeConfig& config,
+                      BehaviorTreeFactory* factory) :
+    ParallelForEachNode(name, config, factory, DefaultExecutor())
+  {}
+
+  ParallelForEachNode(const std::string& name, const NodeConfig& config,
+                      BehaviorTreeFactory* factory, Executor::Ptr executor) :
+    DecoratorNode(name, config), factory_(factory), executor_(std::move(executor))
+  {
+    if (!factory_ || !executor_)
+    {
+      throw RuntimeError("ParallelForEachNode: invalid factory or executor");
+    }
+    setRegistrationID("ParallelForEach");
+    auto raw_port = getRawPortValue("queue");
+    if (!isBlackboardPointer(raw_port))
+    {
+      static_queue_ = convertFromString<SharedQueue<T>>(raw_port);
+    }
+  }
+
+  ~ParallelForEachNode() override
+  {
+    stopCopies();
+  }
+
+  static PortsList providedPorts()
+  {
+    return {BidirectionalPort<SharedQueue<T>>("queue"),
+            InputPort<std::string>("item", "item",
+                                   "key of the item in the blackboard of each copy"),
+            InputPort<unsigned>("max_concurrency", 0,
+                                "items processed at the same time. "
+                                "0: hardware_concurrency()"),
+            InputPort<int>("success_count", 0,
+                           "number of successful items that completes the node. "
+                           "0: all the items"),
+            InputPort<int>("max_failures", 0,
+                           "number of failed items tolerated. Negative: unlimited"),
+            InputPort<NodeStatus>("if_empty", NodeStatus::SUCCESS,
+                                  "Status to return if queue is empty: "
+                                  "SUCCESS, FAILURE, SKIPPED")};
+  }
+
+  void halt() override
+  {
+    stopCopies();
+    DecoratorNode::halt();
+  }
+
+private:
+  // a copy of the subtree, with its own blackboard
+  struct Copy
+  {
+    Tree tree;
+    Blackboard::Ptr blackboard;
+    std::atomic_bool halt_requested = false;
+    // protected by mutex_
+    bool running = false;
+    bool finished = false;
+    NodeStatus result = NodeStatus::IDLE;
+    std::exception_ptr error;
+  };
+
+  BehaviorTreeFactory* factory_;
+  Executor::Ptr executor_;
+  SharedQueue<T> static_queue_;
+  SharedQueue<T> current_queue_;
+  std::vector<std::unique_ptr<Copy>> copies_;
+  size_t success_count_ = 0;
+  size_t failure_count_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable stopped_;
+
+  const SubTreeNode& prototype() const
+  {
+    auto subtree = dynamic_cast<const SubTreeNode*>(child_node_);
+    if (!subtree)
+    {
+      throw RuntimeError("ParallelForEach [", name(), "]: the child must be a SubTree");
+    }
+    return *subtree;
+  }
+
+  // the same remapping of the SubTree, except the item
+  void remapLikePrototype(Blackboard& blackboard, const std::string& item_key) const
+  {
+    for (const auto& [port_name, value] : prototype().config().input_ports)
+    {
+      if (port_name == item_key || port_name == "ID" || port_name == "name")
+      {
+        continue;
+      }
+      if (port_name == "_autoremap")
+      {
+        blackboard.enableAutoRemapping(convertFromString<bool>(value));
+        continue;
+      }
+      if (!port_name.empty() && port_name[0] == '_')
+      {
+        continue;
+      }
+      StringView stripped;
+      if (isBlackboardPointer(value, &stripped))
+      {
+        blackboard.addSubtreeRemapping(port_name, stripped);
+      }
+      else
+      {
+        blackboard.set(port_name, value);
+      }
+    }
+  }
+
+  // pop the next item, or (if item is null) check if there is one
+  bool popItem(T* item)
+  {
+    AnyPtrLocked any_ref = static_queue_ ? AnyPtrLocked() : getLockedPortContent("queue");
+    if (any_ref)
+    {
+      current_queue_ = any_ref.get()->cast<SharedQueue<T>>();
+    }
+    if (!current_queue_ || current_queue_->empty())
+    {
+      return false;
+    }
+    if (item)
+    {
+      *item = std::move(current_queue_->front());
+      current_queue_->pop_front();
+    }
+    return true;
+  }
+
+  // executed by the executor: tick the copy until it completes or is halted
+  void runCopy(Copy* copy)
+  {
+    NodeStatus status = NodeStatus::IDLE;
+    std::exception_ptr error;
+    try
+    {
+      status = copy->tree.tickOnce();
+      while (status == NodeStatus::RUNNING && !copy->halt_requested)
+      {
+        // woken up by the nodes of the copy, or by stopCopies()
+        copy->tree.sleep(std::chrono::milliseconds(10));
+        status = copy->tree.tickOnce();
+      }
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+    // before "running = false": after that, this node may be destroyed
+    emitWakeUpSignal();
+    {
+      std::scoped_lock lk(mutex_);
+      copy->result = status;
+      copy->error = error;
+      copy->running = false;
+      copy->finished = true;
+      // notified with the lock held: the node may be destroyed after the unlock
+      stopped_.notify_all();
+    }
+  }
+
+  void start(Copy& copy)
+  {
+    copy.halt_requested = false;
+    {
+      std::scoped_lock lk(mutex_);
+      copy.running = true;
+      copy.finished = false;
+    }
+    executor_->execute([this, ptr = &copy]() { runCopy(ptr); });
+  }
+
+  // halt the copies that are running and wait for them
+  void stopCopies()
+  {
+    for (auto& copy : copies_)
+    {
+      copy->halt_requested = true;
+      if (auto root = copy->tree.rootNode())
+      {
+        root->emitWakeUpSignal();
+      }
+    }
+    {
+      std::unique_lock lk(mutex_);
+      stopped_.wait(lk, [this] {
+        return std::none_of(copies_.begin(), copies_.end(),
+                            [](const auto& copy) { return copy->running; });
+      });
+    }
+    for (auto& copy : copies_)
+    {
+      copy->tree.haltTree();
+      copy->finished = false;
+    }
+    success_count_ = 0;
+    failure_count_ = 0;
+  }
+
+  NodeStatus finish(NodeStatus status)
+  {
+    stopCopies();
+    resetChild();
+    return status;
+  }
+
+  NodeStatus tick() override
+  {
+    const auto item_key = getInput<std::string>("item").value();
+    unsigned max_concurrency = getInput<unsigned>("max_concurrency").value();
+    if (max_concurrency == 0)
+    {
+      max_concurrency = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const int success_count = getInput<int>("success_count").value();
+    const int max_failures = getInput<int>("max_failures").value();
+
+    if (status() == NodeStatus::IDLE)
+    {
+      if (static_queue_)
+      {
+        current_queue_ = std::make_shared<std::deque<T>>(*static_queue_);
+      }
+      if (!popItem(nullptr))
+      {
+        return getInput<NodeStatus>("if_empty").value();
+      }
+      setStatus(NodeStatus::RUNNING);
+    }
+
+    // collect the results of the copies that completed
+    bool any_running = false;
+    std::exception_ptr error;
+    {
+      std::scoped_lock lk(mutex_);
+      for (auto& copy : copies_)
+      {
+        if (copy->finished)
+        {
+          copy->finished = false;
+          if (copy->error && !error)
+          {
+            error = copy->error;
+          }
+          copy->error = nullptr;
+          if (copy->result == NodeStatus::SUCCESS)
+          {
+            success_count_++;
+          }
+          else
+          {
+            failure_count_++;
+          }
+        }
+        any_running |= copy->running;
+      }
+    }
+    if (error)
+    {
+      finish(NodeStatus::FAILURE);
+      std::rethrow_exception(error);
+    }
+
+    if (max_failures >= 0 && failure_count_ > size_t(max_failures))
+    {
+      return finish(NodeStatus::FAILURE);
+    }
+    if (success_count > 0 && success_count_ >= size_t(success_count))
+    {
+      return finish(NodeStatus::SUCCESS);
+    }
+
+    // assign the next items to the idle copies, creating new ones if needed
+    for (size_t i = 0; i < max_concurrency; i++)
+    {
+      if (i < copies_.size() && copies_[i]->running)
+      {
+        continue;
+      }
+      T item;
+      if (!popItem(&item))
+      {
+        break;
+      }
+      if (i == copies_.size())
+      {
+        auto copy = std::make_unique<Copy>();
+        copy->blackboard = Blackboard::create(config().blackboard);
+        // the item is created first, so that it is never remapped to the parent
+        copy->blackboard->set(item_key, std::move(item));
+        remapLikePrototype(*copy->blackboard, item_key);
+        copy->tree = factory_->createTree(prototype().subtreeID(), copy->blackboard);
+        copies_.push_back(std::move(copy));
+      }
+      else
+      {
+        copies_[i]->tree.haltTree();
+        copies_[i]->blackboard->set(item_key, std::move(item));
+      }
+      start(*copies_[i]);
+      any_running = true;
+    }
+
+    if (!any_running)
+    {
+      return finish(NodeStatus::SUCCESS);
+    }
+    return NodeStatus::RUNNING;
+  }
+};
+
+}   // namespace BT
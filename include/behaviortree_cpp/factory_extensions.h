@@ -0,0 +1,936 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/actions/cached_script_nodes.h"
+#include "behaviortree_cpp/scripting/script_cache.hpp"
+#include "behaviortree_cpp/utils/arena.hpp"
+#include "behaviortree_cpp/utils/plugin_index.hpp"
+#include "behaviortree_cpp/utils/shared_library.h"
+#include "behaviortree_cpp/utils/startup_profiler.hpp"
+#include "behaviortree_cpp/utils/string_pool.hpp"
+#include "behaviortree_cpp/utils/thread_pool.hpp"
+#include "behaviortree_cpp/utils/wildcard_matcher.hpp"
+#include "behaviortree_cpp/utils/xml_includes.hpp"
+
+namespace BT
+{
+class TreeTemplate;
+struct LazySubtreeOptions;
+
+// see xml_parsing.h
+void VerifyXML(const std::string& xml_text,
+               const std::unordered_map<std::string, NodeType>& registered_nodes);
+
+/**
+ * @brief The substitution rules of a factory compiled in a WildcardMatcher,
+ * see FactoryExtensions::compiledSubstitutionRules().
+ *
+ * It finds the rule of a node without testing all the filters. It refers to
+ * the rules of the factory: it is valid until they are changed.
+ */
+class CompiledSubstitutionRules
+{
+public:
+  using SubstitutionRule = std::variant<std::string, TestNodeConfig>;
+  using RulesMap = std::unordered_map<std::string, SubstitutionRule>;
+
+  explicit CompiledSubstitutionRules(const RulesMap& rules)
+  {
+    rules_.reserve(rules.size());
+    for (const auto& [filter, rule] : rules)
+    {
+      matcher_.add(filter);
+      rules_.push_back({ filter, &rule });
+    }
+  }
+
+  [[nodiscard]] bool empty() const
+  {
+    return rules_.empty();
+  }
+
+  /// The rule of the first filter, in the order of the RulesMap, that is equal
+  /// to the name or to the registration ID of the node, or that matches its
+  /// path. nullptr if none.
+  [[nodiscard]] const SubstitutionRule* find(StringView name, StringView registration_ID,
+                                              StringView path) const
+  {
+    if (rules_.empty())
+    {
+      return nullptr;
+    }
+    size_t first = matcher_.matchFirst(path);
+    for (StringView str : { name, registration_ID })
+    {
+      const auto& exact = matcher_.matchExact(str);
+      if (!exact.empty())
+      {
+        first = std::min(first, size_t(exact.front()));
+      }
+    }
+    return first == WildcardMatcher::npos ? nullptr : rules_[first].second;
+  }
+
+  /// True if the rules have the same filters, in the same order and at the same
+  /// addresses, of the ones that were compiled.
+  [[nodiscard]] bool isCompiledFrom(const RulesMap& rules) const
+  {
+    if (rules.size() != rules_.size())
+    {
+      return false;
+    }
+    size_t i = 0;
+    for (const auto& [filter, rule] : rules)
+    {
+      if (rules_[i].first != filter || rules_[i].second != &rule)
+      {
+        return false;
+      }
+      i++;
+    }
+    return true;
+  }
+
+private:
+  WildcardMatcher matcher_;
+  // same index of the patterns in matcher_
+  std::vector<std::pair<std::string, const SubstitutionRule*>> rules_;
+};
+
+
+/**
+ * @brief FactoryExtensions adds to a BehaviorTreeFactory the features that
+ * need a state of their own: deferred plugins, parallel loading of the XML
+ * files, precompiled trees, the caches used by TreeTemplate (string pool,
+ * shared manifests, compiled substitution rules, scripts) and the
+ * StartupProfiler.
+ *
+ * The application owns it, next to the factory, that must outlive it:
+ *
+ *    BehaviorTreeFactory factory;
+ *    FactoryExtensions extensions(factory);
+ *    extensions.registerNodeType<MyAction>("MyAction");
+ *    extensions.registerBehaviorTreesFromDirectory("trees");
+ *    auto tree = extensions.createTreeInArena("MainTree");
+ *
+ * The nodes and the trees are registered in the factory, that can be used
+ * directly for everything else.
+ */
+class FactoryExtensions
+{
+public:
+  explicit FactoryExtensions(BehaviorTreeFactory& factory) : factory_(factory)
+  {}
+
+  FactoryExtensions(const FactoryExtensions& other) = delete;
+  FactoryExtensions& operator=(const FactoryExtensions& other) = delete;
+
+  [[nodiscard]] BehaviorTreeFactory& factory() const
+  {
+    return factory_;
+  }
+
+  /// Same as BehaviorTreeFactory::registerNodeType(), measured by the
+  /// StartupProfiler (see setStartupProfiler).
+  template <typename T, typename... ExtraArgs>
+  void registerNodeType(const std::string& ID, const PortsList& ports, ExtraArgs... args)
+  {
+    auto scope = startupScope(StartupProfiler::Phase::REGISTER_NODE, ID);
+    factory_.registerNodeType<T>(ID, ports, args...);
+    measureBuilder(ID);
+  }
+
+  /// Same as BehaviorTreeFactory::registerNodeType(), measured by the
+  /// StartupProfiler (see setStartupProfiler).
+  template <typename T, typename... ExtraArgs>
+  void registerNodeType(const std::string& ID, ExtraArgs... args)
+  {
+    auto scope = startupScope(StartupProfiler::Phase::REGISTER_NODE, ID);
+    factory_.registerNodeType<T>(ID, args...);
+    measureBuilder(ID);
+  }
+
+  /**
+   * @brief registerFromPluginDeferred registers in the factory the nodes listed in the
+   * index of a plugin (see writePluginIndex), without loading the shared library.
+   * The library is loaded, in a private factory, the first time one of its
+   * nodes is created; the scripting enums and the trees it registers are ignored.
+   *
+   * If the default index doesn't exist, it is the same as registerFromPlugin().
+   *
+   * @param file_path   path of the plugin
+   * @param index_path  path of the index; file_path + PLUGIN_INDEX_SUFFIX if empty
+   */
+  void registerFromPluginDeferred(const std::string& file_path,
+                                  const std::string& index_path = {});
+
+  /**
+   * @brief Load the plugins registered with registerFromPluginDeferred() that
+   * were not loaded yet, in parallel. Throws the error of the first plugin that
+   * could not be loaded, after trying to load all of them.
+   *
+   * @param num_threads  if 0, use std::thread::hardware_concurrency()
+   */
+  void loadDeferredPlugins(size_t num_threads = 0);
+
+  /// Plugins registered with registerFromPluginDeferred() and not loaded yet.
+  [[nodiscard]] std::vector<std::string> pendingPlugins() const;
+
+  /**
+   * @brief Load a plugin in a temporary factory and write the index of the
+   * nodes it registers, used by registerFromPluginDeferred().
+   *
+   * @param file_path   path of the plugin
+   * @param index_path  path of the index; file_path + PLUGIN_INDEX_SUFFIX if empty
+   */
+  static void writePluginIndex(const std::string& file_path,
+                               const std::string& index_path = {});
+
+  /**
+   * @brief Write the index of the nodes registered in the factory that are
+   * not builtin, for instance to validate the trees at build time with
+   * btcpp_tree_compiler.
+   */
+  static void writeNodesIndex(const BehaviorTreeFactory& factory,
+                              const std::string& index_path);
+
+  /**
+   * @brief registerBehaviorTreesFromFiles is equivalent to calling
+   * BehaviorTreeFactory::registerBehaviorTreeFromFile for each file, but the files and the ones
+   * they <include> are read and scanned in parallel, by a pool of threads.
+   *
+   * A file included many times is loaded once. The files are merged by
+   * the calling thread into a single document, registered (and therefore parsed
+   * and validated) once, in a deterministic order: each file after the ones
+   * it includes, following the order of the list and of the <include>.
+   * The files must have the same BTCPP_format, if they declare it.
+   * If a file can't be read or is invalid, nothing is registered and the
+   * error of the first of these files, in the same order, is thrown.
+   *
+   * @param filenames    files to load
+   * @param num_threads  size of the pool; if 0, std::thread::hardware_concurrency()
+   */
+  void registerBehaviorTreesFromFiles(const std::vector<std::filesystem::path>& filenames,
+                                      size_t num_threads = 0);
+
+  /// registerBehaviorTreesFromFiles with the files with extension ".xml" of a
+  /// directory (and of its subdirectories, if recursive), sorted by path.
+  void registerBehaviorTreesFromDirectory(const std::filesystem::path& directory,
+                                          bool recursive = false, size_t num_threads = 0);
+
+  /// Version of the format written by SaveBehaviorTreesBinary().
+  static constexpr uint32_t PRECOMPILED_TREES_VERSION = 1;
+
+  /**
+   * @brief registerBehaviorTreeFromBinary loads the trees precompiled with
+   * SaveBehaviorTreesBinary() (see flatbuffers/bt_flatbuffer_helper.h).
+   * The file is memory-mapped and no XML is parsed.
+   *
+   * The same node types must be registered in the factory, before calling this
+   * method. The trees are instantiated with createPrecompiledTree().
+   */
+  void registerBehaviorTreeFromBinary(const std::filesystem::path& filename);
+
+  /// Same of registerBehaviorTreeFromBinary, but passing the content of the file.
+  void registerBehaviorTreeFromBinary(const void* data, size_t size);
+
+  /// Returns the ID of the trees registered with registerBehaviorTreeFromBinary.
+  [[nodiscard]]
+  std::vector<std::string> registeredPrecompiledTrees() const;
+
+  /// Same as BehaviorTreeFactory::createTree(), for the trees registered with registerBehaviorTreeFromBinary.
+  [[nodiscard]]
+  Tree createPrecompiledTree(const std::string& tree_name,
+                             Blackboard::Ptr blackboard = Blackboard::create());
+
+  /// Same as createPrecompiledTree(), but the SubTrees selected by the options are
+  /// created on their first tick (see LazySubTreeNode).
+  [[nodiscard]]
+  Tree createPrecompiledTree(const std::string& tree_name, Blackboard::Ptr blackboard,
+                             const LazySubtreeOptions& lazy_options);
+
+  /**
+   * @brief createTreeInArena is equivalent to BehaviorTreeFactory::createTree, but the nodes
+   * whose class uses BT_ARENA_ALLOCATED_CLASS are allocated contiguously
+   * from a single MonotonicArena, in the same depth-first order used to
+   * tick them. The other nodes and the blackboards are allocated as usual.
+   *
+   * The memory of the arena is released at once, when the Tree is destroyed.
+   *
+   * @param tree_name   ID of the tree, registered previously
+   * @param blackboard  blackboard of the root tree
+   * @param chunk_size  size of the blocks of memory reserved by the arena
+   */
+  [[nodiscard]]
+  Tree createTreeInArena(const std::string& tree_name,
+                         Blackboard::Ptr blackboard = Blackboard::create(),
+                         size_t chunk_size = MonotonicArena::DEFAULT_CHUNK_SIZE)
+  {
+    auto profiler_scope = startupScope(StartupProfiler::Phase::CREATE_TREE, tree_name);
+    MonotonicArena arena(chunk_size);
+    ArenaScope scope(arena);
+    Tree tree = factory_.createTree(tree_name, std::move(blackboard));
+    details::CheckMaxNodes(details::CountNodes(tree), "createTreeInArena");
+    return tree;
+  }
+
+  /**
+   * @brief compiledSubstitutionRules return the substitution rules compiled in
+   * a WildcardMatcher. They are compiled again only when the rules change.
+   */
+  [[nodiscard]]
+  std::shared_ptr<const CompiledSubstitutionRules> compiledSubstitutionRules() const
+  {
+    const auto& rules = factory_.substitutionRules();
+    auto compiled = std::atomic_load(&compiled_rules_);
+    if (!compiled || !compiled->isCompiledFrom(rules))
+    {
+      compiled = std::make_shared<const CompiledSubstitutionRules>(rules);
+      std::atomic_store(&compiled_rules_, compiled);
+    }
+    return compiled;
+  }
+
+  /**
+   * @brief sharedManifests return an immutable copy of the manifests of the
+   * factory, shared
+   * by the trees created from a TreeTemplate. A new copy is made only when
+   * the registered manifests change.
+   */
+  [[nodiscard]]
+  SharedManifests sharedManifests() const
+  {
+    const auto& current = factory_.manifests();
+    auto shared = std::atomic_load(&shared_manifests_);
+    bool same = shared && shared->size() == current.size();
+    for (auto it = current.begin(); same && it != current.end(); ++it)
+    {
+      auto shared_it = shared->find(it->first);
+      same = shared_it != shared->end() && details::SameManifest(it->second, shared_it->second);
+    }
+    if (!same)
+    {
+      shared = std::make_shared<const std::unordered_map<std::string, TreeNodeManifest>>(current);
+      std::atomic_store(&shared_manifests_, shared);
+    }
+    return shared;
+  }
+
+  /// Cache of the parsed scripts of these extensions, used by the nodes
+  /// of registerCachedScriptNodes() and by shareConditionScripts().
+  [[nodiscard]]
+  const ScriptCache::Ptr& scriptCache() const
+  {
+    return script_cache_;
+  }
+
+  /**
+   * @brief Register "CachedScript" and "CachedScriptCondition", the versions
+   * of Script and ScriptCondition that parse their code with scriptCache():
+   * nodes with the same code, in this tree and in the ones created later,
+   * share the parsed function.
+   */
+  void registerCachedScriptNodes()
+  {
+    registerNodeType<CachedScriptNode>("CachedScript", script_cache_);
+    registerNodeType<CachedScriptCondition>("CachedScriptCondition", script_cache_);
+  }
+
+  /**
+   * @brief Replace the pre and post conditions (_skipIf, _onSuccess...) of the
+   * nodes of the tree with the functions of scriptCache(), so that the nodes
+   * with the same condition share a single parsed function.
+   *
+   * The conditions are parsed by BehaviorTreeFactory::createTree anyway: this
+   * reduces the memory of large trees, not the time to create them (for that,
+   * see TreeTemplate, that parses them once per template).
+   * Returns the number of conditions replaced.
+   */
+  size_t shareConditionScripts(Tree& tree) const
+  {
+    size_t replaced = 0;
+    auto share = [&](const std::string& code, ScriptFunction& function) {
+      if (code.empty())
+      {
+        return;
+      }
+      if (auto cached = script_cache_->get(code))
+      {
+        function = cached.value();
+        replaced++;
+      }
+    };
+    for (const auto& subtree : tree.subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        const NodeConfig& config = std::as_const(*node).config();
+        for (const auto& [condition, code] : config.pre_conditions)
+        {
+          share(code, node->preConditionsScripts()[size_t(condition)]);
+        }
+        for (const auto& [condition, code] : config.post_conditions)
+        {
+          share(code, node->postConditionsScripts()[size_t(condition)]);
+        }
+      }
+    }
+    return replaced;
+  }
+
+  /// Use a different cache of scripts (for instance, with a different parser).
+  void setScriptCache(ScriptCache::Ptr cache)
+  {
+    if (!cache)
+    {
+      throw RuntimeError("setScriptCache: invalid cache");
+    }
+    script_cache_ = std::move(cache);
+  }
+
+  /**
+   * @brief Record the duration of the startup in the profiler (see StartupProfiler):
+   *
+   * - registerNodeType(): REGISTER_NODE, and INSTANTIATE_NODE each time the
+   *   factory creates a node of that type;
+   * - registerFromPluginDeferred() and loadDeferredPlugins(): LOAD_PLUGIN, per plugin;
+   * - registerBehaviorTreesFromFiles() and registerBehaviorTreesFromDirectory():
+   *   READ_FILE per file, and PARSE_XML for the document that merges them;
+   * - createTreeInArena(): CREATE_TREE;
+   * - the scripts parsed by scriptCache(): COMPILE_SCRIPT, per script. A new
+   *   ScriptCache that measures the parser is used (see setScriptCache).
+   *
+   * Only the nodes registered after this call are measured. Pass nullptr to
+   * stop recording new registrations.
+   */
+  void setStartupProfiler(StartupProfiler::Ptr profiler)
+  {
+    startup_profiler_ = std::move(profiler);
+    if (startup_profiler_)
+    {
+      std::weak_ptr<StartupProfiler> weak_profiler = startup_profiler_;
+      script_cache_ = std::make_shared<ScriptCache>([weak_profiler](const std::string& script) {
+        auto profiler = weak_profiler.lock();
+        auto scope = profiler ?
+                         profiler->measure(StartupProfiler::Phase::COMPILE_SCRIPT, script) :
+                         StartupProfiler::Scope();
+        return ParseScript(script);
+      });
+    }
+  }
+
+  [[nodiscard]]
+  const StartupProfiler::Ptr& startupProfiler() const
+  {
+    return startup_profiler_;
+  }
+
+  /// Pool of the identifiers (node names, port names, blackboard keys)
+  /// used by the TreeTemplates compiled with these extensions.
+  [[nodiscard]]
+  const StringPool::Ptr& stringPool() const
+  {
+    return string_pool_;
+  }
+
+private:
+  // an empty scope if there is no profiler
+  StartupProfiler::Scope startupScope(StartupProfiler::Phase phase, const std::string& name) const
+  {
+    return startup_profiler_ ? startup_profiler_->measure(phase, name) : StartupProfiler::Scope();
+  }
+
+  // measure the instantiation of the nodes, while the profiler is enabled
+  NodeBuilder timedBuilder(const std::string& ID, NodeBuilder builder) const
+  {
+    if (!startup_profiler_)
+    {
+      return builder;
+    }
+    return [profiler = startup_profiler_, ID, builder = std::move(builder)](
+               const std::string& name, const NodeConfig& config) {
+      auto scope = profiler->measure(StartupProfiler::Phase::INSTANTIATE_NODE, ID);
+      return builder(name, config);
+    };
+  }
+
+  ScriptCache::Ptr script_cache_ = std::make_shared<ScriptCache>();
+  StartupProfiler::Ptr startup_profiler_;
+  StringPool::Ptr string_pool_ = std::make_shared<StringPool>();
+
+  std::unordered_map<std::string, std::shared_ptr<const TreeTemplate>> precompiled_trees_;
+
+  // see compiledSubstitutionRules()
+  mutable std::shared_ptr<const CompiledSubstitutionRules> compiled_rules_;
+  // see sharedManifests()
+  mutable SharedManifests shared_manifests_;
+
+  // a plugin registered with registerFromPluginDeferred()
+  struct DeferredPlugin;
+  std::vector<std::shared_ptr<DeferredPlugin>> deferred_plugins_;
+
+  // register again the builder of ID, measured by timedBuilder()
+  void measureBuilder(const std::string& ID)
+  {
+    if (!startup_profiler_)
+    {
+      return;
+    }
+    const TreeNodeManifest manifest = factory_.manifests().at(ID);
+    NodeBuilder builder = factory_.builders().at(ID);
+    factory_.unregisterBuilder(ID);
+    factory_.registerBuilder(manifest, timedBuilder(ID, std::move(builder)));
+  }
+
+  BehaviorTreeFactory& factory_;
+};
+
+//--------------------------------------------
+
+struct FactoryExtensions::DeferredPlugin
+{
+  std::string path;
+  mutable std::mutex mutex;
+  bool loaded = false;
+  std::exception_ptr error;
+  SharedLibrary library;
+  // the nodes of the plugin are registered here
+  std::unique_ptr<BehaviorTreeFactory> factory;
+
+  [[nodiscard]] bool isLoaded() const
+  {
+    std::scoped_lock lk(mutex);
+    return loaded;
+  }
+
+  // Thread-safe. Once loaded, the builders of the factory are not modified
+  void load()
+  {
+    std::scoped_lock lk(mutex);
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+    if (loaded)
+    {
+      return;
+    }
+    try
+    {
+      library.load(path);
+      if (!library.hasSymbol(PLUGIN_SYMBOL))
+      {
+        throw RuntimeError("Failed to load Plugin from file: ", path);
+      }
+      using Func = void (*)(BehaviorTreeFactory&);
+      auto func = reinterpret_cast<Func>(library.getSymbol(PLUGIN_SYMBOL));
+      factory = std::make_unique<BehaviorTreeFactory>();
+      func(*factory);
+      loaded = true;
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+      throw;
+    }
+  }
+
+  std::unique_ptr<TreeNode> create(const std::string& ID, const std::string& name,
+                                   const NodeConfig& config)
+  {
+    load();
+    auto it = factory->builders().find(ID);
+    if (it == factory->builders().end())
+    {
+      throw RuntimeError("The plugin [", path, "] doesn't register the node [", ID,
+                         "] listed in its index");
+    }
+    return it->second(name, config);
+  }
+};
+
+inline void FactoryExtensions::registerFromPluginDeferred(const std::string& file_path,
+                                                          const std::string& index_path)
+{
+  auto scope = startupScope(StartupProfiler::Phase::LOAD_PLUGIN, file_path);
+  const std::string index =
+      index_path.empty() ? file_path + PLUGIN_INDEX_SUFFIX : index_path;
+  std::ifstream stream(index);
+  if (!stream)
+  {
+    if (!index_path.empty())
+    {
+      throw RuntimeError("registerFromPluginDeferred: can't open the index [", index, "]");
+    }
+    factory_.registerFromPlugin(file_path);
+    return;
+  }
+  const auto manifests = ReadPluginIndex(stream, index);
+  // nothing is registered if one of the IDs is already in use
+  for (const auto& manifest : manifests)
+  {
+    if (factory_.builders().count(manifest.registration_ID) != 0)
+    {
+      throw BehaviorTreeException("ID [", manifest.registration_ID, "] already registered");
+    }
+  }
+
+  auto plugin = std::make_shared<DeferredPlugin>();
+  plugin->path = file_path;
+  for (const auto& manifest : manifests)
+  {
+    factory_.registerBuilder(manifest,
+                             timedBuilder(manifest.registration_ID,
+                                          [plugin, ID = manifest.registration_ID](
+                                              const std::string& name, const NodeConfig& config) {
+                                            return plugin->create(ID, name, config);
+                                          }));
+  }
+  deferred_plugins_.push_back(std::move(plugin));
+}
+
+inline void FactoryExtensions::loadDeferredPlugins(size_t num_threads)
+{
+  std::vector<DeferredPlugin*> pending;
+  for (const auto& plugin : deferred_plugins_)
+  {
+    if (!plugin->isLoaded())
+    {
+      pending.push_back(plugin.get());
+    }
+  }
+  std::vector<std::exception_ptr> errors(pending.size());
+  auto loadPlugin = [this, &pending, &errors](size_t index) {
+    try
+    {
+      auto scope = startupScope(StartupProfiler::Phase::LOAD_PLUGIN, pending[index]->path);
+      pending[index]->load();
+    }
+    catch (...)
+    {
+      errors[index] = std::current_exception();
+    }
+  };
+
+  if (pending.size() <= 1 || num_threads == 1)
+  {
+    for (size_t index = 0; index < pending.size(); index++)
+    {
+      loadPlugin(index);
+    }
+  }
+  else
+  {
+    // the destructor of the pool waits for the tasks
+    WorkStealingPool pool(std::min(num_threads == 0 ? size_t(std::thread::hardware_concurrency()) :
+                                                      num_threads,
+                                   pending.size()));
+    for (size_t index = 0; index < pending.size(); index++)
+    {
+      pool.submit([&loadPlugin, index] { loadPlugin(index); });
+    }
+  }
+  for (const auto& error : errors)
+  {
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+inline std::vector<std::string> FactoryExtensions::pendingPlugins() const
+{
+  std::vector<std::string> out;
+  for (const auto& plugin : deferred_plugins_)
+  {
+    if (!plugin->isLoaded())
+    {
+      out.push_back(plugin->path);
+    }
+  }
+  return out;
+}
+
+inline void FactoryExtensions::writePluginIndex(const std::string& file_path,
+                                                const std::string& index_path)
+{
+  BehaviorTreeFactory factory;
+  factory.registerFromPlugin(file_path);
+  writeNodesIndex(factory, index_path.empty() ? file_path + PLUGIN_INDEX_SUFFIX : index_path);
+}
+
+inline void FactoryExtensions::writeNodesIndex(const BehaviorTreeFactory& factory,
+                                               const std::string& index_path)
+{
+  const std::set<std::string>& builtin = factory.builtinNodes();
+  std::vector<TreeNodeManifest> manifests;
+  for (const auto& [ID, manifest] : factory.manifests())
+  {
+    if (builtin.count(ID) == 0)
+    {
+      manifests.push_back(manifest);
+    }
+  }
+  std::sort(manifests.begin(), manifests.end(), [](const auto& a, const auto& b) {
+    return a.registration_ID < b.registration_ID;
+  });
+
+  std::ofstream out(index_path, std::ios::binary);
+  WritePluginIndex(out, manifests);
+  if (!out)
+  {
+    throw RuntimeError("writeNodesIndex: can't write the index [", index_path, "]");
+  }
+}
+
+inline void FactoryExtensions::registerBehaviorTreesFromFiles(
+    const std::vector<std::filesystem::path>& filenames, size_t num_threads)
+{
+  struct File
+  {
+    std::filesystem::path path;
+    std::string text;
+    std::vector<XMLInclude> includes;
+    std::vector<size_t> included_files;
+    XMLRoot root;
+    std::string error;
+  };
+  std::vector<File> files;
+  std::unordered_map<std::string, size_t> file_index;
+  std::vector<size_t> roots;
+
+  auto addFile = [&](std::filesystem::path path) -> size_t {
+    std::error_code ec;
+    auto canonical = std::filesystem::weakly_canonical(path, ec);
+    if (!ec)
+    {
+      path = std::move(canonical);
+    }
+    auto [it, inserted] = file_index.insert({ path.string(), files.size() });
+    if (inserted)
+    {
+      files.push_back({ std::move(path), {}, {}, {}, {}, {} });
+    }
+    return it->second;
+  };
+  for (const auto& filename : filenames)
+  {
+    roots.push_back(addFile(filename));
+  }
+
+  WorkStealingPool pool(num_threads);
+  // run task(index) for each index in [begin, end) and wait
+  auto parallelFor = [&pool](size_t begin, size_t end, const std::function<void(size_t)>& task) {
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    size_t remaining = end - begin;
+    for (size_t index = begin; index < end; index++)
+    {
+      pool.submit([&, index] {
+        task(index);
+        std::scoped_lock lk(mutex);
+        if (--remaining == 0)
+        {
+          done_cv.notify_one();
+        }
+      });
+    }
+    std::unique_lock lk(mutex);
+    done_cv.wait(lk, [&] { return remaining == 0; });
+  };
+
+  // read the files, one level of the include graph at a time
+  size_t level_begin = 0;
+  while (level_begin < files.size())
+  {
+    const size_t level_end = files.size();
+    parallelFor(level_begin, level_end, [this, &files](size_t index) {
+      File& file = files[index];
+      try
+      {
+        auto read_scope = startupScope(StartupProfiler::Phase::READ_FILE, file.path.string());
+        std::ifstream stream(file.path, std::ios::binary);
+        if (!stream)
+        {
+          throw RuntimeError("Can't open the file [", file.path.string(), "]");
+        }
+        file.text.assign(std::istreambuf_iterator<char>(stream),
+                         std::istreambuf_iterator<char>());
+        file.includes = ScanXMLIncludes(file.text);
+        for (const auto& include : file.includes)
+        {
+          if (!include.ros_pkg.empty())
+          {
+            throw RuntimeError("Using attribute [ros_pkg] in <include>, but this library "
+                               "was compiled without ROS support. Recompile the "
+                               "BehaviorTree.CPP using catkin");
+          }
+        }
+        // registered without the includes, that are registered on their own
+        file.text = RemoveXMLIncludes(std::move(file.text), file.includes);
+        file.root = FindXMLRoot(file.text);
+      }
+      catch (const std::exception& ex)
+      {
+        file.error = ex.what();
+      }
+    });
+    // sequential, to assign the indexes deterministically
+    for (size_t index = level_begin; index < level_end; index++)
+    {
+      const auto parent_path = files[index].path.parent_path();
+      for (const auto& include : files[index].includes)
+      {
+        std::filesystem::path path(include.path);
+        if (path.is_relative())
+        {
+          path = parent_path / path;
+        }
+        const size_t included = addFile(std::move(path));
+        files[index].included_files.push_back(included);
+      }
+    }
+    level_begin = level_end;
+  }
+
+  // post-order visit: the included files first
+  std::vector<size_t> order;
+  std::vector<uint8_t> state(files.size(), 0);   // 0: new, 1: visiting, 2: done
+  std::function<void(size_t)> visit = [&](size_t index) {
+    if (state[index] == 2)
+    {
+      return;
+    }
+    if (state[index] == 1)
+    {
+      throw RuntimeError("Circular <include> of the file [", files[index].path.string(),
+                         "]");
+    }
+    state[index] = 1;
+    for (size_t included : files[index].included_files)
+    {
+      visit(included);
+    }
+    state[index] = 2;
+    order.push_back(index);
+  };
+  for (size_t root : roots)
+  {
+    visit(root);
+  }
+  if (order.empty())
+  {
+    return;
+  }
+  std::string format;
+  size_t merged_size = 0;
+  for (size_t index : order)
+  {
+    const File& file = files[index];
+    if (!file.error.empty())
+    {
+      throw RuntimeError(file.error);
+    }
+    if (!file.root.format.empty() && !format.empty() && file.root.format != format)
+    {
+      throw RuntimeError("registerBehaviorTreesFromFiles: the file [", file.path.string(),
+                         "] has BTCPP_format=\"", file.root.format,
+                         "\", the previous ones \"", format, "\"");
+    }
+    if (format.empty())
+    {
+      format = file.root.format;
+    }
+    merged_size += file.root.end - file.root.begin + 1;
+  }
+
+  // a single document: the factory parses and validates it once, and registers
+  // nothing if it is invalid
+  std::string merged =
+      format.empty() ? "<root>\n" : StrCat("<root BTCPP_format=\"", format, "\">\n");
+  merged.reserve(merged.size() + merged_size + 8);
+  for (size_t index : order)
+  {
+    const File& file = files[index];
+    merged.append(file.text, file.root.begin, file.root.end - file.root.begin);
+    merged += '\n';
+  }
+  merged += "</root>";
+  try
+  {
+    auto scope = startupScope(StartupProfiler::Phase::PARSE_XML,
+                              StrCat(std::to_string(order.size()), " files"));
+    factory_.registerBehaviorTreeFromText(merged);
+  }
+  catch (const std::exception&)
+  {
+    // the error of the first invalid file, as registerBehaviorTreeFromFile() would throw
+    std::unordered_map<std::string, NodeType> registered_nodes;
+    for (const auto& [ID, manifest] : factory_.manifests())
+    {
+      registered_nodes.insert({ ID, manifest.type });
+    }
+    for (size_t index : order)
+    {
+      try
+      {
+        VerifyXML(files[index].text, registered_nodes);
+      }
+      catch (const std::exception& ex)
+      {
+        throw RuntimeError(ex.what());
+      }
+    }
+    throw;
+  }
+}
+
+inline void
+FactoryExtensions::registerBehaviorTreesFromDirectory(const std::filesystem::path& directory,
+                                                      bool recursive, size_t num_threads)
+{
+  if (!std::filesystem::is_directory(directory))
+  {
+    throw RuntimeError("registerBehaviorTreesFromDirectory: [", directory.string(),
+                       "] is not a directory");
+  }
+  std::vector<std::filesystem::path> filenames;
+  auto addEntry = [&filenames](const std::filesystem::directory_entry& entry) {
+    if (entry.is_regular_file() && entry.path().extension() == ".xml")
+    {
+      filenames.push_back(entry.path());
+    }
+  };
+  if (recursive)
+  {
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+      addEntry(entry);
+    }
+  }
+  else
+  {
+    for (const auto& entry : std::filesystem::directory_iterator(directory))
+    {
+      addEntry(entry);
+    }
+  }
+  std::sort(filenames.begin(), filenames.end());
+  registerBehaviorTreesFromFiles(filenames, num_threads);
+}
+
+}   // namespace BT
+
+// definition of the methods that load the precompiled trees
+#include "behaviortree_cpp/tree_template.h"
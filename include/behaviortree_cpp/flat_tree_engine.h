@@ -0,0 +1,370 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+
+namespace BT
+{
+
+/**
+ * @brief FlatTreeEngine ticks a Tree without going through the virtual
+ * executeTick() of its builtin controls and decorators.
+ *
+ * The tree is flattened once, depth first, into an array of instructions.
+ * Sequence, Fallback, Inverter, ForceSuccess, ForceFailure, SubTree,
+ * AlwaysSuccess and AlwaysFailure become cases of a switch, with their
+ * state (status and current child) stored in the engine. Any other node
+ * (user leaves, but also Parallel, Reactive*, Repeat, ...) is executed
+ * as usual with executeTick(), including its subtree.
+ *
+ * The semantic is the same of the original nodes, with these differences:
+ *
+ * - the status of the compiled nodes is kept by the engine, see status():
+ *   TreeNode::status() remains IDLE and their status changes are NOT
+ *   notified to the loggers; the transitions of the other nodes are.
+ * - builtin nodes with pre/post conditions, or with setPreTickFunction()/
+ *   setPostTickFunction() callbacks, must not be compiled: the former are
+ *   detected and executed as usual, the latter can't be; pass
+ *   compile_builtins = false to the constructor if they are used.
+ *
+ * The Tree must outlive the engine and must not be modified (reload(),
+ * substitutions...) after the engine was created. Don't mix tree.tickOnce()
+ * and engine.tickOnce(): halt() the engine first.
+ */
+class FlatTreeEngine
+{
+public:
+  explicit FlatTreeEngine(Tree& tree, bool compile_builtins = true) : tree_(tree)
+  {
+    TreeNode* root = tree.rootNode();
+    if (!root)
+    {
+      throw RuntimeError("FlatTreeEngine: empty tree");
+    }
+    compile(root, compile_builtins);
+  }
+
+  FlatTreeEngine(const FlatTreeEngine&) = delete;
+  FlatTreeEngine& operator=(const FlatTreeEngine&) = delete;
+
+  /// Tick the root once (as Tree::tickExactlyOnce()).
+  NodeStatus tickOnce()
+  {
+    const NodeStatus status = tickInstr(0);
+    if (isStatusCompleted(status))
+    {
+      resetInstr(0);
+    }
+    return status;
+  }
+
+  /// Call tickOnce() until the status is different from RUNNING, with a
+  /// Tree::sleep() in between, as Tree::tickWhileRunning().
+  NodeStatus tickWhileRunning(std::chrono::milliseconds sleep_time = std::chrono::milliseconds(10))
+  {
+    NodeStatus status = tickOnce();
+    while (status == NodeStatus::RUNNING)
+    {
+      if (sleep_time.count() > 0)
+      {
+        tree_.sleep(sleep_time);
+      }
+      status = tickOnce();
+    }
+    return status;
+  }
+
+  /// Halt the running nodes and reset the state of the compiled ones.
+  void halt()
+  {
+    haltInstr(0);
+  }
+
+  /// Status of a node of the tree, also if it was compiled.
+  [[nodiscard]] NodeStatus status(const TreeNode* node) const
+  {
+    for (const auto& instr : instructions_)
+    {
+      if (instr.node == node)
+      {
+        return (instr.op == Op::NODE) ? node->status() : instr.status;
+      }
+    }
+    return node->status();
+  }
+
+  /// Number of nodes executed by executeTick() and number of compiled nodes.
+  [[nodiscard]] size_t virtualNodesCount() const
+  {
+    return instructions_.size() - compiledNodesCount();
+  }
+
+  [[nodiscard]] size_t compiledNodesCount() const
+  {
+    size_t count = 0;
+    for (const auto& instr : instructions_)
+    {
+      count += (instr.op != Op::NODE) ? 1 : 0;
+    }
+    return count;
+  }
+
+private:
+  enum class Op : uint8_t
+  {
+    NODE,   // executeTick() of the node and of its subtree
+    SEQUENCE,
+    FALLBACK,
+    INVERTER,
+    FORCE_SUCCESS,
+    FORCE_FAILURE,
+    // a pass-through decorator, like the SubTree
+    FORWARD,
+    ALWAYS_SUCCESS,
+    ALWAYS_FAILURE
+  };
+
+  struct Instruction
+  {
+    Op op = Op::NODE;
+    TreeNode* node = nullptr;
+    // range of children_
+    uint32_t children_begin = 0;
+    uint32_t children_end = 0;
+    // state of the compiled node
+    NodeStatus status = NodeStatus::IDLE;
+    uint32_t current_child = 0;
+    bool all_skipped = true;
+  };
+
+  Tree& tree_;
+  std::vector<Instruction> instructions_;
+  // index in instructions_ of the children of each instruction
+  std::vector<uint32_t> children_;
+
+  static Op opcode(TreeNode* node)
+  {
+    const auto& conf = node->config();
+    if (!conf.pre_conditions.empty() || !conf.post_conditions.empty())
+    {
+      return Op::NODE;
+    }
+    // both the class and the registration ID: AsyncSequence and AsyncFallback
+    // are instances of SequenceNode and FallbackNode with a different semantic
+    const std::string& ID = node->registrationName();
+    if (ID == "Sequence" && dynamic_cast<SequenceNode*>(node))
+    {
+      return Op::SEQUENCE;
+    }
+    if (ID == "Fallback" && dynamic_cast<FallbackNode*>(node))
+    {
+      return Op::FALLBACK;
+    }
+    if (ID == "Inverter" && dynamic_cast<InverterNode*>(node))
+    {
+      return Op::INVERTER;
+    }
+    if (ID == "ForceSuccess" && dynamic_cast<ForceSuccessNode*>(node))
+    {
+      return Op::FORCE_SUCCESS;
+    }
+    if (ID == "ForceFailure" && dynamic_cast<ForceFailureNode*>(node))
+    {
+      return Op::FORCE_FAILURE;
+    }
+    if (ID == "SubTree" && dynamic_cast<SubTreeNode*>(node))
+    {
+      return Op::FORWARD;
+    }
+    if (ID == "AlwaysSuccess" && dynamic_cast<AlwaysSuccessNode*>(node))
+    {
+      return Op::ALWAYS_SUCCESS;
+    }
+    if (ID == "AlwaysFailure" && dynamic_cast<AlwaysFailureNode*>(node))
+    {
+      return Op::ALWAYS_FAILURE;
+    }
+    return Op::NODE;
+  }
+
+  uint32_t compile(TreeNode* node, bool compile_builtins)
+  {
+    const auto index = uint32_t(instructions_.size());
+    instructions_.push_back({});
+    instructions_[index].node = node;
+    const Op op = compile_builtins ? opcode(node) : Op::NODE;
+    instructions_[index].op = op;
+    if (op == Op::NODE)
+    {
+      return index;
+    }
+
+    std::vector<TreeNode*> children;
+    if (auto control = dynamic_cast<ControlNode*>(node))
+    {
+      children = control->children();
+    }
+    else if (auto decorator = dynamic_cast<DecoratorNode*>(node))
+    {
+      if (!decorator->child())
+      {
+        throw RuntimeError("FlatTreeEngine: the decorator [", node->name(),
+                           "] has no child");
+      }
+      children.push_back(decorator->child());
+    }
+    std::vector<uint32_t> compiled;
+    for (auto* child : children)
+    {
+      compiled.push_back(compile(child, compile_builtins));
+    }
+    instructions_[index].children_begin = uint32_t(children_.size());
+    children_.insert(children_.end(), compiled.begin(), compiled.end());
+    instructions_[index].children_end = uint32_t(children_.size());
+    return index;
+  }
+
+  // reset the status of a child to IDLE, halting it if it is RUNNING
+  // (ControlNode::haltChild)
+  void resetInstr(uint32_t index)
+  {
+    Instruction& instr = instructions_[index];
+    if (instr.op == Op::NODE)
+    {
+      if (instr.node->status() == NodeStatus::RUNNING)
+      {
+        instr.node->haltNode();
+      }
+      instr.node->resetStatus();
+      return;
+    }
+    if (instr.status == NodeStatus::RUNNING)
+    {
+      haltInstr(index);
+    }
+    instr.status = NodeStatus::IDLE;
+  }
+
+  void resetChildren(uint32_t index)
+  {
+    const Instruction& instr = instructions_[index];
+    for (uint32_t c = instr.children_begin; c < instr.children_end; c++)
+    {
+      resetInstr(children_[c]);
+    }
+  }
+
+  void haltInstr(uint32_t index)
+  {
+    Instruction& instr = instructions_[index];
+    if (instr.op == Op::NODE)
+    {
+      resetInstr(index);
+      return;
+    }
+    instr.current_child = 0;
+    resetChildren(index);
+    instr.status = NodeStatus::IDLE;
+  }
+
+  [[noreturn]] void throwIdleChild(const Instruction& instr) const
+  {
+    throw LogicError("[", instr.node->name(), "]: A children should not return IDLE");
+  }
+
+  NodeStatus tickInstr(uint32_t index)
+  {
+    Instruction& instr = instructions_[index];
+    switch (instr.op)
+    {
+      case Op::NODE:
+        return instr.node->executeTick();
+
+      case Op::ALWAYS_SUCCESS:
+        return NodeStatus::SUCCESS;
+
+      case Op::ALWAYS_FAILURE:
+        return NodeStatus::FAILURE;
+
+      case Op::SEQUENCE:
+      case Op::FALLBACK: {
+        // SequenceNode::tick() and FallbackNode::tick()
+        const NodeStatus stop_status =
+            (instr.op == Op::SEQUENCE) ? NodeStatus::FAILURE : NodeStatus::SUCCESS;
+        const uint32_t children_count = instr.children_end - instr.children_begin;
+        if (instr.status == NodeStatus::IDLE)
+        {
+          instr.all_skipped = true;
+        }
+        instr.status = NodeStatus::RUNNING;
+        while (instr.current_child < children_count)
+        {
+          const NodeStatus child_status =
+              tickInstr(children_[instr.children_begin + instr.current_child]);
+          // instructions_ is never resized: instr is still valid
+          instr.all_skipped &= (child_status == NodeStatus::SKIPPED);
+          if (child_status == NodeStatus::RUNNING)
+          {
+            return NodeStatus::RUNNING;
+          }
+          if (child_status == stop_status)
+          {
+            resetChildren(index);
+            instr.current_child = 0;
+            return (instr.status = child_status);
+          }
+          if (child_status == NodeStatus::IDLE)
+          {
+            throwIdleChild(instr);
+          }
+          instr.current_child++;
+        }
+        resetChildren(index);
+        instr.current_child = 0;
+        const NodeStatus done = (instr.op == Op::SEQUENCE) ? NodeStatus::SUCCESS :
+                                                             NodeStatus::FAILURE;
+        return (instr.status = instr.all_skipped ? NodeStatus::SKIPPED : done);
+      }
+
+      case Op::INVERTER:
+      case Op::FORCE_SUCCESS:
+      case Op::FORCE_FAILURE:
+      case Op::FORWARD: {
+        if (instr.op != Op::FORWARD || instr.status == NodeStatus::IDLE)
+        {
+          instr.status = NodeStatus::RUNNING;
+        }
+        const uint32_t child = children_[instr.children_begin];
+        const NodeStatus child_status = tickInstr(child);
+        if (child_status == NodeStatus::IDLE)
+        {
+          throwIdleChild(instr);
+        }
+        if (!isStatusCompleted(child_status))
+        {
+          // RUNNING or SKIPPED
+          return (instr.status = child_status);
+        }
+        resetInstr(child);
+        switch (instr.op)
+        {
+          case Op::INVERTER:
+            return (instr.status = (child_status == NodeStatus::SUCCESS) ?
+                                       NodeStatus::FAILURE :
+                                       NodeStatus::SUCCESS);
+          case Op::FORCE_SUCCESS:
+            return (instr.status = NodeStatus::SUCCESS);
+          case Op::FORCE_FAILURE:
+            return (instr.status = NodeStatus::FAILURE);
+          default:
+            return (instr.status = child_status);
+        }
+      }
+    }
+    return NodeStatus::IDLE;
+  }
+};
+
+}   // namespace BT
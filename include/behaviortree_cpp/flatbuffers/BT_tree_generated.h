@@ -0,0 +1,722 @@
+// automatically generated by the FlatBuffers compiler, do not modify
+
+#ifndef FLATBUFFERS_GENERATED_BTTREE_SERIALIZATION_H_
+#define FLATBUFFERS_GENERATED_BTTREE_SERIALIZATION_H_
+
+#include "behaviortree_cpp/flatbuffers/flatbuffers.h"
+
+namespace Serialization
+{
+struct StringPair;
+struct StringPairBuilder;
+
+struct ConditionScript;
+struct ConditionScriptBuilder;
+
+struct EntryRecord;
+struct EntryRecordBuilder;
+
+struct SubtreeRecord;
+struct SubtreeRecordBuilder;
+
+struct NodeRecord;
+struct NodeRecordBuilder;
+
+struct TreeRecord;
+struct TreeRecordBuilder;
+
+struct TreeSet;
+struct TreeSetBuilder;
+
+struct StringPair FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table
+{
+  typedef StringPairBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE
+  {
+    VT_KEY = 4,
+    VT_VALUE = 6
+  };
+  const flatbuffers::String* key() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_KEY);
+  }
+  const flatbuffers::String* value() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_VALUE);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const
+  {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_KEY) &&
+           verifier.VerifyString(key()) &&
+           VerifyOffset(verifier, VT_VALUE) &&
+           verifier.VerifyString(value()) &&
+           verifier.EndTable();
+  }
+};
+
+struct StringPairBuilder
+{
+  typedef StringPair Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_key(flatbuffers::Offset<flatbuffers::String> key)
+  {
+    fbb_.AddOffset(StringPair::VT_KEY, key);
+  }
+  void add_value(flatbuffers::Offset<flatbuffers::String> value)
+  {
+    fbb_.AddOffset(StringPair::VT_VALUE, value);
+  }
+  explicit StringPairBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb)
+  {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<StringPair> Finish()
+  {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<StringPair>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<StringPair> CreateStringPair(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::String> key = 0,
+    flatbuffers::Offset<flatbuffers::String> value = 0)
+{
+  StringPairBuilder builder_(_fbb);
+  builder_.add_key(key);
+  builder_.add_value(value);
+  return builder_.Finish();
+}
+
+struct ConditionScript FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table
+{
+  typedef ConditionScriptBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE
+  {
+    VT_CONDITION = 4,
+    VT_SCRIPT = 6
+  };
+  int8_t condition() const
+  {
+    return GetField<int8_t>(VT_CONDITION, 0);
+  }
+  const flatbuffers::String* script() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_SCRIPT);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const
+  {
+    return VerifyTableStart(verifier) &&
+           VerifyField<int8_t>(verifier, VT_CONDITION) &&
+           VerifyOffset(verifier, VT_SCRIPT) &&
+           verifier.VerifyString(script()) &&
+           verifier.EndTable();
+  }
+};
+
+struct ConditionScriptBuilder
+{
+  typedef ConditionScript Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_condition(int8_t condition)
+  {
+    fbb_.AddElement<int8_t>(ConditionScript::VT_CONDITION, condition, 0);
+  }
+  void add_script(flatbuffers::Offset<flatbuffers::String> script)
+  {
+    fbb_.AddOffset(ConditionScript::VT_SCRIPT, script);
+  }
+  explicit ConditionScriptBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb)
+  {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<ConditionScript> Finish()
+  {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<ConditionScript>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<ConditionScript> CreateConditionScript(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    int8_t condition = 0,
+    flatbuffers::Offset<flatbuffers::String> script = 0)
+{
+  ConditionScriptBuilder builder_(_fbb);
+  builder_.add_script(script);
+  builder_.add_condition(condition);
+  return builder_.Finish();
+}
+
+struct EntryRecord FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table
+{
+  typedef EntryRecordBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE
+  {
+    VT_KEY = 4,
+    VT_NODE_ID = 6,
+    VT_PORT_NAME = 8,
+    VT_LITERAL = 10
+  };
+  const flatbuffers::String* key() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_KEY);
+  }
+  const flatbuffers::String* node_id() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_NODE_ID);
+  }
+  const flatbuffers::String* port_name() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_PORT_NAME);
+  }
+  const flatbuffers::String* literal() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_LITERAL);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const
+  {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_KEY) &&
+           verifier.VerifyString(key()) &&
+           VerifyOffset(verifier, VT_NODE_ID) &&
+           verifier.VerifyString(node_id()) &&
+           VerifyOffset(verifier, VT_PORT_NAME) &&
+           verifier.VerifyString(port_name()) &&
+           VerifyOffset(verifier, VT_LITERAL) &&
+           verifier.VerifyString(literal()) &&
+           verifier.EndTable();
+  }
+};
+
+struct EntryRecordBuilder
+{
+  typedef EntryRecord Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_key(flatbuffers::Offset<flatbuffers::String> key)
+  {
+    fbb_.AddOffset(EntryRecord::VT_KEY, key);
+  }
+  void add_node_id(flatbuffers::Offset<flatbuffers::String> node_id)
+  {
+    fbb_.AddOffset(EntryRecord::VT_NODE_ID, node_id);
+  }
+  void add_port_name(flatbuffers::Offset<flatbuffers::String> port_name)
+  {
+    fbb_.AddOffset(EntryRecord::VT_PORT_NAME, port_name);
+  }
+  void add_literal(flatbuffers::Offset<flatbuffers::String> literal)
+  {
+    fbb_.AddOffset(EntryRecord::VT_LITERAL, literal);
+  }
+  explicit EntryRecordBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb)
+  {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<EntryRecord> Finish()
+  {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<EntryRecord>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<EntryRecord> CreateEntryRecord(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::String> key = 0,
+    flatbuffers::Offset<flatbuffers::String> node_id = 0,
+    flatbuffers::Offset<flatbuffers::String> port_name = 0,
+    flatbuffers::Offset<flatbuffers::String> literal = 0)
+{
+  EntryRecordBuilder builder_(_fbb);
+  builder_.add_key(key);
+  builder_.add_node_id(node_id);
+  builder_.add_port_name(port_name);
+  builder_.add_literal(literal);
+  return builder_.Finish();
+}
+
+struct SubtreeRecord FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table
+{
+  typedef SubtreeRecordBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE
+  {
+    VT_INSTANCE_NAME = 4,
+    VT_TREE_ID = 6,
+    VT_PARENT = 8,
+    VT_REMAPPING = 10,
+    VT_AUTOREMAP = 12,
+    VT_ENTRIES = 14
+  };
+  const flatbuffers::String* instance_name() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_INSTANCE_NAME);
+  }
+  const flatbuffers::String* tree_id() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_TREE_ID);
+  }
+  int32_t parent() const
+  {
+    return GetField<int32_t>(VT_PARENT, -1);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>* remapping() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>*>(VT_REMAPPING);
+  }
+  bool autoremap() const
+  {
+    return GetField<uint8_t>(VT_AUTOREMAP, 0) != 0;
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::EntryRecord>>* entries() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::EntryRecord>>*>(VT_ENTRIES);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const
+  {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_INSTANCE_NAME) &&
+           verifier.VerifyString(instance_name()) &&
+           VerifyOffset(verifier, VT_TREE_ID) &&
+           verifier.VerifyString(tree_id()) &&
+           VerifyField<int32_t>(verifier, VT_PARENT) &&
+           VerifyOffset(verifier, VT_REMAPPING) &&
+           verifier.VerifyVector(remapping()) &&
+           verifier.VerifyVectorOfTables(remapping()) &&
+           VerifyField<uint8_t>(verifier, VT_AUTOREMAP) &&
+           VerifyOffset(verifier, VT_ENTRIES) &&
+           verifier.VerifyVector(entries()) &&
+           verifier.VerifyVectorOfTables(entries()) &&
+           verifier.EndTable();
+  }
+};
+
+struct SubtreeRecordBuilder
+{
+  typedef SubtreeRecord Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_instance_name(flatbuffers::Offset<flatbuffers::String> instance_name)
+  {
+    fbb_.AddOffset(SubtreeRecord::VT_INSTANCE_NAME, instance_name);
+  }
+  void add_tree_id(flatbuffers::Offset<flatbuffers::String> tree_id)
+  {
+    fbb_.AddOffset(SubtreeRecord::VT_TREE_ID, tree_id);
+  }
+  void add_parent(int32_t parent)
+  {
+    fbb_.AddElement<int32_t>(SubtreeRecord::VT_PARENT, parent, -1);
+  }
+  void add_remapping(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>> remapping)
+  {
+    fbb_.AddOffset(SubtreeRecord::VT_REMAPPING, remapping);
+  }
+  void add_autoremap(bool autoremap)
+  {
+    fbb_.AddElement<uint8_t>(SubtreeRecord::VT_AUTOREMAP, static_cast<uint8_t>(autoremap), 0);
+  }
+  void add_entries(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::EntryRecord>>> entries)
+  {
+    fbb_.AddOffset(SubtreeRecord::VT_ENTRIES, entries);
+  }
+  explicit SubtreeRecordBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb)
+  {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<SubtreeRecord> Finish()
+  {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<SubtreeRecord>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<SubtreeRecord> CreateSubtreeRecord(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::String> instance_name = 0,
+    flatbuffers::Offset<flatbuffers::String> tree_id = 0,
+    int32_t parent = -1,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>> remapping = 0,
+    bool autoremap = false,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::EntryRecord>>> entries = 0)
+{
+  SubtreeRecordBuilder builder_(_fbb);
+  builder_.add_instance_name(instance_name);
+  builder_.add_tree_id(tree_id);
+  builder_.add_parent(parent);
+  builder_.add_remapping(remapping);
+  builder_.add_entries(entries);
+  builder_.add_autoremap(autoremap);
+  return builder_.Finish();
+}
+
+struct NodeRecord FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table
+{
+  typedef NodeRecordBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE
+  {
+    VT_NAME = 4,
+    VT_REGISTRATION_ID = 6,
+    VT_PATH = 8,
+    VT_UID = 10,
+    VT_KIND = 12,
+    VT_PARENT = 14,
+    VT_SUBTREE = 16,
+    VT_SUBTREE_ID = 18,
+    VT_INPUT_PORTS = 20,
+    VT_OUTPUT_PORTS = 22,
+    VT_PRE_CONDITIONS = 24,
+    VT_POST_CONDITIONS = 26
+  };
+  const flatbuffers::String* name() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_NAME);
+  }
+  const flatbuffers::String* registration_id() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_REGISTRATION_ID);
+  }
+  const flatbuffers::String* path() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_PATH);
+  }
+  uint16_t uid() const
+  {
+    return GetField<uint16_t>(VT_UID, 0);
+  }
+  int8_t kind() const
+  {
+    return GetField<int8_t>(VT_KIND, 0);
+  }
+  int32_t parent() const
+  {
+    return GetField<int32_t>(VT_PARENT, -1);
+  }
+  int32_t subtree() const
+  {
+    return GetField<int32_t>(VT_SUBTREE, 0);
+  }
+  const flatbuffers::String* subtree_id() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_SUBTREE_ID);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>* input_ports() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>*>(VT_INPUT_PORTS);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>* output_ports() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>*>(VT_OUTPUT_PORTS);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::ConditionScript>>* pre_conditions() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::ConditionScript>>*>(VT_PRE_CONDITIONS);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::ConditionScript>>* post_conditions() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::ConditionScript>>*>(VT_POST_CONDITIONS);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const
+  {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_NAME) &&
+           verifier.VerifyString(name()) &&
+           VerifyOffset(verifier, VT_REGISTRATION_ID) &&
+           verifier.VerifyString(registration_id()) &&
+           VerifyOffset(verifier, VT_PATH) &&
+           verifier.VerifyString(path()) &&
+           VerifyField<uint16_t>(verifier, VT_UID) &&
+           VerifyField<int8_t>(verifier, VT_KIND) &&
+           VerifyField<int32_t>(verifier, VT_PARENT) &&
+           VerifyField<int32_t>(verifier, VT_SUBTREE) &&
+           VerifyOffset(verifier, VT_SUBTREE_ID) &&
+           verifier.VerifyString(subtree_id()) &&
+           VerifyOffset(verifier, VT_INPUT_PORTS) &&
+           verifier.VerifyVector(input_ports()) &&
+           verifier.VerifyVectorOfTables(input_ports()) &&
+           VerifyOffset(verifier, VT_OUTPUT_PORTS) &&
+           verifier.VerifyVector(output_ports()) &&
+           verifier.VerifyVectorOfTables(output_ports()) &&
+           VerifyOffset(verifier, VT_PRE_CONDITIONS) &&
+           verifier.VerifyVector(pre_conditions()) &&
+           verifier.VerifyVectorOfTables(pre_conditions()) &&
+           VerifyOffset(verifier, VT_POST_CONDITIONS) &&
+           verifier.VerifyVector(post_conditions()) &&
+           verifier.VerifyVectorOfTables(post_conditions()) &&
+           verifier.EndTable();
+  }
+};
+
+struct NodeRecordBuilder
+{
+  typedef NodeRecord Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_name(flatbuffers::Offset<flatbuffers::String> name)
+  {
+    fbb_.AddOffset(NodeRecord::VT_NAME, name);
+  }
+  void add_registration_id(flatbuffers::Offset<flatbuffers::String> registration_id)
+  {
+    fbb_.AddOffset(NodeRecord::VT_REGISTRATION_ID, registration_id);
+  }
+  void add_path(flatbuffers::Offset<flatbuffers::String> path)
+  {
+    fbb_.AddOffset(NodeRecord::VT_PATH, path);
+  }
+  void add_uid(uint16_t uid)
+  {
+    fbb_.AddElement<uint16_t>(NodeRecord::VT_UID, uid, 0);
+  }
+  void add_kind(int8_t kind)
+  {
+    fbb_.AddElement<int8_t>(NodeRecord::VT_KIND, kind, 0);
+  }
+  void add_parent(int32_t parent)
+  {
+    fbb_.AddElement<int32_t>(NodeRecord::VT_PARENT, parent, -1);
+  }
+  void add_subtree(int32_t subtree)
+  {
+    fbb_.AddElement<int32_t>(NodeRecord::VT_SUBTREE, subtree, 0);
+  }
+  void add_subtree_id(flatbuffers::Offset<flatbuffers::String> subtree_id)
+  {
+    fbb_.AddOffset(NodeRecord::VT_SUBTREE_ID, subtree_id);
+  }
+  void add_input_ports(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>> input_ports)
+  {
+    fbb_.AddOffset(NodeRecord::VT_INPUT_PORTS, input_ports);
+  }
+  void add_output_ports(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>> output_ports)
+  {
+    fbb_.AddOffset(NodeRecord::VT_OUTPUT_PORTS, output_ports);
+  }
+  void add_pre_conditions(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::ConditionScript>>> pre_conditions)
+  {
+    fbb_.AddOffset(NodeRecord::VT_PRE_CONDITIONS, pre_conditions);
+  }
+  void add_post_conditions(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::ConditionScript>>> post_conditions)
+  {
+    fbb_.AddOffset(NodeRecord::VT_POST_CONDITIONS, post_conditions);
+  }
+  explicit NodeRecordBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb)
+  {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<NodeRecord> Finish()
+  {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<NodeRecord>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<NodeRecord> CreateNodeRecord(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::String> name = 0,
+    flatbuffers::Offset<flatbuffers::String> registration_id = 0,
+    flatbuffers::Offset<flatbuffers::String> path = 0,
+    uint16_t uid = 0,
+    int8_t kind = 0,
+    int32_t parent = -1,
+    int32_t subtree = 0,
+    flatbuffers::Offset<flatbuffers::String> subtree_id = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>> input_ports = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::StringPair>>> output_ports = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::ConditionScript>>> pre_conditions = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::ConditionScript>>> post_conditions = 0)
+{
+  NodeRecordBuilder builder_(_fbb);
+  builder_.add_name(name);
+  builder_.add_registration_id(registration_id);
+  builder_.add_path(path);
+  builder_.add_parent(parent);
+  builder_.add_subtree(subtree);
+  builder_.add_subtree_id(subtree_id);
+  builder_.add_input_ports(input_ports);
+  builder_.add_output_ports(output_ports);
+  builder_.add_pre_conditions(pre_conditions);
+  builder_.add_post_conditions(post_conditions);
+  builder_.add_uid(uid);
+  builder_.add_kind(kind);
+  return builder_.Finish();
+}
+
+struct TreeRecord FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table
+{
+  typedef TreeRecordBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE
+  {
+    VT_TREE_ID = 4,
+    VT_SUBTREES = 6,
+    VT_NODES = 8
+  };
+  const flatbuffers::String* tree_id() const
+  {
+    return GetPointer<const flatbuffers::String*>(VT_TREE_ID);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::SubtreeRecord>>* subtrees() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::SubtreeRecord>>*>(VT_SUBTREES);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::NodeRecord>>* nodes() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::NodeRecord>>*>(VT_NODES);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const
+  {
+    return VerifyTableStart(verifier) &&
+           VerifyOffset(verifier, VT_TREE_ID) &&
+           verifier.VerifyString(tree_id()) &&
+           VerifyOffset(verifier, VT_SUBTREES) &&
+           verifier.VerifyVector(subtrees()) &&
+           verifier.VerifyVectorOfTables(subtrees()) &&
+           VerifyOffset(verifier, VT_NODES) &&
+           verifier.VerifyVector(nodes()) &&
+           verifier.VerifyVectorOfTables(nodes()) &&
+           verifier.EndTable();
+  }
+};
+
+struct TreeRecordBuilder
+{
+  typedef TreeRecord Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_tree_id(flatbuffers::Offset<flatbuffers::String> tree_id)
+  {
+    fbb_.AddOffset(TreeRecord::VT_TREE_ID, tree_id);
+  }
+  void add_subtrees(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::SubtreeRecord>>> subtrees)
+  {
+    fbb_.AddOffset(TreeRecord::VT_SUBTREES, subtrees);
+  }
+  void add_nodes(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::NodeRecord>>> nodes)
+  {
+    fbb_.AddOffset(TreeRecord::VT_NODES, nodes);
+  }
+  explicit TreeRecordBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb)
+  {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<TreeRecord> Finish()
+  {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<TreeRecord>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<TreeRecord> CreateTreeRecord(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    flatbuffers::Offset<flatbuffers::String> tree_id = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::SubtreeRecord>>> subtrees = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::NodeRecord>>> nodes = 0)
+{
+  TreeRecordBuilder builder_(_fbb);
+  builder_.add_tree_id(tree_id);
+  builder_.add_subtrees(subtrees);
+  builder_.add_nodes(nodes);
+  return builder_.Finish();
+}
+
+struct TreeSet FLATBUFFERS_FINAL_CLASS : private flatbuffers::Table
+{
+  typedef TreeSetBuilder Builder;
+  enum FlatBuffersVTableOffset FLATBUFFERS_VTABLE_UNDERLYING_TYPE
+  {
+    VT_VERSION = 4,
+    VT_TREES = 6
+  };
+  uint32_t version() const
+  {
+    return GetField<uint32_t>(VT_VERSION, 0);
+  }
+  const flatbuffers::Vector<flatbuffers::Offset<Serialization::TreeRecord>>* trees() const
+  {
+    return GetPointer<const flatbuffers::Vector<flatbuffers::Offset<Serialization::TreeRecord>>*>(VT_TREES);
+  }
+  bool Verify(flatbuffers::Verifier& verifier) const
+  {
+    return VerifyTableStart(verifier) &&
+           VerifyField<uint32_t>(verifier, VT_VERSION) &&
+           VerifyOffset(verifier, VT_TREES) &&
+           verifier.VerifyVector(trees()) &&
+           verifier.VerifyVectorOfTables(trees()) &&
+           verifier.EndTable();
+  }
+};
+
+struct TreeSetBuilder
+{
+  typedef TreeSet Table;
+  flatbuffers::FlatBufferBuilder& fbb_;
+  flatbuffers::uoffset_t start_;
+  void add_version(uint32_t version)
+  {
+    fbb_.AddElement<uint32_t>(TreeSet::VT_VERSION, version, 0);
+  }
+  void add_trees(flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::TreeRecord>>> trees)
+  {
+    fbb_.AddOffset(TreeSet::VT_TREES, trees);
+  }
+  explicit TreeSetBuilder(flatbuffers::FlatBufferBuilder& _fbb) : fbb_(_fbb)
+  {
+    start_ = fbb_.StartTable();
+  }
+  flatbuffers::Offset<TreeSet> Finish()
+  {
+    const auto end = fbb_.EndTable(start_);
+    auto o = flatbuffers::Offset<TreeSet>(end);
+    return o;
+  }
+};
+
+inline flatbuffers::Offset<TreeSet> CreateTreeSet(
+    flatbuffers::FlatBufferBuilder& _fbb,
+    uint32_t version = 0,
+    flatbuffers::Offset<flatbuffers::Vector<flatbuffers::Offset<Serialization::TreeRecord>>> trees = 0)
+{
+  TreeSetBuilder builder_(_fbb);
+  builder_.add_version(version);
+  builder_.add_trees(trees);
+  return builder_.Finish();
+}
+
+inline const char* TreeSetIdentifier()
+{
+  return "BTTS";
+}
+
+inline bool TreeSetBufferHasIdentifier(const void* buf)
+{
+  return flatbuffers::BufferHasIdentifier(buf, TreeSetIdentifier());
+}
+
+inline const Serialization::TreeSet* GetTreeSet(const void* buf)
+{
+  return flatbuffers::GetRoot<Serialization::TreeSet>(buf);
+}
+
+inline bool VerifyTreeSetBuffer(flatbuffers::Verifier& verifier)
+{
+  return verifier.VerifyBuffer<Serialization::TreeSet>(TreeSetIdentifier());
+}
+
+inline void FinishTreeSetBuffer(flatbuffers::FlatBufferBuilder& fbb,
+                                flatbuffers::Offset<Serialization::TreeSet> root)
+{
+  fbb.Finish(root, TreeSetIdentifier());
+}
+
+}   // namespace Serialization
+
+#endif   // FLATBUFFERS_GENERATED_BTTREE_SERIALIZATION_H_
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <fstream>
+
 #include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/tree_template.h"
 #include "behaviortree_cpp/flatbuffers/BT_logger_generated.h"
+#include "behaviortree_cpp/flatbuffers/BT_tree_generated.h"
 
 namespace BT
 {
@@ -81,12 +85,13 @@ inline void CreateFlatbuffersBehaviorTree(flatbuffers::FlatBufferBuilder& builde
     }
 
     std::vector<flatbuffers::Offset<Serialization::PortConfig>> ports;
-    for (const auto& it : node->config().input_ports)
+    const NodeConfig& config = static_cast<const BT::TreeNode*>(node)->config();
+    for (const auto& it : config.input_ports)
     {
       ports.push_back(Serialization::CreatePortConfigDirect(builder, it.first.c_str(),
                                                             it.second.c_str()));
     }
-    for (const auto& it : node->config().output_ports)
+    for (const auto& it : config.output_ports)
     {
       ports.push_back(Serialization::CreatePortConfigDirect(builder, it.first.c_str(),
                                                             it.second.c_str()));
@@ -103,7 +108,7 @@ inline void CreateFlatbuffersBehaviorTree(flatbuffers::FlatBufferBuilder& builde
 
   std::vector<flatbuffers::Offset<Serialization::NodeModel>> node_models;
 
-  for (const auto& node_it : tree.manifests)
+  for (const auto& node_it : NodeManifests(tree))
   {
     const auto& manifest = node_it.second;
     std::vector<flatbuffers::Offset<Serialization::PortModel>> port_models;
@@ -134,6 +139,53 @@ inline void CreateFlatbuffersBehaviorTree(flatbuffers::FlatBufferBuilder& builde
   builder.Finish(behavior_tree);
 }
 
+/**
+ * @brief Compile the trees registered in the factory (with
+ * registerBehaviorTreeFromFile/Text) into a binary that can be loaded with
+ * FactoryExtensions::registerBehaviorTreeFromBinary().
+ *
+ * Each tree is instantiated once, therefore the XML is validated and the
+ * includes and subtrees are resolved at this point.
+ *
+ * @param tree_IDs  trees to compile. If empty, all the registered trees.
+ */
+inline std::vector<uint8_t> SerializeBehaviorTrees(BehaviorTreeFactory& factory,
+                                                   std::vector<std::string> tree_IDs = {})
+{
+  if (tree_IDs.empty())
+  {
+    tree_IDs = factory.registeredBehaviorTrees();
+  }
+  // the templates are serialized right away: their identifiers don't outlive it
+  FactoryExtensions extensions(factory);
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<flatbuffers::Offset<Serialization::TreeRecord>> trees;
+  trees.reserve(tree_IDs.size());
+  for (const auto& tree_ID : tree_IDs)
+  {
+    const auto tmpl = TreeTemplate::compile(extensions, tree_ID);
+    trees.push_back(tmpl.serialize(builder, tree_ID));
+  }
+  auto tree_set = Serialization::CreateTreeSet(
+      builder, FactoryExtensions::PRECOMPILED_TREES_VERSION, builder.CreateVector(trees));
+  Serialization::FinishTreeSetBuffer(builder, tree_set);
+  return { builder.GetBufferPointer(), builder.GetBufferPointer() + builder.GetSize() };
+}
+
+/// Write the result of SerializeBehaviorTrees() into a file.
+inline void SaveBehaviorTreesBinary(BehaviorTreeFactory& factory,
+                                    const std::filesystem::path& filename,
+                                    std::vector<std::string> tree_IDs = {})
+{
+  const auto buffer = SerializeBehaviorTrees(factory, std::move(tree_IDs));
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  if (!file.write(reinterpret_cast<const char*>(buffer.data()),
+                  std::streamsize(buffer.size())))
+  {
+    throw RuntimeError("SaveBehaviorTreesBinary: can't write [", filename.string(), "]");
+  }
+}
+
 /** Serialize manually the informations about state transition
  * No flatbuffer serialization here
  */
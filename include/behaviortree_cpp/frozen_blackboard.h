@@ -0,0 +1,158 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp/blackboard.h"
+
+namespace BT
+{
+
+/**
+ * @brief FrozenBlackboard is an immutable set of values (maps, calibration
+ * tables, parameters) built once and shared by many trees.
+ *
+ * It is created from a Blackboard, whose values are copied only at that time,
+ * and it can't be modified afterwards: it has no set(), therefore lookups
+ * don't need any lock and the references it returns remain valid as long as
+ * the FrozenBlackboard exists.
+ *
+ *    auto config = Blackboard::create();
+ *    config->set("calibration", LoadCalibration());
+ *    auto frozen = FrozenBlackboard::create(*config);
+ *
+ *    // every tree of the fleet shares the same instance
+ *    auto tree = factory.createTree("Job", Blackboard::create());
+ *    FrozenBlackboard::attach(frozen, *tree.rootBlackboard());
+ *
+ *    // in the node, once (constructor or first tick)
+ *    frozen_ = FrozenBlackboard::find(*config.blackboard);
+ *    // then, without locking anything
+ *    const Calibration& calibration = frozen_->get<Calibration>("calibration");
+ *
+ * attach() stores only the reference-counted pointer in the blackboard of
+ * the tree, as Blackboard::setShared(). The nodes of a SubTree find it if the
+ * key is remapped (or with _autoremap). Alternatively, pass the pointer to
+ * the constructor of the nodes, with BehaviorTreeFactory::registerNodeType().
+ */
+class FrozenBlackboard
+{
+public:
+  using Ptr = std::shared_ptr<const FrozenBlackboard>;
+
+  /// Default key used by attach() and find().
+  static constexpr const char* DEFAULT_KEY = "frozen_blackboard";
+
+  /// Copy all the entries of the source (but not the ones of its parents).
+  [[nodiscard]] static Ptr create(const Blackboard& source)
+  {
+    auto frozen = std::shared_ptr<FrozenBlackboard>(new FrozenBlackboard());
+    for (const auto& key : source.getKeys())
+    {
+      const std::string key_str(key);
+      if (auto entry = source.getEntry(key_str))
+      {
+        std::scoped_lock lock(entry->entry_mutex);
+        frozen->storage_.emplace(key_str, Item{ entry->value, entry->port_info });
+      }
+    }
+    return frozen;
+  }
+
+  /// Store the pointer in the entry [key] of the blackboard.
+  static void attach(const Ptr& frozen, Blackboard& blackboard,
+                     const std::string& key = DEFAULT_KEY)
+  {
+    blackboard.setShared<FrozenBlackboard>(key, frozen);
+  }
+
+  /// The instance stored by attach(). nullptr if the entry doesn't exist.
+  [[nodiscard]] static Ptr find(const Blackboard& blackboard,
+                                const std::string& key = DEFAULT_KEY)
+  {
+    return blackboard.getShared<FrozenBlackboard>(key);
+  }
+
+  /// nullptr if the key doesn't exist.
+  [[nodiscard]] const Any* getAny(const std::string& key) const
+  {
+    auto it = storage_.find(key);
+    return it == storage_.end() ? nullptr : &it->second.value;
+  }
+
+  /// nullptr if the key doesn't exist or contains a different type.
+  template <typename T> [[nodiscard]]
+  const T* getPtr(const std::string& key) const
+  {
+    const Any* any = getAny(key);
+    return any ? any->castPtr<T>() : nullptr;
+  }
+
+  /// Reference to the value, without copying it.
+  /// Throws if the key doesn't exist or contains a different type.
+  template <typename T> [[nodiscard]]
+  const T& get(const std::string& key) const
+  {
+    const Any* any = getAny(key);
+    if (!any)
+    {
+      throw RuntimeError("FrozenBlackboard::get() error. Missing key [", key, "]");
+    }
+    if (const T* ptr = any->castPtr<T>())
+    {
+      return *ptr;
+    }
+    throw RuntimeError("FrozenBlackboard::get(", key, "): the entry contains the type [",
+                       DemangledName(any->type()), "]");
+  }
+
+  /// Copy of the value, converted into T like Blackboard::get().
+  /// Return false if the key doesn't exist.
+  template <typename T>
+  bool get(const std::string& key, T& value) const
+  {
+    if (const Any* any = getAny(key))
+    {
+      value = any->cast<T>();
+      return true;
+    }
+    return false;
+  }
+
+  [[nodiscard]] const PortInfo* portInfo(const std::string& key) const
+  {
+    auto it = storage_.find(key);
+    return it == storage_.end() ? nullptr : &it->second.info;
+  }
+
+  [[nodiscard]] std::vector<StringView> getKeys() const
+  {
+    std::vector<StringView> keys;
+    keys.reserve(storage_.size());
+    for (const auto& [key, item] : storage_)
+    {
+      keys.emplace_back(key);
+    }
+    return keys;
+  }
+
+  [[nodiscard]] size_t size() const
+  {
+    return storage_.size();
+  }
+
+private:
+  FrozenBlackboard() = default;
+
+  struct Item
+  {
+    Any value;
+    PortInfo info;
+  };
+
+  std::unordered_map<std::string, Item> storage_;
+};
+
+}   // namespace BT
@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/tree_runner.h"
+
+namespace BT
+{
+
+/**
+ * @brief LoadTestDriver replays the shape of a production tree, usually with its
+ * leaves replaced by LoadTestNodes (see RegisterLoadTestRules), faster than the
+ * production rate and with many instances at the same time, to find how many
+ * trees and which tick rate a host can sustain.
+ *
+ *   LoadTestDriver::Options options;
+ *   options.trees = 50;
+ *   options.production_period = std::chrono::milliseconds(100);
+ *   options.rate_multiplier = 4;
+ *   LoadTestDriver driver(factory, "MainTree", options);
+ *   auto report = driver.run(std::chrono::seconds(10));
+ *   std::cout << report.achieved_rate_hz << " / " << report.target_rate_hz << std::endl;
+ *
+ * The trees are ticked by a TreeRunner and restarted when completed.
+ * A configuration is sustained ("keeping_up") if every tree achieves at
+ * least Options::min_rate_ratio of its target rate.
+ */
+class LoadTestDriver
+{
+public:
+  struct Options
+  {
+    /// number of instances of the tree
+    size_t trees = 1;
+    /// period of the tree in production
+    std::chrono::nanoseconds production_period = std::chrono::milliseconds(10);
+    /// the trees are ticked with period production_period / rate_multiplier
+    double rate_multiplier = 1.0;
+    /// workers of the TreeRunner. If 0, std::thread::hardware_concurrency()
+    size_t threads = 0;
+    /// fraction of the target rate that each tree must achieve
+    double min_rate_ratio = 0.95;
+  };
+
+  struct Report
+  {
+    size_t trees = 0;
+    double rate_multiplier = 0;
+    /// per tree
+    double target_rate_hz = 0;
+    /// mean and minimum rate of the trees
+    double achieved_rate_hz = 0;
+    double min_rate_hz = 0;
+    /// ticks of all the trees
+    uint64_t ticks = 0;
+    /// delay of the start of the ticks, and their duration
+    std::chrono::nanoseconds mean_latency = {};
+    std::chrono::nanoseconds max_latency = {};
+    std::chrono::nanoseconds mean_tick_duration = {};
+    std::chrono::nanoseconds max_tick_duration = {};
+    bool keeping_up = false;
+  };
+
+  LoadTestDriver(BehaviorTreeFactory& factory, const std::string& tree_id,
+                 Options options) :
+    factory_(factory), tree_id_(tree_id), options_(options)
+  {
+    if (options_.rate_multiplier <= 0 || options_.production_period.count() <= 0)
+    {
+      throw RuntimeError("LoadTestDriver: the period and the rate multiplier must be "
+                         "positive");
+    }
+  }
+
+  [[nodiscard]] const Options& options() const
+  {
+    return options_;
+  }
+
+  /**
+   * @brief Create Options::trees instances of the tree, tick them for the given
+   * duration and halt them. The trees are created before the measurement starts.
+   */
+  Report run(std::chrono::nanoseconds duration)
+  {
+    return run(options_.trees, options_.rate_multiplier, duration);
+  }
+
+  Report run(size_t trees_count, double rate_multiplier, std::chrono::nanoseconds duration)
+  {
+    const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        options_.production_period / rate_multiplier);
+
+    std::vector<std::unique_ptr<Tree>> trees;
+    trees.reserve(trees_count);
+    for (size_t i = 0; i < trees_count; i++)
+    {
+      trees.push_back(std::make_unique<Tree>(factory_.createTree(tree_id_)));
+    }
+
+    Report report;
+    report.trees = trees_count;
+    report.rate_multiplier = rate_multiplier;
+    report.target_rate_hz = 1e9 / double(period.count());
+
+    std::vector<TreeRunner::TreeStatistics> stats;
+    {
+      TreeRunner runner(options_.threads);
+      TreeRunner::TreeOptions tree_options;
+      tree_options.period = period;
+      tree_options.stop_when_completed = false;
+
+      std::vector<TreeRunner::TreeID> ids;
+      for (auto& tree : trees)
+      {
+        ids.push_back(runner.add(*tree, tree_options));
+      }
+      std::this_thread::sleep_for(duration);
+      for (auto id : ids)
+      {
+        stats.push_back(runner.statistics(id));
+        runner.remove(id);
+      }
+    }
+    for (auto& tree : trees)
+    {
+      tree->haltTree();
+    }
+
+    if (stats.empty())
+    {
+      return report;
+    }
+    double rate_sum = 0;
+    double latency_sum = 0;
+    double duration_sum = 0;
+    report.min_rate_hz = stats.front().tick_rate_hz;
+    for (const auto& st : stats)
+    {
+      report.ticks += st.ticks;
+      rate_sum += st.tick_rate_hz;
+      report.min_rate_hz = std::min(report.min_rate_hz, st.tick_rate_hz);
+      latency_sum += double(st.mean_latency.count()) * double(st.ticks);
+      duration_sum += double(st.mean_tick_duration.count()) * double(st.ticks);
+      report.max_latency = std::max(report.max_latency, st.max_latency);
+      report.max_tick_duration = std::max(report.max_tick_duration, st.max_tick_duration);
+    }
+    report.achieved_rate_hz = rate_sum / double(stats.size());
+    if (report.ticks > 0)
+    {
+      report.mean_latency = std::chrono::nanoseconds(int64_t(latency_sum / double(report.ticks)));
+      report.mean_tick_duration =
+          std::chrono::nanoseconds(int64_t(duration_sum / double(report.ticks)));
+    }
+    report.keeping_up = report.min_rate_hz >= options_.min_rate_ratio * report.target_rate_hz;
+    return report;
+  }
+
+  /**
+   * @brief Largest rate multiplier sustained with Options::trees instances:
+   * the multiplier is doubled until the host can't keep up, then refined by
+   * bisection. Each step lasts step_duration.
+   *
+   * @return the report of the largest sustained multiplier (keeping_up is false
+   * if not even the first one, Options::rate_multiplier, is sustained).
+   */
+  Report findMaxRate(std::chrono::nanoseconds step_duration, size_t bisection_steps = 4,
+                     double max_multiplier = 1024)
+  {
+    Report best;
+    double low = 0;
+    double high = options_.rate_multiplier;
+    // doubling
+    while (true)
+    {
+      Report report = run(options_.trees, high, step_duration);
+      if (!report.keeping_up)
+      {
+        if (low == 0)
+        {
+          return report;
+        }
+        break;
+      }
+      best = report;
+      low = high;
+      if (high >= max_multiplier)
+      {
+        return best;
+      }
+      high = std::min(high * 2, max_multiplier);
+    }
+    // bisection, between the last sustained and the first failed multiplier
+    for (size_t i = 0; i < bisection_steps; i++)
+    {
+      const double mid = (low + high) / 2;
+      Report report = run(options_.trees, mid, step_duration);
+      if (report.keeping_up)
+      {
+        best = report;
+        low = mid;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+    return best;
+  }
+
+  /**
+   * @brief Largest number of trees sustained at Options::rate_multiplier, searched
+   * like findMaxRate().
+   */
+  Report findMaxTrees(std::chrono::nanoseconds step_duration, size_t max_trees = 4096)
+  {
+    Report best;
+    size_t low = 0;
+    size_t high = std::max<size_t>(1, options_.trees);
+    // doubling
+    while (true)
+    {
+      Report report = run(high, options_.rate_multiplier, step_duration);
+      if (!report.keeping_up)
+      {
+        if (low == 0)
+        {
+          return report;
+        }
+        break;
+      }
+      best = report;
+      low = high;
+      if (high >= max_trees)
+      {
+        return best;
+      }
+      high = std::min(high * 2, max_trees);
+    }
+    // bisection, between the last sustained and the first failed count
+    while (high - low > std::max<size_t>(1, low / 16))
+    {
+      const size_t mid = low + (high - low) / 2;
+      Report report = run(mid, options_.rate_multiplier, step_duration);
+      if (report.keeping_up)
+      {
+        best = report;
+        low = mid;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+    return best;
+  }
+
+private:
+  BehaviorTreeFactory& factory_;
+  std::string tree_id_;
+  Options options_;
+};
+
+}   // namespace BT
@@ -56,6 +56,10 @@ public:
   }
 
 private:
+  // they can replace the subscriptions to the nodes
+  friend class TransitionBus;
+  friend class FilteredLogger;
+
   bool enabled_;
   bool show_transition_to_idle_;
   std::vector<TreeNode::StatusChangeSubscriber> subscribers_;
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/utils/allocation_counter.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief AllocationTracker counts the heap allocations done inside the
+ * executeTick() of each node, excluding the ones of its children.
+ *
+ * It requires the hooks of AllocationCounter (BTCPP_ALLOCATION_COUNTER_HOOKS).
+ * Typical use, in a test of a real-time loop:
+ *
+ *   AllocationTracker tracker(tree);
+ *   for(int i = 0; i < 10; i++) { tree.tickOnce(); }   // warm-up
+ *   tracker.reset();
+ *   for(int i = 0; i < 1000; i++) { tree.tickOnce(); }
+ *   auto res = tracker.checkNoAllocations();
+ *   ASSERT_TRUE(res) << res.error();
+ *
+ * After the warm-up, these paths don't allocate:
+ *
+ * - executeTick() of the builtin control nodes and decorators (the ones that
+ *   don't evaluate scripts) and of SyncActionNodes that don't allocate;
+ * - the notification of the status changes (Signal::notify);
+ * - PortHandle::get(): literals, and entries containing arithmetic or enum
+ *   types, or types whose copy-assignment reuses the destination (a std::string
+ *   that fits in the capacity of the destination);
+ * - PortHandle::set() and Blackboard::set() of an existing entry with the same
+ *   type, under the same condition about copy-assignment.
+ *
+ * These allocate, and should be avoided in a real-time loop: TreeNode::getInput()
+ * and setOutput() with a std::string key built at each call, the error paths
+ * (that format a message with StrCat), the creation of a blackboard entry,
+ * scripts assigning strings, and the loggers that keep a queue of transitions.
+ *
+ * It uses the pre and post tick callbacks of the nodes (see TreeNode::setPreTickFunction),
+ * that are replaced: don't use it together with other users of those callbacks,
+ * for instance TickProfiler or the breakpoints of Groot2Publisher.
+ */
+class AllocationTracker
+{
+public:
+  struct NodeAllocations
+  {
+    uint16_t uid = 0;
+    std::string full_path;
+    std::string registration_name;
+    // invocations of executeTick()
+    uint64_t calls = 0;
+    // excluding the children
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    // maximum number of allocations in a single executeTick()
+    uint64_t max_allocations_per_tick = 0;
+  };
+
+  AllocationTracker(const Tree& tree) : state_(std::make_shared<State>())
+  {
+    for (const auto& subtree : tree.subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        auto data = std::make_shared<NodeData>();
+        data->uid = node->UID();
+        data->full_path = node->fullPath();
+        data->registration_name = node->registrationName();
+        nodes_.push_back(data);
+
+        node->setPreTickFunction([state = state_, data](TreeNode&) {
+          state->enter(data.get());
+          return NodeStatus::IDLE;
+        });
+        node->setPostTickFunction([state = state_, data](TreeNode&, NodeStatus) {
+          state->exit(data.get());
+          return NodeStatus::IDLE;
+        });
+      }
+    }
+    std::sort(nodes_.begin(), nodes_.end(),
+              [](const auto& a, const auto& b) { return a->uid < b->uid; });
+  }
+
+  ~AllocationTracker()
+  {
+    // the callbacks remain in the nodes, but they do nothing
+    state_->enabled = false;
+  }
+
+  AllocationTracker(const AllocationTracker&) = delete;
+  AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+  /// Clear the counters, for instance at the end of the warm-up
+  void reset()
+  {
+    for (auto& data : nodes_)
+    {
+      data->calls.store(0, std::memory_order_relaxed);
+      data->allocations.store(0, std::memory_order_relaxed);
+      data->bytes.store(0, std::memory_order_relaxed);
+      data->max_per_tick.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void setEnabled(bool enabled)
+  {
+    state_->enabled = enabled;
+  }
+
+  /// Counters of each node, sorted by UID
+  [[nodiscard]] std::vector<NodeAllocations> nodeAllocations() const
+  {
+    std::vector<NodeAllocations> out;
+    out.reserve(nodes_.size());
+    for (const auto& data : nodes_)
+    {
+      out.push_back(toReport(*data));
+    }
+    return out;
+  }
+
+  [[nodiscard]] NodeAllocations nodeAllocations(const std::string& full_path) const
+  {
+    for (const auto& data : nodes_)
+    {
+      if (data->full_path == full_path)
+      {
+        return toReport(*data);
+      }
+    }
+    throw RuntimeError("AllocationTracker: invalid path [", full_path, "]");
+  }
+
+  /// Sum of the allocations of all the nodes
+  [[nodiscard]] uint64_t totalAllocations() const
+  {
+    uint64_t total = 0;
+    for (const auto& data : nodes_)
+    {
+      total += data->allocations.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /**
+   * @brief Fails if any node allocated since the creation of the tracker
+   * (or the last reset), or if the hooks of AllocationCounter are not installed.
+   * The error lists the nodes that allocated.
+   */
+  [[nodiscard]] Result checkNoAllocations() const
+  {
+    if (!AllocationCounter::hooksInstalled())
+    {
+      return nonstd::make_unexpected("AllocationTracker: the allocation hooks are not "
+                                     "installed (see BTCPP_ALLOCATION_COUNTER_HOOKS)");
+    }
+    std::string error;
+    for (const auto& data : nodes_)
+    {
+      const auto report = toReport(*data);
+      if (report.allocations > 0)
+      {
+        error += StrCat("\n  [", report.full_path, "] (", report.registration_name,
+                        "): ", std::to_string(report.allocations), " allocations in ",
+                        std::to_string(report.calls), " ticks");
+      }
+    }
+    if (!error.empty())
+    {
+      return nonstd::make_unexpected("AllocationTracker: nodes allocating during the tick:" +
+                                     error);
+    }
+    return {};
+  }
+
+private:
+  struct NodeData
+  {
+    uint16_t uid = 0;
+    std::string full_path;
+    std::string registration_name;
+    std::atomic<uint64_t> calls = 0;
+    std::atomic<uint64_t> allocations = 0;
+    std::atomic<uint64_t> bytes = 0;
+    std::atomic<uint64_t> max_per_tick = 0;
+  };
+
+  struct Frame
+  {
+    const void* state;
+    NodeData* node;
+    AllocationCounter::Counters start;
+    uint64_t children_allocations;
+    uint64_t children_bytes;
+  };
+
+  struct State
+  {
+    std::atomic<bool> enabled = true;
+
+    // nodes can be ticked by more than one thread: one stack per thread
+    static std::vector<Frame>& stack()
+    {
+      static thread_local std::vector<Frame> frames = [] {
+        std::vector<Frame> out;
+        out.reserve(64);
+        return out;
+      }();
+      return frames;
+    }
+
+    void enter(NodeData* node)
+    {
+      if (!enabled.load(std::memory_order_relaxed))
+      {
+        return;
+      }
+      auto& frames = stack();
+      // the growth of the stack is not counted: read the counters after push_back()
+      frames.push_back({ this, node, {}, 0, 0 });
+      frames.back().start = AllocationCounter::thread();
+    }
+
+    void exit(NodeData* node)
+    {
+      const AllocationCounter::Counters now = AllocationCounter::thread();
+      auto& frames = stack();
+      // the post tick callback is invoked also when a precondition skipped
+      // the tick (without pre tick callback) or after an exception
+      auto it = std::find_if(frames.rbegin(), frames.rend(),
+                             [&](const Frame& frame) { return frame.node == node; });
+      if (it == frames.rend())
+      {
+        return;
+      }
+      frames.erase(it.base(), frames.end());
+      const Frame frame = frames.back();
+      frames.pop_back();
+
+      const uint64_t inclusive = now.allocations - frame.start.allocations;
+      const uint64_t inclusive_bytes = now.bytes - frame.start.bytes;
+      const uint64_t exclusive = inclusive - frame.children_allocations;
+      node->calls.fetch_add(1, std::memory_order_relaxed);
+      node->allocations.fetch_add(exclusive, std::memory_order_relaxed);
+      node->bytes.fetch_add(inclusive_bytes - frame.children_bytes, std::memory_order_relaxed);
+      uint64_t max = node->max_per_tick.load(std::memory_order_relaxed);
+      while (exclusive > max)
+      {
+        if (node->max_per_tick.compare_exchange_weak(max, exclusive, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      if (!frames.empty() && frames.back().state == this)
+      {
+        frames.back().children_allocations += inclusive;
+        frames.back().children_bytes += inclusive_bytes;
+      }
+    }
+  };
+
+  static NodeAllocations toReport(const NodeData& data)
+  {
+    NodeAllocations report;
+    report.uid = data.uid;
+    report.full_path = data.full_path;
+    report.registration_name = data.registration_name;
+    report.calls = data.calls.load(std::memory_order_relaxed);
+    report.allocations = data.allocations.load(std::memory_order_relaxed);
+    report.bytes = data.bytes.load(std::memory_order_relaxed);
+    report.max_allocations_per_tick = data.max_per_tick.load(std::memory_order_relaxed);
+    return report;
+  }
+
+  // shared with the callbacks of the nodes, that may outlive the tracker
+  std::shared_ptr<State> state_;
+  std::vector<std::shared_ptr<NodeData>> nodes_;
+};
+
+}   // namespace BT
@@ -0,0 +1,763 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BT_COMPRESSED_LOG_MMAP
+#endif
+
+#if defined(BTCPP_LOGGER_ZSTD)
+#include <zstd.h>
+#endif
+
+#include "behaviortree_cpp/loggers/abstract_logger.h"
+#include "behaviortree_cpp/loggers/bt_file_logger_v2.h"
+#include "behaviortree_cpp/utils/bounded_queue.hpp"
+#include "behaviortree_cpp/utils/lock_profiler.hpp"
+#include "behaviortree_cpp/xml_parsing.h"
+
+namespace BT
+{
+
+/**
+ * @brief Common definitions of CompressedFileLogger and CompressedLogReader.
+ *
+ * Format (native byte order, see the byte order mark):
+ *
+ * - 4 bytes: "BTCL"
+ * - 2 bytes: byte order mark (0x0102), 2 bytes: version
+ * - 4 bytes: size of the XML string (N), next N bytes: the XML of the tree
+ * - 8 bytes: first timestamp (microseconds since epoch)
+ * - a sequence of blocks, each with a BlockHeader and its payload.
+ *
+ * Each transition of a block is encoded as two varints: the zig-zag delta of
+ * its timestamp (microseconds, relative to the previous transition) and
+ * (node_uid << 3 | status). The payload is optionally compressed with zstd.
+ * A transition takes 3-4 bytes before compression, instead of 9.
+ */
+struct CompressedLog
+{
+  static constexpr char MAGIC[4] = { 'B', 'T', 'C', 'L' };
+  static constexpr char BLOCK_MAGIC[4] = { 'B', 'T', 'C', 'B' };
+  static constexpr uint16_t BYTE_ORDER_MARK = 0x0102;
+  static constexpr uint16_t VERSION = 1;
+
+  enum class Codec : uint8_t
+  {
+    VARINT = 0,
+    ZSTD = 1
+  };
+
+  struct BlockHeader
+  {
+    Codec codec = Codec::VARINT;
+    uint32_t count = 0;
+    uint32_t raw_size = 0;
+    uint32_t stored_size = 0;
+    // range of the timestamps of the block, relative to the first timestamp
+    uint64_t min_timestamp_usec = 0;
+    uint64_t max_timestamp_usec = 0;
+  };
+  // magic(4), codec(1), padding(3), count, raw_size, stored_size, min, max
+  static constexpr size_t BLOCK_HEADER_SIZE = 36;
+
+  static void writeBlockHeader(const BlockHeader& header, char* dst)
+  {
+    std::memset(dst, 0, BLOCK_HEADER_SIZE);
+    std::memcpy(dst, BLOCK_MAGIC, 4);
+    dst[4] = char(header.codec);
+    std::memcpy(dst + 8, &header.count, 4);
+    std::memcpy(dst + 12, &header.raw_size, 4);
+    std::memcpy(dst + 16, &header.stored_size, 4);
+    std::memcpy(dst + 20, &header.min_timestamp_usec, 8);
+    std::memcpy(dst + 28, &header.max_timestamp_usec, 8);
+  }
+
+  /// Return false if src doesn't contain a block header.
+  static bool readBlockHeader(const char* src, size_t size, BlockHeader& header)
+  {
+    if (size < BLOCK_HEADER_SIZE || std::memcmp(src, BLOCK_MAGIC, 4) != 0)
+    {
+      return false;
+    }
+    header.codec = Codec(src[4]);
+    std::memcpy(&header.count, src + 8, 4);
+    std::memcpy(&header.raw_size, src + 12, 4);
+    std::memcpy(&header.stored_size, src + 16, 4);
+    std::memcpy(&header.min_timestamp_usec, src + 20, 8);
+    std::memcpy(&header.max_timestamp_usec, src + 28, 8);
+    return size - BLOCK_HEADER_SIZE >= header.stored_size;
+  }
+
+  static void putVarint(std::string& dst, uint64_t value)
+  {
+    while (value >= 0x80)
+    {
+      dst.push_back(char(uint8_t(value) | 0x80));
+      value >>= 7;
+    }
+    dst.push_back(char(value));
+  }
+
+  static bool getVarint(const char*& src, const char* end, uint64_t& value)
+  {
+    value = 0;
+    for (int shift = 0; src != end && shift < 64; shift += 7)
+    {
+      const auto byte = uint8_t(*src++);
+      value |= uint64_t(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static uint64_t zigzag(int64_t value)
+  {
+    return (uint64_t(value) << 1) ^ uint64_t(value >> 63);
+  }
+
+  static int64_t unzigzag(uint64_t value)
+  {
+    return int64_t(value >> 1) ^ -int64_t(value & 1);
+  }
+};
+
+/**
+ * @brief CompressedFileLogger is an alternative to FileLogger2 for long missions:
+ * it writes the same transitions, block-compressed, with a much smaller
+ * bandwidth to the disk.
+ *
+ * - the tick thread only pushes the transition into a lock-free BoundedQueue;
+ *   when the queue is full, the transition is dropped (see droppedCount())
+ *   or, with OverflowPolicy::BLOCK, the tick thread waits.
+ * - a separate thread encodes the transitions in blocks and appends them to a
+ *   preallocated, memory-mapped file (std::ofstream on other platforms).
+ * - blocks are compressed with zstd if BTCPP_LOGGER_ZSTD is defined
+ *   (link libzstd), and delta/varint-encoded otherwise.
+ *
+ * Use CompressedLogReader to read the file and to seek by time.
+ * The timestamps must be absolute (the default of StatusChangeLogger).
+ */
+class CompressedFileLogger : public StatusChangeLogger
+{
+public:
+  enum class OverflowPolicy
+  {
+    DROP,
+    BLOCK
+  };
+
+  struct Options
+  {
+    /// transitions that can wait to be encoded
+    size_t queue_capacity = 16384;
+    /// transitions in each block
+    size_t block_transitions = 4096;
+    /// initial size of the file; it grows by doubling
+    size_t preallocated_bytes = 16 * 1024 * 1024;
+    OverflowPolicy overflow = OverflowPolicy::DROP;
+    /// used only if compiled with BTCPP_LOGGER_ZSTD
+    int zstd_level = 3;
+  };
+
+  CompressedFileLogger(const Tree& tree, const std::filesystem::path& filepath)
+    : CompressedFileLogger(tree, filepath, Options())
+  {}
+
+  CompressedFileLogger(const Tree& tree, const std::filesystem::path& filepath,
+                       const Options& options)
+    : StatusChangeLogger(tree.rootNode())
+    , options_(options)
+    , queue_(std::max<size_t>(options.queue_capacity, 2))
+  {
+    if (options_.block_transitions == 0)
+    {
+      throw RuntimeError("CompressedFileLogger: block_transitions can't be 0");
+    }
+    output_.open(filepath, options_.preallocated_bytes);
+
+    const std::string xml = WriteTreeToXML(tree, true, true);
+    const auto xml_size = uint32_t(xml.size());
+    first_timestamp_usec_ = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::high_resolution_clock::now().time_since_epoch())
+                                .count();
+    std::string header(CompressedLog::MAGIC, 4);
+    header.append(reinterpret_cast<const char*>(&CompressedLog::BYTE_ORDER_MARK), 2);
+    header.append(reinterpret_cast<const char*>(&CompressedLog::VERSION), 2);
+    header.append(reinterpret_cast<const char*>(&xml_size), 4);
+    header.append(xml);
+    header.append(reinterpret_cast<const char*>(&first_timestamp_usec_), 8);
+    output_.append(header.data(), header.size());
+
+    thread_ = std::thread(&CompressedFileLogger::writerLoop, this);
+  }
+
+  CompressedFileLogger(const CompressedFileLogger& other) = delete;
+  CompressedFileLogger& operator=(const CompressedFileLogger& other) = delete;
+
+  ~CompressedFileLogger() override
+  {
+    {
+      std::unique_lock lk(mutex_);
+      running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+    output_.close();
+  }
+
+  void callback(Duration timestamp, const TreeNode& node, NodeStatus /*prev_status*/,
+                NodeStatus status) override
+  {
+    FileLogger2::Transition transition;
+    const int64_t usec =
+        std::chrono::duration_cast<std::chrono::microseconds>(timestamp).count();
+    transition.timestamp_usec = uint64_t(std::max<int64_t>(usec - first_timestamp_usec_, 0));
+    transition.node_uid = node.UID();
+    transition.status = static_cast<uint8_t>(status);
+
+    if (queue_.tryPush(transition))
+    {
+      return;
+    }
+    // wake up the writer, that is sleeping with a full queue
+    cv_.notify_one();
+    if (options_.overflow == OverflowPolicy::DROP)
+    {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    while (!queue_.tryPush(transition))
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  /// the queue of the transitions, allocated by the constructor
+  [[nodiscard]] size_t bufferedBytes() const
+  {
+    return queue_.capacity() * sizeof(FileLogger2::Transition);
+  }
+
+  /// Write the pending transitions into the file. It blocks until they are written.
+  void flush() override
+  {
+    std::unique_lock lk(mutex_);
+    const uint64_t request = ++flush_requested_;
+    cv_.notify_all();
+    cv_.wait(lk, [&] { return flush_done_ >= request || !running_; });
+  }
+
+  /// Transitions lost because the queue was full.
+  [[nodiscard]] uint64_t droppedCount() const
+  {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /// Transitions written into the file.
+  [[nodiscard]] uint64_t writtenCount() const
+  {
+    return written_.load(std::memory_order_relaxed);
+  }
+
+private:
+  /// Append-only file, preallocated and memory-mapped when possible.
+  class OutputFile
+  {
+  public:
+    void open(const std::filesystem::path& filepath, size_t preallocated_bytes)
+    {
+#if defined(BT_COMPRESSED_LOG_MMAP)
+      fd_ = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if (fd_ < 0)
+      {
+        throw RuntimeError("CompressedFileLogger: can't open the file [",
+                           filepath.string(), "]");
+      }
+      reserve(std::max<size_t>(preallocated_bytes, 4096));
+#else
+      (void)preallocated_bytes;
+      file_.open(filepath, std::ios::binary | std::ios::trunc);
+      if (!file_)
+      {
+        throw RuntimeError("CompressedFileLogger: can't open the file [",
+                           filepath.string(), "]");
+      }
+#endif
+    }
+
+    void append(const char* data, size_t size)
+    {
+#if defined(BT_COMPRESSED_LOG_MMAP)
+      if (size_ + size > capacity_)
+      {
+        reserve(std::max(capacity_ * 2, size_ + size));
+      }
+      std::memcpy(address_ + size_, data, size);
+#else
+      file_.write(data, std::streamsize(size));
+#endif
+      size_ += size;
+    }
+
+    /// A block is reserved in place, to avoid a copy.
+    char* reserveBlock(size_t size)
+    {
+#if defined(BT_COMPRESSED_LOG_MMAP)
+      if (size_ + size > capacity_)
+      {
+        reserve(std::max(capacity_ * 2, size_ + size));
+      }
+      char* ptr = address_ + size_;
+      size_ += size;
+      return ptr;
+#else
+      (void)size;
+      return nullptr;
+#endif
+    }
+
+    void close()
+    {
+#if defined(BT_COMPRESSED_LOG_MMAP)
+      if (fd_ >= 0)
+      {
+        if (address_)
+        {
+          ::munmap(address_, capacity_);
+          address_ = nullptr;
+        }
+        // remove the preallocated space that wasn't used
+        if (::ftruncate(fd_, off_t(size_)) != 0)
+        {
+          std::cerr << "CompressedFileLogger: can't truncate the file" << std::endl;
+        }
+        ::close(fd_);
+        fd_ = -1;
+      }
+#else
+      file_.close();
+#endif
+    }
+
+    bool mapped() const
+    {
+#if defined(BT_COMPRESSED_LOG_MMAP)
+      return true;
+#else
+      return false;
+#endif
+    }
+
+  private:
+    size_t size_ = 0;
+#if defined(BT_COMPRESSED_LOG_MMAP)
+    void reserve(size_t capacity)
+    {
+      if (address_)
+      {
+        ::munmap(address_, capacity_);
+        address_ = nullptr;
+      }
+      if (::ftruncate(fd_, off_t(capacity)) != 0)
+      {
+        throw RuntimeError("CompressedFileLogger: can't resize the file");
+      }
+      void* address = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+      if (address == MAP_FAILED)
+      {
+        throw RuntimeError("CompressedFileLogger: can't map the file");
+      }
+      address_ = static_cast<char*>(address);
+      capacity_ = capacity;
+    }
+
+    int fd_ = -1;
+    char* address_ = nullptr;
+    size_t capacity_ = 0;
+#else
+    std::ofstream file_;
+#endif
+  };
+
+  struct Block
+  {
+    std::string raw;
+    CompressedLog::BlockHeader header;
+    uint64_t previous_usec = 0;
+
+    void add(const FileLogger2::Transition& transition)
+    {
+      const uint64_t usec = transition.timestamp_usec;
+      if (header.count == 0)
+      {
+        // the first timestamp of the block is encoded as its delta from 0
+        header.min_timestamp_usec = usec;
+        header.max_timestamp_usec = usec;
+        previous_usec = 0;
+      }
+      header.min_timestamp_usec = std::min(header.min_timestamp_usec, usec);
+      header.max_timestamp_usec = std::max(header.max_timestamp_usec, usec);
+      CompressedLog::putVarint(raw, CompressedLog::zigzag(int64_t(usec - previous_usec)));
+      CompressedLog::putVarint(raw, (uint64_t(transition.node_uid) << 3) |
+                                        (transition.status & 0x07));
+      previous_usec = usec;
+      header.count++;
+    }
+  };
+
+  void writeBlock(Block& block)
+  {
+    if (block.header.count == 0)
+    {
+      return;
+    }
+    CompressedLog::BlockHeader& header = block.header;
+    header.raw_size = uint32_t(block.raw.size());
+    const char* payload = block.raw.data();
+    header.codec = CompressedLog::Codec::VARINT;
+    header.stored_size = header.raw_size;
+#if defined(BTCPP_LOGGER_ZSTD)
+    compressed_.resize(ZSTD_compressBound(block.raw.size()));
+    const size_t size = ZSTD_compress(compressed_.data(), compressed_.size(),
+                                      block.raw.data(), block.raw.size(),
+                                      options_.zstd_level);
+    if (!ZSTD_isError(size) && size < block.raw.size())
+    {
+      header.codec = CompressedLog::Codec::ZSTD;
+      header.stored_size = uint32_t(size);
+      payload = compressed_.data();
+    }
+#endif
+    if (output_.mapped())
+    {
+      char* dst = output_.reserveBlock(CompressedLog::BLOCK_HEADER_SIZE + header.stored_size);
+      CompressedLog::writeBlockHeader(header, dst);
+      std::memcpy(dst + CompressedLog::BLOCK_HEADER_SIZE, payload, header.stored_size);
+    }
+    else
+    {
+      char header_data[CompressedLog::BLOCK_HEADER_SIZE];
+      CompressedLog::writeBlockHeader(header, header_data);
+      output_.append(header_data, sizeof(header_data));
+      output_.append(payload, header.stored_size);
+    }
+    written_.fetch_add(header.count, std::memory_order_relaxed);
+    block.raw.clear();
+    block.header = {};
+  }
+
+  void writerLoop()
+  {
+    Block block;
+    block.raw.reserve(options_.block_transitions * 4);
+    FileLogger2::Transition transition;
+
+    while (true)
+    {
+      bool running = true;
+      bool flush = false;
+      uint64_t flush_request = 0;
+      {
+        std::unique_lock lk(mutex_);
+        cv_.wait_for(lk, std::chrono::milliseconds(10), [this] {
+          return !running_ || flush_requested_ != flush_done_ ||
+                 queue_.size() * 2 >= queue_.capacity();
+        });
+        running = running_;
+        flush_request = flush_requested_;
+        flush = (flush_request != flush_done_);
+      }
+
+      while (queue_.tryPop(transition))
+      {
+        block.add(transition);
+        if (block.header.count >= options_.block_transitions)
+        {
+          writeBlock(block);
+        }
+      }
+
+      if (!running || flush)
+      {
+        writeBlock(block);
+        std::unique_lock lk(mutex_);
+        flush_done_ = flush_request;
+        cv_.notify_all();
+      }
+      if (!running)
+      {
+        break;
+      }
+    }
+  }
+
+  Options options_;
+  int64_t first_timestamp_usec_ = 0;
+  BoundedQueue<FileLogger2::Transition> queue_;
+  OutputFile output_;
+  std::string compressed_;
+
+  std::atomic<uint64_t> dropped_ = 0;
+  std::atomic<uint64_t> written_ = 0;
+
+  using Mutex = SiteMutex<std::mutex, LockSites::CompressedFileLogger>;
+  Mutex mutex_;
+  ConditionVariableFor<Mutex> cv_;
+  bool running_ = true;
+  uint64_t flush_requested_ = 0;
+  uint64_t flush_done_ = 0;
+  std::thread thread_;
+};
+
+/**
+ * @brief CompressedLogReader reads the files written by CompressedFileLogger.
+ * Only the block headers are read when the file is opened: the transitions
+ * of a time interval are decoded without decoding the whole file.
+ *
+ *   CompressedLogReader reader("mission.btclog");
+ *   reader.forRange(std::chrono::seconds(3600), std::chrono::seconds(3660),
+ *                   [](const FileLogger2::Transition& tr) { ... });
+ */
+class CompressedLogReader
+{
+public:
+  explicit CompressedLogReader(const std::filesystem::path& filepath)
+  {
+    load(filepath);
+    const char* ptr = data_;
+    const char* end = data_ + size_;
+    if (size_ < 12 || std::memcmp(ptr, CompressedLog::MAGIC, 4) != 0)
+    {
+      throw RuntimeError("CompressedLogReader: [", filepath.string(),
+                         "] is not a compressed log");
+    }
+    uint16_t bom = 0;
+    uint16_t version = 0;
+    uint32_t xml_size = 0;
+    std::memcpy(&bom, ptr + 4, 2);
+    std::memcpy(&version, ptr + 6, 2);
+    std::memcpy(&xml_size, ptr + 8, 4);
+    if (bom != CompressedLog::BYTE_ORDER_MARK || version != CompressedLog::VERSION)
+    {
+      throw RuntimeError("CompressedLogReader: unsupported byte order or version");
+    }
+    ptr += 12;
+    if (size_t(end - ptr) < size_t(xml_size) + 8)
+    {
+      throw RuntimeError("CompressedLogReader: truncated file");
+    }
+    xml_.assign(ptr, xml_size);
+    ptr += xml_size;
+    std::memcpy(&first_timestamp_usec_, ptr, 8);
+    ptr += 8;
+
+    // a file that wasn't closed contains preallocated zeros after the last block
+    CompressedLog::BlockHeader header;
+    while (CompressedLog::readBlockHeader(ptr, size_t(end - ptr), header))
+    {
+      const char* payload = ptr + CompressedLog::BLOCK_HEADER_SIZE;
+      blocks_.push_back({ header, payload });
+      transitions_count_ += header.count;
+      ptr = payload + header.stored_size;
+    }
+  }
+
+  /// The tree, as written by WriteTreeToXML()
+  [[nodiscard]] const std::string& xml() const
+  {
+    return xml_;
+  }
+
+  /// The timestamps of the transitions are relative to this one.
+  [[nodiscard]] Duration firstTimestamp() const
+  {
+    return std::chrono::microseconds(first_timestamp_usec_);
+  }
+
+  [[nodiscard]] size_t blocksCount() const
+  {
+    return blocks_.size();
+  }
+
+  [[nodiscard]] uint64_t transitionsCount() const
+  {
+    return transitions_count_;
+  }
+
+  /// Invoke func(const FileLogger2::Transition&) for each transition.
+  template <typename Function>
+  void forEach(Function&& func) const
+  {
+    forRange(Duration::min(), Duration::max(), std::forward<Function>(func));
+  }
+
+  /// Invoke func(const FileLogger2::Transition&) for each transition with
+  /// timestamp (relative to firstTimestamp()) in the interval [from, to].
+  template <typename Function>
+  void forRange(Duration from, Duration to, Function&& func) const
+  {
+    const auto toUsec = [](Duration time) -> uint64_t {
+      if (time <= Duration::zero())
+      {
+        return 0;
+      }
+      if (time == Duration::max())
+      {
+        return std::numeric_limits<uint64_t>::max();
+      }
+      return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(time).count());
+    };
+    const uint64_t from_usec = toUsec(from);
+    const uint64_t to_usec = toUsec(to);
+
+    std::string buffer;
+    for (const auto& block : blocks_)
+    {
+      if (block.header.max_timestamp_usec < from_usec ||
+          block.header.min_timestamp_usec > to_usec)
+      {
+        continue;
+      }
+      decodeBlock(block, buffer, [&](const FileLogger2::Transition& transition) {
+        if (transition.timestamp_usec >= from_usec && transition.timestamp_usec <= to_usec)
+        {
+          func(transition);
+        }
+      });
+    }
+  }
+
+private:
+  struct BlockRecord
+  {
+    CompressedLog::BlockHeader header;
+    const char* payload;
+  };
+
+  template <typename Function>
+  void decodeBlock(const BlockRecord& block, std::string& buffer, Function&& func) const
+  {
+    const char* ptr = block.payload;
+    const char* end = block.payload + block.header.stored_size;
+    if (block.header.codec == CompressedLog::Codec::ZSTD)
+    {
+#if defined(BTCPP_LOGGER_ZSTD)
+      buffer.resize(block.header.raw_size);
+      const size_t size = ZSTD_decompress(buffer.data(), buffer.size(), ptr,
+                                          block.header.stored_size);
+      if (ZSTD_isError(size) || size != block.header.raw_size)
+      {
+        throw RuntimeError("CompressedLogReader: corrupted block");
+      }
+      ptr = buffer.data();
+      end = ptr + size;
+#else
+      (void)buffer;
+      throw RuntimeError("CompressedLogReader: the log is compressed with zstd, "
+                         "compile with BTCPP_LOGGER_ZSTD to read it");
+#endif
+    }
+    else if (block.header.codec != CompressedLog::Codec::VARINT)
+    {
+      throw RuntimeError("CompressedLogReader: unknown codec");
+    }
+
+    FileLogger2::Transition transition;
+    uint64_t usec = 0;
+    for (uint32_t i = 0; i < block.header.count; i++)
+    {
+      uint64_t delta = 0;
+      uint64_t node = 0;
+      if (!CompressedLog::getVarint(ptr, end, delta) ||
+          !CompressedLog::getVarint(ptr, end, node))
+      {
+        throw RuntimeError("CompressedLogReader: corrupted block");
+      }
+      usec += uint64_t(CompressedLog::unzigzag(delta));
+      transition.timestamp_usec = usec;
+      transition.node_uid = uint16_t(node >> 3);
+      transition.status = uint8_t(node & 0x07);
+      func(static_cast<const FileLogger2::Transition&>(transition));
+    }
+  }
+
+  void load(const std::filesystem::path& filepath)
+  {
+#if defined(BT_COMPRESSED_LOG_MMAP)
+    const int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      throw RuntimeError("CompressedLogReader: can't open the file [", filepath.string(),
+                         "]");
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+      ::close(fd);
+      throw RuntimeError("CompressedLogReader: can't read the file [", filepath.string(),
+                         "]");
+    }
+    const size_t size = size_t(info.st_size);
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED)
+    {
+      throw RuntimeError("CompressedLogReader: can't map the file [", filepath.string(),
+                         "]");
+    }
+    mapping_ = std::shared_ptr<const void>(
+        address, [size](const void* ptr) { ::munmap(const_cast<void*>(ptr), size); });
+    data_ = static_cast<const char*>(address);
+    size_ = size;
+#else
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file)
+    {
+      throw RuntimeError("CompressedLogReader: can't open the file [", filepath.string(),
+                         "]");
+    }
+    auto content = std::make_shared<std::string>((std::istreambuf_iterator<char>(file)),
+                                                 std::istreambuf_iterator<char>());
+    data_ = content->data();
+    size_ = content->size();
+    mapping_ = std::move(content);
+#endif
+  }
+
+  std::shared_ptr<const void> mapping_;
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  std::string xml_;
+  int64_t first_timestamp_usec_ = 0;
+  std::vector<BlockRecord> blocks_;
+  uint64_t transitions_count_ = 0;
+};
+
+}   // namespace BT
+
+#undef BT_COMPRESSED_LOG_MMAP
@@ -9,6 +9,9 @@ namespace BT
 /**
  * @brief StdCoutLogger is a very simple logger that
  * displays all the transitions on the console.
+ *
+ * It prints (and flushes) in the tick thread: to avoid blocking the tree
+ * on a slow console, use TextSinkLogger (bt_text_sink.h).
  */
 
 class StdCoutLogger : public StatusChangeLogger
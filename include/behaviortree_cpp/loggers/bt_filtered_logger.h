@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "behaviortree_cpp/loggers/abstract_logger.h"
+
+namespace BT
+{
+
+/**
+ * @brief FilteredLogger passes to another logger (the target) only the
+ * transitions that match its filters. Any StatusChangeLogger can be the
+ * target, including the ones of the library: FileLogger2, SqliteLogger,
+ * MinitraceLogger, Groot2Publisher...
+ *
+ *   FileLogger2 file_logger(tree, "failures.btlog");
+ *   FilteredLogger filtered(tree, file_logger);
+ *   filtered.setPathFilter({ "MainTree/Navigate*" });
+ *   filtered.enableFlightRecorder(100);
+ *
+ * The target doesn't receive anymore the notifications of the nodes: it is
+ * invoked by the FilteredLogger, that must be destroyed before it. The
+ * setEnabled(), enableTransitionToIdle() and setTimestampType() of the target
+ * still apply, before the filters.
+ *
+ * The filters are applied in this order. Configure them before ticking the tree.
+ */
+class FilteredLogger : public StatusChangeLogger
+{
+public:
+  FilteredLogger(const Tree& tree, StatusChangeLogger& target) :
+    StatusChangeLogger(tree.rootNode()), target_(target), root_node_(tree.rootNode())
+  {
+    target_.subscribers_.clear();
+  }
+
+  void flush() override
+  {
+    target_.flush();
+  }
+
+  /// Log only the nodes whose fullPath() matches one of the wildcards
+  /// (see WildcardMatch). An empty list logs all the nodes.
+  void setPathFilter(const std::vector<std::string>& wildcards)
+  {
+    allowed_uids_.clear();
+    path_filter_ = !wildcards.empty();
+    if (!path_filter_ || !root_node_)
+    {
+      return;
+    }
+    applyRecursiveVisitor(root_node_, [&](TreeNode* node) {
+      const uint16_t uid = node->UID();
+      if (allowed_uids_.size() <= uid)
+      {
+        allowed_uids_.resize(size_t(uid) + 1, 0);
+      }
+      for (const auto& wildcard : wildcards)
+      {
+        if (WildcardMatch(node->fullPath(), wildcard))
+        {
+          allowed_uids_[uid] = 1;
+          break;
+        }
+      }
+    });
+  }
+
+  /// Log only the transitions to FAILURE.
+  void setOnlyFailures(bool only_failures)
+  {
+    only_failures_ = only_failures;
+  }
+
+  /**
+   * @brief Log the transitions of 1 tick every `one_every`. Ticks are
+   * identified by time: the transitions in the interval
+   * [k * one_every * tick_period, (k * one_every + 1) * tick_period) are
+   * logged, i.e. tick_period must be the period of the tree.
+   * one_every = 1 disables the sampling.
+   */
+  void setSampling(unsigned one_every, Duration tick_period)
+  {
+    sample_every_ = std::max(one_every, 1u);
+    sample_period_ = tick_period;
+  }
+
+  /// Custom predicate: the transition is logged if it returns true.
+  using TransitionFilter =
+      std::function<bool(const TreeNode& node, NodeStatus prev_status, NodeStatus status)>;
+  void setFilter(TransitionFilter filter)
+  {
+    predicate_ = std::move(filter);
+  }
+
+  /**
+   * @brief Flight recorder: the last `capacity` transitions are kept in a
+   * ring buffer and passed to the target only when a node fails; then the
+   * target is flushed. capacity = 0 disables it.
+   */
+  void enableFlightRecorder(size_t capacity)
+  {
+    std::unique_lock lk(recorder_mutex_);
+    recorder_capacity_ = capacity;
+    recorder_.clear();
+  }
+
+  /// Remove all the filters.
+  void resetFilters()
+  {
+    setPathFilter({});
+    only_failures_ = false;
+    sample_every_ = 1;
+    predicate_ = {};
+    enableFlightRecorder(0);
+  }
+
+  /// Memory used by the flight recorder, in bytes (see Tree::memoryStats).
+  [[nodiscard]] size_t bufferedBytes() const
+  {
+    std::unique_lock lk(recorder_mutex_);
+    return recorder_.size() * sizeof(Recorded);
+  }
+
+private:
+  struct Recorded
+  {
+    TimePoint timestamp;
+    const TreeNode* node;
+    NodeStatus prev_status;
+    NodeStatus status;
+  };
+
+  StatusChangeLogger& target_;
+  TreeNode* root_node_ = nullptr;
+  const TimePoint first_timestamp_ = std::chrono::high_resolution_clock::now();
+
+  std::vector<uint8_t> allowed_uids_;
+  bool path_filter_ = false;
+  bool only_failures_ = false;
+  unsigned sample_every_ = 1;
+  Duration sample_period_ = {};
+  TransitionFilter predicate_;
+
+  // the transitions may come from different threads
+  mutable std::mutex recorder_mutex_;
+  size_t recorder_capacity_ = 0;
+  std::deque<Recorded> recorder_;
+
+  // the timestamps are absolute, the default of StatusChangeLogger
+  void callback(Duration timestamp, const TreeNode& node, NodeStatus prev,
+                NodeStatus status) override
+  {
+    if (!target_.enabled() ||
+        (status == NodeStatus::IDLE && !target_.showsTransitionToIdle()))
+    {
+      return;
+    }
+    const TimePoint time(timestamp);
+    if (path_filter_ &&
+        (node.UID() >= allowed_uids_.size() || !allowed_uids_[node.UID()]))
+    {
+      return;
+    }
+    if (only_failures_ && status != NodeStatus::FAILURE)
+    {
+      return;
+    }
+    if (sample_every_ > 1 && sample_period_ > Duration::zero())
+    {
+      const auto tick = (time - first_timestamp_) / sample_period_;
+      if (tick % sample_every_ != 0)
+      {
+        return;
+      }
+    }
+    if (predicate_ && !predicate_(node, prev, status))
+    {
+      return;
+    }
+    if (recorder_capacity_ == 0)
+    {
+      forward(time, node, prev, status);
+      return;
+    }
+
+    std::deque<Recorded> recorded;
+    {
+      std::unique_lock lk(recorder_mutex_);
+      if (recorder_.size() >= recorder_capacity_)
+      {
+        recorder_.pop_front();
+      }
+      recorder_.push_back({ time, &node, prev, status });
+      if (status != NodeStatus::FAILURE)
+      {
+        return;
+      }
+      std::swap(recorded, recorder_);
+    }
+    for (const auto& transition : recorded)
+    {
+      forward(transition.timestamp, *transition.node, transition.prev_status,
+              transition.status);
+    }
+    target_.flush();
+  }
+
+  // with the timestamp type of the target
+  void forward(TimePoint timestamp, const TreeNode& node, NodeStatus prev,
+               NodeStatus status)
+  {
+    if (target_.type_ == TimestampType::absolute)
+    {
+      target_.callback(timestamp.time_since_epoch(), node, prev, status);
+    }
+    else
+    {
+      target_.callback(timestamp - target_.first_timestamp_, node, prev, status);
+    }
+  }
+};
+
+}   // namespace BT
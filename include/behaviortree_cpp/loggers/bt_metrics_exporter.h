@@ -0,0 +1,678 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define BT_METRICS_POSIX_SOCKETS
+#endif
+
+#include "behaviortree_cpp/loggers/bt_statistics_observer.h"
+#include "behaviortree_cpp/utils/lock_profiler.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief MetricsExporter publishes the health of a tree in the text format
+ * of Prometheus (or OpenMetrics, that the OpenTelemetry Collector scrapes
+ * with its "prometheus" receiver):
+ *
+ * - bt_tree_ticks_total, bt_tree_tick_duration_seconds (summary): ticks of the root;
+ * - bt_tree_running_nodes: number of nodes currently RUNNING;
+ * - bt_node_transitions_total{group, status}: transitions to SUCCESS,
+ *   FAILURE and SKIPPED, aggregated by group of nodes;
+ * - bt_blackboard_queue_depth{key}: size of the queues added with addQueueDepth();
+ * - bt_tree_memory_bytes{category}: see addMemoryStats();
+ * - bt_lock_acquisitions_total, bt_lock_contentions_total, bt_lock_wait_seconds_total
+ *   and bt_lock_hold_seconds_total{site}: contention of the SiteMutex mutexes,
+ *   only if compiled with BTCPP_LOCK_PROFILING (see LockProfiler; process-wide);
+ * - any gauge added with addGauge().
+ *
+ * The tick thread only updates atomic counters (through StatisticsObserver);
+ * the text is built by the thread that calls serialize(), for instance the
+ * one started by listen(), that answers to "GET /metrics":
+ *
+ *   MetricsExporter exporter(tree);
+ *   exporter.listen(9464);
+ *
+ * To bound the cardinality of the labels, the nodes are grouped by the
+ * longest of Options::path_prefixes that matches their fullPath() or, if
+ * none matches, by the path of their subtree. Groups beyond
+ * Options::max_groups are merged in the group "other".
+ */
+class MetricsExporter : public StatusChangeLogger
+{
+public:
+  enum class Format
+  {
+    PROMETHEUS,
+    OPEN_METRICS
+  };
+
+  struct Options
+  {
+    /// value of the label "tree"
+    std::string tree_name = "tree";
+    /// see the description of the class
+    std::vector<std::string> path_prefixes;
+    /// number of levels of subtrees used to group the nodes not matching path_prefixes
+    unsigned subtree_depth = 1;
+    size_t max_groups = 64;
+    /// needed by bt_tree_tick_duration_seconds. It uses the pre and post tick
+    /// callbacks of the nodes (see StatisticsObserver::enableLatencyHistograms)
+    bool latency_histograms = true;
+    /// publish bt_lock_*, if LockProfiler::compiledIn()
+    bool lock_contention = true;
+  };
+
+  MetricsExporter(const Tree& tree) : MetricsExporter(tree, Options())
+  {}
+
+  MetricsExporter(const Tree& tree, const Options& options);
+
+  ~MetricsExporter() override
+  {
+    stop();
+  }
+
+  void flush() override {}
+
+  /// Gauge computed when the metrics are serialized, in the thread that serializes.
+  void addGauge(const std::string& name, const std::string& help,
+                std::function<double()> value);
+
+  /**
+   * @brief Publish the number of elements of the queue stored in the blackboard
+   * with the given key, as bt_blackboard_queue_depth{key="..."}.
+   * Queue is SharedQueue<T> or SharedBoundedQueue<T> (or any pointer to a
+   * container with size()). The entry is locked while the size is read.
+   */
+  template <typename Queue>
+  void addQueueDepth(const std::string& key, Blackboard::Ptr blackboard);
+
+  /**
+   * @brief Publish Tree::memoryStats() as bt_tree_memory_bytes{category="..."}.
+   * The statistics are computed at most once every min_interval, when the
+   * metrics are serialized. The tree must outlive the exporter.
+   */
+  void addMemoryStats(const Tree& tree, Tree::MemoryStatsOptions options = {},
+                      std::chrono::milliseconds min_interval = std::chrono::seconds(10));
+
+  [[nodiscard]] std::string serialize(Format format = Format::PROMETHEUS) const;
+
+  /**
+   * @brief Start a thread that answers the HTTP requests "GET /metrics".
+   * If the request accepts "application/openmetrics-text", that format is used.
+   *
+   * @param port     TCP port; 0 to let the system choose it (see port()).
+   * @param address  IPv4 address to bind.
+   * @return false if the socket can't be opened.
+   */
+  bool listen(uint16_t port, const std::string& address = "0.0.0.0");
+
+  /// Stop the thread started by listen().
+  void stop();
+
+  /// Port used by listen(), 0 if it is not listening.
+  [[nodiscard]] uint16_t port() const
+  {
+    return port_.load();
+  }
+
+  [[nodiscard]] const StatisticsObserver& observer() const
+  {
+    return *observer_;
+  }
+
+private:
+  void callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
+                NodeStatus status) override;
+
+  std::string groupOf(const std::string& path) const;
+
+  static std::string escapeLabel(const std::string& value);
+
+  static void writeValue(std::ostream& out, double value);
+
+  void serve();
+
+  struct Gauge
+  {
+    std::string name;
+    std::string help;
+    std::string labels;
+    std::function<double()> value;
+  };
+
+  Options options_;
+  std::unique_ptr<StatisticsObserver> observer_;
+  uint16_t root_uid_ = 0;
+  // group of each node, indexed by UID; empty if unknown
+  std::vector<int> group_of_uid_;
+  std::vector<std::string> groups_;
+  std::atomic<int64_t> running_nodes_ = 0;
+
+  mutable std::mutex gauges_mutex_;
+  std::vector<Gauge> gauges_;
+
+  std::atomic<bool> serving_ = false;
+  std::atomic<uint16_t> port_ = 0;
+  int socket_ = -1;
+  std::thread server_thread_;
+};
+
+//--------------------------------------------
+
+inline MetricsExporter::MetricsExporter(const Tree& tree, const Options& options) :
+  StatusChangeLogger(tree.rootNode()), options_(options)
+{
+  observer_ = std::make_unique<StatisticsObserver>(tree);
+  if (options_.latency_histograms)
+  {
+    observer_->enableLatencyHistograms(tree);
+  }
+  root_uid_ = tree.rootNode()->UID();
+
+  const auto& uid_to_path = observer_->uidToPath();
+  const uint16_t max_uid = uid_to_path.empty() ? 0 : uid_to_path.rbegin()->first;
+  group_of_uid_.assign(size_t(max_uid) + 1, -1);
+  for (const auto& [uid, path] : uid_to_path)
+  {
+    std::string group = groupOf(path);
+    auto it = std::find(groups_.begin(), groups_.end(), group);
+    if (it == groups_.end())
+    {
+      if (groups_.size() + 1 >= options_.max_groups && group != "other")
+      {
+        group = "other";
+        it = std::find(groups_.begin(), groups_.end(), group);
+      }
+      if (it == groups_.end())
+      {
+        it = groups_.insert(groups_.end(), group);
+      }
+    }
+    group_of_uid_[uid] = int(it - groups_.begin());
+  }
+}
+
+inline void MetricsExporter::callback(Duration, const TreeNode&,
+                                      NodeStatus prev_status, NodeStatus status)
+{
+  if (status == NodeStatus::RUNNING && prev_status != NodeStatus::RUNNING)
+  {
+    running_nodes_.fetch_add(1, std::memory_order_relaxed);
+  }
+  else if (prev_status == NodeStatus::RUNNING && status != NodeStatus::RUNNING)
+  {
+    running_nodes_.fetch_sub(1, std::memory_order_relaxed);
+  }
+}
+
+inline std::string MetricsExporter::groupOf(const std::string& path) const
+{
+  const std::string* best = nullptr;
+  for (const auto& prefix : options_.path_prefixes)
+  {
+    if (path.compare(0, prefix.size(), prefix) == 0 &&
+        (!best || prefix.size() > best->size()))
+    {
+      best = &prefix;
+    }
+  }
+  if (best)
+  {
+    return *best;
+  }
+  // the last element of the path is the name of the node
+  const auto last_separator = path.rfind('/');
+  if (last_separator == std::string::npos || options_.subtree_depth == 0)
+  {
+    return "/";
+  }
+  size_t end = last_separator;
+  size_t position = 0;
+  for (unsigned level = 0; level < options_.subtree_depth; level++)
+  {
+    const auto next = path.find('/', position);
+    if (next > last_separator)
+    {
+      break;
+    }
+    end = next;
+    position = next + 1;
+  }
+  return path.substr(0, end);
+}
+
+inline void MetricsExporter::addGauge(const std::string& name, const std::string& help,
+                                      std::function<double()> value)
+{
+  std::scoped_lock lock(gauges_mutex_);
+  gauges_.push_back({ name, help, {}, std::move(value) });
+}
+
+template <typename Queue>
+inline void MetricsExporter::addQueueDepth(const std::string& key,
+                                           Blackboard::Ptr blackboard)
+{
+  // don't keep the blackboard alive
+  std::weak_ptr<Blackboard> weak_blackboard = blackboard;
+  auto depth = [weak_blackboard, key]() -> double {
+    auto bb = weak_blackboard.lock();
+    if (!bb)
+    {
+      return NAN;
+    }
+    if (auto any_ref = bb->getAnyLocked(key))
+    {
+      const Any* any = any_ref.get();
+      if (!any->empty() && any->isType<Queue>())
+      {
+        const auto& queue = any->cast<Queue>();
+        return queue ? double(queue->size()) : 0.0;
+      }
+    }
+    return NAN;
+  };
+  std::scoped_lock lock(gauges_mutex_);
+  gauges_.push_back({ "bt_blackboard_queue_depth",
+                      "Number of elements in a queue of the blackboard",
+                      "key=\"" + escapeLabel(key) + "\"", std::move(depth) });
+}
+
+inline void MetricsExporter::addMemoryStats(const Tree& tree, Tree::MemoryStatsOptions options,
+                                            std::chrono::milliseconds min_interval)
+{
+  struct Sampler
+  {
+    const Tree* tree;
+    Tree::MemoryStatsOptions options;
+    std::chrono::milliseconds min_interval;
+    std::mutex mutex;
+    std::chrono::steady_clock::time_point last_sample;
+    bool sampled = false;
+    Tree::MemoryStats stats;
+
+    double get(size_t Tree::MemoryStats::*field)
+    {
+      std::scoped_lock lock(mutex);
+      const auto now = std::chrono::steady_clock::now();
+      if (!sampled || now - last_sample >= min_interval)
+      {
+        stats = tree->memoryStats(options);
+        last_sample = now;
+        sampled = true;
+      }
+      return double(stats.*field);
+    }
+  };
+  auto sampler = std::make_shared<Sampler>();
+  sampler->tree = &tree;
+  sampler->options = std::move(options);
+  sampler->min_interval = min_interval;
+
+  const std::pair<const char*, size_t Tree::MemoryStats::*> categories[] = {
+    { "nodes", &Tree::MemoryStats::nodes_bytes },
+    { "configs", &Tree::MemoryStats::config_bytes },
+    { "manifests", &Tree::MemoryStats::manifests_bytes },
+    { "blackboards", &Tree::MemoryStats::blackboard_bytes },
+    { "scripts", &Tree::MemoryStats::scripts_bytes },
+    { "buffers", &Tree::MemoryStats::buffers_bytes },
+  };
+  std::scoped_lock lock(gauges_mutex_);
+  for (const auto& [category, field] : categories)
+  {
+    gauges_.push_back({ "bt_tree_memory_bytes", "Estimated memory used by the tree",
+                        StrCat("category=\"", category, "\""),
+                        [sampler, field = field] { return sampler->get(field); } });
+  }
+}
+
+inline std::string MetricsExporter::escapeLabel(const std::string& value)
+{
+  std::string out;
+  out.reserve(value.size());
+  for (char c : value)
+  {
+    switch (c)
+    {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '"':
+        out += "\\\"";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      default:
+        out += c;
+    }
+  }
+  return out;
+}
+
+inline void MetricsExporter::writeValue(std::ostream& out, double value)
+{
+  if (std::isnan(value))
+  {
+    out << "NaN";
+  }
+  else if (std::isinf(value))
+  {
+    out << (value > 0 ? "+Inf" : "-Inf");
+  }
+  else
+  {
+    out << value;
+  }
+}
+
+inline std::string MetricsExporter::serialize(Format format) const
+{
+  const bool open_metrics = (format == Format::OPEN_METRICS);
+  // in OpenMetrics the name of a counter doesn't include "_total"
+  auto counter_name = [open_metrics](const std::string& name) {
+    return open_metrics ? name.substr(0, name.size() - 6) : name;
+  };
+
+  std::ostringstream out;
+  out.precision(9);
+  const std::string tree_label = "tree=\"" + escapeLabel(options_.tree_name) + "\"";
+  const auto snapshot = observer_->snapshot();
+  StatisticsObserver::NodeStatistics root_stats;
+  if (root_uid_ < snapshot.nodes.size())
+  {
+    root_stats = snapshot.nodes[root_uid_];
+  }
+
+  const StatisticsObserver::NodeLatency* root_latency = nullptr;
+  if (options_.latency_histograms)
+  {
+    root_latency = &observer_->getLatency(root_uid_);
+  }
+
+  //---- ticks of the root
+  out << "# HELP " << counter_name("bt_tree_ticks_total")
+      << " Ticks of the root of the tree\n"
+      << "# TYPE " << counter_name("bt_tree_ticks_total") << " counter\n"
+      << "bt_tree_ticks_total{" << tree_label << "} "
+      << (root_latency ? root_latency->tick_duration.count() :
+                         uint64_t(root_stats.transitions_count))
+      << "\n";
+
+  if (root_latency)
+  {
+    const auto& histogram = root_latency->tick_duration;
+    auto seconds = [](std::chrono::microseconds usec) { return double(usec.count()) * 1e-6; };
+    out << "# HELP bt_tree_tick_duration_seconds Duration of the ticks of the root\n"
+        << "# TYPE bt_tree_tick_duration_seconds summary\n";
+    for (double quantile : { 0.5, 0.9, 0.99 })
+    {
+      out << "bt_tree_tick_duration_seconds{" << tree_label << ",quantile=\"" << quantile
+          << "\"} ";
+      writeValue(out, seconds(histogram.percentile(quantile)));
+      out << "\n";
+    }
+    out << "bt_tree_tick_duration_seconds_sum{" << tree_label << "} ";
+    writeValue(out, seconds(histogram.sum()));
+    out << "\nbt_tree_tick_duration_seconds_count{" << tree_label << "} "
+        << histogram.count() << "\n";
+  }
+
+  //---- RUNNING nodes
+  out << "# HELP bt_tree_running_nodes Number of nodes in the status RUNNING\n"
+      << "# TYPE bt_tree_running_nodes gauge\n"
+      << "bt_tree_running_nodes{" << tree_label << "} "
+      << std::max<int64_t>(0, running_nodes_.load(std::memory_order_relaxed)) << "\n";
+
+  //---- transitions, by group
+  struct Counts
+  {
+    uint64_t success = 0;
+    uint64_t failure = 0;
+    uint64_t skipped = 0;
+  };
+  std::vector<Counts> counts(groups_.size());
+  for (size_t uid = 0; uid < snapshot.nodes.size() && uid < group_of_uid_.size(); uid++)
+  {
+    const int group = group_of_uid_[uid];
+    if (group >= 0)
+    {
+      counts[group].success += snapshot.nodes[uid].success_count;
+      counts[group].failure += snapshot.nodes[uid].failure_count;
+      counts[group].skipped += snapshot.nodes[uid].skip_count;
+    }
+  }
+  out << "# HELP " << counter_name("bt_node_transitions_total")
+      << " Transitions of the nodes to SUCCESS, FAILURE or SKIPPED\n"
+      << "# TYPE " << counter_name("bt_node_transitions_total") << " counter\n";
+  for (size_t i = 0; i < groups_.size(); i++)
+  {
+    const std::string labels = tree_label + ",group=\"" + escapeLabel(groups_[i]) + "\"";
+    out << "bt_node_transitions_total{" << labels << ",status=\"success\"} "
+        << counts[i].success << "\n"
+        << "bt_node_transitions_total{" << labels << ",status=\"failure\"} "
+        << counts[i].failure << "\n"
+        << "bt_node_transitions_total{" << labels << ",status=\"skipped\"} "
+        << counts[i].skipped << "\n";
+  }
+
+  //---- lock contention
+  if (LockProfiler::compiledIn() && options_.lock_contention)
+  {
+    const auto sites = observer_->lockContention();
+    auto seconds = [](std::chrono::nanoseconds ns) { return double(ns.count()) * 1e-9; };
+    auto write_counter = [&](const std::string& name, const char* help, auto value) {
+      out << "# HELP " << counter_name(name) << " " << help << "\n"
+          << "# TYPE " << counter_name(name) << " counter\n";
+      for (const auto& site : sites)
+      {
+        out << name << "{" << tree_label << ",site=\"" << escapeLabel(site.site) << "\"} ";
+        writeValue(out, value(site));
+        out << "\n";
+      }
+    };
+    using Site = LockProfiler::SiteStatistics;
+    write_counter("bt_lock_acquisitions_total", "Acquisitions of the mutexes, per lock site",
+                  [](const Site& site) { return double(site.acquisitions); });
+    write_counter("bt_lock_contentions_total", "Acquisitions that waited for the mutex",
+                  [](const Site& site) { return double(site.contentions); });
+    write_counter("bt_lock_wait_seconds_total", "Time spent waiting for the mutexes",
+                  [&](const Site& site) { return seconds(site.wait); });
+    write_counter("bt_lock_hold_seconds_total", "Time the mutexes were held",
+                  [&](const Site& site) { return seconds(site.hold); });
+  }
+
+  //---- gauges
+  {
+    std::scoped_lock lock(gauges_mutex_);
+    std::vector<std::string> declared;
+    for (const auto& gauge : gauges_)
+    {
+      if (std::find(declared.begin(), declared.end(), gauge.name) == declared.end())
+      {
+        declared.push_back(gauge.name);
+        out << "# HELP " << gauge.name << " " << gauge.help << "\n"
+            << "# TYPE " << gauge.name << " gauge\n";
+        // samples of the same metric must be contiguous
+        for (const auto& sample : gauges_)
+        {
+          if (sample.name != gauge.name)
+          {
+            continue;
+          }
+          out << sample.name << "{" << tree_label
+              << (sample.labels.empty() ? "" : ",") << sample.labels << "} ";
+          writeValue(out, sample.value ? sample.value() : NAN);
+          out << "\n";
+        }
+      }
+    }
+  }
+
+  if (open_metrics)
+  {
+    out << "# EOF\n";
+  }
+  return out.str();
+}
+
+#if defined(BT_METRICS_POSIX_SOCKETS)
+
+inline bool MetricsExporter::listen(uint16_t port, const std::string& address)
+{
+  stop();
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1)
+  {
+    return false;
+  }
+  socket_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (socket_ < 0)
+  {
+    return false;
+  }
+  const int reuse = 1;
+  setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  socklen_t addr_len = sizeof(addr);
+  if (::bind(socket_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      ::listen(socket_, 8) != 0 ||
+      getsockname(socket_, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0)
+  {
+    ::close(socket_);
+    socket_ = -1;
+    return false;
+  }
+  port_ = ntohs(addr.sin_port);
+  serving_ = true;
+  server_thread_ = std::thread(&MetricsExporter::serve, this);
+  return true;
+}
+
+inline void MetricsExporter::stop()
+{
+  serving_ = false;
+  if (server_thread_.joinable())
+  {
+    server_thread_.join();
+  }
+  if (socket_ >= 0)
+  {
+    ::close(socket_);
+    socket_ = -1;
+  }
+  port_ = 0;
+}
+
+inline void MetricsExporter::serve()
+{
+  while (serving_)
+  {
+    pollfd listening = { socket_, POLLIN, 0 };
+    if (poll(&listening, 1, 100) <= 0)
+    {
+      continue;
+    }
+    const int client = ::accept(socket_, nullptr, nullptr);
+    if (client < 0)
+    {
+      continue;
+    }
+    // read the request line and the headers; the body is ignored
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+    {
+      pollfd readable = { client, POLLIN, 0 };
+      if (poll(&readable, 1, 1000) <= 0)
+      {
+        break;
+      }
+      const auto received = ::recv(client, buffer, sizeof(buffer), 0);
+      if (received <= 0)
+      {
+        break;
+      }
+      request.append(buffer, size_t(received));
+    }
+
+    std::string status = "200 OK";
+    std::string content_type;
+    std::string body;
+    if (request.rfind("GET /metrics", 0) == 0)
+    {
+      if (request.find("application/openmetrics-text") != std::string::npos)
+      {
+        content_type = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+        body = serialize(Format::OPEN_METRICS);
+      }
+      else
+      {
+        content_type = "text/plain; version=0.0.4; charset=utf-8";
+        body = serialize(Format::PROMETHEUS);
+      }
+    }
+    else
+    {
+      status = "404 Not Found";
+      content_type = "text/plain";
+      body = "Not Found\n";
+    }
+    const std::string reply = "HTTP/1.1 " + status + "\r\nContent-Type: " + content_type +
+                              "\r\nContent-Length: " + std::to_string(body.size()) +
+                              "\r\nConnection: close\r\n\r\n" + body;
+    size_t sent = 0;
+    while (sent < reply.size())
+    {
+      const auto count = ::send(client, reply.data() + sent, reply.size() - sent,
+#if defined(MSG_NOSIGNAL)
+                                MSG_NOSIGNAL
+#else
+                                0
+#endif
+      );
+      if (count <= 0)
+      {
+        break;
+      }
+      sent += size_t(count);
+    }
+    ::close(client);
+  }
+}
+
+#else
+
+inline bool MetricsExporter::listen(uint16_t, const std::string&)
+{
+  throw RuntimeError("MetricsExporter::listen() is not supported on this platform");
+}
+
+inline void MetricsExporter::stop()
+{}
+
+inline void MetricsExporter::serve()
+{}
+
+#endif
+
+}   // namespace BT
+
+#undef BT_METRICS_POSIX_SOCKETS
@@ -0,0 +1,406 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sqlite3.h>
+
+#include "behaviortree_cpp/loggers/abstract_logger.h"
+#include "behaviortree_cpp/utils/lock_profiler.hpp"
+#include "behaviortree_cpp/xml_parsing.h"
+
+namespace BT
+{
+
+/**
+ * @brief BatchedSqliteLogger writes the same database of SqliteLogger
+ * (readable by Groot2), but it is meant for high tick rates:
+ *
+ * - rows are inserted in transactions of Options::batch_rows rows, or every
+ *   Options::batch_period, using a single prepared statement;
+ * - the database uses WAL mode with synchronous=NORMAL;
+ * - optionally, each session has its own table of transitions
+ *   ("Transitions_<session_id>"), that makes a session cheap to delete.
+ *   Groot2 reads only the table "Transitions".
+ *
+ * queueDepth() and maxQueueDepth() tell if the writer keeps up with the tree.
+ * It uses the sqlite3 C API directly: link SQLite3.
+ */
+class BatchedSqliteLogger : public StatusChangeLogger
+{
+public:
+  struct Options
+  {
+    /// if true, add this recording to the database
+    bool append = false;
+    /// rows in each transaction
+    size_t batch_rows = 1000;
+    /// maximum time between a transition and its transaction
+    std::chrono::milliseconds batch_period = std::chrono::milliseconds(100);
+    /// journal_mode=WAL and synchronous=NORMAL
+    bool wal_mode = true;
+    /// store the transitions of each session in a separate table
+    bool partition_sessions = false;
+  };
+
+  /**
+   * @param tree      the tree to log
+   * @param filepath  path of the file where info will be stored. To read it
+   *                  with Groot2, you must use the suffix ".db3".
+   */
+  BatchedSqliteLogger(const Tree& tree, const std::filesystem::path& filepath)
+    : BatchedSqliteLogger(tree, filepath, Options())
+  {}
+
+  BatchedSqliteLogger(const Tree& tree, const std::filesystem::path& filepath,
+                      const Options& options)
+    : StatusChangeLogger(tree.rootNode()), options_(options)
+  {
+    if (filepath.extension() != ".db3")
+    {
+      throw RuntimeError("BatchedSqliteLogger: the file extension must be [.db3]");
+    }
+    options_.batch_rows = std::max<size_t>(options_.batch_rows, 1);
+
+    if (sqlite3_open(filepath.string().c_str(), &db_) != SQLITE_OK)
+    {
+      const std::string msg = sqlite3_errmsg(db_);
+      sqlite3_close(db_);
+      throw RuntimeError("BatchedSqliteLogger: can't open [", filepath.string(),
+                         "]: ", msg);
+    }
+    try
+    {
+      if (options_.wal_mode)
+      {
+        execute("PRAGMA journal_mode=WAL;");
+        execute("PRAGMA synchronous=NORMAL;");
+      }
+      execute("CREATE TABLE IF NOT EXISTS Transitions ("
+              "timestamp  INTEGER PRIMARY KEY NOT NULL, "
+              "session_id INTEGER NOT NULL, "
+              "node_uid   INTEGER NOT NULL, "
+              "duration   INTEGER, "
+              "state      INTEGER NOT NULL);");
+      execute("CREATE TABLE IF NOT EXISTS Definitions ("
+              "session_id INTEGER PRIMARY KEY AUTOINCREMENT, "
+              "date       TEXT NOT NULL,"
+              "xml_tree   TEXT NOT NULL);");
+      if (!options_.append)
+      {
+        dropPartitions();
+        execute("DELETE from Transitions;");
+        execute("DELETE from Definitions;");
+      }
+
+      const std::string xml = WriteTreeToXML(tree, true, true);
+      {
+        Statement insert(db_, "INSERT into Definitions (date, xml_tree) "
+                              "VALUES (datetime('now','localtime'),?);");
+        sqlite3_bind_text(insert.get(), 1, xml.data(), int(xml.size()), SQLITE_TRANSIENT);
+        insert.step();
+      }
+      session_id_ = int(sqlite3_last_insert_rowid(db_));
+
+      table_ = "Transitions";
+      if (options_.partition_sessions)
+      {
+        table_ += "_" + std::to_string(session_id_);
+        execute("CREATE TABLE IF NOT EXISTS " + table_ +
+                " ("
+                "timestamp  INTEGER PRIMARY KEY NOT NULL, "
+                "session_id INTEGER NOT NULL, "
+                "node_uid   INTEGER NOT NULL, "
+                "duration   INTEGER, "
+                "state      INTEGER NOT NULL);");
+      }
+      insert_ = std::make_unique<Statement>(db_, "INSERT INTO " + table_ +
+                                                     " VALUES (?, ?, ?, ?, ?);");
+    }
+    catch (...)
+    {
+      insert_.reset();
+      sqlite3_close(db_);
+      throw;
+    }
+    writer_thread_ = std::thread(&BatchedSqliteLogger::writerLoop, this);
+  }
+
+  BatchedSqliteLogger(const BatchedSqliteLogger& other) = delete;
+  BatchedSqliteLogger& operator=(const BatchedSqliteLogger& other) = delete;
+
+  ~BatchedSqliteLogger() override
+  {
+    {
+      std::unique_lock lk(queue_mutex_);
+      loop_ = false;
+    }
+    queue_cv_.notify_all();
+    if (writer_thread_.joinable())
+    {
+      writer_thread_.join();
+    }
+    insert_.reset();
+    sqlite3_close(db_);
+  }
+
+  void callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
+                NodeStatus status) override
+  {
+    using namespace std::chrono;
+    const int64_t tm_usec = int64_t(duration_cast<microseconds>(timestamp).count());
+    monotonic_timestamp_ = std::max(monotonic_timestamp_ + 1, tm_usec);
+
+    int64_t duration = 0;
+    if (status == NodeStatus::RUNNING)
+    {
+      starting_time_[&node] = monotonic_timestamp_;
+    }
+    else if (prev_status == NodeStatus::RUNNING)
+    {
+      auto it = starting_time_.find(&node);
+      if (it != starting_time_.end())
+      {
+        duration = monotonic_timestamp_ - it->second;
+      }
+    }
+
+    size_t depth = 0;
+    {
+      std::unique_lock lk(queue_mutex_);
+      transitions_queue_.push_back({ node.UID(), monotonic_timestamp_, duration, status });
+      depth = transitions_queue_.size();
+    }
+    queue_depth_.store(depth, std::memory_order_relaxed);
+    if (depth > max_queue_depth_.load(std::memory_order_relaxed))
+    {
+      max_queue_depth_.store(depth, std::memory_order_relaxed);
+    }
+    // wake up the writer only when a batch is complete
+    if (depth == options_.batch_rows)
+    {
+      queue_cv_.notify_one();
+    }
+  }
+
+  /// Write the pending transitions. It blocks until they are committed.
+  void flush() override
+  {
+    std::unique_lock lk(queue_mutex_);
+    const uint64_t request = ++flush_requested_;
+    queue_cv_.notify_all();
+    flushed_cv_.wait(lk, [&] { return flush_done_ >= request || !loop_; });
+  }
+
+  [[nodiscard]] int sessionId() const
+  {
+    return session_id_;
+  }
+
+  /// Name of the table where the transitions of this session are written.
+  [[nodiscard]] const std::string& transitionsTable() const
+  {
+    return table_;
+  }
+
+  /// Transitions waiting to be written. If it keeps growing, the writer is too slow.
+  [[nodiscard]] size_t queueDepth() const
+  {
+    return queue_depth_.load(std::memory_order_relaxed);
+  }
+
+  /// Maximum value of queueDepth() since the creation of the logger.
+  [[nodiscard]] size_t maxQueueDepth() const
+  {
+    return max_queue_depth_.load(std::memory_order_relaxed);
+  }
+
+  /// Estimate: the queue and the batch being written grow up to maxQueueDepth().
+  [[nodiscard]] size_t bufferedBytes() const
+  {
+    return 2 * maxQueueDepth() * sizeof(Transition);
+  }
+
+  [[nodiscard]] uint64_t rowsWritten() const
+  {
+    return rows_written_.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Transition
+  {
+    uint16_t node_uid;
+    int64_t timestamp;
+    int64_t duration;
+    NodeStatus status;
+  };
+
+  class Statement
+  {
+  public:
+    Statement(sqlite3* db, const std::string& sql) : db_(db)
+    {
+      if (sqlite3_prepare_v2(db, sql.c_str(), int(sql.size()), &stmt_, nullptr) !=
+          SQLITE_OK)
+      {
+        throw RuntimeError("BatchedSqliteLogger: ", sqlite3_errmsg(db), " in [", sql,
+                           "]");
+      }
+    }
+    ~Statement()
+    {
+      sqlite3_finalize(stmt_);
+    }
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+
+    sqlite3_stmt* get() const
+    {
+      return stmt_;
+    }
+
+    /// Execute the statement and reset it, to be used again.
+    void step()
+    {
+      const int res = sqlite3_step(stmt_);
+      sqlite3_reset(stmt_);
+      if (res != SQLITE_DONE && res != SQLITE_ROW)
+      {
+        throw RuntimeError("BatchedSqliteLogger: ", sqlite3_errmsg(db_));
+      }
+    }
+
+  private:
+    sqlite3* db_;
+    sqlite3_stmt* stmt_ = nullptr;
+  };
+
+  void execute(const std::string& sql)
+  {
+    char* error = nullptr;
+    if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK)
+    {
+      const std::string msg = error ? error : "unknown error";
+      sqlite3_free(error);
+      throw RuntimeError("BatchedSqliteLogger: ", msg, " in [", sql, "]");
+    }
+  }
+
+  void dropPartitions()
+  {
+    std::vector<std::string> tables;
+    {
+      Statement select(db_, "SELECT name FROM sqlite_master WHERE type='table' "
+                            "AND name GLOB 'Transitions_[0-9]*';");
+      while (sqlite3_step(select.get()) == SQLITE_ROW)
+      {
+        tables.emplace_back(
+            reinterpret_cast<const char*>(sqlite3_column_text(select.get(), 0)));
+      }
+    }
+    for (const auto& table : tables)
+    {
+      execute("DROP TABLE " + table + ";");
+    }
+  }
+
+  void writeBatch(const std::vector<Transition>& transitions)
+  {
+    sqlite3_stmt* stmt = insert_->get();
+    for (size_t first = 0; first < transitions.size(); first += options_.batch_rows)
+    {
+      const size_t last = std::min(transitions.size(), first + options_.batch_rows);
+      try
+      {
+        execute("BEGIN TRANSACTION;");
+        for (size_t i = first; i < last; i++)
+        {
+          const auto& trans = transitions[i];
+          sqlite3_bind_int64(stmt, 1, trans.timestamp);
+          sqlite3_bind_int(stmt, 2, session_id_);
+          sqlite3_bind_int(stmt, 3, trans.node_uid);
+          sqlite3_bind_int64(stmt, 4, trans.duration);
+          sqlite3_bind_int(stmt, 5, static_cast<int>(trans.status));
+          insert_->step();
+        }
+        execute("COMMIT;");
+        rows_written_.fetch_add(last - first, std::memory_order_relaxed);
+      }
+      catch (std::exception& err)
+      {
+        // a failed batch must not stop the logger
+        sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+        std::cerr << err.what() << std::endl;
+      }
+    }
+  }
+
+  void writerLoop()
+  {
+    std::vector<Transition> transitions;
+    bool running = true;
+    while (running)
+    {
+      uint64_t flush_request = 0;
+      transitions.clear();
+      {
+        std::unique_lock lk(queue_mutex_);
+        queue_cv_.wait_for(lk, options_.batch_period, [this] {
+          return !loop_ || flush_requested_ != flush_done_ ||
+                 transitions_queue_.size() >= options_.batch_rows;
+        });
+        std::swap(transitions, transitions_queue_);
+        queue_depth_.store(0, std::memory_order_relaxed);
+        running = loop_;
+        flush_request = flush_requested_;
+      }
+
+      writeBatch(transitions);
+
+      if (flush_request != flush_done_)
+      {
+        {
+          std::unique_lock lk(queue_mutex_);
+          flush_done_ = flush_request;
+        }
+        flushed_cv_.notify_all();
+      }
+    }
+    flushed_cv_.notify_all();
+  }
+
+  Options options_;
+  sqlite3* db_ = nullptr;
+  std::unique_ptr<Statement> insert_;
+  std::string table_;
+  int session_id_ = -1;
+
+  int64_t monotonic_timestamp_ = 0;
+  std::unordered_map<const BT::TreeNode*, int64_t> starting_time_;
+
+  std::vector<Transition> transitions_queue_;
+  using Mutex = SiteMutex<std::mutex, LockSites::BatchedSqliteLogger>;
+  Mutex queue_mutex_;
+  ConditionVariableFor<Mutex> queue_cv_;
+  ConditionVariableFor<Mutex> flushed_cv_;
+  bool loop_ = true;
+  uint64_t flush_requested_ = 0;
+  uint64_t flush_done_ = 0;
+
+  std::atomic<size_t> queue_depth_ = 0;
+  std::atomic<size_t> max_queue_depth_ = 0;
+  std::atomic<uint64_t> rows_written_ = 0;
+
+  std::thread writer_thread_;
+};
+
+}   // namespace BT
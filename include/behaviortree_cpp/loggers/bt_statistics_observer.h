@@ -0,0 +1,572 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "behaviortree_cpp/loggers/abstract_logger.h"
+#include "behaviortree_cpp/utils/latency_histogram.hpp"
+#include "behaviortree_cpp/utils/lock_profiler.hpp"
+#include "behaviortree_cpp/utils/perf_counters.hpp"
+#include "behaviortree_cpp/utils/tick_budget.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief StatisticsObserver collects the same statistics of TreeObserver,
+ * about which nodes are executed and their returned status, and can also
+ * measure the latency of the nodes (see enableLatencyHistograms()).
+ *
+ * The statistics are stored in an array indexed by UID, updated with
+ * relaxed atomics: they can be read by another thread while the tree is
+ * ticking, for instance by MetricsExporter. Each NodeStatistics returned is
+ * consistent (a seqlock per node).
+ */
+class StatisticsObserver : public StatusChangeLogger
+{
+public:
+  explicit StatisticsObserver(const BT::Tree& tree);
+  ~StatisticsObserver() override = default;
+
+  virtual void flush() override {}
+
+  void resetStatistics();
+
+  struct NodeStatistics
+  {
+    // Last __valid__ result, either SUCCESS or FAILURE
+    NodeStatus last_result = NodeStatus::IDLE;
+    // Last status. Can be any status, including IDLE or SKIPPED
+    NodeStatus current_status = NodeStatus::IDLE;
+
+    // count status transitions, excluding transition to IDLE
+    unsigned transitions_count = 0;
+    // count number of transitions to SUCCESS
+    unsigned success_count = 0;
+    // count number of transitions to FAILURE
+    unsigned failure_count = 0;
+    // count number of transitions to SKIPPED
+    unsigned skip_count = 0;
+
+    Duration last_timestamp = {};
+  };
+
+  // find the statistics of a node, based on its path
+  NodeStatistics getStatistics(const std::string& path) const;
+
+  // find the statistics of a node, based on its TreeNode::UID()
+  NodeStatistics getStatistics(uint16_t uid) const;
+
+  // all statistics, copied from the nodes that had at least one transition
+  std::unordered_map<uint16_t, NodeStatistics> statistics() const;
+
+  // path to UID map
+  const std::unordered_map<std::string, uint16_t>& pathToUID() const;
+
+  const std::map<uint16_t, std::string> &uidToPath() const;
+
+  struct Snapshot
+  {
+    // value of updatesCount() when the snapshot was taken
+    uint64_t updates = 0;
+    // indexed by UID; nodes that are not in the tree have default statistics
+    std::vector<NodeStatistics> nodes;
+  };
+
+  /// Copy the statistics of all the nodes. It never blocks the tick thread.
+  Snapshot snapshot() const;
+
+  /// Total number of transitions observed. Exporters can compare it with the
+  /// previous Snapshot::updates to skip a snapshot when nothing changed.
+  uint64_t updatesCount() const
+  {
+    return _updates.load(std::memory_order_acquire);
+  }
+
+  struct NodeLatency
+  {
+    // duration of each invocation of executeTick()
+    LatencyHistogram tick_duration;
+    // time between the transition to RUNNING and the following one to
+    // SUCCESS or FAILURE
+    LatencyHistogram running_duration;
+
+    // ticks of this node that exceeded the TickBudget, see enableLatencyHistograms()
+    std::atomic<unsigned> budget_overruns = 0;
+
+    // see enablePerfCounters(). Totals of the invocations of executeTick(),
+    // children included
+    std::atomic<uint64_t> perf_ticks = 0;
+    std::array<std::atomic<uint64_t>, PerfCounters::COUNT_> perf_totals = {};
+
+    std::chrono::steady_clock::time_point tick_start = {};
+    bool budget_expired_at_start = false;
+    Duration running_start = {};
+    PerfCounters::Values perf_start = {};
+  };
+
+  struct NodePerfCounters
+  {
+    uint64_t ticks = 0;
+    // indexed by PerfCounters::Event
+    PerfCounters::Values totals = {};
+
+    [[nodiscard]] uint64_t total(PerfCounters::Event event) const
+    {
+      return totals[event];
+    }
+
+    /// instructions per cycle, 0 if not available
+    [[nodiscard]] double ipc() const
+    {
+      return totals[PerfCounters::CYCLES] > 0 ?
+                 double(totals[PerfCounters::INSTRUCTIONS]) /
+                     double(totals[PerfCounters::CYCLES]) :
+                 0.0;
+    }
+  };
+
+  /**
+   * @brief Record, for each node, the histograms of the durations of tick()
+   * and of RUNNING. Memory is fixed (about 2.5 KB per node) and the overhead
+   * is two clock readings per tick.
+   *
+   * The duration of tick() is measured with the pre and post tick callbacks
+   * of the nodes (see TreeNode::setPreTickFunction), that are replaced:
+   * don't use it together with other users of those callbacks, for instance
+   * the breakpoints of Groot2Publisher.
+   *
+   * When the tree is ticked with a TickBudget (Tree::tickOnce(deadline)),
+   * NodeLatency::budget_overruns counts the ticks during which the deadline
+   * passed, blaming the deepest node that was executing at that time.
+   */
+  void enableLatencyHistograms(const BT::Tree& tree);
+
+  // find the latencies of a node, based on its path
+  const NodeLatency& getLatency(const std::string& path) const;
+
+  // find the latencies of a node, based on its TreeNode::UID()
+  const NodeLatency& getLatency(uint16_t uid) const;
+
+  /**
+   * @brief Like enableLatencyHistograms(), but also attach to each tick of a
+   * node the hardware performance counters of the thread (see PerfCounters):
+   * cycles, instructions, cache misses, branch misses and context switches.
+   *
+   * Reading the counters is a system call: it adds about one microsecond to
+   * each executeTick(), that is included in the counters of the parent nodes.
+   *
+   * @return false if no counter is available in this thread, for instance
+   * in a virtual machine or with a restrictive perf_event_paranoid.
+   * The histograms are enabled anyway.
+   */
+  bool enablePerfCounters(const BT::Tree& tree);
+
+  // find the counters of a node, based on its path
+  NodePerfCounters getPerfCounters(const std::string& path) const;
+
+  // find the counters of a node, based on its TreeNode::UID()
+  NodePerfCounters getPerfCounters(uint16_t uid) const;
+
+  /**
+   * @brief Write the performance counters of the nodes as CSV, one line per path:
+   *
+   *   path,ticks,cycles,instructions,cache_misses,branch_misses,context_switches,ipc
+   */
+  void writePerfCounters(std::ostream& out) const;
+
+  /**
+   * @brief Contention of the mutexes declared with SiteMutex, per lock site
+   * (see LockProfiler). The statistics are process-wide, not limited to this
+   * tree; they are empty unless compiled with BTCPP_LOCK_PROFILING.
+   */
+  std::vector<LockProfiler::SiteStatistics> lockContention() const
+  {
+    return LockProfiler::get().report();
+  }
+
+  /**
+   * @brief Write lockContention() as CSV, one line per lock site (times in microseconds):
+   *
+   *   site,acquisitions,contentions,wait_us,max_wait_us,hold_us,max_hold_us
+   */
+  void writeLockContention(std::ostream& out) const;
+
+  private:
+  // NodeStatistics, written by the tick thread and read by any thread
+  struct AtomicStatistics
+  {
+    // seqlock: odd while the statistics are being written
+    std::atomic<uint32_t> sequence = 0;
+    std::atomic<uint8_t> last_result = uint8_t(NodeStatus::IDLE);
+    std::atomic<uint8_t> current_status = uint8_t(NodeStatus::IDLE);
+    std::atomic<bool> used = false;
+    std::atomic<unsigned> transitions_count = 0;
+    std::atomic<unsigned> success_count = 0;
+    std::atomic<unsigned> failure_count = 0;
+    std::atomic<unsigned> skip_count = 0;
+    std::atomic<Duration::rep> last_timestamp = 0;
+
+    void beginWrite()
+    {
+      // more than one thread may change the status of the same node
+      uint32_t seq = sequence.load(std::memory_order_relaxed);
+      while ((seq & 1) ||
+             !sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+      {
+        seq = sequence.load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void endWrite()
+    {
+      sequence.fetch_add(1, std::memory_order_release);
+    }
+
+    bool read(NodeStatistics& out) const;
+  };
+
+  // dense: UIDs are assigned by the factory starting from 1
+  std::unique_ptr<AtomicStatistics[]> _statistics;
+  size_t _statistics_size = 0;
+  std::atomic<uint64_t> _updates = 0;
+  std::unordered_map<std::string, uint16_t> _path_to_uid;
+  std::map<uint16_t, std::string> _uid_to_path;
+
+  // shared with the callbacks of the nodes, that may outlive the observer
+  std::unordered_map<uint16_t, std::shared_ptr<NodeLatency>> _latencies;
+  std::vector<TreeNode::StatusChangeSubscriber> _latency_subscribers;
+
+  void installTickCallbacks(const BT::Tree& tree, bool perf_counters);
+
+  virtual void callback(Duration timestamp, const TreeNode& node,
+                        NodeStatus prev_status, NodeStatus status) override;
+};
+
+//--------------------------------------------
+
+inline StatisticsObserver::StatisticsObserver(const BT::Tree& tree) :
+  StatusChangeLogger(tree.rootNode())
+{
+  uint16_t max_uid = 0;
+  auto visitor = [this, &max_uid](TreeNode* node) {
+    _path_to_uid.insert({ node->fullPath(), node->UID() });
+    _uid_to_path.insert({ node->UID(), node->fullPath() });
+    max_uid = std::max(max_uid, node->UID());
+  };
+  applyRecursiveVisitor(tree.rootNode(), visitor);
+
+  _statistics_size = _uid_to_path.empty() ? 0 : size_t(max_uid) + 1;
+  _statistics.reset(new AtomicStatistics[_statistics_size]);
+}
+
+inline void StatisticsObserver::callback(Duration timestamp, const TreeNode& node,
+                                   NodeStatus /*prev_status*/, NodeStatus status)
+{
+  const uint16_t uid = node.UID();
+  if (uid >= _statistics_size)
+  {
+    return;
+  }
+  AtomicStatistics& statistics = _statistics[uid];
+  constexpr auto relaxed = std::memory_order_relaxed;
+
+  statistics.beginWrite();
+  statistics.used.store(true, relaxed);
+  if (status == NodeStatus::SUCCESS || status == NodeStatus::FAILURE)
+  {
+    statistics.last_result.store(uint8_t(status), relaxed);
+  }
+  statistics.current_status.store(uint8_t(status), relaxed);
+  statistics.last_timestamp.store(timestamp.count(), relaxed);
+
+  if (status != NodeStatus::IDLE)
+  {
+    statistics.transitions_count.fetch_add(1, relaxed);
+    if (status == NodeStatus::SUCCESS)
+    {
+      statistics.success_count.fetch_add(1, relaxed);
+    }
+    else if (status == NodeStatus::FAILURE)
+    {
+      statistics.failure_count.fetch_add(1, relaxed);
+    }
+    else if (status == NodeStatus::SKIPPED)
+    {
+      statistics.skip_count.fetch_add(1, relaxed);
+    }
+  }
+  statistics.endWrite();
+  _updates.fetch_add(1, std::memory_order_release);
+}
+
+inline bool StatisticsObserver::AtomicStatistics::read(NodeStatistics& out) const
+{
+  constexpr auto relaxed = std::memory_order_relaxed;
+  while (true)
+  {
+    const uint32_t before = sequence.load(std::memory_order_acquire);
+    if (before & 1)
+    {
+      continue;
+    }
+    const bool is_used = used.load(relaxed);
+    out.last_result = NodeStatus(last_result.load(relaxed));
+    out.current_status = NodeStatus(current_status.load(relaxed));
+    out.transitions_count = transitions_count.load(relaxed);
+    out.success_count = success_count.load(relaxed);
+    out.failure_count = failure_count.load(relaxed);
+    out.skip_count = skip_count.load(relaxed);
+    out.last_timestamp = Duration(last_timestamp.load(relaxed));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence.load(relaxed) == before)
+    {
+      return is_used;
+    }
+  }
+}
+
+inline void StatisticsObserver::resetStatistics()
+{
+  for (size_t i = 0; i < _statistics_size; i++)
+  {
+    AtomicStatistics& statistics = _statistics[i];
+    statistics.beginWrite();
+    statistics.used.store(false, std::memory_order_relaxed);
+    statistics.last_result.store(uint8_t(NodeStatus::IDLE), std::memory_order_relaxed);
+    statistics.current_status.store(uint8_t(NodeStatus::IDLE), std::memory_order_relaxed);
+    statistics.transitions_count.store(0, std::memory_order_relaxed);
+    statistics.success_count.store(0, std::memory_order_relaxed);
+    statistics.failure_count.store(0, std::memory_order_relaxed);
+    statistics.skip_count.store(0, std::memory_order_relaxed);
+    statistics.last_timestamp.store(0, std::memory_order_relaxed);
+    statistics.endWrite();
+  }
+  _updates.fetch_add(1, std::memory_order_release);
+}
+
+inline StatisticsObserver::NodeStatistics
+StatisticsObserver::getStatistics(const std::string& path) const
+{
+  auto it = _path_to_uid.find(path);
+  if (it == _path_to_uid.end())
+  {
+    throw std::invalid_argument("Invalid path");
+  }
+  return getStatistics(it->second);
+}
+
+inline StatisticsObserver::NodeStatistics StatisticsObserver::getStatistics(uint16_t uid) const
+{
+  if (!_uid_to_path.count(uid))
+  {
+    throw std::invalid_argument("Invalid UID");
+  }
+  NodeStatistics out;
+  _statistics[uid].read(out);
+  return out;
+}
+
+inline std::unordered_map<uint16_t, StatisticsObserver::NodeStatistics>
+StatisticsObserver::statistics() const
+{
+  std::unordered_map<uint16_t, NodeStatistics> out;
+  for (const auto& [uid, path] : _uid_to_path)
+  {
+    NodeStatistics stats;
+    if (_statistics[uid].read(stats))
+    {
+      out.insert({ uid, stats });
+    }
+  }
+  return out;
+}
+
+inline StatisticsObserver::Snapshot StatisticsObserver::snapshot() const
+{
+  Snapshot out;
+  out.updates = updatesCount();
+  out.nodes.resize(_statistics_size);
+  for (size_t i = 0; i < _statistics_size; i++)
+  {
+    _statistics[i].read(out.nodes[i]);
+  }
+  return out;
+}
+
+inline const std::unordered_map<std::string, uint16_t>& StatisticsObserver::pathToUID() const
+{
+  return _path_to_uid;
+}
+
+inline const std::map<uint16_t, std::string>& StatisticsObserver::uidToPath() const
+{
+  return _uid_to_path;
+}
+
+//--------------------------------------------
+
+inline void StatisticsObserver::enableLatencyHistograms(const BT::Tree& tree)
+{
+  installTickCallbacks(tree, false);
+}
+
+inline bool StatisticsObserver::enablePerfCounters(const BT::Tree& tree)
+{
+  installTickCallbacks(tree, true);
+  return PerfCounters::thread().isAvailable();
+}
+
+inline void StatisticsObserver::installTickCallbacks(const BT::Tree& tree, bool perf_counters)
+{
+  _latencies.clear();
+  _latency_subscribers.clear();
+
+  for (const auto& subtree : tree.subtrees)
+  {
+    for (const auto& node : subtree->nodes)
+    {
+      auto latency = std::make_shared<NodeLatency>();
+      _latencies[node->UID()] = latency;
+
+      node->setPreTickFunction([latency, perf_counters](TreeNode&) {
+        if (perf_counters)
+        {
+          PerfCounters::thread().read(latency->perf_start);
+        }
+        latency->tick_start = std::chrono::steady_clock::now();
+        latency->budget_expired_at_start = TickBudget::expiredAt(latency->tick_start);
+        return NodeStatus::IDLE;
+      });
+      node->setPostTickFunction([latency, perf_counters](TreeNode&, NodeStatus) {
+        const auto now = std::chrono::steady_clock::now();
+        if (perf_counters)
+        {
+          PerfCounters::Values values;
+          if (PerfCounters::thread().read(values))
+          {
+            for (size_t i = 0; i < PerfCounters::COUNT_; i++)
+            {
+              latency->perf_totals[i].fetch_add(values[i] - latency->perf_start[i],
+                                                std::memory_order_relaxed);
+            }
+            latency->perf_ticks.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+        latency->tick_duration.record(now - latency->tick_start);
+        if (!latency->budget_expired_at_start && TickBudget::expiredAt(now) &&
+            TickBudget::claimOverrun())
+        {
+          latency->budget_overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        return NodeStatus::IDLE;
+      });
+      _latency_subscribers.push_back(node->subscribeToStatusChange(
+          [latency](TimePoint timestamp, const TreeNode&, NodeStatus prev,
+                    NodeStatus status) {
+            if (status == NodeStatus::RUNNING)
+            {
+              latency->running_start = timestamp.time_since_epoch();
+            }
+            else if (prev == NodeStatus::RUNNING &&
+                     (status == NodeStatus::SUCCESS || status == NodeStatus::FAILURE))
+            {
+              latency->running_duration.record(timestamp.time_since_epoch() -
+                                               latency->running_start);
+            }
+          }));
+    }
+  }
+}
+
+inline const StatisticsObserver::NodeLatency& StatisticsObserver::getLatency(uint16_t uid) const
+{
+  auto it = _latencies.find(uid);
+  if (it == _latencies.end())
+  {
+    throw RuntimeError("StatisticsObserver: no latency histograms for the node with UID ",
+                       std::to_string(uid),
+                       ". Did you call enableLatencyHistograms()?");
+  }
+  return *it->second;
+}
+
+inline const StatisticsObserver::NodeLatency&
+StatisticsObserver::getLatency(const std::string& path) const
+{
+  auto it = _path_to_uid.find(path);
+  if (it == _path_to_uid.end())
+  {
+    throw RuntimeError("StatisticsObserver: invalid path [", path, "]");
+  }
+  return getLatency(it->second);
+}
+
+inline StatisticsObserver::NodePerfCounters StatisticsObserver::getPerfCounters(uint16_t uid) const
+{
+  const NodeLatency& latency = getLatency(uid);
+  NodePerfCounters out;
+  out.ticks = latency.perf_ticks.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < PerfCounters::COUNT_; i++)
+  {
+    out.totals[i] = latency.perf_totals[i].load(std::memory_order_relaxed);
+  }
+  return out;
+}
+
+inline StatisticsObserver::NodePerfCounters
+StatisticsObserver::getPerfCounters(const std::string& path) const
+{
+  auto it = _path_to_uid.find(path);
+  if (it == _path_to_uid.end())
+  {
+    throw RuntimeError("StatisticsObserver: invalid path [", path, "]");
+  }
+  return getPerfCounters(it->second);
+}
+
+inline void StatisticsObserver::writePerfCounters(std::ostream& out) const
+{
+  out << "path,ticks";
+  for (size_t i = 0; i < PerfCounters::COUNT_; i++)
+  {
+    out << ',' << PerfCounters::toStr(PerfCounters::Event(i));
+  }
+  out << ",ipc\n";
+  for (const auto& [uid, path] : _uid_to_path)
+  {
+    if (!_latencies.count(uid))
+    {
+      continue;
+    }
+    const auto counters = getPerfCounters(uid);
+    // paths can't contain '"'
+    out << '"' << path << "\"," << counters.ticks;
+    for (uint64_t total : counters.totals)
+    {
+      out << ',' << total;
+    }
+    out << ',' << counters.ipc() << '\n';
+  }
+}
+
+inline void StatisticsObserver::writeLockContention(std::ostream& out) const
+{
+  auto usec = [](std::chrono::nanoseconds ns) { return double(ns.count()) * 1e-3; };
+  out << "site,acquisitions,contentions,wait_us,max_wait_us,hold_us,max_hold_us\n";
+  for (const auto& site : lockContention())
+  {
+    out << site.site << ',' << site.acquisitions << ',' << site.contentions << ','
+        << usec(site.wait) << ',' << usec(site.max_wait) << ',' << usec(site.hold) << ','
+        << usec(site.max_hold) << '\n';
+  }
+}
+
+}   // namespace BT
+
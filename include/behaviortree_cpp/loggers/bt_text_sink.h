@@ -0,0 +1,439 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "behaviortree_cpp/loggers/abstract_logger.h"
+#include "behaviortree_cpp/utils/bounded_queue.hpp"
+#include "behaviortree_cpp/utils/lock_profiler.hpp"
+
+namespace BT
+{
+
+enum class LogLevel : uint8_t
+{
+  DEBUG = 0,
+  INFO,
+  WARNING,
+  ERROR,
+  OFF
+};
+
+/**
+ * @brief TextSink writes text messages (for instance the output of the
+ * leaves, or the transitions of TextSinkLogger) from a thread of its own,
+ * so that the tick thread never blocks on the console, a pipe or journald.
+ *
+ * log() copies the message into a lock-free queue (BoundedQueue) and returns:
+ * it never allocates, never locks and never waits. The writer thread
+ * concatenates the pending messages and writes them with a single write and
+ * flush, every Options::flush_interval or earlier if the queue is half full.
+ *
+ * Messages below the level of the sink are discarded before being copied.
+ * Messages longer than MAX_MESSAGE_SIZE are truncated; if the queue is
+ * full they are dropped, and the writer reports how many were lost.
+ *
+ * Use a sink per tree, to avoid the contention of many trees on the same
+ * queue, or the one shared by default (DefaultTextSink()):
+ *
+ *   class SaySomething : public SyncActionNode
+ *   {
+ *     NodeStatus tick() override
+ *     {
+ *       DefaultTextSink()->log(LogLevel::INFO, msg);
+ *       return NodeStatus::SUCCESS;
+ *     }
+ *   };
+ */
+class TextSink
+{
+public:
+  using Ptr = std::shared_ptr<TextSink>;
+  /// Receives a batch of lines, in the writer thread.
+  using Writer = std::function<void(const char* data, size_t size)>;
+
+  static constexpr size_t MAX_MESSAGE_SIZE = 240;
+
+  struct Options
+  {
+    /// number of messages; the memory is allocated once (about 256 bytes each)
+    size_t queue_capacity = 1024;
+    LogLevel level = LogLevel::INFO;
+    std::chrono::milliseconds flush_interval = std::chrono::milliseconds(20);
+    /// prefix each line with the level, for instance "[WARNING] "
+    bool print_level = false;
+    /// prefix each line with seconds since epoch, for instance "[1700000000.123] "
+    bool print_timestamp = false;
+  };
+
+  static const char* levelName(LogLevel level)
+  {
+    switch (level)
+    {
+      case LogLevel::DEBUG:
+        return "DEBUG";
+      case LogLevel::INFO:
+        return "INFO";
+      case LogLevel::WARNING:
+        return "WARNING";
+      case LogLevel::ERROR:
+        return "ERROR";
+      default:
+        return "OFF";
+    }
+  }
+
+  explicit TextSink(std::ostream& out) : TextSink(out, Options())
+  {}
+
+  TextSink(std::ostream& out, const Options& options) :
+    TextSink(
+        [&out](const char* data, size_t size) {
+          out.write(data, std::streamsize(size));
+          out.flush();
+        },
+        options)
+  {}
+
+  TextSink(Writer writer, const Options& options) :
+    options_(options),
+    writer_(std::move(writer)),
+    queue_(std::max<size_t>(options.queue_capacity, 2)),
+    level_(uint8_t(options.level))
+  {
+    if (!writer_)
+    {
+      throw RuntimeError("TextSink: invalid writer");
+    }
+    thread_ = std::thread(&TextSink::writerLoop, this);
+  }
+
+  TextSink(const TextSink&) = delete;
+  TextSink& operator=(const TextSink&) = delete;
+
+  /// The pending messages are written before returning.
+  ~TextSink()
+  {
+    {
+      std::unique_lock lk(mutex_);
+      running_ = false;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+
+  void setLevel(LogLevel level)
+  {
+    level_.store(uint8_t(level), std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] LogLevel level() const
+  {
+    return LogLevel(level_.load(std::memory_order_relaxed));
+  }
+
+  /// Check it before building an expensive message.
+  [[nodiscard]] bool isEnabled(LogLevel level) const
+  {
+    return level != LogLevel::OFF && uint8_t(level) >= level_.load(std::memory_order_relaxed);
+  }
+
+  /// Return false if the message was filtered by the level or dropped.
+  bool log(LogLevel level, std::string_view message)
+  {
+    return log(level, {}, message);
+  }
+
+  /// The line is "source: message". Typically the source is TreeNode::name().
+  bool log(LogLevel level, std::string_view source, std::string_view message)
+  {
+    if (!isEnabled(level))
+    {
+      return false;
+    }
+    Record record;
+    record.timestamp_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+    record.level = level;
+    size_t size = 0;
+    auto append = [&](std::string_view text) {
+      const size_t count = std::min(text.size(), MAX_MESSAGE_SIZE - size);
+      std::memcpy(record.text + size, text.data(), count);
+      size += count;
+      record.truncated |= (count < text.size());
+    };
+    if (!source.empty())
+    {
+      append(source);
+      append(": ");
+    }
+    append(message);
+    record.size = uint16_t(size);
+
+    if (queue_.tryPush(record))
+    {
+      return true;
+    }
+    // wake up the writer, that is sleeping with a full queue
+    cv_.notify_one();
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  /// Write the pending messages. It blocks until they are written.
+  void flush()
+  {
+    std::unique_lock lk(mutex_);
+    const uint64_t request = ++flush_requested_;
+    cv_.notify_all();
+    cv_.wait(lk, [&] { return flush_done_ >= request || !running_; });
+  }
+
+  /// Messages lost because the queue was full.
+  [[nodiscard]] uint64_t droppedCount() const
+  {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  /// Messages written.
+  [[nodiscard]] uint64_t writtenCount() const
+  {
+    return written_.load(std::memory_order_relaxed);
+  }
+
+  /// the queue of the messages, allocated by the constructor
+  [[nodiscard]] size_t bufferedBytes() const
+  {
+    return queue_.capacity() * sizeof(Record);
+  }
+
+private:
+  struct Record
+  {
+    int64_t timestamp_usec = 0;
+    LogLevel level = LogLevel::INFO;
+    bool truncated = false;
+    uint16_t size = 0;
+    char text[MAX_MESSAGE_SIZE];
+  };
+
+  static constexpr size_t BATCH_SIZE = 64 * 1024;
+
+  void format(const Record& record, std::string& out) const
+  {
+    char prefix[48];
+    if (options_.print_timestamp)
+    {
+      std::snprintf(prefix, sizeof(prefix), "[%.3f] ", double(record.timestamp_usec) * 1e-6);
+      out += prefix;
+    }
+    if (options_.print_level)
+    {
+      out += '[';
+      out += levelName(record.level);
+      out += "] ";
+    }
+    out.append(record.text, record.size);
+    if (record.truncated)
+    {
+      out += "...";
+    }
+    out += '\n';
+  }
+
+  void write(std::string& batch)
+  {
+    if (!batch.empty())
+    {
+      writer_(batch.data(), batch.size());
+      batch.clear();
+    }
+  }
+
+  void writerLoop()
+  {
+    std::string batch;
+    batch.reserve(BATCH_SIZE + 2 * MAX_MESSAGE_SIZE);
+    Record record;
+    uint64_t reported_dropped = 0;
+
+    while (true)
+    {
+      bool running = true;
+      uint64_t flush_request = 0;
+      {
+        std::unique_lock lk(mutex_);
+        cv_.wait_for(lk, options_.flush_interval, [this] {
+          return !running_ || flush_requested_ != flush_done_ ||
+                 queue_.size() * 2 >= queue_.capacity();
+        });
+        running = running_;
+        flush_request = flush_requested_;
+      }
+
+      uint64_t count = 0;
+      while (queue_.tryPop(record))
+      {
+        format(record, batch);
+        count++;
+        if (batch.size() >= BATCH_SIZE)
+        {
+          write(batch);
+        }
+      }
+      const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+      if (dropped != reported_dropped)
+      {
+        batch += "[TextSink] " + std::to_string(dropped - reported_dropped) +
+                 " messages dropped\n";
+        reported_dropped = dropped;
+      }
+      write(batch);
+      written_.fetch_add(count, std::memory_order_relaxed);
+
+      {
+        std::unique_lock lk(mutex_);
+        flush_done_ = flush_request;
+      }
+      cv_.notify_all();
+      if (!running)
+      {
+        break;
+      }
+    }
+  }
+
+  const Options options_;
+  Writer writer_;
+  BoundedQueue<Record> queue_;
+  std::atomic<uint8_t> level_;
+
+  std::atomic<uint64_t> dropped_ = 0;
+  std::atomic<uint64_t> written_ = 0;
+
+  using Mutex = SiteMutex<std::mutex, LockSites::TextSink>;
+  Mutex mutex_;
+  ConditionVariableFor<Mutex> cv_;
+  bool running_ = true;
+  uint64_t flush_requested_ = 0;
+  uint64_t flush_done_ = 0;
+  std::thread thread_;
+};
+
+/// The sink shared by default, writing into std::cout.
+inline TextSink::Ptr& DefaultTextSink()
+{
+  static TextSink::Ptr sink = std::make_shared<TextSink>(std::cout);
+  return sink;
+}
+
+/// Replace the default sink. Not thread-safe: call it at startup.
+inline void SetDefaultTextSink(TextSink::Ptr sink)
+{
+  DefaultTextSink() = std::move(sink);
+}
+
+/**
+ * @brief TextSinkLogger displays all the transitions on the console,
+ * like StdCoutLogger, but through a TextSink: the tick thread only
+ * formats the line into the queue of the sink.
+ */
+class TextSinkLogger : public StatusChangeLogger
+{
+public:
+  TextSinkLogger(const Tree& tree) : TextSinkLogger(tree, DefaultTextSink())
+  {}
+
+  TextSinkLogger(const Tree& tree, TextSink::Ptr sink, LogLevel level = LogLevel::INFO,
+                 bool colors = true) :
+    StatusChangeLogger(tree.rootNode()), sink_(std::move(sink)), level_(level), colors_(colors)
+  {
+    if (!sink_)
+    {
+      throw RuntimeError("TextSinkLogger: invalid sink");
+    }
+  }
+
+  void flush() override
+  {
+    sink_->flush();
+  }
+
+  [[nodiscard]] const TextSink::Ptr& sink() const
+  {
+    return sink_;
+  }
+
+private:
+  void callback(Duration timestamp, const TreeNode& node, NodeStatus prev_status,
+                NodeStatus status) override
+  {
+    if (!sink_->isEnabled(level_))
+    {
+      return;
+    }
+    const double since_epoch = std::chrono::duration<double>(timestamp).count();
+    char line[TextSink::MAX_MESSAGE_SIZE];
+    const int size = std::snprintf(line, sizeof(line), "[%.3f]: %-25s %s -> %s", since_epoch,
+                                   node.name().c_str(), statusName(prev_status),
+                                   statusName(status));
+    if (size > 0)
+    {
+      sink_->log(level_, std::string_view(line, std::min(size_t(size), sizeof(line) - 1)));
+    }
+  }
+
+  // without allocations, unlike toStr(status, true)
+  const char* statusName(NodeStatus status) const
+  {
+    switch (status)
+    {
+      case NodeStatus::SUCCESS:
+        return colors_ ? "\x1b[32m"
+                         "SUCCESS"
+                         "\x1b[0m" :
+                         "SUCCESS";
+      case NodeStatus::FAILURE:
+        return colors_ ? "\x1b[31m"
+                         "FAILURE"
+                         "\x1b[0m" :
+                         "FAILURE";
+      case NodeStatus::RUNNING:
+        return colors_ ? "\x1b[33m"
+                         "RUNNING"
+                         "\x1b[0m" :
+                         "RUNNING";
+      case NodeStatus::SKIPPED:
+        return colors_ ? "\x1b[34m"
+                         "SKIPPED"
+                         "\x1b[0m" :
+                         "SKIPPED";
+      case NodeStatus::IDLE:
+        return colors_ ? "\x1b[36m"
+                         "IDLE"
+                         "\x1b[0m" :
+                         "IDLE";
+    }
+    return "Undefined";
+  }
+
+  TextSink::Ptr sink_;
+  LogLevel level_;
+  bool colors_;
+};
+
+}   // namespace BT
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#define BT_PROFILER_THREAD_CPUTIME
+#endif
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/control_node.h"
+#include "behaviortree_cpp/decorator_node.h"
+
+namespace BT
+{
+
+/**
+ * @brief TickProfiler measures the time spent inside tick(), for each node:
+ *
+ * - inclusive time: the whole executeTick() of the node, children included;
+ * - exclusive time: the inclusive time minus the one of its children.
+ *
+ * The results are available per node and per registration ID, and can be
+ * exported in the "collapsed stacks" format of flamegraph.pl / speedscope:
+ *
+ *   TickProfiler::Options options;
+ *   options.sample_every = 10;
+ *   TickProfiler profiler(tree, options);
+ *   ...
+ *   std::ofstream out("ticks.folded");
+ *   profiler.writeCollapsedStacks(out);
+ *
+ * Only one root tick every Options::sample_every is measured; the others
+ * cost a thread_local push and pop per node.
+ *
+ * It uses the pre and post tick callbacks of the nodes (see TreeNode::setPreTickFunction),
+ * that are replaced: don't use it together with other users of those callbacks,
+ * for instance the breakpoints of Groot2Publisher or StatisticsObserver::enableLatencyHistograms().
+ */
+class TickProfiler
+{
+public:
+  enum class Clock
+  {
+    // wall-clock time, std::chrono::steady_clock
+    WALL,
+    // CPU time of the thread, where available (wall-clock otherwise)
+    THREAD_CPU
+  };
+
+  struct Options
+  {
+    /// measure 1 root tick every sample_every
+    unsigned sample_every = 1;
+    Clock clock = Clock::THREAD_CPU;
+  };
+
+  struct NodeProfile
+  {
+    uint16_t uid = 0;
+    std::string name;
+    std::string registration_name;
+    std::string full_path;
+    // sampled invocations of executeTick()
+    uint64_t calls = 0;
+    std::chrono::nanoseconds inclusive_time = {};
+    std::chrono::nanoseconds exclusive_time = {};
+  };
+
+  struct TypeProfile
+  {
+    uint64_t calls = 0;
+    // the inclusive time of nested nodes with the same ID is counted twice
+    std::chrono::nanoseconds inclusive_time = {};
+    std::chrono::nanoseconds exclusive_time = {};
+  };
+
+  TickProfiler(const Tree& tree) : TickProfiler(tree, Options())
+  {}
+
+  TickProfiler(const Tree& tree, const Options& options)
+    : state_(std::make_shared<State>())
+  {
+    state_->sample_every = std::max(options.sample_every, 1u);
+    state_->clock = options.clock;
+
+    std::unordered_map<const TreeNode*, uint16_t> parents;
+    for (const auto& subtree : tree.subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        if (auto control = dynamic_cast<const ControlNode*>(node.get()))
+        {
+          for (const TreeNode* child : control->children())
+          {
+            parents[child] = node->UID();
+          }
+        }
+        else if (auto decorator = dynamic_cast<const DecoratorNode*>(node.get()))
+        {
+          if (decorator->child())
+          {
+            parents[decorator->child()] = node->UID();
+          }
+        }
+      }
+    }
+
+    for (const auto& subtree : tree.subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        auto data = std::make_shared<NodeData>();
+        data->uid = node->UID();
+        data->name = node->name();
+        data->registration_name = node->registrationName();
+        data->full_path = node->fullPath();
+        auto parent_it = parents.find(node.get());
+        data->parent = (parent_it != parents.end()) ? int(parent_it->second) : -1;
+        nodes_[data->uid] = data;
+
+        node->setPreTickFunction([state = state_, data](TreeNode&) {
+          if (state->enabled.load(std::memory_order_relaxed))
+          {
+            state->enter(data.get());
+          }
+          return NodeStatus::IDLE;
+        });
+        node->setPostTickFunction([state = state_, data](TreeNode&, NodeStatus) {
+          if (state->enabled.load(std::memory_order_relaxed))
+          {
+            state->exit(data.get());
+          }
+          return NodeStatus::IDLE;
+        });
+      }
+    }
+  }
+
+  ~TickProfiler()
+  {
+    // the callbacks remain in the nodes, but they do nothing
+    state_->enabled = false;
+  }
+
+  TickProfiler(const TickProfiler&) = delete;
+  TickProfiler& operator=(const TickProfiler&) = delete;
+
+  void reset()
+  {
+    for (auto& [uid, data] : nodes_)
+    {
+      data->calls.store(0, std::memory_order_relaxed);
+      data->inclusive_ns.store(0, std::memory_order_relaxed);
+      data->exclusive_ns.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /// Profile of each node, sorted by UID
+  [[nodiscard]] std::vector<NodeProfile> nodeProfiles() const
+  {
+    std::vector<NodeProfile> out;
+    out.reserve(nodes_.size());
+    for (const auto& [uid, data] : nodes_)
+    {
+      out.push_back(toProfile(*data));
+    }
+    std::sort(out.begin(), out.end(),
+              [](const auto& a, const auto& b) { return a.uid < b.uid; });
+    return out;
+  }
+
+  [[nodiscard]] NodeProfile nodeProfile(uint16_t uid) const
+  {
+    auto it = nodes_.find(uid);
+    if (it == nodes_.end())
+    {
+      throw RuntimeError("TickProfiler: invalid UID ", std::to_string(uid));
+    }
+    return toProfile(*it->second);
+  }
+
+  [[nodiscard]] NodeProfile nodeProfile(const std::string& full_path) const
+  {
+    for (const auto& [uid, data] : nodes_)
+    {
+      if (data->full_path == full_path)
+      {
+        return toProfile(*data);
+      }
+    }
+    throw RuntimeError("TickProfiler: invalid path [", full_path, "]");
+  }
+
+  /// Profiles aggregated by TreeNode::registrationName()
+  [[nodiscard]] std::map<std::string, TypeProfile> typeProfiles() const
+  {
+    std::map<std::string, TypeProfile> out;
+    for (const auto& [uid, data] : nodes_)
+    {
+      auto& type = out[data->registration_name];
+      const NodeProfile profile = toProfile(*data);
+      type.calls += profile.calls;
+      type.inclusive_time += profile.inclusive_time;
+      type.exclusive_time += profile.exclusive_time;
+    }
+    return out;
+  }
+
+  /**
+   * @brief Write a line "root;parent;node <exclusive microseconds>" for each
+   * node, as expected by flamegraph.pl and speedscope.
+   */
+  void writeCollapsedStacks(std::ostream& out) const
+  {
+    for (const auto& profile : nodeProfiles())
+    {
+      const auto usec =
+          std::chrono::duration_cast<std::chrono::microseconds>(profile.exclusive_time);
+      if (usec.count() <= 0)
+      {
+        continue;
+      }
+      std::vector<const NodeData*> stack;
+      for (auto it = nodes_.find(profile.uid); it != nodes_.end();
+           it = nodes_.find(uint16_t(it->second->parent)))
+      {
+        stack.push_back(it->second.get());
+        if (it->second->parent < 0 || stack.size() > nodes_.size())
+        {
+          break;
+        }
+      }
+      for (auto it = stack.rbegin(); it != stack.rend(); ++it)
+      {
+        if (it != stack.rbegin())
+        {
+          out << ';';
+        }
+        out << frameName(**it);
+      }
+      out << ' ' << usec.count() << '\n';
+    }
+  }
+
+private:
+  struct NodeData
+  {
+    uint16_t uid = 0;
+    int parent = -1;
+    std::string name;
+    std::string registration_name;
+    std::string full_path;
+    std::atomic<uint64_t> calls = 0;
+    std::atomic<int64_t> inclusive_ns = 0;
+    std::atomic<int64_t> exclusive_ns = 0;
+  };
+
+  struct Frame
+  {
+    const void* state;
+    NodeData* node;
+    bool sampled;
+    int64_t start_ns;
+    int64_t children_ns;
+  };
+
+  struct State
+  {
+    unsigned sample_every = 1;
+    Clock clock = Clock::THREAD_CPU;
+    std::atomic<bool> enabled = true;
+    std::atomic<uint64_t> root_ticks = 0;
+
+    // nodes can be ticked by more than one thread: one stack per thread
+    static std::vector<Frame>& stack()
+    {
+      static thread_local std::vector<Frame> frames;
+      return frames;
+    }
+
+    int64_t now() const
+    {
+#if defined(BT_PROFILER_THREAD_CPUTIME)
+      if (clock == Clock::THREAD_CPU)
+      {
+        timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+      }
+#endif
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now().time_since_epoch())
+          .count();
+    }
+
+    void enter(NodeData* node)
+    {
+      auto& frames = stack();
+      bool sampled = false;
+      if (frames.empty() || frames.back().state != this)
+      {
+        sampled = (root_ticks.fetch_add(1, std::memory_order_relaxed) % sample_every) == 0;
+      }
+      else
+      {
+        sampled = frames.back().sampled;
+      }
+      frames.push_back({ this, node, sampled, sampled ? now() : 0, 0 });
+    }
+
+    void exit(NodeData* node)
+    {
+      auto& frames = stack();
+      // the post tick callback is invoked also when a precondition skipped
+      // the tick (without pre tick callback) or after an exception
+      auto it = std::find_if(frames.rbegin(), frames.rend(),
+                             [&](const Frame& frame) { return frame.node == node; });
+      if (it == frames.rend())
+      {
+        return;
+      }
+      frames.erase(it.base(), frames.end());
+      const Frame frame = frames.back();
+      frames.pop_back();
+      if (!frame.sampled)
+      {
+        return;
+      }
+      const int64_t inclusive = now() - frame.start_ns;
+      node->calls.fetch_add(1, std::memory_order_relaxed);
+      node->inclusive_ns.fetch_add(inclusive, std::memory_order_relaxed);
+      node->exclusive_ns.fetch_add(inclusive - frame.children_ns,
+                                   std::memory_order_relaxed);
+      if (!frames.empty() && frames.back().state == this)
+      {
+        frames.back().children_ns += inclusive;
+      }
+    }
+  };
+
+  static NodeProfile toProfile(const NodeData& data)
+  {
+    NodeProfile profile;
+    profile.uid = data.uid;
+    profile.name = data.name;
+    profile.registration_name = data.registration_name;
+    profile.full_path = data.full_path;
+    profile.calls = data.calls.load(std::memory_order_relaxed);
+    profile.inclusive_time =
+        std::chrono::nanoseconds(data.inclusive_ns.load(std::memory_order_relaxed));
+    profile.exclusive_time =
+        std::chrono::nanoseconds(data.exclusive_ns.load(std::memory_order_relaxed));
+    return profile;
+  }
+
+  static std::string frameName(const NodeData& data)
+  {
+    std::string name = (data.name == data.registration_name) ?
+                           data.name :
+                           data.name + " (" + data.registration_name + ")";
+    // ';' separates the frames
+    std::replace(name.begin(), name.end(), ';', '_');
+    return name;
+  }
+
+  // shared with the callbacks of the nodes, that may outlive the profiler
+  std::shared_ptr<State> state_;
+  std::unordered_map<uint16_t, std::shared_ptr<NodeData>> nodes_;
+};
+
+}   // namespace BT
+
+#undef BT_PROFILER_THREAD_CPUTIME
@@ -0,0 +1,700 @@
+#pragma once
+
+#include <chrono>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/json_export.h"
+#include "behaviortree_cpp/loggers/abstract_logger.h"
+
+namespace BT
+{
+
+namespace details
+{
+// the records of the file written by TickRecorder
+enum class TickRecord : uint8_t
+{
+  NODE = 'N',         // uid, path
+  BLACKBOARD = 'B',   // index, instance name of the subtree
+  KEY = 'K',          // id, key
+  FRAME = 'F',        // usec since the previous frame
+  FRAME_END = 'E',    // usec spent in tickOnce(), status of the tree
+  RESULT = 'R',       // uid, status
+  WRITE = 'W',        // blackboard, key, kind, value
+};
+
+// how the value of a WRITE is encoded
+enum class TickValueKind : uint8_t
+{
+  STRING = 0,   // the string itself
+  JSON = 1,     // a JSON literal (numbers and booleans)
+  OPAQUE = 2,   // not serializable: only the fact that the entry changed
+};
+
+inline void WriteVarint(std::string& out, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(char((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(char(value));
+}
+
+inline void WriteBytes(std::string& out, const std::string& bytes)
+{
+  WriteVarint(out, bytes.size());
+  out.append(bytes);
+}
+
+inline uint64_t ReadVarint(std::istream& in)
+{
+  uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7)
+  {
+    const int c = in.get();
+    if (c == std::char_traits<char>::eof())
+    {
+      throw RuntimeError("TickReplayer: truncated recording");
+    }
+    value |= uint64_t(c & 0x7F) << shift;
+    if ((c & 0x80) == 0)
+    {
+      return value;
+    }
+  }
+  throw RuntimeError("TickReplayer: invalid varint");
+}
+
+inline std::string ReadBytes(std::istream& in)
+{
+  std::string bytes(ReadVarint(in), '\0');
+  if (!in.read(bytes.data(), std::streamsize(bytes.size())))
+  {
+    throw RuntimeError("TickReplayer: truncated recording");
+  }
+  return bytes;
+}
+
+constexpr const char* kTickRecordingMagic = "BTRR";
+constexpr uint8_t kTickRecordingVersion = 1;
+}   // namespace details
+
+/**
+ * @brief TickRecorder saves what is needed to re-execute a tree
+ * deterministically, tick by tick (see TickReplayer):
+ *
+ * - the status returned by the leaves (actions and conditions, or the nodes
+ *   selected by the filter), in the tick in which they returned it;
+ * - the values written in the blackboards of the tree, in order.
+ *
+ * The tree must be ticked with TickRecorder::tickOnce(), to mark the ticks.
+ * The records are compact: keys and nodes are declared once, timestamps and
+ * identifiers are varints, and a value is written only when its entry
+ * changes. Values are serialized with JsonExporter; the ones that are not
+ * convertible are recorded when their entry is created, but can't be restored.
+ *
+ * The Blackboard doesn't notify the writes: the entries are compared with the
+ * values recorded last time after each result of a stubbed node, and at the
+ * end of each tick. Recording costs a JsonExporter conversion per entry at
+ * each of those points, and the writes done by a node are recorded as
+ * the final value at that point.
+ *
+ * Writes and results are buffered and written to the stream at the end of
+ * each tick.
+ */
+class TickRecorder : public StatusChangeLogger
+{
+public:
+  using NodeFilter = std::function<bool(const TreeNode&)>;
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @param tree       the tree to record. It must outlive the recorder.
+   * @param out        the stream, opened in binary mode.
+   * @param is_stubbed the nodes replaced by the replay. By default,
+   *                   actions and conditions.
+   */
+  TickRecorder(Tree& tree, std::ostream& out, NodeFilter is_stubbed = {}) :
+    StatusChangeLogger(tree.rootNode()), tree_(tree), out_(out),
+    previous_frame_(Clock::now())
+  {
+    if (!is_stubbed)
+    {
+      is_stubbed = [](const TreeNode& node) {
+        return node.type() == NodeType::ACTION || node.type() == NodeType::CONDITION;
+      };
+    }
+    buffer_.append(details::kTickRecordingMagic);
+    buffer_.push_back(char(details::kTickRecordingVersion));
+
+    for (size_t i = 0; i < tree.subtrees.size(); i++)
+    {
+      const auto& subtree = tree.subtrees[i];
+      record(details::TickRecord::BLACKBOARD);
+      details::WriteVarint(buffer_, i);
+      details::WriteBytes(buffer_, subtree->instance_name);
+
+      blackboards_.push_back(subtree->blackboard);
+
+      for (const auto& node : subtree->nodes)
+      {
+        if (!is_stubbed(*node))
+        {
+          continue;
+        }
+        if (stubbed_.size() <= node->UID())
+        {
+          stubbed_.resize(size_t(node->UID()) + 1, 0);
+        }
+        stubbed_[node->UID()] = 1;
+        record(details::TickRecord::NODE);
+        details::WriteVarint(buffer_, node->UID());
+        details::WriteBytes(buffer_, node->fullPath());
+      }
+    }
+    values_.resize(blackboards_.size());
+    // the values that precede the recording are not written
+    recordChanges(false);
+    flush();
+  }
+
+  ~TickRecorder() override
+  {
+    flush();
+  }
+
+  TickRecorder(const TickRecorder&) = delete;
+  TickRecorder& operator=(const TickRecorder&) = delete;
+
+  /// Tick the tree once, recording a frame.
+  NodeStatus tickOnce()
+  {
+    const auto start = Clock::now();
+    std::string pending;
+    {
+      std::scoped_lock lk(mutex_);
+      // results and writes received between two ticks belong to the next one
+      pending.swap(buffer_);
+      record(details::TickRecord::FRAME);
+      details::WriteVarint(buffer_, Usec(start - previous_frame_));
+      buffer_.append(pending);
+      in_tick_ = true;
+    }
+    previous_frame_ = start;
+
+    const NodeStatus status = tree_.tickOnce();
+    // writes after the last result, for instance by a RUNNING node
+    recordChanges(true);
+
+    const auto duration = Clock::now() - start;
+    {
+      std::scoped_lock lk(mutex_);
+      in_tick_ = false;
+      record(details::TickRecord::FRAME_END);
+      details::WriteVarint(buffer_, Usec(duration));
+      buffer_.push_back(char(status));
+      out_.write(buffer_.data(), std::streamsize(buffer_.size()));
+      buffer_.clear();
+    }
+    frames_++;
+    return status;
+  }
+
+  [[nodiscard]] size_t framesCount() const
+  {
+    return frames_;
+  }
+
+  void callback(Duration, const TreeNode& node, NodeStatus, NodeStatus status) override
+  {
+    if (status == NodeStatus::IDLE || node.UID() >= stubbed_.size() ||
+        !stubbed_[node.UID()])
+    {
+      return;
+    }
+    // the writes done while ticking the node precede its result
+    recordChanges(true);
+    std::scoped_lock lk(mutex_);
+    record(details::TickRecord::RESULT);
+    details::WriteVarint(buffer_, node.UID());
+    buffer_.push_back(char(status));
+  }
+
+  /// Write to the stream what was recorded between two ticks.
+  void flush() override
+  {
+    std::scoped_lock lk(mutex_);
+    if (!in_tick_)
+    {
+      out_.write(buffer_.data(), std::streamsize(buffer_.size()));
+      buffer_.clear();
+    }
+    out_.flush();
+  }
+
+private:
+  Tree& tree_;
+  std::ostream& out_;
+  std::vector<uint8_t> stubbed_;
+  std::vector<Blackboard::Ptr> blackboards_;
+  Clock::time_point previous_frame_;
+  size_t frames_ = 0;
+
+  std::mutex mutex_;
+  std::string buffer_;
+  bool in_tick_ = false;
+  std::unordered_map<std::string, uint64_t> key_ids_;
+
+  struct RecordedValue
+  {
+    details::TickValueKind kind = details::TickValueKind::OPAQUE;
+    std::string value;
+  };
+  // last value of each entry, for each blackboard; used by recordChanges()
+  std::vector<std::unordered_map<std::string, RecordedValue>> values_;
+  std::mutex values_mutex_;
+
+  static uint64_t Usec(Clock::duration duration)
+  {
+    return uint64_t(std::max<int64_t>(
+        0, std::chrono::duration_cast<std::chrono::microseconds>(duration).count()));
+  }
+
+  void record(details::TickRecord type)
+  {
+    buffer_.push_back(char(type));
+  }
+
+  static RecordedValue Encode(const Blackboard::Entry& entry)
+  {
+    RecordedValue out;
+    nlohmann::json json;
+    bool converted = false;
+    {
+      std::unique_lock lk(entry.entry_mutex);
+      converted = JsonExporter::get().toJson(entry.value, json);
+    }
+    if (converted && json.is_string())
+    {
+      out.kind = details::TickValueKind::STRING;
+      out.value = json.get<std::string>();
+    }
+    else if (converted && (json.is_number() || json.is_boolean()))
+    {
+      out.kind = details::TickValueKind::JSON;
+      out.value = json.dump();
+    }
+    return out;
+  }
+
+  // compare the entries with their last value; if record is true, write the changes
+  void recordChanges(bool record)
+  {
+    // the results of the asynchronous nodes are received by other threads
+    std::scoped_lock values_lock(values_mutex_);
+    for (size_t i = 0; i < blackboards_.size(); i++)
+    {
+      auto& values = values_[i];
+      for (const auto& key_view : blackboards_[i]->getKeys())
+      {
+        std::string key(key_view);
+        auto entry = blackboards_[i]->getEntry(key);
+        if (!entry)
+        {
+          continue;
+        }
+        RecordedValue value = Encode(*entry);
+        auto it = values.find(key);
+        if (it != values.end() && it->second.kind == value.kind &&
+            it->second.value == value.value)
+        {
+          continue;
+        }
+        if (record)
+        {
+          onWrite(i, key, value);
+        }
+        values.insert_or_assign(std::move(key), std::move(value));
+      }
+    }
+  }
+
+  void onWrite(size_t bb_index, const std::string& key, const RecordedValue& value)
+  {
+    std::scoped_lock lk(mutex_);
+    auto [it, inserted] = key_ids_.emplace(key, key_ids_.size());
+    if (inserted)
+    {
+      record(details::TickRecord::KEY);
+      details::WriteVarint(buffer_, it->second);
+      details::WriteBytes(buffer_, key);
+    }
+    record(details::TickRecord::WRITE);
+    details::WriteVarint(buffer_, bb_index);
+    details::WriteVarint(buffer_, it->second);
+    buffer_.push_back(char(value.kind));
+    details::WriteBytes(buffer_, value.value);
+  }
+};
+
+/**
+ * @brief TickReplayer re-executes a recording of TickRecorder: the stubbed
+ * nodes are replaced by ReplayStub, that returns the recorded statuses,
+ * and the recorded blackboard writes are applied before the stub that
+ * followed them returns. The other nodes are executed as usual.
+ *
+ * Useful to benchmark changes of the engine, or of the control nodes, with
+ * the tick sequence of a production run:
+ *
+ *   std::ifstream in("run.btrr", std::ios::binary);
+ *   TickReplayer replayer(in);
+ *   replayer.prepareFactory(factory);   // before creating the tree
+ *   auto tree = factory.createTree("MainTree");
+ *   replayer.attach(tree);
+ *   while (replayer.tickOnce()) {}
+ *   auto stats = replayer.statistics();
+ *
+ * The replay is deterministic as long as the nodes that are not stubbed
+ * don't depend on time or on external state (for instance Timeout or Delay).
+ * Differences with the recording (a stub ticked when it wasn't, or not
+ * ticked when it was) are counted as divergences.
+ */
+class TickReplayer
+{
+public:
+  struct Statistics
+  {
+    size_t ticks = 0;
+    size_t divergences = 0;
+    /// ticks in which the tree returned a status different from the recorded one
+    size_t status_mismatches = 0;
+    /// writes that couldn't be restored (not serializable, or unknown blackboard)
+    size_t skipped_writes = 0;
+    std::chrono::nanoseconds recorded_tick_time = {};
+    std::chrono::nanoseconds replayed_tick_time = {};
+  };
+
+  /// The node that replaces the stubbed nodes.
+  class ReplayStub : public ActionNodeBase
+  {
+  public:
+    ReplayStub(const std::string& name, const NodeConfig& config, TickReplayer* replayer) :
+      ActionNodeBase(name, config), replayer_(replayer)
+    {}
+
+    static PortsList providedPorts()
+    {
+      return {};
+    }
+
+  private:
+    TickReplayer* replayer_;
+
+    NodeStatus tick() override
+    {
+      return replayer_->stubResult(*this);
+    }
+
+    void halt() override
+    {
+      resetStatus();
+    }
+  };
+
+  static constexpr const char* kStubID = "ReplayStub";
+
+  /// Read the whole recording; throws if it is not valid.
+  explicit TickReplayer(std::istream& in)
+  {
+    char magic[4] = {};
+    in.read(magic, 4);
+    if (!in || std::string(magic, 4) != details::kTickRecordingMagic ||
+        in.get() != details::kTickRecordingVersion)
+    {
+      throw RuntimeError("TickReplayer: not a recording of TickRecorder");
+    }
+    parse(in);
+  }
+
+  TickReplayer(const TickReplayer&) = delete;
+  TickReplayer& operator=(const TickReplayer&) = delete;
+
+  /// Register ReplayStub and the substitution rules of the stubbed nodes.
+  void prepareFactory(BehaviorTreeFactory& factory)
+  {
+    if (factory.manifests().count(kStubID) == 0)
+    {
+      factory.registerNodeType<ReplayStub>(kStubID, this);
+    }
+    for (const auto& [path, uid] : recorded_uids_)
+    {
+      factory.addSubstitutionRule(path, std::string(kStubID));
+    }
+  }
+
+  /// Bind the tree created after prepareFactory(). It must outlive the replayer.
+  void attach(Tree& tree)
+  {
+    tree_ = &tree;
+    blackboards_.assign(bb_names_.size(), nullptr);
+    for (size_t i = 0; i < bb_names_.size(); i++)
+    {
+      for (const auto& subtree : tree.subtrees)
+      {
+        if (subtree->instance_name == bb_names_[i])
+        {
+          blackboards_[i] = subtree->blackboard.get();
+          break;
+        }
+      }
+    }
+    next_frame_ = 0;
+    stats_ = {};
+  }
+
+  /// Replay the next tick. Returns false when the recording is finished.
+  bool tickOnce()
+  {
+    if (!tree_)
+    {
+      throw RuntimeError("TickReplayer: call attach() first");
+    }
+    if (next_frame_ >= frames_.size())
+    {
+      return false;
+    }
+    Frame& frame = frames_[next_frame_++];
+    frame.applied.assign(frame.events.size(), false);
+    current_ = &frame;
+
+    const auto start = std::chrono::steady_clock::now();
+    const NodeStatus status = tree_->tickOnce();
+    // writes after the last result, for instance by a RUNNING stub
+    applyUntil(frame.events.size());
+    stats_.replayed_tick_time += std::chrono::steady_clock::now() - start;
+
+    stats_.recorded_tick_time += frame.duration;
+    stats_.ticks++;
+    if (status != frame.status)
+    {
+      stats_.status_mismatches++;
+    }
+    for (size_t i = 0; i < frame.events.size(); i++)
+    {
+      if (frame.events[i].type == details::TickRecord::RESULT && !frame.applied[i])
+      {
+        stats_.divergences++;
+      }
+    }
+    current_ = nullptr;
+    return true;
+  }
+
+  [[nodiscard]] size_t framesCount() const
+  {
+    return frames_.size();
+  }
+
+  [[nodiscard]] const Statistics& statistics() const
+  {
+    return stats_;
+  }
+
+private:
+  struct Event
+  {
+    details::TickRecord type = details::TickRecord::RESULT;
+    uint64_t uid_or_bb = 0;
+    uint64_t key = 0;
+    NodeStatus status = NodeStatus::IDLE;
+    details::TickValueKind kind = details::TickValueKind::OPAQUE;
+    std::string value;
+  };
+
+  struct Frame
+  {
+    std::chrono::microseconds duration = {};
+    NodeStatus status = NodeStatus::IDLE;
+    std::vector<Event> events;
+    std::vector<bool> applied;
+  };
+
+  std::unordered_map<std::string, uint64_t> recorded_uids_;
+  std::vector<std::string> bb_names_;
+  std::vector<std::string> keys_;
+  std::vector<Frame> frames_;
+
+  Tree* tree_ = nullptr;
+  std::vector<Blackboard*> blackboards_;
+  size_t next_frame_ = 0;
+  Frame* current_ = nullptr;
+  Statistics stats_;
+
+  static NodeStatus ReadStatus(std::istream& in)
+  {
+    const int c = in.get();
+    if (c < int(NodeStatus::IDLE) || c > int(NodeStatus::SKIPPED))
+    {
+      throw RuntimeError("TickReplayer: invalid status");
+    }
+    return static_cast<NodeStatus>(c);
+  }
+
+  void parse(std::istream& in)
+  {
+    using details::ReadBytes;
+    using details::ReadVarint;
+    using details::TickRecord;
+
+    // the records received before the first frame, or between two frames
+    std::vector<Event> pending;
+    Frame* open_frame = nullptr;
+    auto events = [&]() -> std::vector<Event>& {
+      return open_frame ? open_frame->events : pending;
+    };
+
+    int c;
+    while ((c = in.get()) != std::char_traits<char>::eof())
+    {
+      switch (static_cast<TickRecord>(c))
+      {
+        case TickRecord::NODE: {
+          const uint64_t uid = ReadVarint(in);
+          recorded_uids_[ReadBytes(in)] = uid;
+        }
+        break;
+
+        case TickRecord::BLACKBOARD: {
+          const uint64_t index = ReadVarint(in);
+          if (bb_names_.size() <= index)
+          {
+            bb_names_.resize(index + 1);
+          }
+          bb_names_[index] = ReadBytes(in);
+        }
+        break;
+
+        case TickRecord::KEY: {
+          const uint64_t id = ReadVarint(in);
+          if (keys_.size() <= id)
+          {
+            keys_.resize(id + 1);
+          }
+          keys_[id] = ReadBytes(in);
+        }
+        break;
+
+        case TickRecord::FRAME: {
+          ReadVarint(in);
+          frames_.emplace_back();
+          open_frame = &frames_.back();
+          open_frame->events = std::move(pending);
+          pending.clear();
+        }
+        break;
+
+        case TickRecord::FRAME_END: {
+          if (!open_frame)
+          {
+            throw RuntimeError("TickReplayer: end of a frame that wasn't started");
+          }
+          open_frame->duration = std::chrono::microseconds(ReadVarint(in));
+          open_frame->status = ReadStatus(in);
+          open_frame = nullptr;
+        }
+        break;
+
+        case TickRecord::RESULT: {
+          Event event;
+          event.uid_or_bb = ReadVarint(in);
+          event.status = ReadStatus(in);
+          events().push_back(std::move(event));
+        }
+        break;
+
+        case TickRecord::WRITE: {
+          Event event;
+          event.type = TickRecord::WRITE;
+          event.uid_or_bb = ReadVarint(in);
+          event.key = ReadVarint(in);
+          event.kind = static_cast<details::TickValueKind>(in.get());
+          event.value = ReadBytes(in);
+          events().push_back(std::move(event));
+        }
+        break;
+
+        default:
+          throw RuntimeError("TickReplayer: unknown record ", std::to_string(c));
+      }
+    }
+    // an interrupted recording: drop the last frame
+    if (open_frame)
+    {
+      frames_.pop_back();
+    }
+  }
+
+  NodeStatus stubResult(const TreeNode& node)
+  {
+    auto uid_it = recorded_uids_.find(node.fullPath());
+    if (!current_ || uid_it == recorded_uids_.end())
+    {
+      stats_.divergences++;
+      return NodeStatus::FAILURE;
+    }
+    Frame& frame = *current_;
+    for (size_t i = 0; i < frame.events.size(); i++)
+    {
+      const Event& event = frame.events[i];
+      if (event.type == details::TickRecord::RESULT && !frame.applied[i] &&
+          event.uid_or_bb == uid_it->second)
+      {
+        applyUntil(i);
+        frame.applied[i] = true;
+        return event.status;
+      }
+    }
+    // no transition: a RUNNING node that is still running
+    if (node.status() == NodeStatus::RUNNING)
+    {
+      return NodeStatus::RUNNING;
+    }
+    stats_.divergences++;
+    return NodeStatus::FAILURE;
+  }
+
+  // apply the writes before the event at position "end"
+  void applyUntil(size_t end)
+  {
+    Frame& frame = *current_;
+    for (size_t i = 0; i < end; i++)
+    {
+      const Event& event = frame.events[i];
+      if (event.type != details::TickRecord::WRITE || frame.applied[i])
+      {
+        continue;
+      }
+      frame.applied[i] = true;
+      Blackboard* bb =
+          event.uid_or_bb < blackboards_.size() ? blackboards_[event.uid_or_bb] : nullptr;
+      if (!bb || event.key >= keys_.size() ||
+          event.kind == details::TickValueKind::OPAQUE)
+      {
+        stats_.skipped_writes++;
+        continue;
+      }
+      // the blackboard converts the string to the type of the entry
+      bb->set(keys_[event.key], event.value);
+    }
+  }
+};
+
+}   // namespace BT
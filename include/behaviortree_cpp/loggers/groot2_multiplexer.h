@@ -0,0 +1,434 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "behaviortree_cpp/json_export.h"
+#include "behaviortree_cpp/loggers/groot2_publisher.h"
+#include "behaviortree_cpp/utils/executor.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief Groot2Multiplexer serves many trees through a single endpoint,
+ * instead of a Groot2Publisher (a port and two threads) per tree.
+ *
+ * The trees are registered with registerTree(), that returns their ID.
+ * The requests carry it after the first part (see SerializeHeader() with a
+ * TreeUniqueUUID); requests without an ID are addressed to the first tree,
+ * so that a client unaware of the multiplexing sees a single tree.
+ * TREES_LIST returns the registered trees.
+ *
+ * The multiplexer doesn't own a socket: the server loop of the process
+ * passes the parts of each request to handleRequest() and sends the reply
+ * when the callback is invoked. Replies are built by the shared Executor,
+ * in parallel and possibly out of order: use a ROUTER socket, or serialize
+ * the requests of a REP socket.
+ *
+ * Supported requests: FULLTREE, STATUS, STATUS_DELTA, BLACKBOARD,
+ * TOGGLE_RECORDING, GET_TRANSITIONS and TREES_LIST. The hooks require
+ * a Groot2Publisher attached to the tree.
+ */
+class Groot2Multiplexer
+{
+public:
+  using TreeID = Monitor::TreeUniqueUUID;
+  /// Parts of a multipart request or reply
+  using Message = std::vector<std::string>;
+  using ReplyCallback = std::function<void(Message&& reply)>;
+
+  struct TreeInfo
+  {
+    TreeID id;
+    std::string name;
+  };
+
+  /// @param executor used to serialize the replies
+  explicit Groot2Multiplexer(Executor::Ptr executor = DefaultExecutor()) :
+    executor_(std::move(executor))
+  {
+    if (!executor_)
+    {
+      throw RuntimeError("Groot2Multiplexer: invalid executor");
+    }
+  }
+
+  ~Groot2Multiplexer()
+  {
+    std::vector<std::shared_ptr<Channel>> channels;
+    {
+      std::unique_lock lk(channels_mutex_);
+      channels.swap(channels_);
+    }
+    for (const auto& channel : channels)
+    {
+      channel->close();
+    }
+  }
+
+  Groot2Multiplexer(const Groot2Multiplexer&) = delete;
+  Groot2Multiplexer& operator=(const Groot2Multiplexer&) = delete;
+
+  /**
+   * @brief Start serving the tree. It must outlive its registration.
+   * @param name shown by TREES_LIST. If empty, the ID of the main tree.
+   * @param max_transitions transitions kept while recording.
+   */
+  TreeID registerTree(const Tree& tree, std::string name = {},
+                      size_t max_transitions = 1000)
+  {
+    if (name.empty())
+    {
+      name = tree.subtrees.empty() ? std::string() : tree.subtrees.front()->tree_ID;
+    }
+    auto channel = std::make_shared<Channel>(tree, std::move(name), max_transitions);
+    std::unique_lock lk(channels_mutex_);
+    do
+    {
+      channel->id = RandomID();
+    } while (findChannel(channel->id));
+    channels_.push_back(channel);
+    return channel->id;
+  }
+
+  /// Stop serving the tree, waiting for the replies being built.
+  bool unregisterTree(const TreeID& id)
+  {
+    std::shared_ptr<Channel> channel;
+    {
+      std::unique_lock lk(channels_mutex_);
+      auto it = std::find_if(channels_.begin(), channels_.end(),
+                             [&](const auto& ch) { return ch->id == id; });
+      if (it == channels_.end())
+      {
+        return false;
+      }
+      channel = *it;
+      channels_.erase(it);
+    }
+    channel->close();
+    return true;
+  }
+
+  [[nodiscard]] std::vector<TreeInfo> trees() const
+  {
+    std::shared_lock lk(channels_mutex_);
+    std::vector<TreeInfo> out;
+    out.reserve(channels_.size());
+    for (const auto& channel : channels_)
+    {
+      out.push_back({ channel->id, channel->name });
+    }
+    return out;
+  }
+
+  /**
+   * @brief Build the reply to a request. Thread-safe; the callback is
+   * invoked exactly once, by a thread of the Executor, or by this thread
+   * if the request is invalid.
+   */
+  void handleRequest(Message request, ReplyCallback on_reply)
+  {
+    if (request.empty() || request[0].size() < Monitor::RequestHeader::size())
+    {
+      on_reply(ErrorReply("wrong request header"));
+      return;
+    }
+    Monitor::ReplyHeader reply_header;
+    reply_header.request = Monitor::DeserializeRequestHeader(request[0]);
+    if (reply_header.request.protocol != Monitor::kProtocolID)
+    {
+      on_reply(ErrorReply("Protocol not matching"));
+      return;
+    }
+
+    if (reply_header.request.type == Monitor::RequestType::TREES_LIST)
+    {
+      nlohmann::json list = nlohmann::json::array();
+      for (const auto& info : trees())
+      {
+        list.push_back({ { "id", ToHex(info.id) }, { "name", info.name } });
+      }
+      on_reply({ Monitor::SerializeHeader(reply_header), list.dump() });
+      return;
+    }
+
+    std::shared_ptr<Channel> channel;
+    {
+      std::shared_lock lk(channels_mutex_);
+      if (Monitor::DeserializeRequestTreeID(request[0], reply_header.tree_id))
+      {
+        channel = findChannel(reply_header.tree_id);
+      }
+      else if (!channels_.empty())
+      {
+        channel = channels_.front();
+        reply_header.tree_id = channel->id;
+      }
+    }
+    if (!channel || !channel->acquire())
+    {
+      on_reply(ErrorReply("unknown tree"));
+      return;
+    }
+    executor_->execute([channel, reply_header, request = std::move(request),
+                        on_reply = std::move(on_reply)]() mutable {
+      Message reply;
+      try
+      {
+        reply = channel->serve(reply_header, request);
+      }
+      catch (std::exception& err)
+      {
+        reply = ErrorReply(err.what());
+      }
+      channel->release();
+      on_reply(std::move(reply));
+    });
+  }
+
+  static Message ErrorReply(std::string message)
+  {
+    return { "error", std::move(message) };
+  }
+
+  static std::string ToHex(const TreeID& id)
+  {
+    static const char* digits = "0123456789abcdef";
+    std::string out;
+    out.reserve(id.size() * 2);
+    for (char c : id)
+    {
+      out.push_back(digits[(uint8_t(c) >> 4) & 0xF]);
+      out.push_back(digits[uint8_t(c) & 0xF]);
+    }
+    return out;
+  }
+
+private:
+  // the state of one tree; it replaces the buffers of a Groot2Publisher
+  struct Channel : public StatusChangeLogger
+  {
+    const Tree& tree;
+    TreeID id;
+    std::string name;
+
+    Channel(const Tree& tree, std::string name, size_t max_transitions) :
+      StatusChangeLogger(tree.rootNode()), tree(tree), name(std::move(name)),
+      max_transitions_(std::max<size_t>(max_transitions, 1))
+    {
+      std::vector<uint16_t> uids;
+      for (const auto& subtree : tree.subtrees)
+      {
+        for (const auto& node : subtree->nodes)
+        {
+          uids.push_back(node->UID());
+        }
+      }
+      statuses_.reset(uids);
+    }
+
+    void callback(Duration timestamp, const TreeNode& node, NodeStatus,
+                  NodeStatus status) override
+    {
+      statuses_.update(node.UID(), status);
+      if (!recording_.load(std::memory_order_relaxed))
+      {
+        return;
+      }
+      std::unique_lock lk(mutex_);
+      if (!recording_)
+      {
+        return;
+      }
+      // the transition may precede the start of the recording
+      const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+          TimePoint(timestamp) - recording_start_time_);
+      Transition trans;
+      trans.timestamp_usec = uint64_t(std::max<int64_t>(0, elapsed.count()));
+      trans.node_uid = node.UID();
+      trans.status = uint8_t(status);
+      transitions_.push_back(trans);
+      while (transitions_.size() > max_transitions_)
+      {
+        transitions_.pop_front();
+      }
+    }
+
+    void flush() override
+    {}
+
+    bool acquire()
+    {
+      std::unique_lock lk(mutex_);
+      if (closed_)
+      {
+        return false;
+      }
+      in_flight_++;
+      return true;
+    }
+
+    void release()
+    {
+      std::unique_lock lk(mutex_);
+      if (--in_flight_ == 0)
+      {
+        idle_cv_.notify_all();
+      }
+    }
+
+    // no new requests; wait for the ones being served
+    void close()
+    {
+      setEnabled(false);
+      std::unique_lock lk(mutex_);
+      closed_ = true;
+      idle_cv_.wait(lk, [this] { return in_flight_ == 0; });
+    }
+
+    Message serve(const Monitor::ReplyHeader& header, const Message& request)
+    {
+      Message reply = { Monitor::SerializeHeader(header) };
+      switch (header.request.type)
+      {
+        case Monitor::RequestType::FULLTREE:
+          reply.push_back(*full_tree_.get(tree));
+          break;
+
+        case Monitor::RequestType::STATUS:
+          // a full snapshot, without the sequence number and the flag
+          reply.push_back(statuses_.serializeSince(0).substr(9));
+          break;
+
+        case Monitor::RequestType::STATUS_DELTA: {
+          uint64_t client_sequence = 0;
+          if (request.size() > 1 && request[1].size() == sizeof(uint64_t))
+          {
+            Monitor::Deserialize(request[1].data(), 0, client_sequence);
+          }
+          reply.push_back(statuses_.serializeSince(client_sequence));
+        }
+        break;
+
+        case Monitor::RequestType::BLACKBOARD: {
+          if (request.size() != 2)
+          {
+            return ErrorReply("must be 2 parts message");
+          }
+          const auto bytes = blackboards_.dump(tree, request[1]);
+          reply.emplace_back(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }
+        break;
+
+        case Monitor::RequestType::TOGGLE_RECORDING: {
+          if (request.size() != 2)
+          {
+            return ErrorReply("must be 2 parts message");
+          }
+          std::unique_lock lk(mutex_);
+          if (request[1] == "start")
+          {
+            recording_start_time_ = std::chrono::high_resolution_clock::now();
+            recording_ = true;
+            const auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+                recording_start_time_.time_since_epoch());
+            reply.push_back(std::to_string(now.count()));
+          }
+          else if (request[1] == "stop")
+          {
+            recording_ = false;
+            transitions_.clear();
+          }
+        }
+        break;
+
+        case Monitor::RequestType::GET_TRANSITIONS: {
+          std::string buffer;
+          std::unique_lock lk(mutex_);
+          buffer.resize(9 * transitions_.size());
+          unsigned offset = 0;
+          for (const auto& trans : transitions_)
+          {
+            // 6 bytes of timestamp, i.e. up to 8.9 years
+            std::memcpy(&buffer[offset], &trans.timestamp_usec, 6);
+            offset += 6;
+            offset += Monitor::Serialize(buffer.data(), offset, trans.node_uid);
+            offset += Monitor::Serialize(buffer.data(), offset, trans.status);
+          }
+          transitions_.clear();
+          reply.push_back(std::move(buffer));
+        }
+        break;
+
+        default:
+          return ErrorReply(std::string("request not supported: ") +
+                            Monitor::ToString(header.request.type));
+      }
+      return reply;
+    }
+
+  private:
+    struct Transition
+    {
+      uint64_t timestamp_usec = 0;
+      uint16_t node_uid = 0;
+      uint8_t status = 0;
+    };
+
+    Monitor::StatusDeltaLog statuses_;
+    FullTreeCache full_tree_;
+    BlackboardDumpCache blackboards_;
+
+    std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    size_t in_flight_ = 0;
+    bool closed_ = false;
+
+    std::atomic<bool> recording_ = false;
+    TimePoint recording_start_time_;
+    size_t max_transitions_;
+    std::deque<Transition> transitions_;
+  };
+
+  Executor::Ptr executor_;
+  mutable std::shared_mutex channels_mutex_;
+  std::vector<std::shared_ptr<Channel>> channels_;
+
+  // must be called with channels_mutex_ locked
+  std::shared_ptr<Channel> findChannel(const TreeID& id) const
+  {
+    for (const auto& channel : channels_)
+    {
+      if (channel->id == id)
+      {
+        return channel;
+      }
+    }
+    return {};
+  }
+
+  static TreeID RandomID()
+  {
+    static std::mutex mutex;
+    static std::mt19937_64 generator{ std::random_device{}() };
+    TreeID id;
+    std::scoped_lock lk(mutex);
+    for (size_t i = 0; i < id.size(); i += sizeof(uint64_t))
+    {
+      const uint64_t value = generator();
+      std::memcpy(id.data() + i, &value, sizeof(uint64_t));
+    }
+    return id;
+  }
+};
+
+}   // namespace BT
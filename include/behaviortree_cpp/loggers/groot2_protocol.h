@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include <array>
 #include <cstring>
@@ -8,6 +9,8 @@
 #include <memory>
 #include <condition_variable>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "behaviortree_cpp/basic_types.h"
 #include "behaviortree_cpp/contrib/json.hpp"
 
@@ -54,6 +57,12 @@ enum RequestType : uint8_t
   // get all transitions when recording
   GET_TRANSITIONS = 't',
 
+  // get the status of the nodes that changed since a given sequence number
+  STATUS_DELTA = 'd',
+
+  // list the trees served by the same endpoint (JSON)
+  TREES_LIST = 'L',
+
   UNDEFINED = 0,
 };
 
@@ -74,6 +83,8 @@ inline const char* ToString(const RequestType& type)
   case RequestType::DISABLE_ALL_HOOKS: return "disable_hooks";
   case RequestType::TOGGLE_RECORDING: return "toggle_recording";
   case RequestType::GET_TRANSITIONS: return "get_transitions";
+  case RequestType::STATUS_DELTA: return "status_delta";
+  case RequestType::TREES_LIST: return "trees_list";
 
   case RequestType::UNDEFINED: return "undefined";
   }
@@ -166,6 +177,31 @@ inline std::string SerializeHeader(const ReplyHeader& header)
   return buffer;
 }
 
+/*
+ * When many trees are served by the same endpoint (see Groot2Multiplexer),
+ * the first part of the request may be followed by the 16 bytes of the
+ * TreeUniqueUUID of the tree; the same value is returned in the ReplyHeader.
+ * Requests without it are addressed to the first tree.
+ */
+inline std::string SerializeHeader(const RequestHeader& header,
+                                   const TreeUniqueUUID& tree_id)
+{
+  std::string buffer = SerializeHeader(header);
+  buffer.append(tree_id.data(), tree_id.size());
+  return buffer;
+}
+
+/// Return false if the first part of the request doesn't contain a tree ID.
+inline bool DeserializeRequestTreeID(const std::string& buffer, TreeUniqueUUID& tree_id)
+{
+  if (buffer.size() != RequestHeader::size() + tree_id.size())
+  {
+    return false;
+  }
+  Deserialize(buffer.data(), unsigned(RequestHeader::size()), tree_id);
+  return true;
+}
+
 inline RequestHeader DeserializeRequestHeader(const std::string& buffer)
 {
   RequestHeader header;
@@ -188,6 +224,155 @@ inline ReplyHeader DeserializeReplyHeader(const std::string& buffer)
   return header;
 }
 
+/*
+ * STATUS_DELTA: the second part of the request is the sequence number
+ * of the last reply received by the client (uint64, 0 if none).
+ * The second part of the reply contains:
+ *
+ *  - uint64: the sequence number of this reply
+ *  - uint8:  1 if this is a full snapshot, 0 if it contains only the changes
+ *  - N x 3 bytes: node uid (uint16) and status (uint8), as in the reply of STATUS
+ *
+ * The reply is a full snapshot when the client is too far behind.
+ */
+class StatusDeltaLog
+{
+public:
+  /// history_size: changes remembered to build a delta
+  explicit StatusDeltaLog(size_t history_size = 8192) :
+    history_(std::max<size_t>(history_size, 1))
+  {}
+
+  /// Set the nodes of the tree, all IDLE. The sequence number is not reset.
+  void reset(const std::vector<uint16_t>& uids)
+  {
+    std::unique_lock lk(mutex_);
+    uids_ = uids;
+    uint16_t max_uid = 0;
+    for (auto uid : uids_)
+    {
+      max_uid = std::max(max_uid, uid);
+    }
+    statuses_.assign(size_t(max_uid) + 1, uint8_t(NodeStatus::IDLE));
+    last_change_.assign(size_t(max_uid) + 1, 0);
+    // the clients must receive a full snapshot
+    sequence_++;
+    oldest_ = sequence_;
+    count_ = 0;
+  }
+
+  /// To be called for each transition
+  void update(uint16_t uid, NodeStatus status)
+  {
+    std::unique_lock lk(mutex_);
+    if (uid >= statuses_.size() || statuses_[uid] == uint8_t(status))
+    {
+      return;
+    }
+    statuses_[uid] = uint8_t(status);
+    const uint64_t sequence = ++sequence_;
+    last_change_[uid] = sequence;
+    history_[sequence % history_.size()] = uid;
+    if (count_ < history_.size())
+    {
+      count_++;
+    }
+    else
+    {
+      oldest_++;
+    }
+  }
+
+  [[nodiscard]] uint64_t sequence() const
+  {
+    std::unique_lock lk(mutex_);
+    return sequence_;
+  }
+
+  /// The second part of the reply to STATUS_DELTA
+  [[nodiscard]] std::string serializeSince(uint64_t client_sequence) const
+  {
+    std::unique_lock lk(mutex_);
+    const bool full = (client_sequence < oldest_ || client_sequence > sequence_);
+
+    std::string buffer;
+    buffer.resize(9);
+    unsigned offset = 0;
+    offset += Serialize(buffer.data(), offset, sequence_);
+    Serialize(buffer.data(), offset, uint8_t(full ? 1 : 0));
+
+    auto append = [&](uint16_t uid) {
+      const size_t pos = buffer.size();
+      buffer.resize(pos + 3);
+      Serialize(buffer.data(), unsigned(pos), uid);
+      Serialize(buffer.data(), unsigned(pos + 2), statuses_[uid]);
+    };
+
+    if (full)
+    {
+      buffer.reserve(buffer.size() + uids_.size() * 3);
+      for (auto uid : uids_)
+      {
+        append(uid);
+      }
+      return buffer;
+    }
+    // visit only the changes after client_sequence; a node that changed
+    // many times is added once, at its last change
+    for (uint64_t seq = client_sequence + 1; seq <= sequence_; seq++)
+    {
+      const uint16_t uid = history_[seq % history_.size()];
+      if (last_change_[uid] == seq)
+      {
+        append(uid);
+      }
+    }
+    return buffer;
+  }
+
+private:
+  mutable std::mutex mutex_;
+  std::vector<uint16_t> uids_;
+  std::vector<uint8_t> statuses_;
+  std::vector<uint64_t> last_change_;
+  std::vector<uint16_t> history_;
+  uint64_t sequence_ = 0;
+  // changes older than oldest_ are not in the history anymore
+  uint64_t oldest_ = 0;
+  size_t count_ = 0;
+};
+
+/**
+ * @brief Apply the reply to STATUS_DELTA to the statuses known by the client.
+ * @return the sequence number to send with the next request.
+ */
+inline uint64_t ApplyStatusDelta(const std::string& reply,
+                                 std::unordered_map<uint16_t, NodeStatus>& statuses)
+{
+  if (reply.size() < 9 || (reply.size() - 9) % 3 != 0)
+  {
+    throw std::runtime_error("ApplyStatusDelta: wrong size of the reply");
+  }
+  uint64_t sequence = 0;
+  uint8_t full = 0;
+  unsigned offset = 0;
+  offset += Deserialize(reply.data(), offset, sequence);
+  offset += Deserialize(reply.data(), offset, full);
+  if (full)
+  {
+    statuses.clear();
+  }
+  while (offset < reply.size())
+  {
+    uint16_t uid = 0;
+    uint8_t status = 0;
+    offset += Deserialize(reply.data(), offset, uid);
+    offset += Deserialize(reply.data(), offset, status);
+    statuses[uid] = static_cast<NodeStatus>(status);
+  }
+  return sequence;
+}
+
 struct Hook
 {
   using Ptr = std::shared_ptr<Hook>;
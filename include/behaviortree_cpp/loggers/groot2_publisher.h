@@ -1,13 +1,275 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <future>
+#include <map>
+#include <sstream>
+#include "behaviortree_cpp/json_export.h"
 #include "behaviortree_cpp/loggers/abstract_logger.h"
 #include "behaviortree_cpp/loggers/groot2_protocol.h"
+#include "behaviortree_cpp/xml_parsing.h"
 
 namespace BT
 {
 
+/**
+ * @brief FullTreeCache keeps the reply to the FULLTREE request, i.e. the XML
+ * written by WriteTreeToXML() with metadata and builtin models, and writes it
+ * again only when the structure of the tree changes (for instance, after
+ * Tree::reload()). The clients share the same string.
+ */
+class FullTreeCache
+{
+public:
+  using Ptr = std::shared_ptr<const std::string>;
+
+  [[nodiscard]] Ptr get(const Tree& tree)
+  {
+    auto fingerprint = Fingerprint(tree);
+    std::unique_lock lk(mutex_);
+    if (!xml_ || fingerprint != fingerprint_)
+    {
+      std::ostringstream out;
+      WriteTreeToXML(out, tree, true, true);
+      xml_ = std::make_shared<const std::string>(out.str());
+      fingerprint_ = std::move(fingerprint);
+    }
+    return xml_;
+  }
+
+  void invalidate()
+  {
+    std::unique_lock lk(mutex_);
+    xml_.reset();
+  }
+
+private:
+  // the subtrees are replaced, not modified, when the structure changes
+  static std::vector<uintptr_t> Fingerprint(const Tree& tree)
+  {
+    std::vector<uintptr_t> out;
+    out.reserve(tree.subtrees.size() * 3 + 1);
+    out.push_back(tree.manifests.size());
+    for (const auto& subtree : tree.subtrees)
+    {
+      out.push_back(reinterpret_cast<uintptr_t>(subtree.get()));
+      out.push_back(subtree->nodes.size());
+      out.push_back(subtree->nodes.empty() ? 0 : subtree->nodes.front()->UID());
+    }
+    return out;
+  }
+
+  std::mutex mutex_;
+  std::vector<uintptr_t> fingerprint_;
+  Ptr xml_;
+};
+
+/**
+ * @brief BlackboardDumpCache builds the reply to the BLACKBOARD request: the
+ * MessagePack encoding of {subtree_instance_name: {key: value}}, with the
+ * values converted by JsonExporter, as ExportBlackboardToJSON().
+ *
+ * The encoding of each entry (key and value) is kept, and reused for
+ * Options::max_age: the clients polling a large blackboard (for instance
+ * the many clients of a Groot2Multiplexer) convert each value at most once
+ * per max_age. The Blackboard doesn't tell which entries changed, therefore
+ * a value may be reported up to max_age late.
+ */
+class BlackboardDumpCache
+{
+public:
+  struct Options
+  {
+    /// The cached encoding of an entry is refreshed after this time.
+    std::chrono::milliseconds max_age = std::chrono::milliseconds(100);
+  };
+
+  struct Statistics
+  {
+    uint64_t encoded_entries = 0;
+    uint64_t reused_entries = 0;
+  };
+
+  BlackboardDumpCache() : BlackboardDumpCache(Options())
+  {}
+
+  explicit BlackboardDumpCache(const Options& options) : options_(options)
+  {}
+
+  /// @param bb_list  instance names of the subtrees, separated by ';'
+  [[nodiscard]] std::vector<uint8_t> dump(const Tree& tree, const std::string& bb_list)
+  {
+    std::vector<const Tree::Subtree*> selected;
+    for (const auto& bb_name : splitString(bb_list, ';'))
+    {
+      for (const auto& subtree : tree.subtrees)
+      {
+        if (subtree->blackboard && subtree->instance_name == bb_name)
+        {
+          // the names are the keys of a map: skip the duplicates
+          if (std::find(selected.begin(), selected.end(), subtree.get()) == selected.end())
+          {
+            selected.push_back(subtree.get());
+          }
+          break;
+        }
+      }
+    }
+
+    std::scoped_lock lk(mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    generation_++;
+    std::vector<uint8_t> out;
+    WriteMapHeader(out, selected.size());
+    for (const Tree::Subtree* subtree : selected)
+    {
+      WriteString(out, subtree->instance_name);
+      auto& cached = blackboards_[subtree->blackboard.get()];
+      cached.generation = generation_;
+      appendBlackboard(out, *subtree->blackboard, cached, now);
+    }
+    // forget the blackboards that were not requested
+    for (auto it = blackboards_.begin(); it != blackboards_.end();)
+    {
+      it = (it->second.generation == generation_) ? std::next(it) : blackboards_.erase(it);
+    }
+    return out;
+  }
+
+  [[nodiscard]] Statistics statistics() const
+  {
+    std::scoped_lock lk(mutex_);
+    return statistics_;
+  }
+
+  void invalidate()
+  {
+    std::scoped_lock lk(mutex_);
+    blackboards_.clear();
+  }
+
+private:
+  struct CachedEntry
+  {
+    std::weak_ptr<Blackboard::Entry> entry;
+    std::chrono::steady_clock::time_point encoded_at;
+    // MessagePack of the key, followed by the one of the value
+    std::vector<uint8_t> bytes;
+  };
+
+  struct CachedBlackboard
+  {
+    uint64_t generation = 0;
+    std::map<std::string, CachedEntry> entries;
+  };
+
+  void appendBlackboard(std::vector<uint8_t>& out, Blackboard& blackboard,
+                        CachedBlackboard& cached, std::chrono::steady_clock::time_point now)
+  {
+    std::vector<std::pair<std::string, std::shared_ptr<Blackboard::Entry>>> entries;
+    for (const auto& key : blackboard.getKeys())
+    {
+      std::string name(key);
+      if (auto entry = blackboard.getEntry(name))
+      {
+        entries.emplace_back(std::move(name), std::move(entry));
+      }
+    }
+    // same order of nlohmann::json
+    std::sort(entries.begin(), entries.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::map<std::string, CachedEntry> updated;
+    WriteMapHeader(out, entries.size());
+    for (auto& [key, entry] : entries)
+    {
+      auto node = cached.entries.extract(key);
+      CachedEntry item = node ? std::move(node.mapped()) : CachedEntry();
+      if (!node || item.entry.lock() != entry || now - item.encoded_at >= options_.max_age)
+      {
+        item.entry = entry;
+        item.encoded_at = now;
+        item.bytes.clear();
+        WriteString(item.bytes, key);
+        nlohmann::json json;
+        {
+          std::unique_lock lock(entry->entry_mutex);
+          JsonExporter::get().toJson(entry->value, json);
+        }
+        nlohmann::json::to_msgpack(json, item.bytes);
+        statistics_.encoded_entries++;
+      }
+      else
+      {
+        statistics_.reused_entries++;
+      }
+      out.insert(out.end(), item.bytes.begin(), item.bytes.end());
+      updated.emplace(key, std::move(item));
+    }
+    // the entries removed from the blackboard are dropped
+    cached.entries = std::move(updated);
+  }
+
+  static void WriteBigEndian(std::vector<uint8_t>& out, uint64_t value, int bytes)
+  {
+    for (int i = bytes - 1; i >= 0; i--)
+    {
+      out.push_back(uint8_t(value >> (8 * i)));
+    }
+  }
+
+  static void WriteMapHeader(std::vector<uint8_t>& out, size_t size)
+  {
+    if (size < 16)
+    {
+      out.push_back(uint8_t(0x80 | size));
+    }
+    else if (size <= 0xFFFF)
+    {
+      out.push_back(0xde);
+      WriteBigEndian(out, size, 2);
+    }
+    else
+    {
+      out.push_back(0xdf);
+      WriteBigEndian(out, size, 4);
+    }
+  }
+
+  static void WriteString(std::vector<uint8_t>& out, const std::string& str)
+  {
+    const size_t size = str.size();
+    if (size < 32)
+    {
+      out.push_back(uint8_t(0xa0 | size));
+    }
+    else if (size <= 0xFF)
+    {
+      out.push_back(0xd9);
+      WriteBigEndian(out, size, 1);
+    }
+    else if (size <= 0xFFFF)
+    {
+      out.push_back(0xda);
+      WriteBigEndian(out, size, 2);
+    }
+    else
+    {
+      out.push_back(0xdb);
+      WriteBigEndian(out, size, 4);
+    }
+    out.insert(out.end(), str.begin(), str.end());
+  }
+
+  Options options_;
+  mutable std::mutex mutex_;
+  uint64_t generation_ = 0;
+  std::unordered_map<const Blackboard*, CachedBlackboard> blackboards_;
+  Statistics statistics_;
+};
+
 /**
  * @brief The Groot2Publisher is used to create an interface between
  * your BT.CPP executor and Groot2.
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "behaviortree_cpp/loggers/abstract_logger.h"
+
+namespace BT
+{
+
+/**
+ * @brief TransitionBus records all the status transitions of a tree in a
+ * single ring buffer: each node has one subscriber, regardless of the number
+ * of loggers, and a transition costs an atomic increment and a few stores
+ * on the thread that changed the status.
+ *
+ * Consumers read the transitions in batches, each with its own Reader.
+ * The buffer is never blocking: a Reader that is too slow loses the oldest
+ * transitions, see Reader::dropped().
+ *
+ * Existing loggers can be fed by the bus, instead of subscribing to each node:
+ *
+ *   TransitionBus bus(tree);
+ *   FileLogger2 file_logger(tree, "trace.btlog");
+ *   Groot2Publisher publisher(tree);
+ *   bus.attach(file_logger);
+ *   bus.attach(publisher);
+ *
+ * Attached loggers are invoked by the thread of the bus; call flush() to
+ * deliver the pending transitions immediately.
+ */
+class TransitionBus
+{
+public:
+  struct Transition
+  {
+    uint16_t uid = 0;
+    NodeStatus prev_status = NodeStatus::IDLE;
+    NodeStatus status = NodeStatus::IDLE;
+    TimePoint timestamp;
+  };
+
+  /**
+   * @param tree      the tree to observe. It must outlive the bus.
+   * @param capacity  number of transitions in the ring buffer (rounded up
+   *                  to a power of two).
+   * @param period    how often the attached loggers receive the transitions.
+   */
+  explicit TransitionBus(const Tree& tree, size_t capacity = 4096,
+                         std::chrono::milliseconds period = std::chrono::milliseconds(10))
+    : period_(period)
+  {
+    size_t size = 2;
+    while (size < capacity)
+    {
+      size *= 2;
+    }
+    mask_ = size - 1;
+    slots_.reset(new Slot[size]);
+
+    for (const auto& subtree : tree.subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        const uint16_t uid = node->UID();
+        if (nodes_.size() <= uid)
+        {
+          nodes_.resize(size_t(uid) + 1, nullptr);
+        }
+        nodes_[uid] = node.get();
+        subscribers_.push_back(node->subscribeToStatusChange(
+            [this](TimePoint timestamp, const TreeNode& node, NodeStatus prev,
+                   NodeStatus status) { publish(node.UID(), prev, status, timestamp); }));
+      }
+    }
+  }
+
+  ~TransitionBus()
+  {
+    subscribers_.clear();
+    {
+      std::unique_lock lk(thread_mutex_);
+      stop_ = true;
+    }
+    thread_cv_.notify_all();
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+
+  TransitionBus(const TransitionBus&) = delete;
+  TransitionBus& operator=(const TransitionBus&) = delete;
+
+  /// Invoked by the subscribers; it is public to allow injecting transitions.
+  void publish(uint16_t uid, NodeStatus prev, NodeStatus status, TimePoint timestamp)
+  {
+    const uint64_t index = head_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[index & mask_];
+    // seqlock: an odd sequence means that the slot is being written
+    uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    while (true)
+    {
+      if (sequence >= 2 * index + 1)
+      {
+        // the slot was already taken by a newer transition: this one is lost
+        return;
+      }
+      if (sequence & 1)
+      {
+        // an older transition is being written, that takes only a few stores.
+        // This happens only if the buffer wrapped around during that write
+        sequence = slot.sequence.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (slot.sequence.compare_exchange_weak(sequence, 2 * index + 1,
+                                              std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.payload.store(uint64_t(uid) | (uint64_t(prev) << 16) | (uint64_t(status) << 24),
+                       std::memory_order_relaxed);
+    slot.timestamp.store(timestamp.time_since_epoch().count(), std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+  }
+
+  /// Number of transitions published since the creation of the bus.
+  [[nodiscard]] uint64_t published() const
+  {
+    return head_.load(std::memory_order_acquire);
+  }
+
+  /// The node with the given UID, nullptr if it doesn't belong to the tree.
+  [[nodiscard]] const TreeNode* node(uint16_t uid) const
+  {
+    return (uid < nodes_.size()) ? nodes_[uid] : nullptr;
+  }
+
+  /**
+   * @brief Reader reads the transitions published after its creation.
+   * A Reader must be used by a single thread at a time.
+   */
+  class Reader
+  {
+  public:
+    /**
+     * @brief Invoke func(const Transition&) for each new transition.
+     * @return the number of transitions visited.
+     */
+    template <typename Function>
+    size_t poll(Function&& func, size_t max_count = size_t(-1))
+    {
+      size_t count = 0;
+      const uint64_t capacity = bus_->mask_ + 1;
+      while (count < max_count)
+      {
+        const uint64_t head = bus_->head_.load(std::memory_order_acquire);
+        if (next_ == head)
+        {
+          break;
+        }
+        if (head - next_ > capacity)
+        {
+          // overwritten by the producers
+          dropped_ += (head - capacity) - next_;
+          next_ = head - capacity;
+        }
+        Transition transition;
+        const ReadResult result = bus_->read(next_, transition);
+        if (result == ReadResult::NOT_READY)
+        {
+          // published, but still being written
+          break;
+        }
+        if (result == ReadResult::OVERWRITTEN)
+        {
+          dropped_++;
+        }
+        else
+        {
+          func(static_cast<const Transition&>(transition));
+          count++;
+        }
+        next_++;
+      }
+      return count;
+    }
+
+    /// Number of transitions lost because the reader was too slow.
+    [[nodiscard]] uint64_t dropped() const
+    {
+      return dropped_;
+    }
+
+  private:
+    friend class TransitionBus;
+    explicit Reader(const TransitionBus* bus) : bus_(bus), next_(bus->published())
+    {}
+
+    const TransitionBus* bus_;
+    uint64_t next_;
+    uint64_t dropped_ = 0;
+  };
+
+  [[nodiscard]] Reader reader() const
+  {
+    return Reader(this);
+  }
+
+  /**
+   * @brief Feed a logger with the transitions of the bus: the logger doesn't
+   * receive anymore the notifications of the nodes, but it is invoked in batches
+   * by the thread of the bus. The logger must outlive the bus.
+   */
+  void attach(StatusChangeLogger& logger)
+  {
+    logger.subscribers_.clear();
+    std::unique_lock lk(thread_mutex_);
+    loggers_.push_back({&logger, reader()});
+    if (!thread_.joinable())
+    {
+      thread_ = std::thread(&TransitionBus::loop, this);
+    }
+  }
+
+  /// Deliver the pending transitions to the attached loggers and flush them.
+  void flush()
+  {
+    std::unique_lock lk(thread_mutex_);
+    deliver();
+  }
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence = 0;
+    std::atomic<uint64_t> payload = 0;
+    std::atomic<TimePoint::rep> timestamp = 0;
+  };
+
+  enum class ReadResult
+  {
+    OK,
+    NOT_READY,
+    OVERWRITTEN
+  };
+
+  ReadResult read(uint64_t index, Transition& transition) const
+  {
+    const Slot& slot = slots_[index & mask_];
+    const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+    const uint64_t payload = slot.payload.load(std::memory_order_relaxed);
+    const auto timestamp = slot.timestamp.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+
+    if (before < 2 * index + 2)
+    {
+      return ReadResult::NOT_READY;
+    }
+    if (before != 2 * index + 2 || after != before)
+    {
+      return ReadResult::OVERWRITTEN;
+    }
+    transition.uid = uint16_t(payload & 0xFFFF);
+    transition.prev_status = NodeStatus((payload >> 16) & 0xFF);
+    transition.status = NodeStatus((payload >> 24) & 0xFF);
+    transition.timestamp = TimePoint(TimePoint::duration(timestamp));
+    return ReadResult::OK;
+  }
+
+  struct AttachedLogger
+  {
+    StatusChangeLogger* logger;
+    Reader reader;
+  };
+
+  // to be called with thread_mutex_ locked
+  void deliver()
+  {
+    for (auto& [logger, reader] : loggers_)
+    {
+      const size_t count = reader.poll([this, logger = logger](const Transition& tr) {
+        const TreeNode* tree_node = node(tr.uid);
+        if (!tree_node || !logger->enabled() ||
+            (tr.status == NodeStatus::IDLE && !logger->showsTransitionToIdle()))
+        {
+          return;
+        }
+        if (logger->type_ == TimestampType::absolute)
+        {
+          logger->callback(tr.timestamp.time_since_epoch(), *tree_node, tr.prev_status,
+                           tr.status);
+        }
+        else
+        {
+          logger->callback(tr.timestamp - logger->first_timestamp_, *tree_node,
+                           tr.prev_status, tr.status);
+        }
+      });
+      if (count > 0)
+      {
+        logger->flush();
+      }
+    }
+  }
+
+  void loop()
+  {
+    std::unique_lock lk(thread_mutex_);
+    while (!stop_)
+    {
+      thread_cv_.wait_for(lk, period_, [this] { return stop_; });
+      deliver();
+    }
+  }
+
+  std::unique_ptr<Slot[]> slots_;
+  uint64_t mask_ = 0;
+  alignas(64) std::atomic<uint64_t> head_ = 0;
+
+  std::vector<const TreeNode*> nodes_;
+  std::vector<TreeNode::StatusChangeSubscriber> subscribers_;
+
+  std::chrono::milliseconds period_;
+  std::mutex thread_mutex_;
+  std::condition_variable thread_cv_;
+  std::vector<AttachedLogger> loggers_;
+  bool stop_ = false;
+  std::thread thread_;
+};
+
+}   // namespace BT
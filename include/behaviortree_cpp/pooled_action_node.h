@@ -0,0 +1,223 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <mutex>
+
+#include "behaviortree_cpp/action_node.h"
+#include "behaviortree_cpp/utils/cancellation_token.hpp"
+#include "behaviortree_cpp/utils/executor.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief PooledThreadedAction has the same semantic of ThreadedAction,
+ * but tick() is executed by an Executor (by default, a shared thread pool),
+ * instead of starting a new asynchronous task at each activation.
+ *
+ * The executor can be passed to the constructor (for instance as an extra
+ * argument of BehaviorTreeFactory::registerNodeType), otherwise
+ * DefaultExecutor() is used.
+ *
+ * As in ThreadedAction, tick() should periodically check isHaltRequested()
+ * and return as soon as possible when it is true.
+ *
+ * Instead of polling isHaltRequested(), tick() can use cancellationToken():
+ * its callbacks and waits (sleepFor(), wait() on a condition variable) are
+ * interrupted as soon as the node is halted. lastHaltLatency() measures the
+ * time between the halt and the completion of tick().
+ *
+ * Since tick() may wait in the queue of the executor, avoid actions that
+ * block for a long time on an executor with bounded concurrency; use a
+ * dedicated Executor for them.
+ */
+class PooledThreadedAction : public ActionNodeBase
+{
+public:
+  PooledThreadedAction(const std::string& name, const NodeConfig& config) :
+    PooledThreadedAction(name, config, DefaultExecutor())
+  {}
+
+  PooledThreadedAction(const std::string& name, const NodeConfig& config,
+                       Executor::Ptr executor) :
+    ActionNodeBase(name, config), executor_(std::move(executor))
+  {
+    if (!executor_)
+    {
+      throw RuntimeError("PooledThreadedAction: invalid executor");
+    }
+  }
+
+  ~PooledThreadedAction() override
+  {
+    cancelAndWait();
+  }
+
+  bool isHaltRequested() const
+  {
+    return halt_requested_.load();
+  }
+
+  /**
+   * @brief Token of the current activation, cancelled when the node is
+   * halted (or destroyed). Call it from tick().
+   */
+  [[nodiscard]] CancellationToken cancellationToken() const
+  {
+    std::scoped_lock lk(mutex_);
+    return tick_token_;
+  }
+
+  /// Time between the last halt() and the completion of the tick() it interrupted.
+  std::chrono::nanoseconds lastHaltLatency() const
+  {
+    return std::chrono::nanoseconds(last_halt_latency_ns_.load());
+  }
+
+  /// Time spent by the last activation in the queue of the executor
+  std::chrono::nanoseconds lastQueueDelay() const
+  {
+    return std::chrono::nanoseconds(last_queue_delay_ns_.load());
+  }
+
+  const Executor::Ptr& executor() const
+  {
+    return executor_;
+  }
+
+  // Do NOT remove the "final" keyword.
+  NodeStatus executeTick() override final
+  {
+    if (status() == NodeStatus::IDLE)
+    {
+      setStatus(NodeStatus::RUNNING);
+      halt_requested_ = false;
+
+      auto activation = std::make_shared<Activation>();
+      {
+        std::scoped_lock lk(mutex_);
+        activation_ = activation;
+      }
+      const auto submitted = std::chrono::steady_clock::now();
+
+      executor_->execute([this, activation, submitted]() {
+        {
+          std::scoped_lock lk(activation->mutex);
+          if (activation->cancelled)
+          {
+            // halted (or destroyed) before starting: don't touch "this"
+            return;
+          }
+          activation->started = true;
+        }
+        last_queue_delay_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - submitted)
+                                   .count();
+        {
+          std::scoped_lock lk(mutex_);
+          tick_token_ = activation->cancellation.token();
+        }
+        runTick();
+        {
+          std::scoped_lock lk(activation->mutex);
+          activation->finished = true;
+        }
+        activation->cv.notify_all();
+      });
+    }
+
+    std::unique_lock lk(mutex_);
+    if (exptr_)
+    {
+      const auto exptr_copy = exptr_;
+      exptr_ = nullptr;
+      std::rethrow_exception(exptr_copy);
+    }
+    return status();
+  }
+
+  void halt() override
+  {
+    const auto t_halt = std::chrono::steady_clock::now();
+    halt_requested_.store(true);
+    if (cancelAndWait())
+    {
+      last_halt_latency_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                  std::chrono::steady_clock::now() - t_halt)
+                                  .count();
+    }
+  }
+
+private:
+  struct Activation
+  {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool started = false;
+    bool finished = false;
+    bool cancelled = false;
+    CancellationSource cancellation;
+  };
+
+  Executor::Ptr executor_;
+  std::exception_ptr exptr_;
+  std::atomic_bool halt_requested_ = false;
+  std::atomic<int64_t> last_queue_delay_ns_ = 0;
+  std::atomic<int64_t> last_halt_latency_ns_ = 0;
+  std::shared_ptr<Activation> activation_;
+  CancellationToken tick_token_;
+  mutable std::mutex mutex_;
+
+  void runTick()
+  {
+    try
+    {
+      auto status = tick();
+      if (!isHaltRequested())
+      {
+        setStatus(status);
+      }
+    }
+    catch (std::exception&)
+    {
+      std::cerr << "\nUncaught exception from the method tick(): [" << registrationName()
+                << "/" << name() << "]\n"
+                << std::endl;
+      std::unique_lock lk(mutex_);
+      exptr_ = std::current_exception();
+      setStatus(NodeStatus::FAILURE);
+    }
+    emitWakeUpSignal();
+  }
+
+  // If the task didn't start yet, it is cancelled, otherwise its token is
+  // cancelled and we wait for its completion.
+  // Returns true if it waited for a running tick().
+  bool cancelAndWait()
+  {
+    std::shared_ptr<Activation> activation;
+    {
+      std::scoped_lock lk(mutex_);
+      activation = std::move(activation_);
+    }
+    if (!activation)
+    {
+      return false;
+    }
+    activation->cancellation.cancel();
+    std::unique_lock lk(activation->mutex);
+    if (!activation->started)
+    {
+      activation->cancelled = true;
+      return false;
+    }
+    const bool was_running = !activation->finished;
+    activation->cv.wait(lk, [&activation] { return activation->finished; });
+    return was_running;
+  }
+};
+
+}   // namespace BT
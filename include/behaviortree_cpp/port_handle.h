@@ -0,0 +1,253 @@
+#pragma once
+
+#include <optional>
+#include "behaviortree_cpp/tree_node.h"
+
+namespace BT
+{
+
+/**
+ * @brief PortHandle resolves the remapping of a port only once,
+ * instead of doing it every time getInput() or setOutput() is invoked.
+ *
+ * It should be bound in the constructor of the node, i.e. when the factory
+ * creates the instance and the NodeConfig is complete:
+ *
+ *    MyAction(const std::string& name, const NodeConfig& config):
+ *      SyncActionNode(name, config)
+ *    {
+ *      message_.bind(*this, "message");
+ *    }
+ *
+ *    NodeStatus tick() override
+ *    {
+ *      std::string msg;
+ *      if(!message_.get(msg)) { ... }
+ *    }
+ *
+ * - If the port contains a literal (or uses the default value of the
+ *   manifest), it is converted into T once, during bind().
+ * - If the port is remapped to a blackboard entry, the handle keeps a pointer
+ *   to that Entry. Reading it requires neither hashing nor allocations.
+ *   If the entry doesn't exist yet, it will be searched again at the next access.
+ *
+ * The semantic of get() and set() is the same of TreeNode::getInput()
+ * and TreeNode::setOutput().
+ */
+template <typename T>
+class PortHandle
+{
+public:
+  PortHandle() = default;
+
+  /**
+   * @brief bind the handle to the port of a node.
+   *
+   * @param node       the node that owns the port. Its NodeConfig must be complete.
+   * @param port_name  the name of the port, as in providedPorts().
+   */
+  Result bind(const TreeNode& node, const std::string& port_name);
+
+  [[nodiscard]] bool isBound() const
+  {
+    return kind_ != Kind::UNBOUND;
+  }
+
+  /// True if the port contains a literal value, instead of a blackboard pointer
+  [[nodiscard]] bool isLiteral() const
+  {
+    return kind_ == Kind::LITERAL;
+  }
+
+  [[nodiscard]] const std::string& portName() const
+  {
+    return port_name_;
+  }
+
+  /// The key of the blackboard entry. Empty if isLiteral() is true.
+  [[nodiscard]] const std::string& remappedKey() const
+  {
+    return remapped_key_;
+  }
+
+  /// Same as TreeNode::getInput(key, destination)
+  Result get(T& destination) const;
+
+  /// Same as TreeNode::getInput(key)
+  [[nodiscard]] Expected<T> get() const
+  {
+    T out;
+    auto res = get(out);
+    return (res) ? Expected<T>(std::move(out)) : nonstd::make_unexpected(res.error());
+  }
+
+  /// Same as TreeNode::setOutput(key, value)
+  Result set(const T& value);
+
+private:
+  enum class Kind
+  {
+    UNBOUND,
+    LITERAL,
+    ENTRY
+  };
+
+  Kind kind_ = Kind::UNBOUND;
+  bool is_input_ = false;
+  bool is_output_ = false;
+  std::string port_name_;
+  std::string remapped_key_;
+  Blackboard::Ptr blackboard_;
+  std::shared_ptr<ScriptingEnumsRegistry> enums_;
+  std::optional<T> literal_;
+  mutable std::shared_ptr<Blackboard::Entry> entry_;
+
+  Blackboard::Entry* resolveEntry() const
+  {
+    if (!entry_ && blackboard_)
+    {
+      entry_ = blackboard_->getEntry(remapped_key_);
+    }
+    return entry_.get();
+  }
+};
+
+//-------------------------------------------------------
+
+template <typename T>
+inline Result PortHandle<T>::bind(const TreeNode& node, const std::string& port_name)
+{
+  const auto& config = node.config();
+  port_name_ = port_name;
+  blackboard_ = config.blackboard;
+  enums_ = config.enums;
+  literal_.reset();
+  entry_.reset();
+  kind_ = Kind::UNBOUND;
+
+  auto input_it = config.input_ports.find(port_name);
+  auto output_it = config.output_ports.find(port_name);
+  is_input_ = (input_it != config.input_ports.end());
+  is_output_ = (output_it != config.output_ports.end());
+
+  if (!is_input_ && !is_output_)
+  {
+    return nonstd::make_unexpected(StrCat("PortHandle::bind() failed because "
+                                          "NodeConfig does not contain the "
+                                          "port: [", port_name, "]"));
+  }
+
+  const std::string& port_value_str =
+      is_input_ ? input_it->second : output_it->second;
+
+  if (is_input_)
+  {
+    // literals and default values don't change, once the node is created.
+    // Parse them now, using the same logic of getInput()
+    bool use_default = false;
+    if (port_value_str.empty() && config.manifest)
+    {
+      auto port_it = config.manifest->ports.find(port_name);
+      if (port_it != config.manifest->ports.end())
+      {
+        const auto& default_value = port_it->second.defaultValue();
+        use_default = !default_value.empty() && !default_value.isString();
+      }
+    }
+    if (use_default || !TreeNode::getRemappedKey(port_name, port_value_str))
+    {
+      auto value = node.getInput<T>(port_name);
+      if (!value)
+      {
+        return nonstd::make_unexpected(value.error());
+      }
+      literal_ = std::move(value.value());
+      kind_ = Kind::LITERAL;
+      return {};
+    }
+  }
+
+  if (auto remapped = TreeNode::getRemappedKey(port_name, port_value_str))
+  {
+    remapped_key_ = static_cast<std::string>(remapped.value());
+  }
+  else
+  {
+    // same behavior of setOutput()
+    remapped_key_ = port_value_str;
+  }
+
+  if (!blackboard_)
+  {
+    return nonstd::make_unexpected("PortHandle::bind(): trying to access an "
+                                   "invalid Blackboard");
+  }
+  kind_ = Kind::ENTRY;
+  resolveEntry();
+  return {};
+}
+
+template <typename T>
+inline Result PortHandle<T>::get(T& destination) const
+{
+  if (!is_input_)
+  {
+    return nonstd::make_unexpected(StrCat("PortHandle::get() failed because [",
+                                          port_name_, "] is not an input port "
+                                          "or the handle is not bound"));
+  }
+  if (kind_ == Kind::LITERAL)
+  {
+    destination = *literal_;
+    return {};
+  }
+
+  try
+  {
+    if (auto entry = resolveEntry())
+    {
+      std::unique_lock lock(entry->entry_mutex);
+      const Any& val = entry->value;
+      if (!val.empty())
+      {
+        if (!std::is_same_v<T, std::string> && val.type() == typeid(std::string))
+        {
+          destination = ParseString<T>(val.cast<std::string>(), enums_.get());
+        }
+        else if (const T* ptr = val.castPtr<T>())
+        {
+          // copy-assignment: reuse the storage of the destination
+          destination = *ptr;
+        }
+        else
+        {
+          destination = val.cast<T>();
+        }
+        return {};
+      }
+    }
+  }
+  catch (std::exception& err)
+  {
+    return nonstd::make_unexpected(err.what());
+  }
+
+  return nonstd::make_unexpected(StrCat("PortHandle::get() failed because it was "
+                                        "unable to find the key [", port_name_,
+                                        "] remapped to [", remapped_key_, "]"));
+}
+
+template <typename T>
+inline Result PortHandle<T>::set(const T& value)
+{
+  if (!is_output_ || kind_ != Kind::ENTRY)
+  {
+    return nonstd::make_unexpected(StrCat("PortHandle::set() failed because [",
+                                          port_name_, "] is not an output port "
+                                          "or the handle is not bound"));
+  }
+  blackboard_->set(remapped_key_, value);
+  return {};
+}
+
+}   // namespace BT
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+#include "behaviortree_cpp/tree_node.h"
+
+namespace BT
+{
+
+/**
+ * @brief RunningFrontier keeps track of the nodes that are RUNNING (the
+ * "frontier" of the execution) and of the nodes that are not IDLE, updated
+ * by their status changes.
+ *
+ * It is created with the current statuses of the nodes (create it while
+ * the tree is not ticked); after that, the cost is O(1) for each status
+ * change, and the queries are proportional to the number of active nodes,
+ * not to the size of the tree.
+ *
+ * Thread-safe: the status may change in any thread.
+ * The nodes must outlive the frontier.
+ */
+class RunningFrontier
+{
+public:
+  explicit RunningFrontier(const std::vector<TreeNode*>& nodes) :
+    nodes_(nodes)
+    , running_pos_(nodes.size(), NPOS)
+    , active_pos_(nodes.size(), NPOS)
+  {
+    subscribers_.reserve(nodes.size());
+    for (uint32_t i = 0; i < nodes_.size(); i++)
+    {
+      subscribers_.push_back(nodes_[i]->subscribeToStatusChange(
+          [this, i](TimePoint, const TreeNode&, NodeStatus, NodeStatus status) {
+            update(i, status);
+          }));
+      update(i, nodes_[i]->status());
+    }
+  }
+
+  RunningFrontier(const RunningFrontier&) = delete;
+  RunningFrontier& operator=(const RunningFrontier&) = delete;
+
+  /// The nodes that are RUNNING, in no particular order.
+  [[nodiscard]] std::vector<TreeNode*> runningNodes() const
+  {
+    std::scoped_lock lk(mutex_);
+    return toNodes(running_);
+  }
+
+  /// The nodes that are not IDLE (RUNNING, or completed and not reset yet).
+  [[nodiscard]] std::vector<TreeNode*> activeNodes() const
+  {
+    std::scoped_lock lk(mutex_);
+    return toNodes(active_);
+  }
+
+  [[nodiscard]] size_t runningCount() const
+  {
+    std::scoped_lock lk(mutex_);
+    return running_.size();
+  }
+
+  [[nodiscard]] size_t nodesCount() const
+  {
+    return nodes_.size();
+  }
+
+private:
+  static constexpr uint32_t NPOS = std::numeric_limits<uint32_t>::max();
+
+  std::vector<TreeNode*> nodes_;
+  std::vector<TreeNode::StatusChangeSubscriber> subscribers_;
+
+  mutable std::mutex mutex_;
+  // indices of nodes_, and the position of each node in them (or NPOS)
+  std::vector<uint32_t> running_;
+  std::vector<uint32_t> active_;
+  std::vector<uint32_t> running_pos_;
+  std::vector<uint32_t> active_pos_;
+
+  std::vector<TreeNode*> toNodes(const std::vector<uint32_t>& indices) const
+  {
+    std::vector<TreeNode*> out;
+    out.reserve(indices.size());
+    for (uint32_t index : indices)
+    {
+      out.push_back(nodes_[index]);
+    }
+    return out;
+  }
+
+  static void setMember(std::vector<uint32_t>& list, std::vector<uint32_t>& pos,
+                        uint32_t index, bool member)
+  {
+    if (member == (pos[index] != NPOS))
+    {
+      return;
+    }
+    if (member)
+    {
+      pos[index] = uint32_t(list.size());
+      list.push_back(index);
+      return;
+    }
+    // swap with the last one
+    const uint32_t last = list.back();
+    list[pos[index]] = last;
+    pos[last] = pos[index];
+    list.pop_back();
+    pos[index] = NPOS;
+  }
+
+  void update(uint32_t index, NodeStatus status)
+  {
+    std::scoped_lock lk(mutex_);
+    setMember(running_, running_pos_, index, status == NodeStatus::RUNNING);
+    setMember(active_, active_pos_, index, status != NodeStatus::IDLE);
+  }
+};
+
+}   // namespace BT
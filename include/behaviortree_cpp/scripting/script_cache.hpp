@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+#include "behaviortree_cpp/scripting/script_parser.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief ScriptCache maps the text of a script to its parsed ScriptFunction,
+ * so that identical scripts (for instance the same precondition used by
+ * hundreds of nodes) are parsed once and share the same AST.
+ *
+ * Each FactoryExtensions owns one (see FactoryExtensions::scriptCache()),
+ * used by the nodes it registers. It is thread-safe. Only scripts parsed
+ * successfully are cached.
+ */
+class ScriptCache
+{
+public:
+  using Ptr = std::shared_ptr<ScriptCache>;
+  using Parser = std::function<Expected<ScriptFunction>(const std::string&)>;
+
+  struct Statistics
+  {
+    size_t entries = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+
+  /// @param parser  function used to parse a script that is not in cache yet.
+  explicit ScriptCache(Parser parser = ParseScript) : parser_(std::move(parser))
+  {}
+
+  ScriptCache(const ScriptCache&) = delete;
+  ScriptCache& operator=(const ScriptCache&) = delete;
+
+  /**
+   * @brief get the function of a script, parsing it only the first time.
+   * The returned object is a copy, but the parsed code inside it is shared.
+   */
+  Expected<ScriptFunction> get(const std::string& script)
+  {
+    {
+      std::shared_lock lk(mutex_);
+      auto it = cache_.find(script);
+      if (it != cache_.end())
+      {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return it->second;
+      }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    auto executor = parser_(script);
+    if (!executor)
+    {
+      return executor;
+    }
+    std::unique_lock lk(mutex_);
+    // another thread may have parsed the same script in the meantime
+    auto it = cache_.emplace(script, std::move(executor.value())).first;
+    return it->second;
+  }
+
+  [[nodiscard]] Statistics statistics() const
+  {
+    Statistics stats;
+    {
+      std::shared_lock lk(mutex_);
+      stats.entries = cache_.size();
+    }
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  void clear()
+  {
+    std::unique_lock lk(mutex_);
+    cache_.clear();
+  }
+
+private:
+  Parser parser_;
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string, ScriptFunction> cache_;
+  std::atomic<uint64_t> hits_ = 0;
+  std::atomic<uint64_t> misses_ = 0;
+};
+
+}   // namespace BT
@@ -0,0 +1,567 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "behaviortree_cpp/blackboard.h"
+
+namespace BT
+{
+
+/*
+ * Blackboard entries shared between processes through a POSIX shared
+ * memory segment (shm_open + mmap). POSIX only: this header is not
+ * included by behavior_tree.h.
+ */
+
+namespace details
+{
+constexpr uint64_t SHM_BLACKBOARD_MAGIC = 0x3130425442544d53;   // "SMTBTB01"
+constexpr size_t SHM_KEY_SIZE = 64;
+
+struct ShmHeader
+{
+  uint64_t magic;
+  uint32_t capacity;
+  uint32_t value_words;
+  std::atomic<uint32_t> ready;
+};
+
+enum ShmSlotState : uint32_t
+{
+  SHM_SLOT_FREE = 0,
+  SHM_SLOT_INIT = 1,
+  SHM_SLOT_READY = 2
+};
+
+// followed by ShmHeader::value_words atomic words
+struct ShmSlot
+{
+  std::atomic<uint32_t> state;
+  uint32_t size;
+  uint64_t type_hash;
+  std::atomic<uint64_t> seq;
+  char key[SHM_KEY_SIZE];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "SharedMemoryBlackboard requires address-free atomics");
+
+// FNV-1a: the TypeID of a type is different in each process, its name is not
+inline uint64_t ShmHash(const std::string& str)
+{
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (unsigned char c : str)
+  {
+    hash = (hash ^ c) * 0x100000001b3ull;
+  }
+  return hash;
+}
+}   // namespace details
+
+/**
+ * @brief Typed view of a value stored in a SharedMemoryBlackboard,
+ * see SharedMemoryBlackboard::value().
+ *
+ * The value is protected by a seqlock in shared memory (the same protocol
+ * of SeqLockCell): readers never block and retry if a write happens
+ * concurrently, writers are serialized. Cheap to copy.
+ */
+template <typename T>
+class ShmValue
+{
+public:
+  ShmValue() = default;
+
+  [[nodiscard]] T load() const
+  {
+    uint64_t buffer[words_count_];
+    while (true)
+    {
+      const uint64_t seq_before = slot_->seq.load(std::memory_order_acquire);
+      if (seq_before & 1)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      for (size_t i = 0; i < words_count_; i++)
+      {
+        buffer[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot_->seq.load(std::memory_order_relaxed) == seq_before)
+      {
+        break;
+      }
+    }
+    T out;
+    std::memcpy(&out, buffer, sizeof(T));
+    return out;
+  }
+
+  void store(const T& value)
+  {
+    uint64_t buffer[words_count_] = {};
+    std::memcpy(buffer, &value, sizeof(T));
+
+    uint64_t seq = slot_->seq.load(std::memory_order_relaxed);
+    while (true)
+    {
+      if ((seq & 1) == 0 &&
+          slot_->seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+      {
+        break;
+      }
+      std::this_thread::yield();
+      seq = slot_->seq.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < words_count_; i++)
+    {
+      words_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+    slot_->seq.store(seq + 2, std::memory_order_release);
+  }
+
+  /// Number of store(), in any process. 0 if the value was never written.
+  [[nodiscard]] uint64_t version() const
+  {
+    return slot_->seq.load(std::memory_order_acquire) / 2;
+  }
+
+  [[nodiscard]] bool valid() const
+  {
+    return slot_ != nullptr;
+  }
+
+private:
+  friend class SharedMemoryBlackboard;
+  ShmValue(details::ShmSlot* slot, std::atomic<uint64_t>* words) :
+    slot_(slot), words_(words)
+  {}
+
+  static constexpr size_t words_count_ = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  details::ShmSlot* slot_ = nullptr;
+  std::atomic<uint64_t>* words_ = nullptr;
+};
+
+/**
+ * @brief SharedMemoryBlackboard is a table of named, fixed-size values in a
+ * POSIX shared memory segment, that processes can read and write without
+ * serialization: a value is the raw bytes of a trivially copyable type.
+ *
+ * The first process that opens the segment creates it; the others attach to
+ * it. The table has a fixed layout: "capacity" slots, each one able to store
+ * a value up to "max_value_size" bytes. Values are identified by key and
+ * checked by type name and size, therefore all the processes must use the
+ * same definition of the types.
+ *
+ * To use the values from the nodes of a Tree, with the usual getInput() and
+ * setOutput(), see SharedMemoryBridge.
+ */
+class SharedMemoryBlackboard
+{
+public:
+  using Ptr = std::shared_ptr<SharedMemoryBlackboard>;
+
+  struct Options
+  {
+    uint32_t capacity = 256;
+    uint32_t max_value_size = 256;
+    // how long to wait for another process to initialize the segment
+    std::chrono::milliseconds open_timeout = std::chrono::milliseconds(1000);
+  };
+
+  /// Create the segment "/name", or attach to it if it exists.
+  static Ptr open(const std::string& name, const Options& options)
+  {
+    return Ptr(new SharedMemoryBlackboard(name, options));
+  }
+
+  static Ptr open(const std::string& name)
+  {
+    return open(name, Options());
+  }
+
+  /// Remove the segment name: processes that mapped it can still use it.
+  static void remove(const std::string& name)
+  {
+    ::shm_unlink(segmentName(name).c_str());
+  }
+
+  ~SharedMemoryBlackboard()
+  {
+    if (memory_ != MAP_FAILED)
+    {
+      ::munmap(memory_, size_);
+    }
+  }
+
+  SharedMemoryBlackboard(const SharedMemoryBlackboard&) = delete;
+  SharedMemoryBlackboard& operator=(const SharedMemoryBlackboard&) = delete;
+
+  /**
+   * @brief The value with the given key, created if it doesn't exist
+   * (its version is 0 until the first store()).
+   *
+   * Throws if the key exists with another type, or if the table is full.
+   * Keep the returned object: it is valid as long as this blackboard.
+   */
+  template <typename T>
+  [[nodiscard]] ShmValue<T> value(const std::string& key)
+  {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>,
+                  "SharedMemoryBlackboard: the values must be trivially copyable");
+    if (sizeof(T) > header()->value_words * sizeof(uint64_t))
+    {
+      throw RuntimeError("SharedMemoryBlackboard: the type of [", key, "] is larger than "
+                         "the max_value_size of the segment");
+    }
+    details::ShmSlot* slot = findSlot(key, typeHash<T>(), uint32_t(sizeof(T)));
+    return ShmValue<T>(slot, slotWords(slot));
+  }
+
+  [[nodiscard]] uint32_t capacity() const
+  {
+    return header()->capacity;
+  }
+
+  /// True if this process created the segment.
+  [[nodiscard]] bool owner() const
+  {
+    return owner_;
+  }
+
+private:
+  void* memory_ = MAP_FAILED;
+  size_t size_ = 0;
+  size_t slot_stride_ = 0;
+  bool owner_ = false;
+  std::mutex mutex_;
+  std::unordered_map<std::string, details::ShmSlot*> slots_cache_;
+
+  static std::string segmentName(const std::string& name)
+  {
+    return (!name.empty() && name.front() == '/') ? name : "/" + name;
+  }
+
+  template <typename T>
+  static uint64_t typeHash()
+  {
+    return details::ShmHash(TypeID::of<T>().name());
+  }
+
+  static size_t slotStride(uint32_t value_words)
+  {
+    return sizeof(details::ShmSlot) + value_words * sizeof(uint64_t);
+  }
+
+  SharedMemoryBlackboard(const std::string& name, const Options& options)
+  {
+    if (options.capacity == 0)
+    {
+      throw RuntimeError("SharedMemoryBlackboard: the capacity must be positive");
+    }
+    const std::string shm_name = segmentName(name);
+    int fd = ::shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+    owner_ = (fd >= 0);
+    if (!owner_)
+    {
+      fd = ::shm_open(shm_name.c_str(), O_RDWR, 0660);
+    }
+    if (fd < 0)
+    {
+      throw RuntimeError("SharedMemoryBlackboard: can't open [", shm_name, "]: ",
+                         std::strerror(errno));
+    }
+    try
+    {
+      if (owner_)
+      {
+        create(fd, options);
+      }
+      else
+      {
+        attach(fd, shm_name, options);
+      }
+    }
+    catch (...)
+    {
+      ::close(fd);
+      if (owner_)
+      {
+        ::shm_unlink(shm_name.c_str());
+      }
+      throw;
+    }
+    ::close(fd);
+  }
+
+  void map(int fd, size_t size)
+  {
+    memory_ = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory_ == MAP_FAILED)
+    {
+      throw RuntimeError("SharedMemoryBlackboard: mmap failed: ", std::strerror(errno));
+    }
+    size_ = size;
+  }
+
+  void create(int fd, const Options& options)
+  {
+    const uint32_t value_words =
+        uint32_t((options.max_value_size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    slot_stride_ = slotStride(value_words);
+    const size_t size = sizeof(details::ShmHeader) + slot_stride_ * options.capacity;
+    if (::ftruncate(fd, off_t(size)) != 0)
+    {
+      throw RuntimeError("SharedMemoryBlackboard: ftruncate failed: ", std::strerror(errno));
+    }
+    // ftruncate fills the segment with zeros: all the slots are FREE
+    map(fd, size);
+    auto* hdr = header();
+    hdr->magic = details::SHM_BLACKBOARD_MAGIC;
+    hdr->capacity = options.capacity;
+    hdr->value_words = value_words;
+    hdr->ready.store(1, std::memory_order_release);
+  }
+
+  void attach(int fd, const std::string& shm_name, const Options& options)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + options.open_timeout;
+    auto waitCreator = [&]() {
+      if (std::chrono::steady_clock::now() > deadline)
+      {
+        throw RuntimeError("SharedMemoryBlackboard: the segment [", shm_name,
+                           "] was not initialized");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+    struct stat info = {};
+    while (true)
+    {
+      if (::fstat(fd, &info) != 0)
+      {
+        throw RuntimeError("SharedMemoryBlackboard: fstat failed: ", std::strerror(errno));
+      }
+      if (size_t(info.st_size) >= sizeof(details::ShmHeader))
+      {
+        break;
+      }
+      waitCreator();
+    }
+    map(fd, size_t(info.st_size));
+    while (header()->ready.load(std::memory_order_acquire) == 0)
+    {
+      waitCreator();
+    }
+    const auto* hdr = header();
+    slot_stride_ = slotStride(hdr->value_words);
+    if (hdr->magic != details::SHM_BLACKBOARD_MAGIC ||
+        size_ < sizeof(details::ShmHeader) + slot_stride_ * hdr->capacity)
+    {
+      throw RuntimeError("SharedMemoryBlackboard: [", shm_name,
+                         "] is not a valid segment");
+    }
+  }
+
+  details::ShmHeader* header() const
+  {
+    return static_cast<details::ShmHeader*>(memory_);
+  }
+
+  details::ShmSlot* slotAt(uint32_t index) const
+  {
+    auto* base = static_cast<char*>(memory_) + sizeof(details::ShmHeader);
+    return reinterpret_cast<details::ShmSlot*>(base + slot_stride_ * index);
+  }
+
+  static std::atomic<uint64_t>* slotWords(details::ShmSlot* slot)
+  {
+    return reinterpret_cast<std::atomic<uint64_t>*>(slot + 1);
+  }
+
+  // open addressing, linear probing. Slots are never released.
+  details::ShmSlot* findSlot(const std::string& key, uint64_t type_hash, uint32_t size)
+  {
+    if (key.empty() || key.size() >= details::SHM_KEY_SIZE)
+    {
+      throw RuntimeError("SharedMemoryBlackboard: the key [", key, "] must have between 1 "
+                         "and ", std::to_string(details::SHM_KEY_SIZE - 1), " characters");
+    }
+    std::scoped_lock lk(mutex_);
+    auto checkType = [&](details::ShmSlot* slot) {
+      if (slot->type_hash != type_hash || slot->size != size)
+      {
+        throw RuntimeError("SharedMemoryBlackboard: the key [", key,
+                           "] exists, with a different type");
+      }
+      return slot;
+    };
+    if (auto it = slots_cache_.find(key); it != slots_cache_.end())
+    {
+      return checkType(it->second);
+    }
+
+    const uint32_t capacity = header()->capacity;
+    const uint32_t first = uint32_t(details::ShmHash(key) % capacity);
+    for (uint32_t i = 0; i < capacity; i++)
+    {
+      details::ShmSlot* slot = slotAt((first + i) % capacity);
+      uint32_t state = slot->state.load(std::memory_order_acquire);
+      if (state == details::SHM_SLOT_FREE)
+      {
+        if (slot->state.compare_exchange_strong(state, details::SHM_SLOT_INIT,
+                                                std::memory_order_acquire))
+        {
+          std::memcpy(slot->key, key.c_str(), key.size() + 1);
+          slot->type_hash = type_hash;
+          slot->size = size;
+          slot->state.store(details::SHM_SLOT_READY, std::memory_order_release);
+          slots_cache_[key] = slot;
+          return slot;
+        }
+      }
+      // another process is initializing the slot
+      while (state == details::SHM_SLOT_INIT)
+      {
+        std::this_thread::yield();
+        state = slot->state.load(std::memory_order_acquire);
+      }
+      if (std::strncmp(slot->key, key.c_str(), details::SHM_KEY_SIZE) == 0)
+      {
+        slots_cache_[key] = slot;
+        return checkType(slot);
+      }
+    }
+    throw RuntimeError("SharedMemoryBlackboard: the segment is full, can't add [", key, "]");
+  }
+};
+
+/**
+ * @brief SharedMemoryBridge connects the entries of a Blackboard to the
+ * values of a SharedMemoryBlackboard, so that the nodes can keep using
+ * getInput() and setOutput():
+ *
+ *   auto shm = SharedMemoryBlackboard::open("robot");
+ *   SharedMemoryBridge bridge(shm, tree.rootBlackboard());
+ *   bridge.exportEntry<Pose2D>("goal");      // written by this process
+ *   bridge.importEntry<Pose2D>("robot_pose"); // written by another one
+ *   while (running) {
+ *     bridge.sync();
+ *     tree.tickOnce();
+ *   }
+ *
+ * sync() copies only the values that changed since the previous call:
+ * an exported entry is compared with the bytes it published last time, an
+ * imported value is detected by the version of its seqlock. No
+ * serialization is done.
+ *
+ * An entry can be either exported or imported, not both. sync() must be
+ * called from a single thread.
+ */
+class SharedMemoryBridge
+{
+public:
+  SharedMemoryBridge(SharedMemoryBlackboard::Ptr shm, Blackboard::Ptr blackboard) :
+    shm_(std::move(shm)), blackboard_(std::move(blackboard))
+  {
+    if (!shm_ || !blackboard_)
+    {
+      throw RuntimeError("SharedMemoryBridge: null pointer");
+    }
+  }
+
+  /// Publish the entry [key] of the blackboard as the value [shm_key].
+  template <typename T>
+  void exportEntry(const std::string& key, const std::string& shm_key = {})
+  {
+    checkNew(key);
+    auto value = shm_->value<T>(shm_key.empty() ? key : shm_key);
+    auto blackboard = blackboard_;
+    // the value published last time, if any
+    auto last = std::make_shared<std::unique_ptr<T>>();
+    bindings_[key] = [=]() mutable {
+      auto entry = blackboard->getEntry(key);
+      if (!entry)
+      {
+        return;
+      }
+      T local;
+      {
+        std::scoped_lock lk(entry->entry_mutex);
+        if (entry->value.empty())
+        {
+          return;
+        }
+        local = entry->value.cast<T>();
+      }
+      // T is trivially copyable: the bytes are the value
+      if (*last && std::memcmp(last->get(), &local, sizeof(T)) == 0)
+      {
+        return;
+      }
+      value.store(local);
+      *last = std::make_unique<T>(local);
+    };
+  }
+
+  /// Copy the value [shm_key] into the entry [key] of the blackboard.
+  template <typename T>
+  void importEntry(const std::string& key, const std::string& shm_key = {})
+  {
+    checkNew(key);
+    auto value = shm_->value<T>(shm_key.empty() ? key : shm_key);
+    auto blackboard = blackboard_;
+    auto last_version = std::make_shared<uint64_t>(0);
+    bindings_[key] = [=]() {
+      const uint64_t version = value.version();
+      if (version == *last_version)
+      {
+        return;
+      }
+      blackboard->set(key, value.load());
+      *last_version = version;
+    };
+  }
+
+  /// Exchange the values that changed since the last call.
+  void sync()
+  {
+    for (auto& [key, binding] : bindings_)
+    {
+      binding();
+    }
+  }
+
+private:
+  SharedMemoryBlackboard::Ptr shm_;
+  Blackboard::Ptr blackboard_;
+  std::unordered_map<std::string, std::function<void()>> bindings_;
+
+  void checkNew(const std::string& key) const
+  {
+    if (bindings_.count(key) != 0)
+    {
+      throw RuntimeError("SharedMemoryBridge: the entry [", key, "] is already bound");
+    }
+  }
+};
+
+}   // namespace BT
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "behaviortree_cpp/port_handle.h"
+
+namespace BT
+{
+
+/**
+ * @brief Port declared at compile time. Use StaticInputPort(), StaticOutputPort()
+ * and StaticBidirectionalPort() to create it and make_ports() to create the list.
+ *
+ * The default value is a string, converted as if it was written in the XML.
+ */
+template <typename T = void>
+struct StaticPort
+{
+  using value_type = T;
+
+  PortDirection direction = PortDirection::INPUT;
+  StringView name;
+  StringView description;
+  StringView default_value;
+
+  [[nodiscard]] constexpr StaticPort withDefault(StringView value) const
+  {
+    StaticPort out = *this;
+    out.default_value = value;
+    return out;
+  }
+
+  [[nodiscard]] constexpr StaticPort withDescription(StringView text) const
+  {
+    StaticPort out = *this;
+    out.description = text;
+    return out;
+  }
+
+  [[nodiscard]] std::pair<std::string, PortInfo> toPortInfo() const
+  {
+    auto port = CreatePort<T>(direction, name, description);
+    if (!default_value.empty())
+    {
+      port.second.setDefaultValue(std::string(default_value));
+    }
+    return port;
+  }
+};
+
+/// Same rules of IsAllowedPortName(), usable at compile time
+[[nodiscard]] constexpr bool IsAllowedStaticPortName(StringView name)
+{
+  if (name.empty() || name == "name" || name == "ID" || name.front() == '_')
+  {
+    return false;
+  }
+  const char first = name.front();
+  return (first >= 'a' && first <= 'z') || (first >= 'A' && first <= 'Z');
+}
+
+template <typename T>
+[[nodiscard]] constexpr StaticPort<T> MakeStaticPort(PortDirection direction,
+                                                     StringView name,
+                                                     StringView description)
+{
+  // when evaluated at compile time, this throw is a compilation error
+  if (!IsAllowedStaticPortName(name))
+  {
+    throw RuntimeError("The name of a port must not be `name` or `ID` "
+                       "and must start with an alphabetic character. "
+                       "Underscore is reserved.");
+  }
+  return StaticPort<T>{direction, name, description, {}};
+}
+
+template <typename T = void>
+[[nodiscard]] constexpr StaticPort<T> StaticInputPort(StringView name,
+                                                      StringView description = {})
+{
+  return MakeStaticPort<T>(PortDirection::INPUT, name, description);
+}
+
+template <typename T = void>
+[[nodiscard]] constexpr StaticPort<T> StaticOutputPort(StringView name,
+                                                       StringView description = {})
+{
+  return MakeStaticPort<T>(PortDirection::OUTPUT, name, description);
+}
+
+template <typename T = void>
+[[nodiscard]] constexpr StaticPort<T> StaticBidirectionalPort(StringView name,
+                                                              StringView description = {})
+{
+  return MakeStaticPort<T>(PortDirection::INOUT, name, description);
+}
+
+/**
+ * @brief StaticPortsList is the compile-time alternative to providedPorts():
+ *
+ *   class SaySomething : public SyncActionNode
+ *   {
+ *   public:
+ *     static constexpr auto ports = make_ports(
+ *         StaticInputPort<std::string>("message"),
+ *         StaticOutputPort<int>("count").withDescription("number of messages"));
+ *     ...
+ *   };
+ *
+ * The factory creates the PortsList once per type, at registration, and
+ * assignDefaultRemapping() doesn't create it at all.
+ * Ports can be addressed by index; see StaticPortHandles.
+ */
+template <typename... Ports>
+class StaticPortsList
+{
+public:
+  constexpr explicit StaticPortsList(Ports... ports) : ports_(ports...)
+  {
+    // when evaluated at compile time, this throw is a compilation error
+    for (size_t i = 0; i < sizeof...(Ports); i++)
+    {
+      for (size_t j = i + 1; j < sizeof...(Ports); j++)
+      {
+        if (name(i) == name(j))
+        {
+          throw RuntimeError("make_ports: duplicated port name");
+        }
+      }
+    }
+  }
+
+  [[nodiscard]] static constexpr size_t size()
+  {
+    return sizeof...(Ports);
+  }
+
+  [[nodiscard]] constexpr StringView name(size_t index) const
+  {
+    StringView out;
+    size_t i = 0;
+    std::apply([&](const auto&... port) { ((out = (i++ == index) ? port.name : out), ...); },
+               ports_);
+    return out;
+  }
+
+  /// Index of the port with the given name, size() if not found.
+  [[nodiscard]] constexpr size_t indexOf(StringView port_name) const
+  {
+    for (size_t i = 0; i < size(); i++)
+    {
+      if (name(i) == port_name)
+      {
+        return i;
+      }
+    }
+    return size();
+  }
+
+  template <size_t I>
+  [[nodiscard]] constexpr const auto& port() const
+  {
+    return std::get<I>(ports_);
+  }
+
+  /// Invoke func(StringView name, PortDirection direction) for each port.
+  template <typename Function>
+  void forEach(Function&& func) const
+  {
+    std::apply([&](const auto&... port) { (func(port.name, port.direction), ...); },
+               ports_);
+  }
+
+  [[nodiscard]] PortsList toPortsList() const
+  {
+    PortsList list;
+    list.reserve(size());
+    std::apply([&](const auto&... port) { (list.insert(port.toPortInfo()), ...); },
+               ports_);
+    return list;
+  }
+
+private:
+  std::tuple<Ports...> ports_;
+};
+
+template <typename... Ports>
+[[nodiscard]] constexpr StaticPortsList<Ports...> make_ports(Ports... ports)
+{
+  return StaticPortsList<Ports...>(ports...);
+}
+
+/**
+ * @brief A PortHandle for each port of a StaticPortsList, addressed by index;
+ * ports without type use a PortHandle<std::string>.
+ *
+ *   StaticPortHandles<std::decay_t<decltype(ports)>> handles_;
+ *
+ *   // in the constructor
+ *   handles_.bind(*this, ports);
+ *
+ *   // in tick()
+ *   auto msg = handles_.get<ports.indexOf("message")>().get();
+ */
+template <typename Spec>
+class StaticPortHandles;
+
+template <typename... Ports>
+class StaticPortHandles<StaticPortsList<Ports...>>
+{
+  template <typename T>
+  using HandleType = PortHandle<std::conditional_t<std::is_void_v<T>, std::string, T>>;
+
+public:
+  /// Bind all the handles. The ports that the node doesn't have remain unbound.
+  Result bind(const TreeNode& node, const StaticPortsList<Ports...>& spec)
+  {
+    Result result;
+    bindImpl(node, spec, result, std::index_sequence_for<Ports...>{});
+    return result;
+  }
+
+  template <size_t I>
+  [[nodiscard]] auto& get()
+  {
+    static_assert(I < sizeof...(Ports), "StaticPortHandles: port not found");
+    return std::get<I>(handles_);
+  }
+
+  template <size_t I>
+  [[nodiscard]] const auto& get() const
+  {
+    static_assert(I < sizeof...(Ports), "StaticPortHandles: port not found");
+    return std::get<I>(handles_);
+  }
+
+private:
+  std::tuple<HandleType<typename Ports::value_type>...> handles_;
+
+  template <size_t... I>
+  void bindImpl(const TreeNode& node, const StaticPortsList<Ports...>& spec,
+                Result& result, std::index_sequence<I...>)
+  {
+    auto bindOne = [&](auto& handle, StringView name) {
+      auto res = handle.bind(node, std::string(name));
+      if (!res && result)
+      {
+        result = res;
+      }
+    };
+    (bindOne(std::get<I>(handles_), spec.name(I)), ...);
+  }
+};
+
+}   // namespace BT
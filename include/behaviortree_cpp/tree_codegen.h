@@ -0,0 +1,273 @@
+#pragma once
+
+#include <cstdio>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/tree_template.h"
+#include "behaviortree_cpp/flatbuffers/bt_flatbuffer_helper.h"
+#include "behaviortree_cpp/utils/plugin_index.hpp"
+
+namespace BT
+{
+
+/*
+ * Code generation of the trees validated and precompiled at build time,
+ * see the tool btcpp_tree_compiler and the CMake function btcpp_compile_tree().
+ *
+ * The generated translation unit contains the trees serialized by
+ * SerializeBehaviorTrees() and the manifests of the nodes used by them.
+ * Its registration function checks that the factory has the same nodes and
+ * then calls FactoryExtensions::registerBehaviorTreeFromBinary():
+ * no XML is parsed or validated at runtime.
+ */
+
+namespace details
+{
+// stand-ins of the nodes of a manifest, used only to compile the trees
+class PlaceholderAction : public SyncActionNode
+{
+public:
+  using SyncActionNode::SyncActionNode;
+  NodeStatus tick() override
+  {
+    return NodeStatus::SUCCESS;
+  }
+};
+
+class PlaceholderCondition : public ConditionNode
+{
+public:
+  using ConditionNode::ConditionNode;
+  NodeStatus tick() override
+  {
+    return NodeStatus::SUCCESS;
+  }
+};
+
+class PlaceholderDecorator : public DecoratorNode
+{
+public:
+  using DecoratorNode::DecoratorNode;
+  NodeStatus tick() override
+  {
+    return child_node_->executeTick();
+  }
+};
+
+class PlaceholderControl : public ControlNode
+{
+public:
+  using ControlNode::ControlNode;
+  NodeStatus tick() override
+  {
+    return NodeStatus::SUCCESS;
+  }
+};
+
+inline void WriteCStringLiteral(std::ostream& out, const std::string& str)
+{
+  out << '"';
+  size_t line = 0;
+  for (char c : str)
+  {
+    if (c == '"' || c == '\\')
+    {
+      out << '\\' << c;
+    }
+    else if (c >= 0x20 && c < 0x7f)
+    {
+      out << c;
+    }
+    else
+    {
+      // octal escapes have at most 3 digits: they can't absorb the next character
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\%03o", unsigned(static_cast<unsigned char>(c)));
+      out << escaped;
+    }
+    if (c == '\n' && ++line % 16 == 0)
+    {
+      out << "\"\n    \"";
+    }
+  }
+  out << '"';
+}
+}   // namespace details
+
+/**
+ * @brief Register a placeholder node for each manifest that is not registered
+ * in the factory yet, so that the trees that use them can be created, validated
+ * and compiled by a process that doesn't link the real nodes.
+ */
+inline void RegisterPlaceholderNodes(BehaviorTreeFactory& factory,
+                                     const std::vector<TreeNodeManifest>& manifests)
+{
+  for (const auto& manifest : manifests)
+  {
+    if (factory.builders().count(manifest.registration_ID) != 0)
+    {
+      continue;
+    }
+    switch (manifest.type)
+    {
+      case NodeType::ACTION:
+        factory.registerBuilder(manifest, CreateBuilder<details::PlaceholderAction>());
+        break;
+      case NodeType::CONDITION:
+        factory.registerBuilder(manifest, CreateBuilder<details::PlaceholderCondition>());
+        break;
+      case NodeType::DECORATOR:
+        factory.registerBuilder(manifest, CreateBuilder<details::PlaceholderDecorator>());
+        break;
+      case NodeType::CONTROL:
+        factory.registerBuilder(manifest, CreateBuilder<details::PlaceholderControl>());
+        break;
+      default:
+        throw RuntimeError("RegisterPlaceholderNodes: the node [", manifest.registration_ID,
+                           "] has an unsupported type [", toStr(manifest.type), "]");
+    }
+  }
+}
+
+/**
+ * @brief Check that the nodes registered in the factory are compatible with
+ * the manifests used to compile a tree: same type and, for each port of the
+ * manifest, same direction and type. Throws RuntimeError otherwise.
+ *
+ * @param index_text   manifests in the format of WritePluginIndex()
+ * @param source_name  used in the error messages
+ */
+inline void CheckCompiledManifests(const BehaviorTreeFactory& factory,
+                                   const std::string& index_text,
+                                   const std::string& source_name)
+{
+  std::istringstream in(index_text);
+  const auto& registered = factory.manifests();
+  for (const auto& manifest : ReadPluginIndex(in, source_name))
+  {
+    auto it = registered.find(manifest.registration_ID);
+    if (it == registered.end())
+    {
+      throw RuntimeError("The trees of [", source_name, "] use the node [",
+                         manifest.registration_ID, "], that is not registered");
+    }
+    if (it->second.type != manifest.type)
+    {
+      throw RuntimeError("The node [", manifest.registration_ID, "] used by [", source_name,
+                         "] is a ", toStr(it->second.type), " instead of a ",
+                         toStr(manifest.type));
+    }
+    for (const auto& [name, info] : manifest.ports)
+    {
+      auto port = it->second.ports.find(name);
+      if (port == it->second.ports.end() || port->second.direction() != info.direction() ||
+          (info.isStronglyTyped() && port->second.isStronglyTyped() &&
+           port->second.typeName() != info.typeName()))
+      {
+        throw RuntimeError("The port [", name, "] of the node [", manifest.registration_ID,
+                           "] is not the same used to compile the trees of [",
+                           source_name, "]");
+      }
+    }
+  }
+}
+
+/**
+ * @brief Write a translation unit with the trees registered in the factory,
+ * that defines:
+ *
+ *   void <function_name>(BT::FactoryExtensions& extensions);
+ *
+ * The trees are created once here, therefore any error in the XML (unknown
+ * nodes, invalid ports, wrong remapping) is reported while generating the code.
+ *
+ * @param tree_IDs     trees to compile. Empty: all the registered trees
+ * @param source_name  name of the XML, used in the comments and in the errors
+ */
+inline void WriteCompiledTreesSource(std::ostream& out, BehaviorTreeFactory& factory,
+                                     const std::string& function_name,
+                                     const std::string& header_name,
+                                     const std::string& source_name,
+                                     std::vector<std::string> tree_IDs = {})
+{
+  if (tree_IDs.empty())
+  {
+    tree_IDs = factory.registeredBehaviorTrees();
+  }
+  const auto& builtin = factory.builtinNodes();
+
+  // the templates are serialized right away: their identifiers don't outlive it
+  FactoryExtensions extensions(factory);
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<flatbuffers::Offset<Serialization::TreeRecord>> trees;
+  std::set<std::string> used_nodes;
+  for (const auto& tree_ID : tree_IDs)
+  {
+    Tree prototype = factory.createTree(tree_ID);
+    for (const auto& subtree : prototype.subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        if (builtin.count(node->registrationName()) == 0)
+        {
+          used_nodes.insert(node->registrationName());
+        }
+      }
+    }
+    trees.push_back(TreeTemplate::compile(extensions, prototype).serialize(builder, tree_ID));
+  }
+  auto tree_set = Serialization::CreateTreeSet(
+      builder, FactoryExtensions::PRECOMPILED_TREES_VERSION, builder.CreateVector(trees));
+  Serialization::FinishTreeSetBuffer(builder, tree_set);
+
+  std::vector<TreeNodeManifest> manifests;
+  for (const auto& ID : used_nodes)
+  {
+    manifests.push_back(factory.manifests().at(ID));
+  }
+  std::ostringstream index;
+  WritePluginIndex(index, manifests);
+
+  out << "// Generated by btcpp_tree_compiler from " << source_name << ": do not edit.\n\n"
+      << "#include \"" << header_name << "\"\n"
+      << "#include \"behaviortree_cpp/tree_codegen.h\"\n\n"
+      << "namespace\n{\n"
+      << "// the trees, in the format of BT::SerializeBehaviorTrees()\n"
+      << "alignas(16) const unsigned char trees_data[] = {";
+  const uint8_t* data = builder.GetBufferPointer();
+  for (size_t i = 0; i < builder.GetSize(); i++)
+  {
+    out << ((i % 16 == 0) ? "\n    " : " ") << unsigned(data[i]) << ',';
+  }
+  out << "\n};\n\n"
+      << "// the nodes used by the trees, in the format of BT::WritePluginIndex()\n"
+      << "const char* const manifests_index =\n    ";
+  details::WriteCStringLiteral(out, index.str());
+  out << ";\n}   // namespace\n\n"
+      << "void " << function_name << "(BT::FactoryExtensions& extensions)\n{\n"
+      << "  BT::CheckCompiledManifests(extensions.factory(), manifests_index, ";
+  details::WriteCStringLiteral(out, source_name);
+  out << ");\n"
+      << "  extensions.registerBehaviorTreeFromBinary(trees_data, sizeof(trees_data));\n"
+      << "}\n";
+}
+
+/// Write the header that declares the function of WriteCompiledTreesSource().
+inline void WriteCompiledTreesHeader(std::ostream& out, const std::string& function_name,
+                                     const std::string& source_name)
+{
+  out << "// Generated by btcpp_tree_compiler from " << source_name << ": do not edit.\n\n"
+      << "#pragma once\n\n"
+      << "namespace BT\n{\nclass FactoryExtensions;\n}\n\n"
+      << "/// Register the trees of " << source_name << ", validated and precompiled\n"
+      << "/// at build time. The nodes used by the trees must be registered first.\n"
+      << "/// The trees are created with FactoryExtensions::createPrecompiledTree().\n"
+      << "void " << function_name << "(BT::FactoryExtensions& extensions);\n";
+}
+
+}   // namespace BT
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <unordered_set>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/utils/tick_clock.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief TreeExecutor drives a Tree, ticking it only when something
+ * can change, instead of polling it with a fixed sleep as
+ * Tree::tickWhileRunning() does.
+ *
+ * The executor subscribes to the status changes of the nodes and keeps track
+ * of the leaves that are RUNNING. A running leaf is either:
+ *
+ * - "event-driven": it invokes TreeNode::emitWakeUpSignal() when it can make
+ *   progress (ThreadedAction, SleepNode, or any node registered with
+ *   markEventDriven()). While ONLY these nodes are running, the executor sleeps
+ *   until a wake-up signal arrives (or Options::max_idle expires).
+ * - "polling": any other leaf (for instance a StatefulActionNode that checks
+ *   a condition in onRunning()). If at least one of them is running,
+ *   the tree is ticked again after Options::poll_period.
+ *
+ * External events can wake up the tree with notify().
+ *
+ * The wait between two ticks can be replaced with setWaitFunction(), for
+ * instance to run an event loop in the same thread (see AttachIoReactor()).
+ *
+ * runAtFixedRate() provides, instead, a periodic mode with drift correction
+ * and jitter statistics. Each tick has a TickBudget that ends with its period.
+ *
+ * The Tree must outlive the executor.
+ */
+class TreeExecutor
+{
+public:
+  struct Options
+  {
+    /// Sleep between ticks, when a polling node is RUNNING
+    std::chrono::milliseconds poll_period = std::chrono::milliseconds(10);
+    /// Maximum sleep, if only event-driven nodes are RUNNING
+    std::chrono::milliseconds max_idle = std::chrono::milliseconds(1000);
+  };
+
+  struct Statistics
+  {
+    uint64_t ticks = 0;
+    /// ticks caused by emitWakeUpSignal() or notify()
+    uint64_t wakeups = 0;
+    /// ticks caused by the poll_period or the max_idle timeout
+    uint64_t timeouts = 0;
+    std::chrono::nanoseconds idle_time = {};
+    std::chrono::nanoseconds busy_time = {};
+  };
+
+  /// Statistics of runAtFixedRate(). Jitter is the difference between
+  /// the scheduled and the actual start time of a tick.
+  struct RateStatistics
+  {
+    uint64_t ticks = 0;
+    /// ticks that started later than the beginning of the following period
+    uint64_t overruns = 0;
+    /// periods skipped because of an overrun
+    uint64_t skipped_periods = 0;
+    std::chrono::nanoseconds min_jitter = std::chrono::nanoseconds::max();
+    std::chrono::nanoseconds max_jitter = {};
+    double mean_jitter_ns = 0;
+    double stddev_jitter_ns = 0;
+
+    // used to compute the variance online (Welford)
+    double m2_jitter_ = 0;
+  };
+
+  TreeExecutor(Tree& tree) : TreeExecutor(tree, Options())
+  {}
+
+  TreeExecutor(Tree& tree, Options options) : tree_(tree), options_(options)
+  {
+    if (!tree_.rootNode())
+    {
+      throw RuntimeError("TreeExecutor: empty Tree");
+    }
+    subscribe();
+  }
+
+  TreeExecutor(const TreeExecutor&) = delete;
+  TreeExecutor& operator=(const TreeExecutor&) = delete;
+
+  /**
+   * @brief Nodes with this registration ID will be considered event-driven,
+   * i.e. they promise to call emitWakeUpSignal() when they can make progress.
+   */
+  void markEventDriven(const std::string& registration_ID)
+  {
+    event_driven_IDs_.insert(registration_ID);
+    subscribe();
+  }
+
+  /// Returns true if it was interrupted before the timeout.
+  using WaitFunction = std::function<bool(std::chrono::milliseconds timeout)>;
+
+  /**
+   * @brief Use this function, instead of Tree::sleep(), to wait between two
+   * ticks of run(). It should return early when the event-driven nodes
+   * can make progress (see AttachIoReactor()). Not thread-safe: call
+   * it before run().
+   */
+  void setWaitFunction(WaitFunction wait)
+  {
+    wait_function_ = std::move(wait);
+  }
+
+  [[nodiscard]] Tree& tree() const
+  {
+    return tree_;
+  }
+
+  /**
+   * @brief Tick the tree until it returns SUCCESS or FAILURE,
+   * or until stop() is called (in that case the tree is halted and
+   * IDLE is returned).
+   */
+  NodeStatus run()
+  {
+    using Clock = std::chrono::steady_clock;
+    stop_requested_ = false;
+
+    NodeStatus status = tickOnce();
+    while (status == NodeStatus::RUNNING)
+    {
+      if (stop_requested_)
+      {
+        tree_.haltTree();
+        return NodeStatus::IDLE;
+      }
+      const auto timeout =
+          (polling_running_ > 0) ? options_.poll_period : options_.max_idle;
+
+      const auto t_sleep = Clock::now();
+      const bool woken_up = waitFor(timeout);
+      stats_.idle_time += Clock::now() - t_sleep;
+      woken_up ? stats_.wakeups++ : stats_.timeouts++;
+
+      status = tickOnce();
+    }
+    return status;
+  }
+
+  /**
+   * @brief Tick the tree periodically, with drift correction: the
+   * schedule is computed from the start time, not from the end of the
+   * previous tick. If a tick lasts longer than a period, the missed
+   * periods are skipped.
+   *
+   * @param period  the period of the tick.
+   * @param stop_when_done  if true, return when the tree completes
+   *                        (SUCCESS or FAILURE). Otherwise tick until stop().
+   */
+  NodeStatus runAtFixedRate(std::chrono::nanoseconds period, bool stop_when_done = true)
+  {
+    using Clock = std::chrono::steady_clock;
+    stop_requested_ = false;
+    rate_stats_ = {};
+
+    const auto start = Clock::now();
+    uint64_t cycle = 0;
+    NodeStatus status = NodeStatus::IDLE;
+
+    while (!stop_requested_)
+    {
+      const auto scheduled = start + cycle * period;
+      std::this_thread::sleep_until(scheduled);
+
+      const auto now = Clock::now();
+      updateJitter(std::chrono::duration_cast<std::chrono::nanoseconds>(now - scheduled));
+
+      {
+        // the tick should complete before the beginning of the next period
+        TickBudget::Scope budget(scheduled + period);
+        status = tickOnce();
+      }
+      if (stop_when_done && isStatusCompleted(status))
+      {
+        return status;
+      }
+
+      // next cycle, skipping the periods that have been missed
+      cycle++;
+      const auto elapsed = Clock::now() - start;
+      const uint64_t expected_cycle = uint64_t(elapsed / period) + 1;
+      if (expected_cycle > cycle)
+      {
+        rate_stats_.overruns++;
+        rate_stats_.skipped_periods += (expected_cycle - cycle);
+        cycle = expected_cycle;
+      }
+    }
+    if (status == NodeStatus::RUNNING)
+    {
+      tree_.haltTree();
+    }
+    return NodeStatus::IDLE;
+  }
+
+  /// Wake up the executor, from any thread. Use it when an external
+  /// event (not managed by the nodes of the tree) happened.
+  void notify()
+  {
+    tree_.rootNode()->emitWakeUpSignal();
+  }
+
+  /// Ask run() or runAtFixedRate() to return. Thread-safe.
+  void stop()
+  {
+    stop_requested_ = true;
+    notify();
+  }
+
+  /// Number of leaves currently in RUNNING state.
+  [[nodiscard]] size_t runningLeaves() const
+  {
+    return event_driven_running_ + polling_running_;
+  }
+
+  [[nodiscard]] const Statistics& statistics() const
+  {
+    return stats_;
+  }
+
+  [[nodiscard]] const RateStatistics& rateStatistics() const
+  {
+    return rate_stats_;
+  }
+
+private:
+  Tree& tree_;
+  Options options_;
+  Statistics stats_;
+  RateStatistics rate_stats_;
+  std::atomic_bool stop_requested_ = false;
+
+  WaitFunction wait_function_;
+  std::unordered_set<std::string> event_driven_IDs_;
+  std::vector<TreeNode::StatusChangeSubscriber> subscribers_;
+  std::atomic<int> event_driven_running_ = 0;
+  std::atomic<int> polling_running_ = 0;
+
+  NodeStatus tickOnce()
+  {
+    const auto t_start = std::chrono::steady_clock::now();
+    TickClock::Scope tick_clock;
+    const auto status = tree_.tickOnce();
+    stats_.busy_time += std::chrono::steady_clock::now() - t_start;
+    stats_.ticks++;
+    return status;
+  }
+
+  bool waitFor(std::chrono::milliseconds timeout)
+  {
+    if (wait_function_)
+    {
+      return wait_function_(timeout);
+    }
+    // Tree::sleep returns early if emitWakeUpSignal() was called, even
+    // before the beginning of the sleep.
+    const auto t_start = std::chrono::steady_clock::now();
+    tree_.sleep(std::chrono::duration_cast<std::chrono::system_clock::duration>(timeout));
+    return (std::chrono::steady_clock::now() - t_start) < timeout;
+  }
+
+  bool isEventDriven(const TreeNode& node) const
+  {
+    return dynamic_cast<const ThreadedAction*>(&node) != nullptr ||
+           dynamic_cast<const SleepNode*>(&node) != nullptr ||
+           event_driven_IDs_.count(node.registrationName()) != 0;
+  }
+
+  void subscribe()
+  {
+    subscribers_.clear();
+    event_driven_running_ = 0;
+    polling_running_ = 0;
+
+    for (const auto& subtree : tree_.subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        if (node->type() != NodeType::ACTION && node->type() != NodeType::CONDITION)
+        {
+          continue;
+        }
+        std::atomic<int>* counter =
+            isEventDriven(*node) ? &event_driven_running_ : &polling_running_;
+        if (node->status() == NodeStatus::RUNNING)
+        {
+          (*counter)++;
+        }
+        subscribers_.push_back(node->subscribeToStatusChange(
+            [counter](TimePoint, const TreeNode&, NodeStatus prev, NodeStatus status) {
+              if (prev == NodeStatus::RUNNING)
+              {
+                (*counter)--;
+              }
+              if (status == NodeStatus::RUNNING)
+              {
+                (*counter)++;
+              }
+            }));
+      }
+    }
+  }
+
+  void updateJitter(std::chrono::nanoseconds jitter)
+  {
+    auto& st = rate_stats_;
+    st.ticks++;
+    st.min_jitter = std::min(st.min_jitter, jitter);
+    st.max_jitter = std::max(st.max_jitter, jitter);
+    const double value = double(jitter.count());
+    const double delta = value - st.mean_jitter_ns;
+    st.mean_jitter_ns += delta / double(st.ticks);
+    st.m2_jitter_ += delta * (value - st.mean_jitter_ns);
+    st.stddev_jitter_ns = (st.ticks > 1) ? std::sqrt(st.m2_jitter_ / double(st.ticks - 1)) : 0.0;
+  }
+};
+
+}   // namespace BT
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/running_frontier.h"
+#include "behaviortree_cpp/utils/wildcard_matcher.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief TreeIndex answers the queries on a Tree that would otherwise visit
+ * all its nodes: the paths of the nodes and their status (RunningFrontier)
+ * are indexed on first use and kept until the subtrees of the tree change.
+ *
+ *    TreeIndex index(tree);
+ *    auto move_nodes = index.getNodesByPath<MoveBaseNode>("move_*");
+ *    // after a tick
+ *    auto running = index.runningNodes();
+ *
+ * The tree must outlive the index. Replacing the nodes of an existing
+ * subtree, or calling Tree::reload(), requires invalidate().
+ * Not thread-safe: use it from the thread that ticks the tree.
+ */
+class TreeIndex
+{
+public:
+  explicit TreeIndex(Tree& tree) : tree_(tree)
+  {}
+
+  TreeIndex(const TreeIndex&) = delete;
+  TreeIndex& operator=(const TreeIndex&) = delete;
+
+  [[nodiscard]] Tree& tree() const
+  {
+    return tree_;
+  }
+
+  /// Same as Tree::getNodesByPath(), using the index.
+  template <typename NodeType = BT::TreeNode>
+  [[nodiscard]] std::vector<const TreeNode*> getNodesByPath(StringView wildcard_filter)
+  {
+    std::vector<const TreeNode*> nodes;
+    for (TreeNode* node : nodesMatchingPath(wildcard_filter))
+    {
+      if (dynamic_cast<const NodeType*>(node))
+      {
+        nodes.push_back(node);
+      }
+    }
+    return nodes;
+  }
+
+  /// The nodes which fullPath() match a wildcard filter, in the order of
+  /// Tree::subtrees. The paths are indexed when this is called the first time
+  /// and the result of each filter is cached, until the subtrees change.
+  [[nodiscard]] const std::vector<TreeNode*>& nodesMatchingPath(StringView wildcard_filter)
+  {
+    auto& index = pathIndex();
+    const std::string filter(wildcard_filter);
+    if (auto it = index.queries.find(filter); it != index.queries.end())
+    {
+      return it->second;
+    }
+    if (index.queries.size() >= PathIndex::MAX_CACHED_QUERIES)
+    {
+      index.queries.clear();
+    }
+
+    // only the paths that start with the literal prefix of the filter can match
+    const StringView prefix =
+        wildcard_filter.substr(0, WildcardMatcher::LiteralPrefix(wildcard_filter));
+    const bool simple = wildcard_filter.find_first_of("[(\\") == StringView::npos;
+    auto it = std::lower_bound(index.items.begin(), index.items.end(), prefix,
+                               [](const PathIndex::Item& item, StringView key) {
+                                 return StringView(item.path) < key;
+                               });
+    std::vector<std::pair<size_t, TreeNode*>> found;
+    for (; it != index.items.end() && StringView(it->path).substr(0, prefix.size()) == prefix;
+         ++it)
+    {
+      bool match = false;
+      if (prefix.size() == wildcard_filter.size())
+      {
+        match = it->path.size() == prefix.size();
+      }
+      else
+      {
+        match = simple ? WildcardMatcher::Match(it->path, wildcard_filter) :
+                         WildcardMatch(it->path, wildcard_filter);
+      }
+      if (match)
+      {
+        found.push_back({ it->position, it->node });
+      }
+    }
+    std::sort(found.begin(), found.end());
+
+    auto& nodes = index.queries[filter];
+    nodes.reserve(found.size());
+    for (const auto& [position, node] : found)
+    {
+      nodes.push_back(node);
+    }
+    return nodes;
+  }
+
+  /// The nodes that are RUNNING, in no particular order. The first call
+  /// subscribes to the status of all the nodes (see RunningFrontier): create
+  /// the index while the tree is not ticked. Then the cost is proportional
+  /// to the number of running nodes.
+  [[nodiscard]] std::vector<TreeNode*> runningNodes()
+  {
+    return frontier().runningNodes();
+  }
+
+  /**
+   * @brief Same as Tree::haltTree(), but only the nodes that are not IDLE are
+   * halted and reset, instead of visiting the entire tree.
+   * Useful in large trees where few nodes are active at the same time.
+   */
+  void haltActiveNodes()
+  {
+    auto& frontier = this->frontier();
+    TreeNode* root = tree_.rootNode();
+    if (root && root->status() == NodeStatus::RUNNING)
+    {
+      root->haltNode();
+    }
+    // running nodes not reachable from a running parent
+    for (TreeNode* node : frontier.runningNodes())
+    {
+      if (node->status() == NodeStatus::RUNNING)
+      {
+        node->haltNode();
+      }
+    }
+    for (TreeNode* node : frontier.activeNodes())
+    {
+      node->resetStatus();
+    }
+  }
+
+  /// Discard the index of the paths and the RunningFrontier. This is needed
+  /// only if the nodes of an existing subtree are replaced, or after
+  /// Tree::reload().
+  void invalidate()
+  {
+    path_index_.reset();
+    frontier_.reset();
+  }
+
+private:
+  // the nodes of the tree sorted by fullPath()
+  struct PathIndex
+  {
+    struct Item
+    {
+      std::string path;
+      // position in Tree::subtrees, to return the nodes in that order
+      size_t position;
+      TreeNode* node;
+    };
+    std::vector<Item> items;
+
+    // to detect that Tree::subtrees changed
+    const void* subtrees_data = nullptr;
+    size_t subtrees_count = 0;
+    size_t nodes_count = 0;
+
+    // the result of the recent filters
+    static constexpr size_t MAX_CACHED_QUERIES = 256;
+    std::unordered_map<std::string, std::vector<TreeNode*>> queries;
+  };
+
+  Tree& tree_;
+  std::unique_ptr<PathIndex> path_index_;
+
+  // created by the first call of runningNodes() or haltActiveNodes()
+  std::unique_ptr<RunningFrontier> frontier_;
+  const void* frontier_subtrees_data_ = nullptr;
+  size_t frontier_subtrees_count_ = 0;
+
+  // like pathIndex(), but checking only Tree::subtrees, to stay O(1):
+  // replacing the nodes of a subtree requires invalidate()
+  RunningFrontier& frontier()
+  {
+    const auto& subtrees = tree_.subtrees;
+    if (frontier_ && frontier_subtrees_data_ == subtrees.data() &&
+        frontier_subtrees_count_ == subtrees.size())
+    {
+      return *frontier_;
+    }
+    std::vector<TreeNode*> nodes;
+    for (const auto& subtree : subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        nodes.push_back(node.get());
+      }
+    }
+    frontier_.reset();
+    frontier_ = std::make_unique<RunningFrontier>(nodes);
+    frontier_subtrees_data_ = subtrees.data();
+    frontier_subtrees_count_ = subtrees.size();
+    return *frontier_;
+  }
+
+  PathIndex& pathIndex()
+  {
+    const auto& subtrees = tree_.subtrees;
+    size_t nodes_count = 0;
+    for (const auto& subtree : subtrees)
+    {
+      nodes_count += subtree->nodes.size();
+    }
+    if (path_index_ && path_index_->subtrees_data == subtrees.data() &&
+        path_index_->subtrees_count == subtrees.size() &&
+        path_index_->nodes_count == nodes_count)
+    {
+      return *path_index_;
+    }
+
+    path_index_ = std::make_unique<PathIndex>();
+    path_index_->subtrees_data = subtrees.data();
+    path_index_->subtrees_count = subtrees.size();
+    path_index_->nodes_count = nodes_count;
+    auto& items = path_index_->items;
+    items.reserve(nodes_count);
+    for (const auto& subtree : subtrees)
+    {
+      for (const auto& node : subtree->nodes)
+      {
+        items.push_back({ node->fullPath(), items.size(), node.get() });
+      }
+    }
+    std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+      return a.path < b.path;
+    });
+    return *path_index_;
+  }
+};
+
+}   // namespace BT
@@ -239,6 +239,43 @@ public:
     return (res) ? Expected<T>(out) : nonstd::make_unexpected(res.error());
   }
 
+  /**
+   * @brief getInputRef reads an input port without copying its value:
+   * the returned object points to the value stored in the blackboard entry
+   * and keeps the entry locked, until it is destroyed.
+   *
+   *    if(auto cloud = getInputRef<PointCloud>("cloud")) {
+   *      const PointCloud& points = *cloud->get();
+   *    }
+   *
+   * Remapping follows the same rules of getInput(), but no conversion is
+   * done: T must be the type stored in the entry (numbers and strings are
+   * converted by Any; use getInput() to read them). Literal and default
+   * values are not stored in the blackboard: use getInput() to read them.
+   * The blackboard must outlive the returned object, like getAnyLocked().
+   *
+   * @param key   the name of the port.
+   */
+  template <typename T> [[nodiscard]]
+  Expected<LockedPtr<T>> getInputRef(const std::string& key) const;
+
+  /**
+   * @brief Read an input port as a shared immutable value.
+   *
+   * If the entry was published with setOutputShared() or Blackboard::setShared(),
+   * the value is not copied: the pointer is shared with the writer.
+   * In any other case, it contains a copy of the value read by getInput().
+   */
+  template <typename T> [[nodiscard]]
+  Expected<std::shared_ptr<const T>> getInputShared(const std::string& key) const;
+
+  /**
+   * @brief Publish a shared immutable value in an output port (see
+   * Blackboard::setShared), with the same remapping rules of setOutput().
+   */
+  template <typename T>
+  Result setOutputShared(const std::string& key, std::shared_ptr<const T> value);
+
   /**
    * @brief setOutput modifies the content of an Output port
    * @param key    the name of the port.
@@ -248,6 +285,12 @@ public:
   template <typename T>
   Result setOutput(const std::string& key, const T& value);
 
+  /// Same as setOutput(key, const T&), but the value is moved into the
+  /// blackboard entry, when possible.
+  template <typename T,
+            typename = typename std::enable_if<!std::is_lvalue_reference<T>::value>::type>
+  Result setOutput(const std::string& key, T&& value);
+
   /**
    * @brief getLockedPortContent should be used when:
    *
@@ -329,6 +372,11 @@ protected:
   friend class DecoratorNode;
   friend class ControlNode;
   friend class Tree;
+  friend class TreeTemplate;
+  friend class FlatTreeEngine;
+  friend class BatchTreeEngine;
+  friend class TreeIndex;
+  friend class FactoryExtensions;
 
   [[nodiscard]] NodeConfig& config();
 
@@ -363,6 +411,12 @@ private:
   struct PImpl;
   std::unique_ptr<PImpl> _p;
 
+  template <typename T>
+  Result setOutputImpl(const std::string& key, T&& value);
+
+  // blackboard key of an output port
+  Expected<StringView> remappedOutputKey(const std::string& key);
+
   Expected<NodeStatus> checkPreConditions();
   void checkPostConditions(NodeStatus status);
 
@@ -372,6 +426,35 @@ private:
 };
 
 //-------------------------------------------------------
+
+/**
+ * @brief Convert the string into T. It address the special case where T is
+ * an enum and the string is one of the registered scripting enums.
+ *
+ * May throw if the conversion fails.
+ */
+template <typename T> [[nodiscard]]
+inline T ParseString(const std::string& str, const ScriptingEnumsRegistry* enums)
+{
+  if constexpr (std::is_enum_v<T> && !std::is_same_v<T, NodeStatus>)
+  {
+    if(enums)
+    {
+      auto it = enums->find(str);
+      // conversion available
+      if( it != enums->end() )
+      {
+        return static_cast<T>(it->second);
+      }
+    }
+    // hopefully str contains a number that can be parsed. May throw
+    return static_cast<T>(convertFromString<int>(str));
+  }
+  else {
+    return convertFromString<T>(str);
+  }
+}
+
 template <typename T>
 inline Result TreeNode::getInput(const std::string& key, T& destination) const
 {
@@ -465,8 +548,159 @@ inline Result TreeNode::getInput(const std::string& key, T& destination) const
   }
 }
 
+template <typename T>
+inline Expected<LockedPtr<T>> TreeNode::getInputRef(const std::string& key) const
+{
+  auto remap_it = config().input_ports.find(key);
+  if (remap_it == config().input_ports.end())
+  {
+    return nonstd::make_unexpected(StrCat("getInputRef() failed because "
+                                          "NodeConfig::input_ports "
+                                          "does not contain the key: [",
+                                          key, "]"));
+  }
+  auto notStored = [&key](const std::string& where) {
+    return nonstd::make_unexpected(StrCat("getInputRef() failed because the ", where,
+                                          " of the port [", key, "] is not stored with "
+                                          "type [", TypeID::of<T>().name(),
+                                          "]. Use getInput() instead"));
+  };
+
+  const std::string& port_value_str = remap_it->second;
+  if (port_value_str.empty() && config().manifest)
+  {
+    const auto& port_manifest = config().manifest->ports.at(key);
+    if (!port_manifest.defaultValue().empty())
+    {
+      return notStored("default value");
+    }
+  }
+
+  auto remapped_res = getRemappedKey(key, port_value_str);
+  if (!remapped_res)
+  {
+    return notStored("literal value");
+  }
+  const auto& remapped_key = remapped_res.value();
+  if (!config().blackboard)
+  {
+    return nonstd::make_unexpected("getInputRef(): trying to access an invalid Blackboard");
+  }
+
+  if (auto entry = config().blackboard->getEntry(std::string(remapped_key)))
+  {
+    // the value, or the immutable object published with setShared().
+    // To be called with the entry locked.
+    auto valuePtr = [&entry]() -> const T* {
+      if (const T* ptr = entry->value.template castPtr<T>())
+      {
+        return ptr;
+      }
+      if (auto shared = entry->value.template castPtr<std::shared_ptr<const T>>())
+      {
+        return shared->get();
+      }
+      return nullptr;
+    };
+
+    const T* ptr = nullptr;
+    bool empty = true;
+    {
+      std::unique_lock lock(entry->entry_mutex);
+      ptr = valuePtr();
+      empty = entry->value.empty();
+    }
+    while (ptr)
+    {
+      LockedPtr<T> locked(ptr, &entry->entry_mutex);
+      // the value may have been replaced before the entry was locked again
+      const T* current = valuePtr();
+      if (current == ptr)
+      {
+        return locked;
+      }
+      ptr = current;
+      empty = entry->value.empty();
+    }
+    if (!empty)
+    {
+      return notStored("blackboard entry");
+    }
+  }
+  return nonstd::make_unexpected(StrCat("getInputRef() failed because it was unable to "
+                                        "find the key [", key, "] remapped to [",
+                                        remapped_key, "]"));
+}
+
+template <typename T>
+inline Expected<std::shared_ptr<const T>>
+TreeNode::getInputShared(const std::string& key) const
+{
+  auto remap_it = config().input_ports.find(key);
+  if (remap_it != config().input_ports.end() && config().blackboard)
+  {
+    auto remapped_res = getRemappedKey(key, remap_it->second);
+    if (remapped_res)
+    {
+      if (auto entry = config().blackboard->getEntry(std::string(remapped_res.value())))
+      {
+        std::unique_lock lock(entry->entry_mutex);
+        if (auto shared = entry->value.castPtr<std::shared_ptr<const T>>())
+        {
+          return *shared;
+        }
+      }
+    }
+  }
+  // any other case: use a copy
+  T value;
+  if (auto res = getInput(key, value); !res)
+  {
+    return nonstd::make_unexpected(res.error());
+  }
+  return std::make_shared<const T>(std::move(value));
+}
+
+template <typename T>
+inline Result TreeNode::setOutputShared(const std::string& key,
+                                        std::shared_ptr<const T> value)
+{
+  auto remapped_key = remappedOutputKey(key);
+  if (!remapped_key)
+  {
+    return nonstd::make_unexpected(remapped_key.error());
+  }
+  config().blackboard->setShared(static_cast<std::string>(remapped_key.value()),
+                                 std::move(value));
+  return {};
+}
+
 template <typename T>
 inline Result TreeNode::setOutput(const std::string& key, const T& value)
+{
+  return setOutputImpl(key, value);
+}
+
+template <typename T, typename>
+inline Result TreeNode::setOutput(const std::string& key, T&& value)
+{
+  return setOutputImpl(key, std::move(value));
+}
+
+template <typename T>
+inline Result TreeNode::setOutputImpl(const std::string& key, T&& value)
+{
+  auto remapped_key = remappedOutputKey(key);
+  if (!remapped_key)
+  {
+    return nonstd::make_unexpected(remapped_key.error());
+  }
+  config().blackboard->set(static_cast<std::string>(remapped_key.value()),
+                           std::forward<T>(value));
+  return {};
+}
+
+inline Expected<StringView> TreeNode::remappedOutputKey(const std::string& key)
 {
   if (!config().blackboard)
   {
@@ -491,19 +725,14 @@ inline Result TreeNode::setOutput(const std::string& key, const T& value)
   {
     remapped_key = stripBlackboardPointer(remapped_key);
   }
-  config().blackboard->set(static_cast<std::string>(remapped_key), value);
-
-  return {};
+  return remapped_key;
 }
 
 // Utility function to fill the list of ports using T::providedPorts();
 template <typename T>
 inline void assignDefaultRemapping(NodeConfig& config)
 {
-  for (const auto& it : getProvidedPorts<T>())
-  {
-    const auto& port_name = it.first;
-    const auto direction = it.second.direction();
+  auto assign = [&config](const std::string& port_name, PortDirection direction) {
     if (direction != PortDirection::OUTPUT)
     {
       // PortDirection::{INPUT,INOUT}
@@ -514,6 +743,20 @@ inline void assignDefaultRemapping(NodeConfig& config)
       // PortDirection::{OUTPUT,INOUT}
       config.output_ports[port_name] = "=";
     }
+  };
+  if constexpr (has_static_ports_spec<T>::value)
+  {
+    // no need to create the PortsList
+    T::ports.forEach([&assign](StringView name, PortDirection direction) {
+      assign(std::string(name), direction);
+    });
+  }
+  else
+  {
+    for (const auto& it : getProvidedPorts<T>())
+    {
+      assign(it.first, it.second.direction());
+    }
   }
 }
 
@@ -0,0 +1,357 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+
+namespace BT
+{
+
+namespace details
+{
+// a Tree::Subtree, where it is attached and what it contains
+struct ReloadSubtree
+{
+  Tree::Subtree::Ptr subtree;
+  // index of the parent subtree and of the SubTreeNode in its nodes
+  int parent = -1;
+  size_t parent_node = 0;
+  // equal if the subtree can be reused
+  std::string signature;
+};
+
+// ports remapping or remapping of a blackboard
+template <typename Map>
+inline void AppendReloadSignature(std::string& out, const Map& ports)
+{
+  // the order of an unordered_map is not relevant
+  const std::map<std::string, std::string> sorted(ports.begin(), ports.end());
+  for (const auto& [name, value] : sorted)
+  {
+    out += StrCat(" ", name, "=", value);
+  }
+  out += ';';
+}
+
+inline std::vector<ReloadSubtree> IndexReloadSubtrees(const Tree& tree)
+{
+  std::vector<ReloadSubtree> out(tree.subtrees.size());
+  std::unordered_map<const TreeNode*, size_t> roots;
+  for (size_t i = 0; i < tree.subtrees.size(); i++)
+  {
+    out[i].subtree = tree.subtrees[i];
+    if (!tree.subtrees[i]->nodes.empty())
+    {
+      roots[tree.subtrees[i]->nodes.front().get()] = i;
+    }
+  }
+
+  for (size_t i = 0; i < tree.subtrees.size(); i++)
+  {
+    const auto& subtree = *tree.subtrees[i];
+    std::unordered_map<const TreeNode*, size_t> local;
+    for (size_t j = 0; j < subtree.nodes.size(); j++)
+    {
+      local[subtree.nodes[j].get()] = j;
+    }
+    auto localIndex = [&local](const TreeNode* node) -> std::string {
+      auto it = local.find(node);
+      return it == local.end() ? std::string("?") : std::to_string(it->second);
+    };
+
+    // Tree::reload() appends the remapping of the blackboard
+    std::string& signature = out[i].signature;
+    signature = subtree.tree_ID + '\n';
+
+    for (size_t j = 0; j < subtree.nodes.size(); j++)
+    {
+      const TreeNode* node = subtree.nodes[j].get();
+      const auto& config = node->config();
+      signature += StrCat(node->registrationName(), "|", node->name(), "|", config.path, "|");
+      AppendReloadSignature(signature, config.input_ports);
+      AppendReloadSignature(signature, config.output_ports);
+      for (const auto& [cond, script] : config.pre_conditions)
+      {
+        signature += StrCat(" pre", std::to_string(int(cond)), "=", script);
+      }
+      for (const auto& [cond, script] : config.post_conditions)
+      {
+        signature += StrCat(" post", std::to_string(int(cond)), "=", script);
+      }
+
+      if (auto subtree_node = dynamic_cast<const SubTreeNode*>(node))
+      {
+        signature += StrCat("|subtree ", subtree_node->subtreeID());
+        auto it = roots.find(subtree_node->child());
+        if (it != roots.end())
+        {
+          out[it->second].parent = int(i);
+          out[it->second].parent_node = j;
+        }
+      }
+      else if (auto control = dynamic_cast<const ControlNode*>(node))
+      {
+        signature += "|children";
+        for (const TreeNode* child : control->children())
+        {
+          signature += ' ' + localIndex(child);
+        }
+      }
+      else if (auto decorator = dynamic_cast<const DecoratorNode*>(node))
+      {
+        signature += "|child " + localIndex(decorator->child());
+      }
+      signature += '\n';
+    }
+  }
+  return out;
+}
+
+// copy the values of the entries that have the same key and type
+using BlackboardStorage = std::unordered_map<std::string, std::shared_ptr<Blackboard::Entry>>;
+
+inline void CopyReloadedEntries(const BlackboardStorage& from, BlackboardStorage& to)
+{
+  for (const auto& [key, old_entry] : from)
+  {
+    auto it = to.find(key);
+    if (it == to.end() || it->second == old_entry || old_entry->value.empty() ||
+        it->second->port_info.type() != old_entry->port_info.type())
+    {
+      continue;
+    }
+    Blackboard::Entry& entry = *it->second;
+    std::scoped_lock lk(entry.entry_mutex, old_entry->entry_mutex);
+    entry.value = old_entry->value;
+  }
+}
+}   // namespace details
+
+inline Tree::ReloadStats Tree::reload(Tree&& new_tree)
+{
+  if (new_tree.subtrees.empty() || new_tree.subtrees.front()->nodes.empty())
+  {
+    throw RuntimeError("Tree::reload: the new tree is empty");
+  }
+  if (&new_tree == this)
+  {
+    throw LogicError("Tree::reload: a tree can not be reloaded from itself");
+  }
+  details::CheckMaxNodes(details::CountNodes(new_tree), "Tree::reload");
+
+  auto old_index = details::IndexReloadSubtrees(*this);
+  auto new_index = details::IndexReloadSubtrees(new_tree);
+  for (auto* index : { &old_index, &new_index })
+  {
+    for (auto& item : *index)
+    {
+      if (const auto& bb = item.subtree->blackboard)
+      {
+        std::unique_lock lk(bb->mutex_);
+        details::AppendReloadSignature(item.signature, bb->internal_to_external_);
+        item.signature += bb->autoremapping_ ? "_autoremap\n" : "\n";
+      }
+    }
+  }
+
+  std::unordered_map<std::string, size_t> old_by_name;
+  for (size_t i = 0; i < old_index.size(); i++)
+  {
+    old_by_name.emplace(old_index[i].subtree->instance_name, i);
+  }
+
+  // for each new subtree, the old one with the same name (-1 if none)
+  // and if it is reused
+  std::vector<int> previous(new_index.size(), -1);
+  std::vector<bool> reused(new_index.size(), false);
+  for (size_t i = 0; i < new_index.size(); i++)
+  {
+    auto it = old_by_name.find(new_index[i].subtree->instance_name);
+    if (it == old_by_name.end())
+    {
+      continue;
+    }
+    const auto& old_subtree = old_index[it->second];
+    previous[i] = int(it->second);
+    reused[i] = old_subtree.signature == new_index[i].signature &&
+                (old_subtree.parent < 0) == (new_index[i].parent < 0);
+  }
+
+  // an old subtree keeps running only if it is reused with all its ancestors
+  std::vector<bool> keeps_running(old_index.size(), false);
+  std::function<bool(size_t)> isContinuous = [&](size_t i) {
+    if (!reused[i])
+    {
+      return false;
+    }
+    const int parent = new_index[i].parent;
+    if (parent < 0)
+    {
+      return true;
+    }
+    return previous[size_t(parent)] == old_index[size_t(previous[i])].parent &&
+           isContinuous(size_t(parent));
+  };
+  for (size_t i = 0; i < new_index.size(); i++)
+  {
+    if (isContinuous(i))
+    {
+      keeps_running[size_t(previous[i])] = true;
+    }
+  }
+
+  ReloadStats stats;
+  for (size_t i = 0; i < old_index.size(); i++)
+  {
+    for (const auto& node : old_index[i].subtree->nodes)
+    {
+      const bool running = node->status() == NodeStatus::RUNNING;
+      stats.halted_nodes += (running && !keeps_running[i]) ? 1 : 0;
+    }
+  }
+  // halt the topmost old subtrees that don't keep running, with their descendants
+  for (size_t i = 0; i < old_index.size(); i++)
+  {
+    const int parent = old_index[i].parent;
+    if (keeps_running[i] || (parent >= 0 && !keeps_running[size_t(parent)]))
+    {
+      continue;
+    }
+    const auto& nodes = old_index[i].subtree->nodes;
+    if (!nodes.empty() && nodes.front()->status() != NodeStatus::IDLE)
+    {
+      nodes.front()->haltNode();
+    }
+  }
+
+  std::vector<Subtree::Ptr> merged(new_index.size());
+  for (size_t i = 0; i < new_index.size(); i++)
+  {
+    if (reused[i])
+    {
+      merged[i] = old_index[size_t(previous[i])].subtree;
+      stats.reused_subtrees++;
+      stats.reused_nodes += merged[i]->nodes.size();
+      continue;
+    }
+    merged[i] = new_index[i].subtree;
+    stats.rebuilt_subtrees++;
+    stats.rebuilt_nodes += merged[i]->nodes.size();
+    for (auto& node : merged[i]->nodes)
+    {
+      node->setWakeUpInstance(wake_up_);
+    }
+    if (previous[i] >= 0)
+    {
+      auto& old_bb = old_index[size_t(previous[i])].subtree->blackboard;
+      auto& new_bb = merged[i]->blackboard;
+      if (old_bb && new_bb && old_bb != new_bb)
+      {
+        std::scoped_lock lk(old_bb->mutex_, new_bb->mutex_);
+        details::CopyReloadedEntries(old_bb->storage_, new_bb->storage_);
+      }
+    }
+  }
+
+  // attach each subtree to the SubTreeNode of its parent. A reused parent has
+  // the same nodes of the new one: the SubTreeNode has the same index.
+  for (size_t i = 0; i < new_index.size(); i++)
+  {
+    const int parent = new_index[i].parent;
+    if (parent < 0)
+    {
+      continue;
+    }
+    auto& parent_subtree = *merged[size_t(parent)];
+    auto* subtree_node = static_cast<DecoratorNode*>(
+        parent_subtree.nodes[new_index[i].parent_node].get());
+    subtree_node->child_node_ = merged[i]->nodes.front().get();
+    if (auto& bb = merged[i]->blackboard)
+    {
+      // the remapped entries are the ones shared with the previous parent:
+      // share the ones of the new parent instead. The parents are attached
+      // first, therefore their own entries are already rebound.
+      std::vector<std::pair<std::string, PortInfo>> remapped;
+      {
+        std::unique_lock lk(bb->mutex_);
+        auto old_parent = bb->parent_bb_.lock();
+        bb->parent_bb_ = parent_subtree.blackboard;
+        if (old_parent && old_parent != parent_subtree.blackboard)
+        {
+          std::unique_lock parent_lk(old_parent->mutex_);
+          std::unordered_set<const Blackboard::Entry*> parent_entries;
+          for (const auto& [key, entry] : old_parent->storage_)
+          {
+            parent_entries.insert(entry.get());
+          }
+          for (auto it = bb->storage_.begin(); it != bb->storage_.end();)
+          {
+            if (parent_entries.count(it->second.get()) != 0)
+            {
+              remapped.emplace_back(it->first, it->second->port_info);
+              it = bb->storage_.erase(it);
+            }
+            else
+            {
+              ++it;
+            }
+          }
+        }
+      }
+      for (const auto& [key, info] : remapped)
+      {
+        bb->createEntry(key, info);
+      }
+    }
+  }
+  // same order of the UIDs assigned by BehaviorTreeFactory::createTree
+  uid_counter_ = 0;
+  for (auto& subtree : merged)
+  {
+    for (auto& node : subtree->nodes)
+    {
+      node->config().uid = getUID();
+    }
+  }
+
+  // the nodes point to the manifests: update them without removing any,
+  // then move the nodes taken from new_tree to the manifests of this tree.
+  // The manifests shared by the trees of a TreeTemplate are kept alive by
+  // their subtrees.
+  for (const auto& [id, manifest] : new_tree.manifests)
+  {
+    manifests[id] = manifest;
+  }
+  if (!new_tree.manifests.empty())
+  {
+    for (auto& subtree : merged)
+    {
+      for (auto& node : subtree->nodes)
+      {
+        auto& config = node->config();
+        if (!config.manifest)
+        {
+          continue;
+        }
+        auto it = new_tree.manifests.find(config.manifest->registration_ID);
+        if (it != new_tree.manifests.end() && &it->second == config.manifest)
+        {
+          config.manifest = &manifests.at(it->first);
+        }
+      }
+    }
+  }
+  // the old subtrees that are not reused are destroyed here
+  subtrees = std::move(merged);
+  // otherwise the destructor of new_tree would halt the nodes
+  new_tree.subtrees.clear();
+  return stats;
+}
+
+}   // namespace BT
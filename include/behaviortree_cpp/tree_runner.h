@@ -0,0 +1,371 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/utils/cpu_topology.hpp"
+#include "behaviortree_cpp/utils/executor.hpp"
+#include "behaviortree_cpp/utils/thread_pool.hpp"
+#include "behaviortree_cpp/utils/tick_clock.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief TreeRunner multiplexes many trees onto a fixed number of
+ * worker threads (a WorkStealingPool), instead of using a thread per tree.
+ *
+ * Each tree is ticked periodically with its own period. A tree is never
+ * ticked concurrently by two workers: the following tick is scheduled
+ * only after the previous one has completed.
+ *
+ * The workers can be pinned to CPUs or NUMA nodes (see
+ * WorkStealingPool::Placement). Then each tree is assigned to a NUMA node,
+ * or to a CPU, and ticked by the workers of that node; the asynchronous work
+ * submitted by the tree to executor() stays on the same node. Create the
+ * tree with RunOnNumaNode() to allocate its nodes and blackboards there.
+ *
+ * The trees must outlive the TreeRunner (or be removed first).
+ */
+class TreeRunner
+{
+public:
+  using Clock = std::chrono::steady_clock;
+  using TreeID = size_t;
+
+  struct TreeStatistics
+  {
+    uint64_t ticks = 0;
+    NodeStatus last_status = NodeStatus::IDLE;
+    /// Time between the scheduled start of a tick and its actual start
+    std::chrono::nanoseconds mean_latency = {};
+    std::chrono::nanoseconds max_latency = {};
+    /// Duration of Tree::tickOnce()
+    std::chrono::nanoseconds mean_tick_duration = {};
+    std::chrono::nanoseconds max_tick_duration = {};
+    /// Achieved tick rate, measured since the tree was added
+    double tick_rate_hz = 0;
+    /// ticks executed on a NUMA node different from the previous tick
+    uint64_t numa_migrations = 0;
+    /// ticks executed outside the NUMA node assigned to the tree
+    uint64_t remote_ticks = 0;
+  };
+
+  struct TreePlacement
+  {
+    /// -1: any
+    int numa_node = -1;
+    int cpu = -1;
+    /// CPU of the last tick, -1 if unknown
+    int last_cpu = -1;
+  };
+
+  struct TreeOptions
+  {
+    std::chrono::nanoseconds period = std::chrono::milliseconds(10);
+    /// If true, the tree will not be ticked anymore once it returns
+    /// SUCCESS or FAILURE. Otherwise, it is ticked again at the next period.
+    bool stop_when_completed = true;
+    /// Tick the tree on this NUMA node. If -1 and the workers are pinned,
+    /// the nodes are assigned round-robin.
+    int numa_node = -1;
+    /// Tick the tree on the worker pinned to this CPU (Pinning::CORE), if any.
+    int cpu = -1;
+  };
+
+  /// @param num_threads  if 0, use std::thread::hardware_concurrency()
+  explicit TreeRunner(size_t num_threads = 0) :
+    TreeRunner(num_threads, WorkStealingPool::Placement())
+  {}
+
+  TreeRunner(size_t num_threads, WorkStealingPool::Placement placement) :
+    pool_(std::make_shared<WorkStealingPool>(num_threads, placement)),
+    executor_(std::make_shared<PoolExecutor>(pool_, 0))
+  {
+    dispatcher_ = std::thread([this] { dispatchLoop(); });
+  }
+
+  TreeRunner(const TreeRunner&) = delete;
+  TreeRunner& operator=(const TreeRunner&) = delete;
+
+  ~TreeRunner()
+  {
+    {
+      std::scoped_lock lk(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    dispatcher_.join();
+    // wait the ticks in flight
+    std::unique_lock lk(mutex_);
+    cv_.wait(lk, [this] { return in_flight_ == 0; });
+  }
+
+  /// Add a tree. It will be ticked for the first time as soon as possible.
+  TreeID add(Tree& tree)
+  {
+    return add(tree, TreeOptions());
+  }
+
+  TreeID add(Tree& tree, TreeOptions options)
+  {
+    auto entry = std::make_shared<Entry>();
+    entry->tree = &tree;
+    entry->options = options;
+    entry->added = Clock::now();
+    {
+      std::scoped_lock lk(mutex_);
+      place(*entry);
+      entry->id = trees_.size();
+      trees_.push_back(entry);
+      schedule_.push({entry->added, entry});
+    }
+    cv_.notify_all();
+    return entry->id;
+  }
+
+  /**
+   * @brief Stop ticking a tree. Blocks until its current tick (if any)
+   * is complete. The tree is NOT halted.
+   */
+  void remove(TreeID id)
+  {
+    std::unique_lock lk(mutex_);
+    if (id >= trees_.size() || !trees_[id])
+    {
+      return;
+    }
+    auto entry = trees_[id];
+    entry->removed = true;
+    cv_.wait(lk, [&entry] { return !entry->in_flight; });
+    trees_[id].reset();
+  }
+
+  /// True if the tree is not scheduled anymore (completed or removed)
+  [[nodiscard]] bool isDone(TreeID id) const
+  {
+    std::scoped_lock lk(mutex_);
+    return id >= trees_.size() || !trees_[id] || trees_[id]->done;
+  }
+
+  /// Block until all the trees added with stop_when_completed are done.
+  void waitAll()
+  {
+    std::unique_lock lk(mutex_);
+    cv_.wait(lk, [this] {
+      return std::all_of(trees_.begin(), trees_.end(), [](const auto& entry) {
+        return !entry || entry->done;
+      });
+    });
+  }
+
+  [[nodiscard]] TreeStatistics statistics(TreeID id) const
+  {
+    std::scoped_lock lk(mutex_);
+    if (id >= trees_.size() || !trees_[id])
+    {
+      return {};
+    }
+    return trees_[id]->stats;
+  }
+
+  [[nodiscard]] TreePlacement placement(TreeID id) const
+  {
+    std::scoped_lock lk(mutex_);
+    if (id >= trees_.size() || !trees_[id])
+    {
+      return {};
+    }
+    return trees_[id]->placement;
+  }
+
+  [[nodiscard]] size_t numThreads() const
+  {
+    return pool_->size();
+  }
+
+  [[nodiscard]] const std::shared_ptr<WorkStealingPool>& pool() const
+  {
+    return pool_;
+  }
+
+  /**
+   * @brief Executor that shares the workers of the runner. Pass it to the
+   * PooledThreadedActions of the trees: the work submitted while ticking
+   * is queued on the worker (and the NUMA node) that ticks the tree.
+   */
+  [[nodiscard]] const std::shared_ptr<PoolExecutor>& executor() const
+  {
+    return executor_;
+  }
+
+private:
+  struct Entry
+  {
+    TreeID id = 0;
+    Tree* tree = nullptr;
+    TreeOptions options;
+    Clock::time_point added;
+    TreePlacement placement;
+    // -1 if the tree is not bound to a worker
+    int worker = -1;
+    bool in_flight = false;
+    bool removed = false;
+    bool done = false;
+    TreeStatistics stats;
+  };
+  using EntryPtr = std::shared_ptr<Entry>;
+
+  struct Scheduled
+  {
+    Clock::time_point due;
+    EntryPtr entry;
+    bool operator>(const Scheduled& other) const
+    {
+      return due > other.due;
+    }
+  };
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<EntryPtr> trees_;
+  std::priority_queue<Scheduled, std::vector<Scheduled>, std::greater<Scheduled>> schedule_;
+  size_t in_flight_ = 0;
+  bool stopping_ = false;
+  size_t next_node_ = 0;
+
+  std::shared_ptr<WorkStealingPool> pool_;
+  std::shared_ptr<PoolExecutor> executor_;
+  std::thread dispatcher_;
+
+  // must be called with the mutex locked
+  void place(Entry& entry)
+  {
+    auto& where = entry.placement;
+    where.cpu = entry.options.cpu;
+    where.numa_node = entry.options.numa_node;
+    const auto& workers = pool_->placement();
+    if (where.cpu >= 0)
+    {
+      for (size_t i = 0; i < workers.size(); i++)
+      {
+        if (workers[i].cpu == where.cpu)
+        {
+          entry.worker = int(i);
+          break;
+        }
+      }
+      where.numa_node = CpuTopology::get().nodeOfCpu(where.cpu);
+    }
+    else if (where.numa_node < 0 && pool_->isPinned())
+    {
+      where.numa_node = int(next_node_++ % CpuTopology::get().numaNodes());
+    }
+  }
+
+  void dispatchLoop()
+  {
+    std::unique_lock lk(mutex_);
+    while (!stopping_)
+    {
+      if (schedule_.empty())
+      {
+        cv_.wait(lk);
+        continue;
+      }
+      const auto due = schedule_.top().due;
+      if (Clock::now() < due)
+      {
+        cv_.wait_until(lk, due);
+        continue;
+      }
+      Scheduled item = schedule_.top();
+      schedule_.pop();
+      if (item.entry->removed)
+      {
+        continue;
+      }
+      item.entry->in_flight = true;
+      in_flight_++;
+      if (item.entry->worker >= 0)
+      {
+        pool_->submitToWorker(size_t(item.entry->worker), [this, item] { tick(item); });
+      }
+      else
+      {
+        pool_->submit([this, item] { tick(item); }, item.entry->placement.numa_node);
+      }
+    }
+  }
+
+  void tick(const Scheduled& item)
+  {
+    Entry& entry = *item.entry;
+    const int cpu = CpuTopology::currentCpu();
+    const auto t_start = Clock::now();
+    NodeStatus status = NodeStatus::FAILURE;
+    try
+    {
+      TickClock::Scope tick_clock;
+      status = entry.tree->tickOnce();
+    }
+    catch (...)
+    {
+      // don't tick again a tree that threw
+      entry.options.stop_when_completed = true;
+    }
+    const auto t_end = Clock::now();
+
+    std::unique_lock lk(mutex_);
+    auto& st = entry.stats;
+    st.ticks++;
+    st.last_status = status;
+    auto update = [&st](std::chrono::nanoseconds& mean, std::chrono::nanoseconds& max,
+                        std::chrono::nanoseconds value) {
+      mean += (value - mean) / int64_t(st.ticks);
+      max = std::max(max, value);
+    };
+    update(st.mean_latency, st.max_latency, t_start - item.due);
+    update(st.mean_tick_duration, st.max_tick_duration, t_end - t_start);
+    const std::chrono::duration<double> elapsed = t_end - entry.added;
+    st.tick_rate_hz = (elapsed.count() > 0) ? double(st.ticks) / elapsed.count() : 0;
+
+    const auto& topology = CpuTopology::get();
+    const int node = topology.nodeOfCpu(cpu);
+    auto& where = entry.placement;
+    if (where.last_cpu >= 0 && node != topology.nodeOfCpu(where.last_cpu))
+    {
+      st.numa_migrations++;
+    }
+    if (where.numa_node >= 0 && node >= 0 && node != where.numa_node)
+    {
+      st.remote_ticks++;
+    }
+    where.last_cpu = cpu;
+
+    entry.in_flight = false;
+    in_flight_--;
+    if (isStatusCompleted(status) && entry.options.stop_when_completed)
+    {
+      entry.done = true;
+    }
+    else if (!entry.removed)
+    {
+      // drift-free schedule, but never in the past
+      const auto next_due = std::max(item.due + entry.options.period, t_end);
+      schedule_.push({next_due, item.entry});
+    }
+    lk.unlock();
+    cv_.notify_all();
+  }
+};
+
+}   // namespace BT
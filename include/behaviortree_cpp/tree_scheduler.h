@@ -0,0 +1,443 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/utils/tick_clock.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief DeadlineScheduler ticks many trees with different rates on a pool
+ * of worker threads, in earliest-deadline-first (or rate-monotonic) order.
+ *
+ * Each tree is released periodically; a release must be ticked before its
+ * deadline (by default, the end of the period). The deadline is passed to
+ * Tree::tickOnce(deadline), so that cooperative nodes can see their
+ * TickBudget. A tree is never ticked concurrently: the next release is
+ * scheduled after the previous tick has completed.
+ *
+ * Under overload, the trees are protected by priority: when a tree misses
+ * a deadline, the trees with a lower priority apply their MissPolicy for
+ * one period of that tree. A tree also applies its policy when its tick
+ * would certainly end after the deadline (it starts late, or its mean
+ * tick duration doesn't fit the time left).
+ *
+ * The trees must outlive the scheduler (or be removed first).
+ */
+class DeadlineScheduler
+{
+public:
+  using Clock = std::chrono::steady_clock;
+  using TreeID = size_t;
+
+  enum class Policy
+  {
+    /// the ready tree with the earliest absolute deadline first
+    EARLIEST_DEADLINE_FIRST,
+    /// the ready tree with the shortest period first (static priority)
+    RATE_MONOTONIC
+  };
+
+  /// What a tree does when it is late, or shed because of the overload
+  enum class MissPolicy
+  {
+    /// tick it anyway
+    RUN_LATE,
+    /// skip this release; the tree is ticked at the next one
+    SKIP,
+    /// tick it, but double its period (up to max_degradation), until it
+    /// meets the deadline for recovery_releases consecutive releases
+    DEGRADE
+  };
+
+  struct TreeOptions
+  {
+    std::chrono::nanoseconds period = std::chrono::milliseconds(10);
+    /// relative to the release. If zero, equal to the period
+    std::chrono::nanoseconds deadline = {};
+    /// higher values are more important
+    int priority = 0;
+    MissPolicy on_miss = MissPolicy::RUN_LATE;
+    /// maximum multiplier of the period, with MissPolicy::DEGRADE
+    unsigned max_degradation = 8;
+    unsigned recovery_releases = 10;
+    /// If true, the tree will not be ticked anymore once it returns
+    /// SUCCESS or FAILURE.
+    bool stop_when_completed = false;
+  };
+
+  struct TreeStatistics
+  {
+    uint64_t releases = 0;
+    uint64_t ticks = 0;
+    /// ticks that completed after their deadline
+    uint64_t deadline_misses = 0;
+    /// releases skipped by MissPolicy::SKIP, or lost because the previous
+    /// tick was still running when their deadline passed
+    uint64_t skipped = 0;
+    /// current multiplier of the period (MissPolicy::DEGRADE)
+    unsigned degradation = 1;
+    NodeStatus last_status = NodeStatus::IDLE;
+    /// completion time minus deadline, for the ticks that missed it
+    std::chrono::nanoseconds mean_lateness = {};
+    std::chrono::nanoseconds max_lateness = {};
+    /// time between the release and the completion of the tick
+    std::chrono::nanoseconds mean_response_time = {};
+    std::chrono::nanoseconds max_response_time = {};
+    /// duration of Tree::tickOnce()
+    std::chrono::nanoseconds mean_tick_duration = {};
+  };
+
+  /**
+   * @param num_threads  if 0, use std::thread::hardware_concurrency()
+   */
+  explicit DeadlineScheduler(size_t num_threads = 0,
+                             Policy policy = Policy::EARLIEST_DEADLINE_FIRST) :
+    policy_(policy)
+  {
+    if (num_threads == 0)
+    {
+      num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++)
+    {
+      workers_.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  DeadlineScheduler(const DeadlineScheduler&) = delete;
+  DeadlineScheduler& operator=(const DeadlineScheduler&) = delete;
+
+  /// Wait the ticks in progress; the trees are not halted.
+  ~DeadlineScheduler()
+  {
+    {
+      std::scoped_lock lk(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_)
+    {
+      worker.join();
+    }
+  }
+
+  /// Add a tree, released for the first time immediately.
+  TreeID add(Tree& tree, TreeOptions options)
+  {
+    if (options.period <= std::chrono::nanoseconds::zero())
+    {
+      throw RuntimeError("DeadlineScheduler: the period must be positive");
+    }
+    if (options.deadline <= std::chrono::nanoseconds::zero())
+    {
+      options.deadline = options.period;
+    }
+    options.max_degradation = std::max(options.max_degradation, 1u);
+
+    auto entry = std::make_shared<Entry>();
+    entry->tree = &tree;
+    entry->options = options;
+    {
+      std::scoped_lock lk(mutex_);
+      entry->id = trees_.size();
+      trees_.push_back(entry);
+      release(entry, Clock::now());
+    }
+    cv_.notify_all();
+    return entry->id;
+  }
+
+  /// Stop ticking a tree, waiting for its tick in progress. It is NOT halted.
+  void remove(TreeID id)
+  {
+    std::unique_lock lk(mutex_);
+    if (id >= trees_.size() || !trees_[id])
+    {
+      return;
+    }
+    auto entry = trees_[id];
+    entry->removed = true;
+    cv_.wait(lk, [&entry] { return !entry->in_flight; });
+    trees_[id].reset();
+  }
+
+  /// True if the tree is not scheduled anymore (completed or removed)
+  [[nodiscard]] bool isDone(TreeID id) const
+  {
+    std::scoped_lock lk(mutex_);
+    return id >= trees_.size() || !trees_[id] || trees_[id]->done;
+  }
+
+  [[nodiscard]] TreeStatistics statistics(TreeID id) const
+  {
+    std::scoped_lock lk(mutex_);
+    if (id >= trees_.size() || !trees_[id])
+    {
+      return {};
+    }
+    return trees_[id]->stats;
+  }
+
+  /// Deadline misses of all the trees, including the removed ones.
+  [[nodiscard]] uint64_t totalDeadlineMisses() const
+  {
+    std::scoped_lock lk(mutex_);
+    return total_misses_;
+  }
+
+  [[nodiscard]] size_t numThreads() const
+  {
+    return workers_.size();
+  }
+
+private:
+  struct Entry
+  {
+    TreeID id = 0;
+    Tree* tree = nullptr;
+    TreeOptions options;
+    Clock::time_point release;
+    Clock::time_point deadline;
+    unsigned on_time_streak = 0;
+    bool in_flight = false;
+    bool removed = false;
+    bool done = false;
+    TreeStatistics stats;
+  };
+  using EntryPtr = std::shared_ptr<Entry>;
+
+  struct Job
+  {
+    // deadline (EDF) or period (RM); then the priority, then the deadline
+    std::chrono::nanoseconds key;
+    int priority;
+    Clock::time_point deadline;
+    EntryPtr entry;
+
+    bool operator>(const Job& other) const
+    {
+      if (key != other.key)
+      {
+        return key > other.key;
+      }
+      if (priority != other.priority)
+      {
+        return priority < other.priority;
+      }
+      return deadline > other.deadline;
+    }
+  };
+
+  struct Pending
+  {
+    Clock::time_point release;
+    EntryPtr entry;
+
+    bool operator>(const Pending& other) const
+    {
+      return release > other.release;
+    }
+  };
+
+  template <typename T>
+  using MinHeap = std::priority_queue<T, std::vector<T>, std::greater<T>>;
+
+  const Policy policy_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<EntryPtr> trees_;
+  MinHeap<Pending> pending_;
+  MinHeap<Job> ready_;
+  bool stopping_ = false;
+  uint64_t total_misses_ = 0;
+  // the lower priorities are shed until overload_until_
+  int overload_priority_ = 0;
+  Clock::time_point overload_until_;
+
+  std::vector<std::thread> workers_;
+
+  // must be called with the mutex locked
+  void release(const EntryPtr& entry, Clock::time_point when)
+  {
+    entry->release = when;
+    entry->deadline = when + entry->options.deadline;
+    pending_.push({ when, entry });
+  }
+
+  std::chrono::nanoseconds period(const Entry& entry) const
+  {
+    return entry.options.period * entry.stats.degradation;
+  }
+
+  // move the released trees to the ready queue
+  void promote(Clock::time_point now)
+  {
+    while (!pending_.empty() && pending_.top().release <= now)
+    {
+      EntryPtr entry = pending_.top().entry;
+      pending_.pop();
+      if (entry->removed)
+      {
+        continue;
+      }
+      entry->stats.releases++;
+      const auto key = (policy_ == Policy::EARLIEST_DEADLINE_FIRST) ?
+                           entry->deadline.time_since_epoch() :
+                           std::chrono::nanoseconds(entry->options.period);
+      ready_.push({ key, entry->options.priority, entry->deadline, entry });
+    }
+  }
+
+  // true if the tick should not start now, according to the MissPolicy
+  bool mustShed(Entry& entry, Clock::time_point now) const
+  {
+    if (entry.options.on_miss == MissPolicy::RUN_LATE)
+    {
+      return false;
+    }
+    const bool late = now + entry.stats.mean_tick_duration > entry.deadline;
+    const bool overload =
+        now < overload_until_ && entry.options.priority < overload_priority_;
+    return late || overload;
+  }
+
+  void workerLoop()
+  {
+    std::unique_lock lk(mutex_);
+    while (!stopping_)
+    {
+      const auto now = Clock::now();
+      promote(now);
+      if (ready_.empty())
+      {
+        if (pending_.empty())
+        {
+          cv_.wait(lk);
+        }
+        else
+        {
+          cv_.wait_until(lk, pending_.top().release);
+        }
+        continue;
+      }
+      Job job = ready_.top();
+      ready_.pop();
+      Entry& entry = *job.entry;
+      if (entry.removed)
+      {
+        continue;
+      }
+      if (mustShed(entry, now))
+      {
+        if (entry.options.on_miss == MissPolicy::SKIP)
+        {
+          entry.stats.skipped++;
+          scheduleNext(job.entry, now);
+          continue;
+        }
+        degrade(entry);
+      }
+      entry.in_flight = true;
+      lk.unlock();
+      tick(job.entry);
+      lk.lock();
+    }
+  }
+
+  void degrade(Entry& entry)
+  {
+    entry.on_time_streak = 0;
+    entry.stats.degradation =
+        std::min(entry.stats.degradation * 2, entry.options.max_degradation);
+  }
+
+  void tick(const EntryPtr& entry_ptr)
+  {
+    Entry& entry = *entry_ptr;
+    const auto t_start = Clock::now();
+    NodeStatus status = NodeStatus::FAILURE;
+    bool threw = false;
+    try
+    {
+      TickClock::Scope tick_clock;
+      status = entry.tree->tickOnce(entry.deadline);
+    }
+    catch (...)
+    {
+      threw = true;
+    }
+    const auto t_end = Clock::now();
+
+    std::unique_lock lk(mutex_);
+    auto& st = entry.stats;
+    st.ticks++;
+    st.last_status = status;
+    const std::chrono::nanoseconds response = t_end - entry.release;
+    st.mean_response_time += (response - st.mean_response_time) / int64_t(st.ticks);
+    st.max_response_time = std::max(st.max_response_time, response);
+    const std::chrono::nanoseconds duration = t_end - t_start;
+    st.mean_tick_duration += (duration - st.mean_tick_duration) / int64_t(st.ticks);
+
+    if (t_end > entry.deadline)
+    {
+      const std::chrono::nanoseconds lateness = t_end - entry.deadline;
+      st.deadline_misses++;
+      total_misses_++;
+      st.mean_lateness += (lateness - st.mean_lateness) / int64_t(st.deadline_misses);
+      st.max_lateness = std::max(st.max_lateness, lateness);
+      // protect this tree from the less important ones, for one period
+      if (t_end >= overload_until_ || entry.options.priority > overload_priority_)
+      {
+        overload_priority_ = entry.options.priority;
+      }
+      overload_until_ = std::max(overload_until_, t_end + period(entry));
+      if (entry.options.on_miss == MissPolicy::DEGRADE)
+      {
+        degrade(entry);
+      }
+    }
+    else if (st.degradation > 1 && ++entry.on_time_streak >= entry.options.recovery_releases)
+    {
+      st.degradation /= 2;
+      entry.on_time_streak = 0;
+    }
+
+    entry.in_flight = false;
+    if (threw || (isStatusCompleted(status) && entry.options.stop_when_completed))
+    {
+      entry.done = true;
+    }
+    else if (!entry.removed)
+    {
+      scheduleNext(entry_ptr, t_end);
+    }
+    lk.unlock();
+    cv_.notify_all();
+  }
+
+  // must be called with the mutex locked
+  void scheduleNext(const EntryPtr& entry, Clock::time_point now)
+  {
+    // drift-free releases; the ones whose deadline already passed are lost
+    auto next = entry->release + period(*entry);
+    while (next + entry->options.deadline <= now)
+    {
+      entry->stats.skipped++;
+      next += period(*entry);
+    }
+    release(entry, next);
+  }
+};
+
+}   // namespace BT
@@ -0,0 +1,1110 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "behaviortree_cpp/factory_extensions.h"
+#include "behaviortree_cpp/decorators/subtree_node.h"
+#include "behaviortree_cpp/flatbuffers/BT_tree_generated.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BT_TREE_TEMPLATE_MMAP
+#endif
+#include <fstream>
+
+namespace BT
+{
+
+class LazySubTreeNode;
+
+/// See TreeTemplate::instantiate and LazySubTreeNode.
+struct LazySubtreeOptions
+{
+  /// SubTrees created on their first tick: wildcards (see WildcardMatch)
+  /// matched with the fullPath() of the SubTree node, or IDs of the subtree.
+  std::vector<std::string> filters = { "*" };
+  /// If not zero, ReleaseIdleSubtrees() destroys the nodes of the lazy subtrees
+  /// that have not been ticked for this time.
+  std::chrono::milliseconds release_after = {};
+};
+
+/**
+ * @brief TreeTemplate is a tree compiled once from a tree registered in the
+ * BehaviorTreeFactory, that can be instantiated many times without parsing
+ * the XML again. The identifiers, the manifests and the compiled substitution
+ * rules are taken from the FactoryExtensions of the factory.
+ *
+ * It contains the resolved builders, the configuration of each node
+ * (port remapping, manifests, enums), the parsed pre/post-condition scripts
+ * and the structure of the subtrees, with their blackboard remapping:
+ *
+ *    auto tree_template = TreeTemplate::compile(extensions, "MainTree");
+ *    // for each job
+ *    Tree tree = tree_template.instantiate(Blackboard::create());
+ *
+ * The factory and its FactoryExtensions must outlive the TreeTemplate and
+ * the builders used by the tree must not be unregistered.
+ *
+ * A TreeTemplate can also be serialized in a flatbuffers binary (see
+ * SaveBehaviorTreesBinary) and loaded by another process with
+ * FactoryExtensions::registerBehaviorTreeFromBinary(), without parsing the XML.
+ */
+class TreeTemplate
+{
+public:
+  TreeTemplate() = default;
+
+  /**
+   * @brief compile a tree previously registered with
+   * BehaviorTreeFactory::registerBehaviorTreeFromText/File.
+   * A prototype of the tree is instantiated once (and then destroyed).
+   */
+  [[nodiscard]] static TreeTemplate compile(const FactoryExtensions& extensions,
+                                            const std::string& tree_name)
+  {
+    Tree prototype = extensions.factory().createTree(tree_name);
+    return compile(extensions, prototype);
+  }
+
+  /// Record the structure of an existing tree, created by the same factory.
+  [[nodiscard]] static TreeTemplate compile(const FactoryExtensions& extensions,
+                                            const Tree& prototype)
+  {
+    details::CheckMaxNodes(details::CountNodes(prototype), "TreeTemplate::compile");
+    TreeTemplate tmpl;
+    tmpl.factory_ = &extensions.factory();
+    tmpl.manifests_ = extensions.sharedManifests();
+    StringPool& pool = *extensions.stringPool();
+
+    std::unordered_map<const Blackboard*, int> subtree_of_blackboard;
+    std::unordered_map<const TreeNode*, int> subtree_of_node;
+    for (size_t index = 0; index < prototype.subtrees.size(); index++)
+    {
+      const auto& subtree = *prototype.subtrees[index];
+      subtree_of_blackboard[subtree.blackboard.get()] = int(index);
+      for (const auto& node : subtree.nodes)
+      {
+        subtree_of_node[node.get()] = int(index);
+      }
+    }
+
+    for (size_t index = 0; index < prototype.subtrees.size(); index++)
+    {
+      const auto& subtree = *prototype.subtrees[index];
+      SubtreeRecord record;
+      record.instance_name = pool.intern(subtree.instance_name);
+      record.tree_ID = pool.intern(subtree.tree_ID);
+
+      const Blackboard& bb = *subtree.blackboard;
+      std::unique_lock lk(bb.mutex_);
+      // the entries shared with the parent are the remapped ones
+      std::unordered_set<const Blackboard::Entry*> parent_entries;
+      if (auto parent = bb.parent_bb_.lock())
+      {
+        auto it = subtree_of_blackboard.find(parent.get());
+        record.parent = (it != subtree_of_blackboard.end()) ? it->second : -1;
+        std::unique_lock parent_lock(parent->mutex_);
+        for (const auto& [key, entry] : parent->storage_)
+        {
+          parent_entries.insert(entry.get());
+        }
+      }
+      record.remapping = bb.internal_to_external_;
+      record.autoremapping = bb.autoremapping_;
+      for (const auto& [key, entry] : bb.storage_)
+      {
+        std::unique_lock entry_lock(entry->entry_mutex);
+        record.entries.push_back({pool.intern(key), entry->port_info, entry->value,
+                                  parent_entries.count(entry.get()) != 0});
+      }
+      tmpl.subtrees_.push_back(std::move(record));
+    }
+
+    if (auto root = prototype.rootNode())
+    {
+      const auto rules = extensions.compiledSubstitutionRules();
+      tmpl.recordNode(root, -1, subtree_of_node, *rules, pool);
+    }
+    return tmpl;
+  }
+
+  /**
+   * @brief instantiate a new tree. The XML is not parsed again.
+   *
+   * To allocate the nodes from a single arena, invoke this method inside
+   * an ArenaScope (only the classes that use BT_ARENA_ALLOCATED_CLASS).
+   *
+   * @param blackboard  blackboard of the root tree
+   */
+  [[nodiscard]] Tree instantiate(Blackboard::Ptr blackboard = Blackboard::create()) const
+  {
+    return instantiateImpl(nullptr, std::move(blackboard), {});
+  }
+
+  /**
+   * @brief instantiate a new tree, in which the SubTrees selected by
+   * the options are replaced by a LazySubTreeNode: their nodes and blackboards
+   * are created on the first tick.
+   *
+   * The template is shared with the lazy nodes, that may outlive it.
+   */
+  [[nodiscard]] static Tree instantiate(const std::shared_ptr<const TreeTemplate>& tmpl,
+                                        Blackboard::Ptr blackboard,
+                                        const LazySubtreeOptions& options)
+  {
+    return tmpl->instantiateImpl(&tmpl, std::move(blackboard),
+                                 std::make_shared<const LazySubtreeOptions>(options));
+  }
+
+  [[nodiscard]] bool empty() const
+  {
+    return nodes_.empty();
+  }
+
+  [[nodiscard]] size_t nodesCount() const
+  {
+    return nodes_.size();
+  }
+
+  [[nodiscard]] size_t subtreesCount() const
+  {
+    return subtrees_.size();
+  }
+
+  /**
+   * @brief serialize the template into a Serialization::TreeRecord.
+   * Builders are identified by registration ID; the type of the blackboard
+   * entries by the port of the node that uses them.
+   */
+  [[nodiscard]] flatbuffers::Offset<Serialization::TreeRecord>
+  serialize(flatbuffers::FlatBufferBuilder& builder, const std::string& tree_ID) const;
+
+  /**
+   * @brief Create a template from a record produced by serialize().
+   * The builders are resolved and the conditions parsed (by the ScriptCache
+   * of the extensions) once, here, as compile() does. The nodes matched by a
+   * substitution rule of the factory are created with
+   * BehaviorTreeFactory::instantiateTreeNode().
+   */
+  [[nodiscard]] static TreeTemplate deserialize(const FactoryExtensions& extensions,
+                                                const Serialization::TreeRecord& record);
+
+private:
+  enum class NodeKind
+  {
+    LEAF,
+    CONTROL,
+    DECORATOR
+  };
+
+  // identifiers are interned in the StringPool of the FactoryExtensions
+  struct NodeRecord
+  {
+    InternedString name;
+    InternedString registration_ID;
+    NodeConfig config;
+    // nullptr if the node must be created by BehaviorTreeFactory::instantiateTreeNode
+    const NodeBuilder* builder = nullptr;
+    NodeKind kind = NodeKind::LEAF;
+    int parent = -1;
+    int subtree = 0;
+    // not empty if this is a SubTreeNode
+    InternedString subtree_ID;
+    TreeNode::PreScripts pre_scripts;
+    TreeNode::PostScripts post_scripts;
+  };
+
+  struct EntryRecord
+  {
+    InternedString key;
+    PortInfo info;
+    Any value;
+    // the entry belongs to the parent blackboard: see createSubtree()
+    bool remapped = false;
+  };
+
+  struct SubtreeRecord
+  {
+    InternedString instance_name;
+    InternedString tree_ID;
+    int parent = -1;
+    std::unordered_map<std::string, std::string> remapping;
+    bool autoremapping = false;
+    std::vector<EntryRecord> entries;
+  };
+
+  const BehaviorTreeFactory* factory_ = nullptr;
+  // shared with the trees, that point to them: see makeSubtree()
+  SharedManifests manifests_;
+  std::vector<SubtreeRecord> subtrees_;
+  // in depth-first order: parents before children
+  std::vector<NodeRecord> nodes_;
+
+  friend class LazySubTreeNode;
+
+  using LazyOptionsPtr = std::shared_ptr<const LazySubtreeOptions>;
+
+  Tree instantiateImpl(const std::shared_ptr<const TreeTemplate>* self,
+                       Blackboard::Ptr blackboard, const LazyOptionsPtr& lazy) const;
+
+  // first record after the descendants of the given one
+  size_t descendantsEnd(size_t index) const
+  {
+    size_t end = index + 1;
+    while (end < nodes_.size() && nodes_[end].parent >= int(index))
+    {
+      end++;
+    }
+    return end;
+  }
+
+  bool isLazy(const NodeRecord& record, const LazyOptionsPtr& lazy) const;
+
+  static void setWakeUpInstance(TreeNode& node, std::shared_ptr<WakeUpSignal> instance)
+  {
+    node.setWakeUpInstance(std::move(instance));
+  }
+
+  Tree::Subtree::Ptr createSubtree(size_t index, const Blackboard::Ptr& parent_bb) const;
+
+  // an empty Tree::Subtree that keeps alive the manifests its nodes point to
+  Tree::Subtree::Ptr makeSubtree() const
+  {
+    struct SubtreeWithManifests
+    {
+      // declared first, to be destroyed after the nodes
+      SharedManifests manifests;
+      Tree::Subtree subtree;
+    };
+    auto holder = std::make_shared<SubtreeWithManifests>();
+    holder->manifests = manifests_;
+    return Tree::Subtree::Ptr(holder, &holder->subtree);
+  }
+
+  // objects created while instantiating, indexed as subtrees_ and nodes_
+  struct BuildState
+  {
+    std::vector<Tree::Subtree::Ptr>* subtrees_out = nullptr;
+    std::vector<Tree::Subtree*> subtrees;
+    std::vector<TreeNode*> nodes;
+    std::vector<LazySubTreeNode*> lazy_nodes;
+  };
+
+  /// Create the nodes [begin, end) and their subtrees. The parents of the
+  /// first records of the range must be in state.nodes already.
+  void buildNodes(size_t begin, size_t end, BuildState& state,
+                  const std::shared_ptr<const TreeTemplate>* self,
+                  const LazyOptionsPtr& lazy) const;
+
+  static bool substitutionApplies(const TreeNode& node,
+                                  const CompiledSubstitutionRules& rules)
+  {
+    return rules.find(node.name(), node.registrationName(), node.fullPath()) != nullptr;
+  }
+
+  void recordNode(TreeNode* node, int parent,
+                  const std::unordered_map<const TreeNode*, int>& subtree_of_node,
+                  const CompiledSubstitutionRules& rules, StringPool& pool)
+  {
+    NodeRecord record;
+    record.name = pool.intern(node->name());
+    record.registration_ID = pool.intern(node->registrationName());
+    record.config = node->config();
+    record.config.blackboard.reset();
+    // the prototype may point to the manifests of the factory, that can change
+    auto manifest_it = manifests_->find(record.registration_ID.str());
+    record.config.manifest = manifest_it != manifests_->end() ? &manifest_it->second : nullptr;
+    record.parent = parent;
+    record.subtree = subtree_of_node.at(node);
+    record.pre_scripts = node->preConditionsScripts();
+    record.post_scripts = node->postConditionsScripts();
+
+    if (!substitutionApplies(*node, rules))
+    {
+      const auto& builders = factory_->builders();
+      auto it = builders.find(record.registration_ID.str());
+      if (it == builders.end())
+      {
+        throw RuntimeError("TreeTemplate: builder not found for [",
+                           record.registration_ID.str(), "]");
+      }
+      record.builder = &it->second;
+    }
+    if (auto subtree_node = dynamic_cast<SubTreeNode*>(node))
+    {
+      record.subtree_ID = pool.intern(subtree_node->subtreeID());
+    }
+
+    const int index = int(nodes_.size());
+    if (auto control = dynamic_cast<ControlNode*>(node))
+    {
+      record.kind = NodeKind::CONTROL;
+      nodes_.push_back(std::move(record));
+      for (auto child : control->children())
+      {
+        recordNode(child, index, subtree_of_node, rules, pool);
+      }
+    }
+    else if (auto decorator = dynamic_cast<DecoratorNode*>(node))
+    {
+      record.kind = NodeKind::DECORATOR;
+      nodes_.push_back(std::move(record));
+      if (auto child = decorator->child())
+      {
+        recordNode(child, index, subtree_of_node, rules, pool);
+      }
+    }
+    else
+    {
+      nodes_.push_back(std::move(record));
+    }
+  }
+};
+
+/**
+ * @brief LazySubTreeNode is a SubTreeNode that creates its subtree (nodes and
+ * blackboards) the first time it is ticked, from a TreeTemplate.
+ * See TreeTemplate::instantiate(tmpl, blackboard, options).
+ *
+ * The lazy nodes are not in Tree::subtrees: loggers and observers created
+ * before the first tick don't see them. With LazySubtreeOptions::release_after,
+ * ReleaseIdleSubtrees() destroys the subtrees that are not used; the keys of
+ * their blackboards are lost, unless remapped to the parent.
+ */
+class LazySubTreeNode : public SubTreeNode
+{
+public:
+  LazySubTreeNode(const std::string& name, const NodeConfig& config,
+                  std::shared_ptr<const TreeTemplate> tmpl, size_t record,
+                  std::shared_ptr<const LazySubtreeOptions> options) :
+    SubTreeNode(name, config),
+    template_(std::move(tmpl)),
+    record_(record),
+    options_(std::move(options))
+  {}
+
+  ~LazySubTreeNode() override = default;
+
+  NodeStatus tick() override
+  {
+    if (!child_node_)
+    {
+      instantiateSubtree();
+    }
+    last_tick_ = std::chrono::steady_clock::now();
+    return SubTreeNode::tick();
+  }
+
+  void halt() override
+  {
+    if (!child_node_)
+    {
+      resetStatus();
+      return;
+    }
+    SubTreeNode::halt();
+  }
+
+  /// True if the subtree was created and not released.
+  [[nodiscard]] bool instantiated() const
+  {
+    return child_node_ != nullptr;
+  }
+
+  /// Destroy the subtree, if it is IDLE. It will be created again by the next tick.
+  bool release()
+  {
+    if (!child_node_ || status() != NodeStatus::IDLE)
+    {
+      return false;
+    }
+    child_node_ = nullptr;
+    subtrees_.clear();
+    return true;
+  }
+
+  /// release() if it was not ticked for LazySubtreeOptions::release_after.
+  bool releaseIfIdle(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now())
+  {
+    if (options_->release_after.count() <= 0 || now - last_tick_ < options_->release_after)
+    {
+      return false;
+    }
+    return release();
+  }
+
+  /// Subtrees created by this node, including the nested ones that are not lazy.
+  [[nodiscard]] const std::vector<Tree::Subtree::Ptr>& subtrees() const
+  {
+    return subtrees_;
+  }
+
+private:
+  friend class TreeTemplate;
+
+  void instantiateSubtree();
+
+  std::shared_ptr<const TreeTemplate> template_;
+  size_t record_;
+  std::shared_ptr<const LazySubtreeOptions> options_;
+  std::chrono::steady_clock::time_point last_tick_ = {};
+  std::shared_ptr<WakeUpSignal> wake_up_signal_;
+  std::vector<Tree::Subtree::Ptr> subtrees_;
+};
+
+/**
+ * @brief Invoke LazySubTreeNode::releaseIfIdle() for all the lazy subtrees of the tree.
+ * Call it periodically, between two ticks.
+ * @return number of subtrees released.
+ */
+inline size_t ReleaseIdleSubtrees(const Tree& tree)
+{
+  std::vector<LazySubTreeNode*> lazy_nodes;
+  applyRecursiveVisitor(tree.rootNode(), [&lazy_nodes](TreeNode* node) {
+    if (auto lazy = dynamic_cast<LazySubTreeNode*>(node))
+    {
+      lazy_nodes.push_back(lazy);
+    }
+  });
+  const auto now = std::chrono::steady_clock::now();
+  size_t released = 0;
+  // nested subtrees first: releasing a node destroys the ones it contains
+  for (auto it = lazy_nodes.rbegin(); it != lazy_nodes.rend(); ++it)
+  {
+    released += (*it)->releaseIfIdle(now) ? 1 : 0;
+  }
+  return released;
+}
+
+//--------------------------------------------
+
+inline bool TreeTemplate::isLazy(const NodeRecord& record, const LazyOptionsPtr& lazy) const
+{
+  if (!lazy || record.subtree_ID.empty() || !record.builder)
+  {
+    return false;
+  }
+  for (const auto& filter : lazy->filters)
+  {
+    if (filter == record.subtree_ID.str() || WildcardMatch(record.config.path, filter))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline Tree::Subtree::Ptr TreeTemplate::createSubtree(size_t index,
+                                                      const Blackboard::Ptr& parent_bb) const
+{
+  const auto& record = subtrees_[index];
+  auto subtree = makeSubtree();
+  subtree->instance_name = record.instance_name.str();
+  subtree->tree_ID = record.tree_ID.str();
+  auto bb = Blackboard::create(parent_bb);
+  bb->internal_to_external_ = record.remapping;
+  bb->autoremapping_ = record.autoremapping;
+  for (const auto& entry : record.entries)
+  {
+    if (!entry.remapped)
+    {
+      bb->storage_.emplace(entry.key.str(),
+                           std::make_shared<Blackboard::Entry>(Any(entry.value), entry.info));
+    }
+  }
+  // after the local ones: createEntry() shares the entry of the parent,
+  // creating it if needed, as BehaviorTreeFactory::createTree does
+  for (const auto& entry : record.entries)
+  {
+    if (entry.remapped)
+    {
+      bb->createEntry(entry.key.str(), entry.info);
+    }
+  }
+  subtree->blackboard = std::move(bb);
+  return subtree;
+}
+
+inline void TreeTemplate::buildNodes(size_t begin, size_t end, BuildState& state,
+                                     const std::shared_ptr<const TreeTemplate>* self,
+                                     const LazyOptionsPtr& lazy) const
+{
+  for (size_t index = begin; index < end; index++)
+  {
+    const auto& record = nodes_[index];
+    Tree::Subtree* subtree = state.subtrees[size_t(record.subtree)];
+    if (!subtree)
+    {
+      // parents are created before their children
+      const int parent = subtrees_[size_t(record.subtree)].parent;
+      auto new_subtree = createSubtree(
+          size_t(record.subtree),
+          parent >= 0 ? state.subtrees[size_t(parent)]->blackboard : Blackboard::Ptr());
+      subtree = new_subtree.get();
+      state.subtrees[size_t(record.subtree)] = subtree;
+      state.subtrees_out->push_back(std::move(new_subtree));
+    }
+
+    NodeConfig config = record.config;
+    config.blackboard = subtree->blackboard;
+
+    const bool lazy_node = isLazy(record, lazy);
+    std::unique_ptr<TreeNode> node;
+    if (lazy_node)
+    {
+      auto lazy_ptr =
+          std::make_unique<LazySubTreeNode>(record.name.str(), config, *self, index, lazy);
+      state.lazy_nodes.push_back(lazy_ptr.get());
+      node = std::move(lazy_ptr);
+    }
+    else if (record.builder)
+    {
+      node = (*record.builder)(record.name.str(), config);
+    }
+    else
+    {
+      // a substitution rule applies to this node
+      node = factory_->instantiateTreeNode(record.name.str(), record.registration_ID.str(),
+                                           config);
+    }
+    if (lazy_node || record.builder)
+    {
+      node->setRegistrationID(record.registration_ID.str());
+      node->preConditionsScripts() = record.pre_scripts;
+      node->postConditionsScripts() = record.post_scripts;
+    }
+
+    if (!record.subtree_ID.empty())
+    {
+      static_cast<SubTreeNode*>(node.get())->setSubtreeID(record.subtree_ID.str());
+    }
+    if (record.parent >= 0)
+    {
+      const auto& parent_record = nodes_[size_t(record.parent)];
+      TreeNode* parent = state.nodes[size_t(record.parent)];
+      if (parent_record.kind == NodeKind::CONTROL)
+      {
+        static_cast<ControlNode*>(parent)->addChild(node.get());
+      }
+      else
+      {
+        static_cast<DecoratorNode*>(parent)->setChild(node.get());
+      }
+    }
+    state.nodes[index] = node.get();
+    subtree->nodes.push_back(std::move(node));
+
+    if (lazy_node)
+    {
+      // the subtree is created by LazySubTreeNode::tick()
+      index = descendantsEnd(index) - 1;
+    }
+  }
+}
+
+inline Tree TreeTemplate::instantiateImpl(const std::shared_ptr<const TreeTemplate>* self,
+                                          Blackboard::Ptr blackboard,
+                                          const LazyOptionsPtr& lazy) const
+{
+  if (!factory_)
+  {
+    throw RuntimeError("TreeTemplate::instantiate: the template is empty");
+  }
+  Tree tree;
+  tree.subtrees.reserve(subtrees_.size());
+
+  BuildState state;
+  state.subtrees_out = &tree.subtrees;
+  state.subtrees.resize(subtrees_.size(), nullptr);
+  state.nodes.resize(nodes_.size(), nullptr);
+
+  if (!subtrees_.empty())
+  {
+    const auto& record = subtrees_.front();
+    auto subtree = makeSubtree();
+    subtree->instance_name = record.instance_name.str();
+    subtree->tree_ID = record.tree_ID.str();
+    subtree->blackboard = blackboard;
+    for (const auto& entry : record.entries)
+    {
+      if (!blackboard->getEntry(entry.key.str()))
+      {
+        blackboard->createEntry(entry.key.str(), entry.info);
+      }
+    }
+    state.subtrees[0] = subtree.get();
+    tree.subtrees.push_back(std::move(subtree));
+  }
+  if (!lazy)
+  {
+    // same order of BehaviorTreeFactory::createTree
+    for (size_t index = 1; index < subtrees_.size(); index++)
+    {
+      const int parent = subtrees_[index].parent;
+      auto subtree = createSubtree(
+          index, parent >= 0 ? state.subtrees[size_t(parent)]->blackboard : Blackboard::Ptr());
+      state.subtrees[index] = subtree.get();
+      tree.subtrees.push_back(std::move(subtree));
+    }
+  }
+
+  buildNodes(0, nodes_.size(), state, self, lazy);
+
+  // as createTree: Tree::getUID() continues after the UIDs of the nodes,
+  // the ones of the lazy subtrees included
+  size_t next_uid = 0;
+  for (const auto& record : nodes_)
+  {
+    next_uid = std::max(next_uid, size_t(record.config.uid) + 1);
+  }
+  tree.uid_counter_ = uint16_t(next_uid);
+
+  tree.initialize();
+  for (auto* lazy_node : state.lazy_nodes)
+  {
+    lazy_node->wake_up_signal_ = tree.wake_up_;
+  }
+  return tree;
+}
+
+inline void LazySubTreeNode::instantiateSubtree()
+{
+  const TreeTemplate& tmpl = *template_;
+  const auto& record = tmpl.nodes_[record_];
+
+  std::vector<Tree::Subtree::Ptr> subtrees;
+  // the Subtree that contains this node, only to provide the parent blackboard
+  Tree::Subtree parent;
+  parent.blackboard = config().blackboard;
+
+  TreeTemplate::BuildState state;
+  state.subtrees_out = &subtrees;
+  state.subtrees.resize(tmpl.subtrees_.size(), nullptr);
+  state.subtrees[size_t(record.subtree)] = &parent;
+  state.nodes.resize(tmpl.nodes_.size(), nullptr);
+  state.nodes[record_] = this;
+
+  // the nested lazy subtrees remain lazy
+  tmpl.buildNodes(record_ + 1, tmpl.descendantsEnd(record_), state, &template_, options_);
+
+  for (auto& subtree : subtrees)
+  {
+    for (auto& node : subtree->nodes)
+    {
+      TreeTemplate::setWakeUpInstance(*node, wake_up_signal_);
+    }
+  }
+  for (auto* lazy_node : state.lazy_nodes)
+  {
+    lazy_node->wake_up_signal_ = wake_up_signal_;
+  }
+  subtrees_ = std::move(subtrees);
+}
+
+//--------------------------------------------
+
+inline flatbuffers::Offset<Serialization::TreeRecord>
+TreeTemplate::serialize(flatbuffers::FlatBufferBuilder& builder,
+                        const std::string& tree_ID) const
+{
+  using StringPairOffset = flatbuffers::Offset<Serialization::StringPair>;
+  auto serializePorts = [&builder](const PortsRemapping& ports) {
+    std::vector<StringPairOffset> out;
+    out.reserve(ports.size());
+    for (const auto& [key, value] : ports)
+    {
+      out.push_back(Serialization::CreateStringPair(builder, builder.CreateString(key),
+                                                    builder.CreateString(value)));
+    }
+    return builder.CreateVector(out);
+  };
+  auto serializeRemapping = [&builder](const std::unordered_map<std::string, std::string>& remap) {
+    std::vector<StringPairOffset> out;
+    out.reserve(remap.size());
+    for (const auto& [key, value] : remap)
+    {
+      out.push_back(Serialization::CreateStringPair(builder, builder.CreateString(key),
+                                                    builder.CreateString(value)));
+    }
+    return builder.CreateVector(out);
+  };
+  auto serializeConditions = [&builder](const auto& conditions) {
+    std::vector<flatbuffers::Offset<Serialization::ConditionScript>> out;
+    for (const auto& [id, script] : conditions)
+    {
+      out.push_back(Serialization::CreateConditionScript(builder, int8_t(id),
+                                                         builder.CreateString(script)));
+    }
+    return builder.CreateVector(out);
+  };
+
+  // the port that uses each blackboard key, for each subtree
+  std::vector<std::unordered_map<std::string, std::pair<std::string, std::string>>> typed_keys(
+      subtrees_.size());
+  for (const auto& node : nodes_)
+  {
+    auto& keys = typed_keys[size_t(node.subtree)];
+    for (const auto* ports : { &node.config.input_ports, &node.config.output_ports })
+    {
+      for (const auto& [port_name, value] : *ports)
+      {
+        StringView key;
+        if (TreeNode::isBlackboardPointer(value, &key))
+        {
+          std::string key_str = (key == "=") ? port_name : std::string(key);
+          keys.emplace(std::move(key_str),
+                       std::make_pair(node.registration_ID.str(), port_name));
+        }
+      }
+    }
+  }
+
+  std::vector<flatbuffers::Offset<Serialization::SubtreeRecord>> subtrees;
+  subtrees.reserve(subtrees_.size());
+  for (size_t index = 0; index < subtrees_.size(); index++)
+  {
+    const auto& record = subtrees_[index];
+    std::vector<flatbuffers::Offset<Serialization::EntryRecord>> entries;
+    for (const auto& entry : record.entries)
+    {
+      flatbuffers::Offset<flatbuffers::String> node_ID = 0;
+      flatbuffers::Offset<flatbuffers::String> port_name = 0;
+      flatbuffers::Offset<flatbuffers::String> literal = 0;
+      auto it = typed_keys[index].find(entry.key.str());
+      if (it != typed_keys[index].end())
+      {
+        node_ID = builder.CreateString(it->second.first);
+        port_name = builder.CreateString(it->second.second);
+      }
+      if (!entry.value.empty() && entry.value.isString())
+      {
+        // values assigned by the attributes of <SubTree>
+        literal = builder.CreateString(entry.value.cast<std::string>());
+      }
+      entries.push_back(Serialization::CreateEntryRecord(
+          builder, builder.CreateString(entry.key.str()), node_ID, port_name, literal));
+    }
+    subtrees.push_back(Serialization::CreateSubtreeRecord(
+        builder, builder.CreateString(record.instance_name.str()),
+        builder.CreateString(record.tree_ID.str()), record.parent,
+        serializeRemapping(record.remapping), record.autoremapping,
+        builder.CreateVector(entries)));
+  }
+
+  std::vector<flatbuffers::Offset<Serialization::NodeRecord>> nodes;
+  nodes.reserve(nodes_.size());
+  for (const auto& node : nodes_)
+  {
+    nodes.push_back(Serialization::CreateNodeRecord(
+        builder, builder.CreateString(node.name.str()),
+        builder.CreateString(node.registration_ID.str()),
+        builder.CreateString(node.config.path), node.config.uid, int8_t(node.kind),
+        node.parent, node.subtree, builder.CreateString(node.subtree_ID.str()),
+        serializePorts(node.config.input_ports), serializePorts(node.config.output_ports),
+        serializeConditions(node.config.pre_conditions),
+        serializeConditions(node.config.post_conditions)));
+  }
+
+  return Serialization::CreateTreeRecord(builder, builder.CreateString(tree_ID),
+                                         builder.CreateVector(subtrees),
+                                         builder.CreateVector(nodes));
+}
+
+inline TreeTemplate TreeTemplate::deserialize(const FactoryExtensions& extensions,
+                                              const Serialization::TreeRecord& record)
+{
+  auto str = [](const flatbuffers::String* value) {
+    return value ? value->str() : std::string();
+  };
+  StringPool& pool = *extensions.stringPool();
+  TreeTemplate tmpl;
+  tmpl.factory_ = &extensions.factory();
+  tmpl.manifests_ = extensions.sharedManifests();
+  const auto& manifests = *tmpl.manifests_;
+
+  if (record.subtrees())
+  {
+    for (const auto* subtree : *record.subtrees())
+    {
+      if (subtree->parent() >= int(tmpl.subtrees_.size()))
+      {
+        throw RuntimeError("TreeTemplate: invalid record of the tree [",
+                           str(record.tree_id()), "]");
+      }
+      SubtreeRecord out;
+      out.instance_name = pool.intern(str(subtree->instance_name()));
+      out.tree_ID = pool.intern(str(subtree->tree_id()));
+      out.parent = subtree->parent();
+      out.autoremapping = subtree->autoremap();
+      if (subtree->remapping())
+      {
+        for (const auto* pair : *subtree->remapping())
+        {
+          out.remapping.insert({ str(pair->key()), str(pair->value()) });
+        }
+      }
+      if (subtree->entries())
+      {
+        for (const auto* entry : *subtree->entries())
+        {
+          EntryRecord entry_out;
+          entry_out.key = pool.intern(str(entry->key()));
+          if (entry->node_id() && entry->port_name())
+          {
+            auto manifest_it = manifests.find(entry->node_id()->str());
+            if (manifest_it != manifests.end())
+            {
+              auto port_it = manifest_it->second.ports.find(entry->port_name()->str());
+              if (port_it != manifest_it->second.ports.end())
+              {
+                entry_out.info = port_it->second;
+              }
+            }
+          }
+          if (entry->literal())
+          {
+            entry_out.value = Any(entry->literal()->str());
+          }
+          // the serialized record doesn't say it: same rules of Blackboard::createEntry()
+          const auto& key = entry_out.key.str();
+          entry_out.remapped = out.parent >= 0 &&
+                               (out.remapping.count(key) != 0 ||
+                                (out.autoremapping && !key.empty() && key.front() != '_'));
+          out.entries.push_back(std::move(entry_out));
+        }
+      }
+      tmpl.subtrees_.push_back(std::move(out));
+    }
+  }
+
+  if (record.nodes())
+  {
+    details::CheckMaxNodes(record.nodes()->size(), "TreeTemplate::deserialize");
+    const auto rules = extensions.compiledSubstitutionRules();
+    const auto& builders = tmpl.factory_->builders();
+    ScriptCache& script_cache = *extensions.scriptCache();
+    auto parseCondition = [&script_cache](const std::string& script) {
+      auto executor = script_cache.get(script);
+      if (!executor)
+      {
+        throw RuntimeError("TreeTemplate: invalid condition [", script,
+                           "]: ", executor.error());
+      }
+      return executor.value();
+    };
+    tmpl.nodes_.reserve(record.nodes()->size());
+    for (const auto* node : *record.nodes())
+    {
+      const int parent = node->parent();
+      const int subtree = node->subtree();
+      if (parent >= int(tmpl.nodes_.size()) || subtree < 0 ||
+          subtree >= int(tmpl.subtrees_.size()) || node->kind() < 0 ||
+          node->kind() > int8_t(NodeKind::DECORATOR) ||
+          (parent >= 0 && tmpl.nodes_[size_t(parent)].kind == NodeKind::LEAF))
+      {
+        throw RuntimeError("TreeTemplate: invalid record of the tree [",
+                           str(record.tree_id()), "]");
+      }
+      NodeRecord out;
+      out.name = pool.intern(str(node->name()));
+      out.registration_ID = pool.intern(str(node->registration_id()));
+      out.kind = NodeKind(node->kind());
+      out.parent = parent;
+      out.subtree = subtree;
+      out.subtree_ID = pool.intern(str(node->subtree_id()));
+
+      NodeConfig& config = out.config;
+      config.uid = node->uid();
+      config.path = str(node->path());
+      auto manifest_it = manifests.find(out.registration_ID.str());
+      if (manifest_it != manifests.end())
+      {
+        config.manifest = &manifest_it->second;
+      }
+      if (node->input_ports())
+      {
+        for (const auto* pair : *node->input_ports())
+        {
+          config.input_ports.insert({ str(pair->key()), str(pair->value()) });
+        }
+      }
+      if (node->output_ports())
+      {
+        for (const auto* pair : *node->output_ports())
+        {
+          config.output_ports.insert({ str(pair->key()), str(pair->value()) });
+        }
+      }
+      if (node->pre_conditions())
+      {
+        for (const auto* condition : *node->pre_conditions())
+        {
+          config.pre_conditions.insert(
+              { PreCond(condition->condition()), str(condition->script()) });
+        }
+      }
+      if (node->post_conditions())
+      {
+        for (const auto* condition : *node->post_conditions())
+        {
+          config.post_conditions.insert(
+              { PostCond(condition->condition()), str(condition->script()) });
+        }
+      }
+
+      // otherwise, created by instantiateTreeNode(), that also parses the scripts
+      if (!rules->find(out.name.str(), out.registration_ID.str(), config.path))
+      {
+        auto builder_it = builders.find(out.registration_ID.str());
+        if (builder_it == builders.end())
+        {
+          throw RuntimeError("TreeTemplate: builder not found for [",
+                             out.registration_ID.str(), "]");
+        }
+        out.builder = &builder_it->second;
+        for (const auto& [id, script] : config.pre_conditions)
+        {
+          out.pre_scripts[size_t(id)] = parseCondition(script);
+        }
+        for (const auto& [id, script] : config.post_conditions)
+        {
+          out.post_scripts[size_t(id)] = parseCondition(script);
+        }
+      }
+      tmpl.nodes_.push_back(std::move(out));
+    }
+  }
+  return tmpl;
+}
+
+//--------------------------------------------
+
+inline void FactoryExtensions::registerBehaviorTreeFromBinary(const void* data, size_t size)
+{
+  flatbuffers::Verifier verifier(static_cast<const uint8_t*>(data), size);
+  if (!Serialization::VerifyTreeSetBuffer(verifier))
+  {
+    throw RuntimeError("registerBehaviorTreeFromBinary: invalid binary");
+  }
+  const auto* tree_set = Serialization::GetTreeSet(data);
+  if (tree_set->version() != PRECOMPILED_TREES_VERSION)
+  {
+    throw RuntimeError("registerBehaviorTreeFromBinary: version ",
+                       std::to_string(tree_set->version()), " is not supported");
+  }
+  if (!tree_set->trees())
+  {
+    return;
+  }
+  // validate everything before registering
+  std::vector<std::pair<std::string, std::shared_ptr<const TreeTemplate>>> loaded;
+  for (const auto* tree : *tree_set->trees())
+  {
+    std::string tree_ID = tree->tree_id() ? tree->tree_id()->str() : std::string();
+    loaded.emplace_back(std::move(tree_ID), std::make_shared<const TreeTemplate>(
+                                                TreeTemplate::deserialize(*this, *tree)));
+  }
+  for (auto& [tree_ID, tmpl] : loaded)
+  {
+    precompiled_trees_[tree_ID] = std::move(tmpl);
+  }
+}
+
+inline void
+FactoryExtensions::registerBehaviorTreeFromBinary(const std::filesystem::path& filename)
+{
+#if defined(BT_TREE_TEMPLATE_MMAP)
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw RuntimeError("registerBehaviorTreeFromBinary: can't open [", filename.string(),
+                       "]");
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0)
+  {
+    ::close(fd);
+    throw RuntimeError("registerBehaviorTreeFromBinary: invalid file [",
+                       filename.string(), "]");
+  }
+  const size_t size = size_t(info.st_size);
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    throw RuntimeError("registerBehaviorTreeFromBinary: can't map [", filename.string(),
+                       "]");
+  }
+  try
+  {
+    registerBehaviorTreeFromBinary(data, size);
+  }
+  catch (...)
+  {
+    munmap(data, size);
+    throw;
+  }
+  // the strings are copied in the StringPool
+  munmap(data, size);
+#else
+  std::ifstream file(filename, std::ios::binary);
+  if (!file)
+  {
+    throw RuntimeError("registerBehaviorTreeFromBinary: can't open [", filename.string(),
+                       "]");
+  }
+  std::vector<char> buffer((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+  registerBehaviorTreeFromBinary(buffer.data(), buffer.size());
+#endif
+}
+
+inline std::vector<std::string> FactoryExtensions::registeredPrecompiledTrees() const
+{
+  std::vector<std::string> out;
+  out.reserve(precompiled_trees_.size());
+  for (const auto& [tree_ID, tmpl] : precompiled_trees_)
+  {
+    out.push_back(tree_ID);
+  }
+  std::sort(out.begin(), out.end());
+  return out;
+}
+
+inline Tree FactoryExtensions::createPrecompiledTree(const std::string& tree_name,
+                                                     Blackboard::Ptr blackboard)
+{
+  auto it = precompiled_trees_.find(tree_name);
+  if (it == precompiled_trees_.end())
+  {
+    throw RuntimeError("createPrecompiledTree: the tree [", tree_name,
+                       "] was not registered with registerBehaviorTreeFromBinary");
+  }
+  return it->second->instantiate(std::move(blackboard));
+}
+
+inline Tree FactoryExtensions::createPrecompiledTree(const std::string& tree_name,
+                                                     Blackboard::Ptr blackboard,
+                                                     const LazySubtreeOptions& lazy_options)
+{
+  auto it = precompiled_trees_.find(tree_name);
+  if (it == precompiled_trees_.end())
+  {
+    throw RuntimeError("createPrecompiledTree: the tree [", tree_name,
+                       "] was not registered with registerBehaviorTreeFromBinary");
+  }
+  return TreeTemplate::instantiate(it->second, std::move(blackboard), lazy_options);
+}
+
+}   // namespace BT
+
+#undef BT_TREE_TEMPLATE_MMAP
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace BT
+{
+
+/**
+ * @brief Counters of the heap allocations done by the current thread.
+ *
+ * They are updated by the replacement of the global operator new and delete
+ * defined by BTCPP_ALLOCATION_COUNTER_HOOKS(), that must be expanded in exactly
+ * one translation unit of the executable (typically the one of main() of a test):
+ *
+ *   #include "behaviortree_cpp/utils/allocation_counter.hpp"
+ *   BTCPP_ALLOCATION_COUNTER_HOOKS()
+ *
+ * Without the hooks the counters are always zero: check hooksInstalled().
+ */
+struct AllocationCounter
+{
+  struct Counters
+  {
+    uint64_t allocations = 0;
+    uint64_t deallocations = 0;
+    uint64_t bytes = 0;
+  };
+
+  /// Counters of the current thread, since it was started
+  [[nodiscard]] static Counters& thread()
+  {
+    static thread_local Counters counters;
+    return counters;
+  }
+
+  [[nodiscard]] static bool hooksInstalled()
+  {
+    return installedFlag();
+  }
+
+  static void recordAllocation(size_t size)
+  {
+    auto& counters = thread();
+    counters.allocations++;
+    counters.bytes += size;
+  }
+
+  static void recordDeallocation()
+  {
+    thread().deallocations++;
+  }
+
+  static bool& installedFlag()
+  {
+    static bool installed = false;
+    return installed;
+  }
+};
+
+/**
+ * @brief Count the allocations of the current thread during the lifetime of the scope.
+ *
+ *   AllocationScope scope;
+ *   tree.tickOnce();
+ *   assert(scope.allocations() == 0);
+ */
+class AllocationScope
+{
+public:
+  AllocationScope() : start_(AllocationCounter::thread())
+  {}
+
+  [[nodiscard]] uint64_t allocations() const
+  {
+    return AllocationCounter::thread().allocations - start_.allocations;
+  }
+
+  [[nodiscard]] uint64_t deallocations() const
+  {
+    return AllocationCounter::thread().deallocations - start_.deallocations;
+  }
+
+  [[nodiscard]] uint64_t bytes() const
+  {
+    return AllocationCounter::thread().bytes - start_.bytes;
+  }
+
+  void restart()
+  {
+    start_ = AllocationCounter::thread();
+  }
+
+private:
+  AllocationCounter::Counters start_;
+};
+
+namespace details
+{
+inline void* CountedAlloc(size_t size)
+{
+  BT::AllocationCounter::recordAllocation(size);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+inline void* CountedAlignedAlloc(size_t size, std::align_val_t align)
+{
+  BT::AllocationCounter::recordAllocation(size);
+  const auto alignment = static_cast<size_t>(align);
+  // aligned_alloc requires a size multiple of the alignment
+  const size_t rounded = ((size == 0 ? 1 : size) + alignment - 1) / alignment * alignment;
+  if (void* ptr = std::aligned_alloc(alignment, rounded))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+inline void CountedFree(void* ptr)
+{
+  if (ptr)
+  {
+    BT::AllocationCounter::recordDeallocation();
+    std::free(ptr);
+  }
+}
+
+struct AllocationHooksRegistration
+{
+  AllocationHooksRegistration()
+  {
+    AllocationCounter::installedFlag() = true;
+  }
+};
+}   // namespace details
+
+}   // namespace BT
+
+// clang-format off
+#define BTCPP_ALLOCATION_COUNTER_HOOKS()                                                        \
+  static const BT::details::AllocationHooksRegistration btcpp_allocation_hooks_registration;    \
+  void* operator new(std::size_t size) { return BT::details::CountedAlloc(size); }              \
+  void* operator new[](std::size_t size) { return BT::details::CountedAlloc(size); }            \
+  void* operator new(std::size_t size, const std::nothrow_t&) noexcept                          \
+  { try { return BT::details::CountedAlloc(size); } catch (...) { return nullptr; } }           \
+  void* operator new[](std::size_t size, const std::nothrow_t&) noexcept                        \
+  { try { return BT::details::CountedAlloc(size); } catch (...) { return nullptr; } }           \
+  void* operator new(std::size_t size, std::align_val_t al)                                     \
+  { return BT::details::CountedAlignedAlloc(size, al); }                                        \
+  void* operator new[](std::size_t size, std::align_val_t al)                                   \
+  { return BT::details::CountedAlignedAlloc(size, al); }                                        \
+  void operator delete(void* ptr) noexcept { BT::details::CountedFree(ptr); }                   \
+  void operator delete[](void* ptr) noexcept { BT::details::CountedFree(ptr); }                 \
+  void operator delete(void* ptr, std::size_t) noexcept { BT::details::CountedFree(ptr); }      \
+  void operator delete[](void* ptr, std::size_t) noexcept { BT::details::CountedFree(ptr); }    \
+  void operator delete(void* ptr, std::align_val_t) noexcept { BT::details::CountedFree(ptr); } \
+  void operator delete[](void* ptr, std::align_val_t) noexcept { BT::details::CountedFree(ptr); } \
+  void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept                       \
+  { BT::details::CountedFree(ptr); }                                                            \
+  void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept                     \
+  { BT::details::CountedFree(ptr); }
+// clang-format on
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+
+namespace BT
+{
+
+/**
+ * @brief MonotonicArena is a bump allocator: memory is taken from large
+ * chunks, in the order of allocation, and released all at once.
+ *
+ * The memory is NOT released when the MonotonicArena object is destroyed,
+ * but when both the arena and all the objects allocated from it are gone.
+ * For this reason, it is safe to destroy an object allocated in the arena
+ * (for instance a Blackboard shared with the user) later than the others.
+ *
+ * Allocation is not thread-safe; it is meant to be used by a single thread,
+ * through ArenaScope. Deallocation is thread-safe.
+ */
+class MonotonicArena
+{
+public:
+  static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+  struct Statistics
+  {
+    size_t chunks = 0;
+    size_t bytes_reserved = 0;
+    size_t bytes_used = 0;
+    size_t allocations = 0;
+    /// Objects allocated in the arena and not destroyed yet.
+    size_t live_allocations = 0;
+  };
+
+  explicit MonotonicArena(size_t chunk_size = DEFAULT_CHUNK_SIZE) :
+    state_(new State(chunk_size))
+  {}
+
+  MonotonicArena(const MonotonicArena&) = delete;
+  MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+  ~MonotonicArena()
+  {
+    state_->unref();
+  }
+
+  [[nodiscard]] Statistics statistics() const
+  {
+    Statistics stats = state_->stats;
+    // the arena itself holds one reference
+    stats.live_allocations = state_->refs.load(std::memory_order_relaxed) - 1;
+    return stats;
+  }
+
+private:
+  friend void ArenaDeallocate(void* ptr) noexcept;
+  friend void* ArenaAllocate(size_t size, size_t alignment);
+
+  struct State
+  {
+    explicit State(size_t size) : chunk_size(std::max<size_t>(size, 256))
+    {}
+
+    ~State()
+    {
+      for (auto chunk : chunks)
+      {
+        ::operator delete(chunk);
+      }
+    }
+
+    const size_t chunk_size;
+    std::vector<void*> chunks;
+    char* current = nullptr;
+    size_t available = 0;
+    Statistics stats;
+    std::atomic<size_t> refs = 1;
+
+    void* allocate(size_t size, size_t alignment)
+    {
+      auto align_forward = [alignment](char* ptr) {
+        const auto addr = reinterpret_cast<std::uintptr_t>(ptr);
+        return static_cast<size_t>((alignment - addr % alignment) % alignment);
+      };
+      size_t padding = current ? align_forward(current) : 0;
+      if (!current || padding + size > available)
+      {
+        const size_t chunk_bytes = std::max(chunk_size, size + alignment);
+        current = static_cast<char*>(::operator new(chunk_bytes));
+        chunks.push_back(current);
+        available = chunk_bytes;
+        padding = align_forward(current);
+        stats.chunks++;
+        stats.bytes_reserved += chunk_bytes;
+      }
+      char* ptr = current + padding;
+      current = ptr + size;
+      available -= padding + size;
+      stats.bytes_used += size;
+      stats.allocations++;
+      return ptr;
+    }
+
+    void unref() noexcept
+    {
+      if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      {
+        delete this;
+      }
+    }
+  };
+
+  // Placed right before each object allocated by ArenaAllocate()
+  struct alignas(std::max_align_t) Header
+  {
+    State* state;   // nullptr if allocated on the heap
+    size_t prefix;  // also the alignment of the allocation
+  };
+
+  State* state_;
+
+  static MonotonicArena*& currentArena()
+  {
+    thread_local MonotonicArena* arena = nullptr;
+    return arena;
+  }
+
+  friend class ArenaScope;
+};
+
+/**
+ * @brief While an ArenaScope is alive, the objects allocated with
+ * ArenaAllocate() by the current thread (in particular the nodes that use
+ * BT_ARENA_ALLOCATED_CLASS) are taken from the given arena.
+ *
+ * Scopes can be nested; the destructor restores the previous arena.
+ */
+class ArenaScope
+{
+public:
+  explicit ArenaScope(MonotonicArena& arena) : previous_(MonotonicArena::currentArena())
+  {
+    MonotonicArena::currentArena() = &arena;
+  }
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+  ~ArenaScope()
+  {
+    MonotonicArena::currentArena() = previous_;
+  }
+
+  /// The arena of the innermost scope of this thread, or nullptr.
+  [[nodiscard]] static MonotonicArena* current()
+  {
+    return MonotonicArena::currentArena();
+  }
+
+private:
+  MonotonicArena* previous_;
+};
+
+/**
+ * @brief Allocate memory from the arena of the current ArenaScope, if any,
+ * otherwise from the heap. Must be released with ArenaDeallocate().
+ */
+inline void* ArenaAllocate(size_t size, size_t alignment = alignof(std::max_align_t))
+{
+  using Header = MonotonicArena::Header;
+  // the prefix contains the header and keeps the object aligned
+  const size_t prefix = std::max(alignment, sizeof(Header));
+  alignment = prefix;
+
+  MonotonicArena::State* state = nullptr;
+  char* raw = nullptr;
+  if (auto arena = MonotonicArena::currentArena())
+  {
+    state = arena->state_;
+    raw = static_cast<char*>(state->allocate(prefix + size, alignment));
+    state->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  else
+  {
+    raw = static_cast<char*>(::operator new(prefix + size, std::align_val_t(alignment)));
+  }
+  auto header = reinterpret_cast<Header*>(raw + prefix) - 1;
+  header->state = state;
+  header->prefix = prefix;
+  return raw + prefix;
+}
+
+inline void ArenaDeallocate(void* ptr) noexcept
+{
+  if (!ptr)
+  {
+    return;
+  }
+  using Header = MonotonicArena::Header;
+  auto header = static_cast<Header*>(ptr) - 1;
+  if (header->state)
+  {
+    header->state->unref();
+  }
+  else
+  {
+    const size_t prefix = header->prefix;
+    ::operator delete(static_cast<char*>(ptr) - prefix, std::align_val_t(prefix));
+  }
+}
+
+}   // namespace BT
+
+/**
+ * Add to a class the operators new/delete that use ArenaAllocate().
+ *
+ * Use it only in the classes of the application, for instance its own
+ * TreeNodes, never in a class of the library (TreeNode, Blackboard, the
+ * built-in nodes): their deleting destructors are compiled in the library,
+ * and would release the memory with the global operator delete.
+ */
+#define BT_ARENA_ALLOCATED_CLASS                                                         \
+  static void* operator new(std::size_t size)                                           \
+  {                                                                                      \
+    return BT::ArenaAllocate(size);                                                      \
+  }                                                                                      \
+  static void* operator new(std::size_t size, std::align_val_t alignment)               \
+  {                                                                                      \
+    return BT::ArenaAllocate(size, static_cast<std::size_t>(alignment));                 \
+  }                                                                                      \
+  static void operator delete(void* ptr) noexcept                                        \
+  {                                                                                      \
+    BT::ArenaDeallocate(ptr);                                                            \
+  }                                                                                      \
+  static void operator delete(void* ptr, std::align_val_t) noexcept                      \
+  {                                                                                      \
+    BT::ArenaDeallocate(ptr);                                                            \
+  }
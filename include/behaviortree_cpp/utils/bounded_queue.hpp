@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace BT
+{
+
+/**
+ * @brief BoundedQueue is a lock-free FIFO queue with a fixed capacity,
+ * that can be used by multiple producers and multiple consumers
+ * (D. Vyukov's bounded MPMC queue).
+ *
+ * Memory is allocated once, in the constructor: push and pop never allocate
+ * and never block. The capacity is rounded up to a power of two.
+ *
+ * To share it through the blackboard, use SharedBoundedQueue<T>:
+ * the queue is modified in place by producers and consumers.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity)
+  {
+    size_t size = 2;
+    while (size < capacity)
+    {
+      size *= 2;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; i++)
+    {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  ~BoundedQueue()
+  {
+    const size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+    for (size_t pos = dequeue_pos_.load(std::memory_order_relaxed); pos != end; pos++)
+    {
+      Cell& cell = cells_[pos & mask_];
+      if (cell.constructed)
+      {
+        std::launder(reinterpret_cast<T*>(cell.storage))->~T();
+      }
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  /**
+   * @brief Return false if the queue is full; in that case, value is not moved.
+   * If the constructor of T throws, the slot already claimed is published
+   * empty (consumers skip it) and the exception is rethrown.
+   */
+  template <typename... Args>
+  bool tryEmplace(Args&&... args)
+  {
+    Cell* cell = nullptr;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      cell = &cells_[pos & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+      if (diff == 0)
+      {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    try
+    {
+      new (cell->storage) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      cell->constructed = false;
+      cell->sequence.store(pos + 1, std::memory_order_release);
+      throw;
+    }
+    cell->constructed = true;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPush(const T& value)
+  {
+    return tryEmplace(value);
+  }
+
+  bool tryPush(T&& value)
+  {
+    return tryEmplace(std::move(value));
+  }
+
+  /// Return false if the queue is empty.
+  bool tryPop(T& destination)
+  {
+    Cell* cell = nullptr;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      cell = &cells_[pos & mask_];
+      const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<std::ptrdiff_t>(sequence - (pos + 1));
+      if (diff == 0)
+      {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        {
+          if (cell->constructed)
+          {
+            break;
+          }
+          // the producer failed to construct the value: recycle the slot
+          cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+          pos = dequeue_pos_.load(std::memory_order_relaxed);
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    T* value = std::launder(reinterpret_cast<T*>(cell->storage));
+    destination = std::move(*value);
+    value->~T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Number of elements. It is approximate if other threads are using the queue.
+  [[nodiscard]] size_t size() const
+  {
+    const size_t pushed = enqueue_pos_.load(std::memory_order_acquire);
+    const size_t popped = dequeue_pos_.load(std::memory_order_acquire);
+    return (pushed > popped) ? (pushed - popped) : 0;
+  }
+
+  [[nodiscard]] bool empty() const
+  {
+    return size() == 0;
+  }
+
+  [[nodiscard]] size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+private:
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    // false if the constructor of T threw; written before sequence is published
+    bool constructed = false;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  // keep the two indexes in different cache lines, to avoid false sharing
+  static constexpr size_t CACHE_LINE = 64;
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_ = 0;
+  alignas(CACHE_LINE) std::atomic<size_t> enqueue_pos_ = 0;
+  alignas(CACHE_LINE) std::atomic<size_t> dequeue_pos_ = 0;
+};
+
+template <typename T>
+using SharedBoundedQueue = std::shared_ptr<BoundedQueue<T>>;
+
+}   // namespace BT
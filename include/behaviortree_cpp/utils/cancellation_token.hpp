@@ -0,0 +1,282 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace BT
+{
+
+namespace details
+{
+// shared by a CancellationSource and its tokens
+struct CancellationState
+{
+  std::atomic<bool> cancelled = false;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::chrono::steady_clock::time_point cancel_time;
+  uint64_t next_id = 1;
+  std::unordered_map<uint64_t, std::function<void()>> callbacks;
+  // callback being executed by cancel(), and its thread
+  uint64_t running_id = 0;
+  std::thread::id running_thread;
+  std::condition_variable callback_done;
+
+  void unregister(uint64_t id)
+  {
+    std::unique_lock lk(mutex);
+    callbacks.erase(id);
+    // wait for it, unless the callback unregisters itself
+    callback_done.wait(lk, [&] {
+      return running_id != id || running_thread == std::this_thread::get_id();
+    });
+  }
+};
+}   // namespace details
+
+/**
+ * @brief CancellationToken tells an asynchronous operation that it should stop.
+ *
+ * Unlike a flag that must be polled, a token can also:
+ *
+ * - invoke callbacks when it is cancelled (onCancel()), to abort a request,
+ *   close a socket or cancel a timer;
+ * - interrupt a blocking wait: sleepFor(), or wait() on a condition variable.
+ *
+ * Tokens are cheap to copy and thread-safe. A default constructed token is
+ * never cancelled.
+ */
+class CancellationToken
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  CancellationToken() = default;
+
+  /**
+   * @brief Unregisters the callback when destroyed (waiting for it, if it is
+   * being executed by another thread). Keep it alive while the resources
+   * used by the callback are.
+   */
+  class Registration
+  {
+  public:
+    Registration() = default;
+    Registration(Registration&& other) noexcept = default;
+    Registration& operator=(Registration&& other) noexcept
+    {
+      reset();
+      state_ = std::move(other.state_);
+      id_ = other.id_;
+      return *this;
+    }
+    Registration(const Registration&) = delete;
+    Registration& operator=(const Registration&) = delete;
+
+    ~Registration()
+    {
+      reset();
+    }
+
+    void reset()
+    {
+      if (auto state = std::move(state_))
+      {
+        state->unregister(id_);
+      }
+    }
+
+  private:
+    friend class CancellationToken;
+    std::shared_ptr<details::CancellationState> state_;
+    uint64_t id_ = 0;
+  };
+
+  [[nodiscard]] bool isCancelled() const
+  {
+    return state_ && state_->cancelled.load(std::memory_order_acquire);
+  }
+
+  explicit operator bool() const
+  {
+    return isCancelled();
+  }
+
+  /**
+   * @brief Invoke the callback when the token is cancelled, by the thread
+   * that calls CancellationSource::cancel(). If it was already cancelled,
+   * the callback is invoked immediately by this thread.
+   */
+  [[nodiscard]] Registration onCancel(std::function<void()> callback) const;
+
+  /// Sleep, returning early if the token is cancelled.
+  /// @return true if it was cancelled.
+  bool sleepFor(Clock::duration duration) const;
+
+  /**
+   * @brief Same as cv.wait(lock, pred), but it returns also when the token
+   * is cancelled. The mutex of the lock must be the one used to notify cv.
+   *
+   * @return the value of pred(), i.e. false if it returned because of the
+   * cancellation.
+   */
+  template <typename Predicate>
+  bool wait(std::condition_variable& cv, std::unique_lock<std::mutex>& lock,
+            Predicate pred) const
+  {
+    if (!state_)
+    {
+      cv.wait(lock, pred);
+      return true;
+    }
+    std::mutex* mutex = lock.mutex();
+    auto registration = onCancelUnlocked(lock, [&cv, mutex]() {
+      // locking the mutex, the waiter is either before the check of the
+      // predicate or inside wait(): the notification is not lost
+      std::lock_guard<std::mutex> lk(*mutex);
+      cv.notify_all();
+    });
+    cv.wait(lock, [&] { return pred() || isCancelled(); });
+    // unregister without holding the mutex needed by the callback
+    lock.unlock();
+    registration.reset();
+    lock.lock();
+    return pred();
+  }
+
+  /// Time when the token was cancelled, or Clock::time_point() if it wasn't.
+  [[nodiscard]] Clock::time_point cancelTime() const;
+
+private:
+  friend class CancellationSource;
+  std::shared_ptr<details::CancellationState> state_;
+
+  explicit CancellationToken(std::shared_ptr<details::CancellationState> state) :
+    state_(std::move(state))
+  {}
+
+  // onCancel() that releases the lock if the callback must be invoked immediately
+  template <typename Callback>
+  Registration onCancelUnlocked(std::unique_lock<std::mutex>& lock, Callback callback) const
+  {
+    if (isCancelled())
+    {
+      return {};
+    }
+    lock.unlock();
+    auto registration = onCancel(std::move(callback));
+    lock.lock();
+    return registration;
+  }
+};
+
+/**
+ * @brief CancellationSource creates the tokens and cancels them.
+ *
+ * It is meant for a single operation: once cancelled, it remains cancelled.
+ * Create a new source to start a new operation.
+ */
+class CancellationSource
+{
+public:
+  CancellationSource() : state_(std::make_shared<details::CancellationState>())
+  {}
+
+  [[nodiscard]] CancellationToken token() const
+  {
+    return CancellationToken(state_);
+  }
+
+  [[nodiscard]] bool isCancelled() const
+  {
+    return state_->cancelled.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Cancel the tokens: the callbacks are invoked by this thread
+   * and the waits are interrupted. Only the first call has an effect.
+   * @return false if it was already cancelled.
+   */
+  bool cancel()
+  {
+    auto& st = *state_;
+    std::unique_lock lk(st.mutex);
+    if (st.cancelled.load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+    st.cancel_time = CancellationToken::Clock::now();
+    st.cancelled.store(true, std::memory_order_release);
+    st.cv.notify_all();
+    st.running_thread = std::this_thread::get_id();
+    while (!st.callbacks.empty())
+    {
+      auto it = st.callbacks.begin();
+      std::function<void()> callback = std::move(it->second);
+      st.running_id = it->first;
+      st.callbacks.erase(it);
+      lk.unlock();
+      callback();
+      lk.lock();
+      st.running_id = 0;
+      st.callback_done.notify_all();
+    }
+    return true;
+  }
+
+private:
+  std::shared_ptr<details::CancellationState> state_;
+};
+
+inline CancellationToken::Registration
+CancellationToken::onCancel(std::function<void()> callback) const
+{
+  Registration registration;
+  if (!state_)
+  {
+    return registration;
+  }
+  {
+    std::scoped_lock lk(state_->mutex);
+    if (!state_->cancelled.load(std::memory_order_relaxed))
+    {
+      registration.state_ = state_;
+      registration.id_ = state_->next_id++;
+      state_->callbacks.emplace(registration.id_, std::move(callback));
+      return registration;
+    }
+  }
+  callback();
+  return registration;
+}
+
+inline bool CancellationToken::sleepFor(Clock::duration duration) const
+{
+  if (!state_)
+  {
+    std::this_thread::sleep_for(duration);
+    return false;
+  }
+  std::unique_lock lk(state_->mutex);
+  return state_->cv.wait_for(lk, duration, [this] {
+    return state_->cancelled.load(std::memory_order_relaxed);
+  });
+}
+
+inline CancellationToken::Clock::time_point CancellationToken::cancelTime() const
+{
+  if (!state_)
+  {
+    return {};
+  }
+  std::scoped_lock lk(state_->mutex);
+  return state_->cancel_time;
+}
+
+}   // namespace BT
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace BT
+{
+
+/**
+ * @brief CpuTopology describes the NUMA nodes of the machine and their CPUs,
+ * read once from /sys/devices/system/node (Linux). Elsewhere, or if that
+ * information is not available, there is a single node with all the CPUs.
+ */
+class CpuTopology
+{
+public:
+  static const CpuTopology& get()
+  {
+    static const CpuTopology topology;
+    return topology;
+  }
+
+  [[nodiscard]] size_t numaNodes() const
+  {
+    return nodes_.size();
+  }
+
+  [[nodiscard]] size_t cpusCount() const
+  {
+    return node_of_cpu_.size();
+  }
+
+  [[nodiscard]] const std::vector<int>& cpusOfNode(size_t node) const
+  {
+    static const std::vector<int> empty;
+    return node < nodes_.size() ? nodes_[node] : empty;
+  }
+
+  /// -1 if unknown
+  [[nodiscard]] int nodeOfCpu(int cpu) const
+  {
+    return (cpu >= 0 && size_t(cpu) < node_of_cpu_.size()) ? node_of_cpu_[size_t(cpu)] : -1;
+  }
+
+  /// The CPU executing the current thread, or -1 if not supported.
+  [[nodiscard]] static int currentCpu()
+  {
+#ifdef __linux__
+    return ::sched_getcpu();
+#else
+    return -1;
+#endif
+  }
+
+  [[nodiscard]] int currentNode() const
+  {
+    return nodeOfCpu(currentCpu());
+  }
+
+  /// Parse a list of CPUs in the format of the kernel, for instance "0-3,8,10-11".
+  static std::vector<int> ParseCpuList(const std::string& list)
+  {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ','))
+    {
+      if (range.empty() || range == "\n")
+      {
+        continue;
+      }
+      const auto dash = range.find('-');
+      try
+      {
+        const int first = std::stoi(range.substr(0, dash));
+        const int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; cpu++)
+        {
+          cpus.push_back(cpu);
+        }
+      }
+      catch (std::exception&)
+      {
+        return {};
+      }
+    }
+    return cpus;
+  }
+
+private:
+  std::vector<std::vector<int>> nodes_;
+  std::vector<int> node_of_cpu_;
+
+  CpuTopology()
+  {
+#ifdef __linux__
+    for (int node = 0;; node++)
+    {
+      std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+      if (!file)
+      {
+        break;
+      }
+      std::string list;
+      std::getline(file, list);
+      nodes_.push_back(ParseCpuList(list));
+    }
+#endif
+    if (nodes_.empty())
+    {
+      nodes_.emplace_back();
+      const int count = int(std::max(1u, std::thread::hardware_concurrency()));
+      for (int cpu = 0; cpu < count; cpu++)
+      {
+        nodes_[0].push_back(cpu);
+      }
+    }
+    for (size_t node = 0; node < nodes_.size(); node++)
+    {
+      for (int cpu : nodes_[node])
+      {
+        if (node_of_cpu_.size() <= size_t(cpu))
+        {
+          node_of_cpu_.resize(size_t(cpu) + 1, -1);
+        }
+        node_of_cpu_[size_t(cpu)] = int(node);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Restrict the current thread to the given CPUs.
+ * @return false if not supported, or if the system refused it.
+ */
+inline bool SetCurrentThreadAffinity(const std::vector<int>& cpus)
+{
+#ifdef __linux__
+  if (cpus.empty())
+  {
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus)
+  {
+    if (cpu >= 0 && cpu < CPU_SETSIZE)
+    {
+      CPU_SET(cpu, &set);
+    }
+  }
+  return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+/**
+ * @brief Execute the function in a new thread bound to the CPUs of a NUMA node,
+ * and return its result.
+ *
+ * The memory allocated and initialized by the function is placed by the
+ * kernel on that node (first-touch policy). For instance, to keep the nodes,
+ * the arena and the blackboards of a tree local to the thread that ticks it:
+ *
+ *   Tree tree = RunOnNumaNode(1, [&] { return extensions.createTreeInArena("Main"); });
+ */
+template <typename Function>
+auto RunOnNumaNode(size_t node, Function&& function) -> std::invoke_result_t<Function>
+{
+  using Result = std::invoke_result_t<Function>;
+  std::exception_ptr error;
+  auto run = [&]() {
+    SetCurrentThreadAffinity(CpuTopology::get().cpusOfNode(node));
+    return function();
+  };
+  if constexpr (std::is_void_v<Result>)
+  {
+    std::thread thread([&]() {
+      try
+      {
+        run();
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+    });
+    thread.join();
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+  }
+  else
+  {
+    std::optional<Result> result;
+    std::thread thread([&]() {
+      try
+      {
+        result.emplace(run());
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+      }
+    });
+    thread.join();
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+    return std::move(*result);
+  }
+}
+
+}   // namespace BT
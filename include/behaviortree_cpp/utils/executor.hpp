@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "behaviortree_cpp/exceptions.h"
+#include "behaviortree_cpp/utils/thread_pool.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief Executor is the interface used to run asynchronous work
+ * (for instance by PooledThreadedAction) without creating a thread
+ * for each execution.
+ */
+class Executor
+{
+public:
+  using Ptr = std::shared_ptr<Executor>;
+  using Task = std::function<void()>;
+  using Clock = std::chrono::steady_clock;
+
+  struct Statistics
+  {
+    uint64_t executed = 0;
+    /// Tasks submitted, but not started yet
+    size_t queued = 0;
+    /// Time between execute() and the beginning of the task
+    std::chrono::nanoseconds mean_queue_delay = {};
+    std::chrono::nanoseconds max_queue_delay = {};
+  };
+
+  virtual ~Executor() = default;
+
+  /// Thread-safe. The task will be executed, eventually, in a different thread.
+  virtual void execute(Task task) = 0;
+
+  [[nodiscard]] virtual Statistics statistics() const = 0;
+};
+
+/**
+ * @brief PoolExecutor runs tasks on a WorkStealingPool, with an optional
+ * limit to the number of tasks executed concurrently. Tasks exceeding that
+ * limit are queued (FIFO).
+ */
+class PoolExecutor : public Executor
+{
+public:
+  /**
+   * @param num_threads      size of the pool. If 0, hardware_concurrency() is used
+   * @param max_concurrency  maximum number of tasks running at the same time.
+   *                         If 0, it is equal to the number of threads.
+   */
+  explicit PoolExecutor(size_t num_threads = 0, size_t max_concurrency = 0) :
+    pool_(std::make_shared<WorkStealingPool>(num_threads))
+  {
+    max_concurrency_ = (max_concurrency == 0) ? pool_->size() : max_concurrency;
+  }
+
+  /// Share an existing pool.
+  PoolExecutor(std::shared_ptr<WorkStealingPool> pool, size_t max_concurrency) :
+    pool_(std::move(pool)), max_concurrency_(max_concurrency)
+  {
+    if (!pool_)
+    {
+      throw RuntimeError("PoolExecutor: invalid pool");
+    }
+    if (max_concurrency_ == 0)
+    {
+      max_concurrency_ = pool_->size();
+    }
+  }
+
+  ~PoolExecutor() override
+  {
+    // wait all the tasks, because they reference this object
+    std::unique_lock lk(mutex_);
+    done_cv_.wait(lk, [this] { return running_ == 0 && queue_.empty(); });
+  }
+
+  void execute(Task task) override
+  {
+    std::unique_lock lk(mutex_);
+    queue_.push_back({std::move(task), Clock::now()});
+    dispatch(lk);
+  }
+
+  [[nodiscard]] Statistics statistics() const override
+  {
+    std::scoped_lock lk(mutex_);
+    Statistics stats = stats_;
+    stats.queued = queue_.size();
+    return stats;
+  }
+
+private:
+  struct Item
+  {
+    Task task;
+    Clock::time_point submitted;
+  };
+
+  std::shared_ptr<WorkStealingPool> pool_;
+  size_t max_concurrency_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable done_cv_;
+  std::deque<Item> queue_;
+  size_t running_ = 0;
+  Statistics stats_;
+
+  // must be called with the mutex locked
+  void dispatch(std::unique_lock<std::mutex>& lk)
+  {
+    while (running_ < max_concurrency_ && !queue_.empty())
+    {
+      Item item = std::move(queue_.front());
+      queue_.pop_front();
+      running_++;
+      lk.unlock();
+      pool_->submit([this, item = std::move(item)]() mutable { run(item); });
+      lk.lock();
+    }
+  }
+
+  void run(Item& item)
+  {
+    const auto delay = Clock::now() - item.submitted;
+    {
+      std::scoped_lock lk(mutex_);
+      stats_.executed++;
+      stats_.mean_queue_delay += (delay - stats_.mean_queue_delay) / int64_t(stats_.executed);
+      stats_.max_queue_delay = std::max<std::chrono::nanoseconds>(stats_.max_queue_delay, delay);
+    }
+    try
+    {
+      item.task();
+    }
+    catch (...)
+    {}
+
+    std::unique_lock lk(mutex_);
+    running_--;
+    dispatch(lk);
+    if (running_ == 0 && queue_.empty())
+    {
+      done_cv_.notify_all();
+    }
+  }
+};
+
+/// The Executor used when none is specified explicitly.
+/// By default, it is a PoolExecutor with hardware_concurrency() threads.
+inline Executor::Ptr& DefaultExecutor()
+{
+  static Executor::Ptr executor = std::make_shared<PoolExecutor>();
+  return executor;
+}
+
+/// Replace the default executor. Not thread-safe: call it at startup.
+inline void SetDefaultExecutor(Executor::Ptr executor)
+{
+  DefaultExecutor() = std::move(executor);
+}
+
+}   // namespace BT
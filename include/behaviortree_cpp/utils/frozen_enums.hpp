@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp/basic_types.h"
+
+namespace BT
+{
+class TreeNode;
+
+/**
+ * @brief FrozenEnumsTable is an immutable copy of the table of scripting
+ * enums (name -> value), stored in a single flat array with open addressing.
+ *
+ * Compared to the original std::unordered_map<std::string, int>, find()
+ * accepts a string_view (no temporary std::string) and usually needs one
+ * hash, one probe and one string comparison, without following pointers.
+ */
+class FrozenEnumsTable
+{
+public:
+  FrozenEnumsTable() = default;
+
+  explicit FrozenEnumsTable(const std::unordered_map<std::string, int>& table)
+  {
+    // load factor lower than 0.5: probe sequences are very short
+    size_t capacity = 8;
+    while (capacity < table.size() * 2)
+    {
+      capacity *= 2;
+    }
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+    for (const auto& [name, value] : table)
+    {
+      const size_t hash = hashOf(name);
+      size_t index = hash & mask_;
+      while (slots_[index].used)
+      {
+        index = (index + 1) & mask_;
+      }
+      slots_[index] = {name, hash, value, true};
+    }
+    size_ = table.size();
+  }
+
+  /// Pointer to the value of the enum, nullptr if not found.
+  [[nodiscard]] const int* find(std::string_view name) const
+  {
+    if (size_ == 0)
+    {
+      return nullptr;
+    }
+    const size_t hash = hashOf(name);
+    for (size_t index = hash & mask_;; index = (index + 1) & mask_)
+    {
+      const Slot& slot = slots_[index];
+      if (!slot.used)
+      {
+        return nullptr;
+      }
+      if (slot.hash == hash && slot.name == name)
+      {
+        return &slot.value;
+      }
+    }
+  }
+
+  [[nodiscard]] size_t size() const
+  {
+    return size_;
+  }
+
+  [[nodiscard]] bool empty() const
+  {
+    return size_ == 0;
+  }
+
+private:
+  struct Slot
+  {
+    std::string name;
+    size_t hash = 0;
+    int value = 0;
+    bool used = false;
+  };
+
+  std::vector<Slot> slots_;
+  size_t mask_ = 0;
+  size_t size_ = 0;
+
+  static size_t hashOf(std::string_view name)
+  {
+    return std::hash<std::string_view>{}(name);
+  }
+};
+
+/**
+ * @brief FrozenEnumsIndex maps the nodes of a tree to the frozen copy of
+ * their scripting enums. The nodes that share the same registry share the
+ * same FrozenEnumsTable. See FreezeScriptingEnums().
+ */
+class FrozenEnumsIndex
+{
+public:
+  /// Add a node that uses the scripting enums given by registry.
+  void add(const TreeNode* node,
+           const std::shared_ptr<const std::unordered_map<std::string, int>>& registry)
+  {
+    if (!registry)
+    {
+      return;
+    }
+    auto& table = tables_[registry.get()];
+    if (!table)
+    {
+      table = std::make_shared<const FrozenEnumsTable>(*registry);
+    }
+    nodes_[node] = table;
+  }
+
+  /// Frozen enums of a node, nullptr if the node was not added.
+  [[nodiscard]] const FrozenEnumsTable* find(const TreeNode* node) const
+  {
+    auto it = nodes_.find(node);
+    return (it != nodes_.end()) ? it->second.get() : nullptr;
+  }
+
+  [[nodiscard]] size_t size() const
+  {
+    return nodes_.size();
+  }
+
+private:
+  std::unordered_map<const void*, std::shared_ptr<const FrozenEnumsTable>> tables_;
+  std::unordered_map<const TreeNode*, std::shared_ptr<const FrozenEnumsTable>> nodes_;
+};
+
+/**
+ * @brief Convert the string into T, using a FrozenEnumsTable if T is an enum.
+ *
+ * May throw if the conversion fails.
+ */
+template <typename T> [[nodiscard]]
+inline T ParseString(const std::string& str, const FrozenEnumsTable* enums)
+{
+  if constexpr (std::is_enum_v<T> && !std::is_same_v<T, NodeStatus>)
+  {
+    if(enums)
+    {
+      if(const int* value = enums->find(str))
+      {
+        return static_cast<T>(*value);
+      }
+    }
+    // hopefully str contains a number that can be parsed. May throw
+    return static_cast<T>(convertFromString<int>(str));
+  }
+  else {
+    return convertFromString<T>(str);
+  }
+}
+
+}   // namespace BT
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "behaviortree_cpp/exceptions.h"
+
+namespace BT
+{
+
+/**
+ * @brief IoReactor is a minimal event loop based on epoll (Linux only).
+ *
+ * Handlers are registered for a file descriptor with watchOnce() or posted
+ * from any thread with post(); they are executed by the thread that calls
+ * poll(). With AttachIoReactor(), that is the thread of a TreeExecutor,
+ * between two ticks: a single thread drives the tree and all its I/O.
+ *
+ * Thread-safe.
+ */
+class IoReactor
+{
+public:
+  using Handler = std::function<void(uint32_t events)>;
+
+  IoReactor()
+  {
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0)
+    {
+      throw RuntimeError("IoReactor: epoll_create1 failed: ", std::strerror(errno));
+    }
+    event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0)
+    {
+      ::close(epoll_fd_);
+      throw RuntimeError("IoReactor: eventfd failed: ", std::strerror(errno));
+    }
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u64 = NOTIFY_ID;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev);
+  }
+
+  ~IoReactor()
+  {
+    ::close(event_fd_);
+    ::close(epoll_fd_);
+  }
+
+  IoReactor(const IoReactor&) = delete;
+  IoReactor& operator=(const IoReactor&) = delete;
+
+  /**
+   * @brief Invoke the handler once, from poll(), when the file descriptor
+   * is ready for the given events (EPOLLIN, EPOLLOUT, ...). The handler
+   * receives the events that occurred, including EPOLLERR or EPOLLHUP.
+   *
+   * A file descriptor can have a single watch at a time.
+   * @return the identifier to be used with cancel().
+   */
+  uint64_t watchOnce(int fd, uint32_t events, Handler handler)
+  {
+    std::scoped_lock lk(mutex_);
+    if (watched_fds_.count(fd) != 0)
+    {
+      throw RuntimeError("IoReactor: the file descriptor ", std::to_string(fd),
+                         " is already watched");
+    }
+    const uint64_t id = next_id_++;
+    epoll_event ev = {};
+    ev.events = events | EPOLLONESHOT;
+    ev.data.u64 = id;
+    if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+      throw RuntimeError("IoReactor: can't watch the file descriptor ", std::to_string(fd),
+                         ": ", std::strerror(errno));
+    }
+    watches_.emplace(id, Watch{ fd, std::move(handler) });
+    watched_fds_.emplace(fd, id);
+    return id;
+  }
+
+  /// Remove a watch. Returns false if it was already executed (or cancelled).
+  bool cancel(uint64_t id)
+  {
+    std::scoped_lock lk(mutex_);
+    auto it = watches_.find(id);
+    if (it == watches_.end())
+    {
+      return false;
+    }
+    removeWatch(it);
+    return true;
+  }
+
+  /// Execute the function in poll(). Can be called from any thread, for
+  /// instance by the completion callback of an asynchronous client.
+  void post(std::function<void()> function)
+  {
+    {
+      std::scoped_lock lk(mutex_);
+      posted_.push_back(std::move(function));
+    }
+    notify();
+  }
+
+  /// Interrupt poll(), from any thread.
+  void notify()
+  {
+    const uint64_t one = 1;
+    [[maybe_unused]] auto ret = ::write(event_fd_, &one, sizeof(one));
+  }
+
+  /**
+   * @brief Wait for events, up to the timeout, and execute their handlers
+   * and the posted functions.
+   *
+   * @return true if it was woken up by an event or by notify(),
+   *         false if the timeout expired.
+   */
+  bool poll(std::chrono::milliseconds timeout)
+  {
+    epoll_event events[MAX_EVENTS];
+    const int count = ::epoll_wait(epoll_fd_, events, MAX_EVENTS,
+                                   int(std::max<int64_t>(0, timeout.count())));
+    if (count < 0 && errno != EINTR)
+    {
+      throw RuntimeError("IoReactor: epoll_wait failed: ", std::strerror(errno));
+    }
+
+    std::vector<std::pair<Handler, uint32_t>> ready;
+    std::vector<std::function<void()>> posted;
+    {
+      std::scoped_lock lk(mutex_);
+      for (int i = 0; i < count; i++)
+      {
+        if (events[i].data.u64 == NOTIFY_ID)
+        {
+          uint64_t value;
+          [[maybe_unused]] auto ret = ::read(event_fd_, &value, sizeof(value));
+          continue;
+        }
+        auto it = watches_.find(events[i].data.u64);
+        if (it != watches_.end())
+        {
+          // removed before executing the handler: it can watch the fd again
+          ready.emplace_back(std::move(it->second.handler), uint32_t(events[i].events));
+          removeWatch(it);
+        }
+      }
+      posted.swap(posted_);
+    }
+    for (auto& [handler, ev] : ready)
+    {
+      handler(ev);
+    }
+    for (auto& function : posted)
+    {
+      function();
+    }
+    return count > 0;
+  }
+
+  /// Number of watches not executed yet.
+  [[nodiscard]] size_t watchesCount() const
+  {
+    std::scoped_lock lk(mutex_);
+    return watches_.size();
+  }
+
+private:
+  static constexpr uint64_t NOTIFY_ID = 0;
+  static constexpr int MAX_EVENTS = 64;
+
+  struct Watch
+  {
+    int fd;
+    Handler handler;
+  };
+
+  int epoll_fd_ = -1;
+  int event_fd_ = -1;
+  mutable std::mutex mutex_;
+  uint64_t next_id_ = NOTIFY_ID + 1;
+  std::unordered_map<uint64_t, Watch> watches_;
+  std::unordered_map<int, uint64_t> watched_fds_;
+  std::vector<std::function<void()>> posted_;
+
+  void removeWatch(std::unordered_map<uint64_t, Watch>::iterator it)
+  {
+    // the fd may have been closed already: ignore the error
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    watched_fds_.erase(it->second.fd);
+    watches_.erase(it);
+  }
+};
+
+}   // namespace BT
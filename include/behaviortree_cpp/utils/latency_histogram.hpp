@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace BT
+{
+
+/**
+ * @brief LatencyHistogram is a fixed-memory histogram of durations,
+ * with a logarithmic scale (similar to HdrHistogram): each power of two is
+ * divided in 8 buckets, i.e. the relative error of a percentile is below 12.5%.
+ *
+ * Durations are recorded in microseconds, up to about 19 hours; longer
+ * durations are recorded in the last bucket, but max() is exact.
+ *
+ * record() is wait-free, costs a few instructions and can be called while
+ * another thread reads the percentiles; the values read are approximate
+ * if record() is called concurrently.
+ */
+class LatencyHistogram
+{
+public:
+  static constexpr unsigned SUB_BUCKET_BITS = 3;
+  static constexpr unsigned SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+  static constexpr unsigned MAX_EXPONENT = 36;
+  static constexpr unsigned BUCKETS_COUNT =
+      (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + SUB_BUCKETS;
+
+  LatencyHistogram()
+  {
+    reset();
+  }
+
+  void record(std::chrono::microseconds duration)
+  {
+    const uint64_t usec = duration.count() > 0 ? uint64_t(duration.count()) : 0;
+    buckets_[bucketIndex(usec)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(usec, std::memory_order_relaxed);
+    if (usec > max_.load(std::memory_order_relaxed))
+    {
+      max_.store(usec, std::memory_order_relaxed);
+    }
+    if (usec < min_.load(std::memory_order_relaxed))
+    {
+      min_.store(usec, std::memory_order_relaxed);
+    }
+  }
+
+  template <typename Rep, typename Period>
+  void record(std::chrono::duration<Rep, Period> duration)
+  {
+    record(std::chrono::duration_cast<std::chrono::microseconds>(duration));
+  }
+
+  void reset()
+  {
+    for (auto& bucket : buckets_)
+    {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+    min_.store(UINT64_MAX, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] uint64_t count() const
+  {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::chrono::microseconds max() const
+  {
+    return std::chrono::microseconds(max_.load(std::memory_order_relaxed));
+  }
+
+  [[nodiscard]] std::chrono::microseconds min() const
+  {
+    return count() == 0 ? std::chrono::microseconds(0) :
+                          std::chrono::microseconds(min_.load(std::memory_order_relaxed));
+  }
+
+  [[nodiscard]] std::chrono::microseconds sum() const
+  {
+    return std::chrono::microseconds(sum_.load(std::memory_order_relaxed));
+  }
+
+  [[nodiscard]] std::chrono::microseconds mean() const
+  {
+    const uint64_t samples = count();
+    return std::chrono::microseconds(
+        samples == 0 ? 0 : sum_.load(std::memory_order_relaxed) / samples);
+  }
+
+  /**
+   * @brief The duration that is greater or equal than the given fraction
+   * of the samples, for instance percentile(0.99). It is the upper bound of
+   * the bucket, limited by max().
+   */
+  [[nodiscard]] std::chrono::microseconds percentile(double fraction) const
+  {
+    const uint64_t samples = count();
+    if (samples == 0)
+    {
+      return std::chrono::microseconds(0);
+    }
+    fraction = fraction < 0.0 ? 0.0 : (fraction > 1.0 ? 1.0 : fraction);
+    auto target = uint64_t(fraction * double(samples) + 0.5);
+    target = target == 0 ? 1 : target;
+
+    uint64_t accumulated = 0;
+    for (unsigned i = 0; i < BUCKETS_COUNT; i++)
+    {
+      accumulated += buckets_[i].load(std::memory_order_relaxed);
+      if (accumulated >= target)
+      {
+        const uint64_t upper = bucketUpperBound(i);
+        const uint64_t maximum = max_.load(std::memory_order_relaxed);
+        return std::chrono::microseconds(upper < maximum ? upper : maximum);
+      }
+    }
+    return max();
+  }
+
+  [[nodiscard]] std::chrono::microseconds p50() const
+  {
+    return percentile(0.5);
+  }
+
+  [[nodiscard]] std::chrono::microseconds p99() const
+  {
+    return percentile(0.99);
+  }
+
+  /// Index of the bucket of a value, in microseconds
+  static unsigned bucketIndex(uint64_t usec)
+  {
+    if (usec < SUB_BUCKETS)
+    {
+      return unsigned(usec);
+    }
+    unsigned exponent = 63 - unsigned(countLeadingZeros(usec));
+    if (exponent > MAX_EXPONENT)
+    {
+      return BUCKETS_COUNT - 1;
+    }
+    const unsigned shift = exponent - SUB_BUCKET_BITS;
+    const unsigned sub_bucket = unsigned(usec >> shift) & (SUB_BUCKETS - 1);
+    return (shift + 1) * SUB_BUCKETS + sub_bucket;
+  }
+
+  /// Largest value, in microseconds, recorded in the given bucket
+  static uint64_t bucketUpperBound(unsigned index)
+  {
+    if (index < SUB_BUCKETS)
+    {
+      return index;
+    }
+    const unsigned shift = index / SUB_BUCKETS - 1;
+    const uint64_t sub_bucket = index % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub_bucket + 1) << shift) - 1;
+  }
+
+private:
+  static int countLeadingZeros(uint64_t value)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#else
+    int count = 0;
+    for (uint64_t mask = uint64_t(1) << 63; (value & mask) == 0; mask >>= 1)
+    {
+      count++;
+    }
+    return count;
+#endif
+  }
+
+  std::array<std::atomic<uint32_t>, BUCKETS_COUNT> buckets_;
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> sum_;
+  std::atomic<uint64_t> max_;
+  std::atomic<uint64_t> min_;
+};
+
+}   // namespace BT
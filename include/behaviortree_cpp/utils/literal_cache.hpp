@@ -0,0 +1,191 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+#include "behaviortree_cpp/tree_node.h"
+#include "behaviortree_cpp/utils/frozen_enums.hpp"
+#include "behaviortree_cpp/utils/safe_any.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief LiteralPortsCache stores the values of the input ports that contain
+ * a literal (i.e. not a blackboard pointer), after they are converted from
+ * string the first time, so that the same string is not parsed at each tick
+ * (see LiteralPortsTable).
+ *
+ * A value is used only if both the literal and the requested type didn't change.
+ * It is thread-safe; copies contain the values already converted.
+ */
+class LiteralPortsCache
+{
+public:
+  LiteralPortsCache() = default;
+
+  LiteralPortsCache(const LiteralPortsCache& other)
+  {
+    std::scoped_lock lk(other.mutex_);
+    values_ = other.values_;
+  }
+
+  LiteralPortsCache& operator=(const LiteralPortsCache& other)
+  {
+    if (this != &other)
+    {
+      std::scoped_lock lk(mutex_, other.mutex_);
+      values_ = other.values_;
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Copy into destination the value of a port.
+   *
+   * @param port     name of the port
+   * @param literal  content of the port
+   * @param parse    function T(const std::string&), invoked if the value
+   *                 is not in cache yet. It may throw.
+   */
+  template <typename T, typename Parser>
+  void get(const std::string& port, const std::string& literal, T& destination,
+           const Parser& parse)
+  {
+    {
+      std::scoped_lock lk(mutex_);
+      auto it = values_.find(port);
+      if (it != values_.end() && it->second.type == typeid(T) &&
+          it->second.literal == literal)
+      {
+        if (const T* value = it->second.value.template castPtr<T>())
+        {
+          destination = *value;
+        }
+        else
+        {
+          // numbers are stored by Any as int64_t or double
+          destination = it->second.value.template cast<T>();
+        }
+        return;
+      }
+    }
+    // convert without holding the lock
+    T value = parse(literal);
+    {
+      std::scoped_lock lk(mutex_);
+      values_.insert_or_assign(port, Value{literal, typeid(T), Any(value)});
+    }
+    destination = std::move(value);
+  }
+
+  void clear()
+  {
+    std::scoped_lock lk(mutex_);
+    values_.clear();
+  }
+
+private:
+  struct Value
+  {
+    std::string literal;
+    std::type_index type;
+    Any value;
+  };
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Value> values_;
+};
+
+/**
+ * @brief LiteralPortsTable keeps a LiteralPortsCache for each node, outside
+ * of its NodeConfig. A node reads its literal ports through the table and
+ * parses them only the first time:
+ *
+ *    double threshold;
+ *    literals.getInput(*this, "threshold", threshold);
+ *
+ * The other ports (blackboard pointers, default values and strings) are
+ * read with TreeNode::getInput(). Enums are converted with the frozen copy
+ * given to the constructor (see FreezeScriptingEnums()), if the node is in
+ * it, or with the registry of the node. The table is owned by the application,
+ * can be shared by the nodes of a tree and must outlive them, unless
+ * erase() is invoked when a node is destroyed.
+ */
+class LiteralPortsTable
+{
+public:
+  LiteralPortsTable() = default;
+
+  explicit LiteralPortsTable(std::shared_ptr<const FrozenEnumsIndex> enums) :
+    enums_(std::move(enums))
+  {}
+
+  LiteralPortsTable(const LiteralPortsTable&) = delete;
+  LiteralPortsTable& operator=(const LiteralPortsTable&) = delete;
+
+  /// Same as node.getInput(key, destination).
+  template <typename T>
+  Result getInput(const TreeNode& node, const std::string& key, T& destination)
+  {
+    // strings are not converted: caching them would not help
+    if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, StringView>)
+    {
+      return node.getInput(key, destination);
+    }
+    else
+    {
+      const NodeConfig& config = node.config();
+      auto remap_it = config.input_ports.find(key);
+      if (remap_it == config.input_ports.end() || remap_it->second.empty() ||
+          TreeNode::getRemappedKey(key, remap_it->second))
+      {
+        return node.getInput(key, destination);
+      }
+      LiteralPortsCache* cache = nullptr;
+      {
+        std::scoped_lock lk(mutex_);
+        // the elements of an unordered_map are not moved by a rehash
+        cache = &caches_[&node];
+      }
+      try
+      {
+        const FrozenEnumsTable* frozen = enums_ ? enums_->find(&node) : nullptr;
+        cache->get(key, remap_it->second, destination, [&](const std::string& str) {
+          if (frozen)
+          {
+            return ParseString<T>(str, frozen);
+          }
+          return ParseString<T>(str, config.enums.get());
+        });
+        return {};
+      }
+      catch (std::exception& err)
+      {
+        return nonstd::make_unexpected(err.what());
+      }
+    }
+  }
+
+  /// Remove the values of a node (for instance, before destroying it).
+  void erase(const TreeNode* node)
+  {
+    std::scoped_lock lk(mutex_);
+    caches_.erase(node);
+  }
+
+  void clear()
+  {
+    std::scoped_lock lk(mutex_);
+    caches_.clear();
+  }
+
+private:
+  std::shared_ptr<const FrozenEnumsIndex> enums_;
+  std::mutex mutex_;
+  std::unordered_map<const TreeNode*, LiteralPortsCache> caches_;
+};
+
+}   // namespace BT
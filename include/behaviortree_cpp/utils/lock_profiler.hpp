@@ -0,0 +1,340 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace BT
+{
+
+/**
+ * @brief Counters of a lock site (a mutex member of a class, shared by all
+ * its instances). Updated with relaxed atomics by ProfiledMutex.
+ */
+struct LockSite
+{
+  explicit LockSite(const char* site_name);
+
+  LockSite(const LockSite&) = delete;
+  LockSite& operator=(const LockSite&) = delete;
+
+  const char* name;
+  std::atomic<uint64_t> acquisitions = 0;
+  // acquisitions that found the mutex locked
+  std::atomic<uint64_t> contentions = 0;
+  std::atomic<uint64_t> wait_ns = 0;
+  std::atomic<uint64_t> max_wait_ns = 0;
+  // only exclusive locks
+  std::atomic<uint64_t> hold_ns = 0;
+  std::atomic<uint64_t> max_hold_ns = 0;
+
+  static void updateMax(std::atomic<uint64_t>& max, uint64_t value)
+  {
+    uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current &&
+           !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+  }
+};
+
+/**
+ * @brief LockProfiler collects the contention of the mutexes declared with
+ * SiteMutex, per lock site, when compiled with BTCPP_LOCK_PROFILING.
+ *
+ * Only the classes owned by the application use SiteMutex (TimerWheel,
+ * TextSink, CompressedFileLogger and BatchedSqliteLogger); the mutexes of
+ * the classes compiled in the library stay the plain standard types.
+ * With the definition, those mutexes are ProfiledMutex, that count the
+ * acquisitions, how many of them had to wait, the time spent waiting,
+ * and the time the lock was held.
+ *
+ * BTCPP_LOCK_PROFILING changes the layout of the classes above: define it
+ * in all the translation units that use them.
+ *
+ * The report is available through StatisticsObserver::lockContention() and
+ * MetricsExporter (bt_lock_*).
+ */
+class LockProfiler
+{
+public:
+  struct SiteStatistics
+  {
+    std::string site;
+    uint64_t acquisitions = 0;
+    uint64_t contentions = 0;
+    std::chrono::nanoseconds wait = {};
+    std::chrono::nanoseconds max_wait = {};
+    std::chrono::nanoseconds hold = {};
+    std::chrono::nanoseconds max_hold = {};
+
+    /// fraction of the acquisitions that had to wait
+    [[nodiscard]] double contentionRatio() const
+    {
+      return acquisitions > 0 ? double(contentions) / double(acquisitions) : 0.0;
+    }
+  };
+
+  static constexpr bool compiledIn()
+  {
+#ifdef BTCPP_LOCK_PROFILING
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  static LockProfiler& get()
+  {
+    static LockProfiler profiler;
+    return profiler;
+  }
+
+  /// When disabled, ProfiledMutex doesn't read the clock nor update the counters.
+  static void setEnabled(bool enabled)
+  {
+    enabledFlag().store(enabled, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] static bool isEnabled()
+  {
+    return enabledFlag().load(std::memory_order_relaxed);
+  }
+
+  /// Statistics of the sites used at least once, sorted by total wait time.
+  [[nodiscard]] std::vector<SiteStatistics> report() const
+  {
+    std::vector<SiteStatistics> out;
+    std::scoped_lock lk(mutex_);
+    for (const LockSite* site : sites_)
+    {
+      SiteStatistics stats;
+      stats.site = site->name;
+      stats.acquisitions = site->acquisitions.load(std::memory_order_relaxed);
+      if (stats.acquisitions == 0)
+      {
+        continue;
+      }
+      stats.contentions = site->contentions.load(std::memory_order_relaxed);
+      stats.wait = std::chrono::nanoseconds(site->wait_ns.load(std::memory_order_relaxed));
+      stats.max_wait =
+          std::chrono::nanoseconds(site->max_wait_ns.load(std::memory_order_relaxed));
+      stats.hold = std::chrono::nanoseconds(site->hold_ns.load(std::memory_order_relaxed));
+      stats.max_hold =
+          std::chrono::nanoseconds(site->max_hold_ns.load(std::memory_order_relaxed));
+      out.push_back(std::move(stats));
+    }
+    std::sort(out.begin(), out.end(),
+              [](const auto& a, const auto& b) { return a.wait > b.wait; });
+    return out;
+  }
+
+  void reset()
+  {
+    std::scoped_lock lk(mutex_);
+    for (LockSite* site : sites_)
+    {
+      site->acquisitions = 0;
+      site->contentions = 0;
+      site->wait_ns = 0;
+      site->max_wait_ns = 0;
+      site->hold_ns = 0;
+      site->max_hold_ns = 0;
+    }
+  }
+
+private:
+  friend struct LockSite;
+
+  LockProfiler() = default;
+
+  static std::atomic<bool>& enabledFlag()
+  {
+    static std::atomic<bool> enabled = true;
+    return enabled;
+  }
+
+  void add(LockSite* site)
+  {
+    std::scoped_lock lk(mutex_);
+    sites_.push_back(site);
+  }
+
+  mutable std::mutex mutex_;
+  std::vector<LockSite*> sites_;
+};
+
+inline LockSite::LockSite(const char* site_name) : name(site_name)
+{
+  LockProfiler::get().add(this);
+}
+
+/**
+ * @brief Wrapper of a mutex (std::mutex, std::recursive_mutex or
+ * std::shared_mutex) that records its contention in the LockSite Site.
+ *
+ * An uncontended lock costs a try_lock() and a clock reading more than the
+ * wrapped mutex; unlock() reads the clock once to measure the hold time.
+ * Use it with std::condition_variable_any (see ConditionVariableFor).
+ */
+template <typename MutexT, const char* Site>
+class ProfiledMutex
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  ProfiledMutex() = default;
+  ProfiledMutex(const ProfiledMutex&) = delete;
+  ProfiledMutex& operator=(const ProfiledMutex&) = delete;
+
+  void lock()
+  {
+    if (!LockProfiler::isEnabled())
+    {
+      mutex_.lock();
+      acquired({});
+      return;
+    }
+    if (mutex_.try_lock())
+    {
+      acquired(Clock::now());
+      return;
+    }
+    const auto start = Clock::now();
+    mutex_.lock();
+    const auto now = Clock::now();
+    contended(now - start);
+    acquired(now);
+  }
+
+  bool try_lock()
+  {
+    if (!mutex_.try_lock())
+    {
+      return false;
+    }
+    acquired(LockProfiler::isEnabled() ? Clock::now() : Clock::time_point{});
+    return true;
+  }
+
+  void unlock()
+  {
+    // read before unlocking: the next owner overwrites them
+    const bool outermost = (--depth_ == 0);
+    const auto hold_start = hold_start_;
+    mutex_.unlock();
+    if (outermost && hold_start != Clock::time_point{})
+    {
+      const auto hold = uint64_t(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - hold_start)
+              .count());
+      auto& stats = site();
+      stats.hold_ns.fetch_add(hold, std::memory_order_relaxed);
+      LockSite::updateMax(stats.max_hold_ns, hold);
+    }
+  }
+
+  void lock_shared()
+  {
+    if (!LockProfiler::isEnabled())
+    {
+      mutex_.lock_shared();
+      return;
+    }
+    if (!mutex_.try_lock_shared())
+    {
+      const auto start = Clock::now();
+      mutex_.lock_shared();
+      contended(Clock::now() - start);
+    }
+    site().acquisitions.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bool try_lock_shared()
+  {
+    if (!mutex_.try_lock_shared())
+    {
+      return false;
+    }
+    if (LockProfiler::isEnabled())
+    {
+      site().acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  void unlock_shared()
+  {
+    mutex_.unlock_shared();
+  }
+
+  static LockSite& site()
+  {
+    static LockSite stats(Site);
+    return stats;
+  }
+
+private:
+  void acquired(Clock::time_point now)
+  {
+    // recursive mutexes: the hold time is measured by the outermost lock
+    if (depth_++ == 0)
+    {
+      hold_start_ = now;
+    }
+    if (now != Clock::time_point{})
+    {
+      site().acquisitions.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void contended(Clock::duration wait)
+  {
+    const auto wait_ns =
+        uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(wait).count());
+    auto& stats = site();
+    stats.contentions.fetch_add(1, std::memory_order_relaxed);
+    stats.wait_ns.fetch_add(wait_ns, std::memory_order_relaxed);
+    LockSite::updateMax(stats.max_wait_ns, wait_ns);
+  }
+
+  MutexT mutex_;
+  // written only by the owner of the exclusive lock
+  unsigned depth_ = 0;
+  Clock::time_point hold_start_ = {};
+};
+
+/// Names of the lock sites.
+namespace LockSites
+{
+inline constexpr char TimerWheel[] = "TimerWheel::mutex_";
+inline constexpr char CompressedFileLogger[] = "CompressedFileLogger::mutex_";
+inline constexpr char BatchedSqliteLogger[] = "BatchedSqliteLogger::queue_mutex_";
+inline constexpr char TextSink[] = "TextSink::mutex_";
+}   // namespace LockSites
+
+/**
+ * @brief The type of a mutex of the lock site Site: ProfiledMutex if compiled
+ * with BTCPP_LOCK_PROFILING, MutexT otherwise.
+ */
+#ifdef BTCPP_LOCK_PROFILING
+template <typename MutexT, const char* Site>
+using SiteMutex = ProfiledMutex<MutexT, Site>;
+#else
+template <typename MutexT, const char* Site>
+using SiteMutex = MutexT;
+#endif
+
+/// std::condition_variable for std::mutex, std::condition_variable_any otherwise.
+template <typename Mutex>
+using ConditionVariableFor =
+    std::conditional_t<std::is_same_v<Mutex, std::mutex>, std::condition_variable,
+                       std::condition_variable_any>;
+
+}   // namespace BT
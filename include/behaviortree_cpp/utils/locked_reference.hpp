@@ -40,6 +40,7 @@ class LockedPtr {
   LockedPtr& operator=(LockedPtr&& other) {
     std::swap(ref_, other.ref_);
     std::swap(mutex_, other.mutex_);
+    return *this;
   }
 
   operator bool() const {
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace BT
+{
+
+/**
+ * HeapBytes() estimates the memory allocated on the heap by an object,
+ * excluding sizeof(object) itself. The overhead of the allocator is ignored.
+ */
+template <typename T>
+inline std::enable_if_t<std::is_trivially_copyable_v<T>, size_t> HeapBytes(const T&)
+{
+  return 0;
+}
+
+inline size_t HeapBytes(const std::string& str)
+{
+  // with the small string optimization, the characters are inside the object
+  const auto* data = reinterpret_cast<const char*>(str.data());
+  const auto* object = reinterpret_cast<const char*>(&str);
+  if (data >= object && data < object + sizeof(std::string))
+  {
+    return 0;
+  }
+  return str.capacity() + 1;
+}
+
+template <typename T>
+inline size_t HeapBytes(const std::vector<T>& vect)
+{
+  size_t bytes = vect.capacity() * sizeof(T);
+  if constexpr (!std::is_trivially_copyable_v<T>)
+  {
+    for (const auto& item : vect)
+    {
+      bytes += HeapBytes(item);
+    }
+  }
+  return bytes;
+}
+
+template <typename Key, typename T, typename Hash, typename Equal, typename Alloc>
+inline size_t HeapBytes(const std::unordered_map<Key, T, Hash, Equal, Alloc>& map)
+{
+  using Map = std::unordered_map<Key, T, Hash, Equal, Alloc>;
+  // each node stores the pair, the pointer to the next node and the hash
+  constexpr size_t node_bytes = sizeof(typename Map::value_type) + 2 * sizeof(void*);
+  size_t bytes = map.bucket_count() * sizeof(void*) + map.size() * node_bytes;
+  for (const auto& [key, value] : map)
+  {
+    bytes += HeapBytes(key) + HeapBytes(value);
+  }
+  return bytes;
+}
+
+template <typename Key, typename T, typename Compare, typename Alloc>
+inline size_t HeapBytes(const std::map<Key, T, Compare, Alloc>& map)
+{
+  using Map = std::map<Key, T, Compare, Alloc>;
+  // each node of the red-black tree stores the pair, three pointers and the color
+  constexpr size_t node_bytes = sizeof(typename Map::value_type) + 4 * sizeof(void*);
+  size_t bytes = map.size() * node_bytes;
+  for (const auto& [key, value] : map)
+  {
+    bytes += HeapBytes(key) + HeapBytes(value);
+  }
+  return bytes;
+}
+
+}   // namespace BT
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <charconv>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "behaviortree_cpp/basic_types.h"
+
+namespace BT
+{
+
+/**
+ * @brief Invoke func(StringView) for each part of str separated by
+ * the delimiter, without allocating memory. Consistent with splitString():
+ * a trailing delimiter doesn't produce an empty part.
+ */
+template <typename Function>
+inline void ForEachPart(StringView str, char delimiter, Function&& func)
+{
+  size_t pos = 0;
+  while (pos < str.size())
+  {
+    size_t next = str.find(delimiter, pos);
+    if (next == StringView::npos)
+    {
+      next = str.size();
+    }
+    func(str.substr(pos, next - pos));
+    pos = next + 1;
+  }
+}
+
+/// Number of parts visited by ForEachPart()
+[[nodiscard]] inline size_t CountParts(StringView str, char delimiter)
+{
+  size_t count = 0;
+  ForEachPart(str, delimiter, [&count](StringView) { count++; });
+  return count;
+}
+
+/**
+ * @brief Convert a string into a number using std::from_chars:
+ * it doesn't allocate, doesn't depend on the locale and doesn't throw.
+ *
+ * Leading and trailing spaces and a leading '+' are accepted, any other
+ * character that is not part of the number is an error.
+ */
+template <typename T>
+[[nodiscard]] inline Expected<T> ParseNumber(StringView str)
+{
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                "ParseNumber requires a numeric type");
+
+  const auto not_space = str.find_first_not_of(" \t\n\r");
+  StringView trimmed =
+      (not_space == StringView::npos) ? StringView() : str.substr(not_space);
+  trimmed = trimmed.substr(0, trimmed.find_last_not_of(" \t\n\r") + 1);
+  if (trimmed.size() > 1 && trimmed.front() == '+' && trimmed[1] != '-')
+  {
+    trimmed.remove_prefix(1);
+  }
+
+  auto error = [str]() {
+    return nonstd::make_unexpected(
+        StrCat("Can't convert string [", str, "] to ", TypeID::of<T>().name()));
+  };
+  if (trimmed.empty())
+  {
+    return error();
+  }
+
+  T value = 0;
+  const char* first = trimmed.data();
+  const char* last = trimmed.data() + trimmed.size();
+#if !defined(__cpp_lib_to_chars)
+  // std::from_chars for floating point types is not available in this standard library
+  if constexpr (std::is_floating_point_v<T>)
+  {
+    const std::string copy(trimmed);
+    char* end = nullptr;
+    value = static_cast<T>(std::strtod(copy.c_str(), &end));
+    if (end != copy.c_str() + copy.size())
+    {
+      return error();
+    }
+    return value;
+  }
+  else
+#endif
+  {
+    const auto [ptr, ec] = std::from_chars(first, last, value);
+    if (ec != std::errc() || ptr != last)
+    {
+      return error();
+    }
+  }
+  return value;
+}
+
+/**
+ * @brief Convert numbers separated by the delimiter (";" by default).
+ * The string is visited twice: CountParts() sizes the vector, that is
+ * allocated once, then the parts are converted.
+ */
+template <typename T>
+[[nodiscard]] inline Expected<std::vector<T>> ParseNumbers(StringView str,
+                                                          char delimiter = ';')
+{
+  std::vector<T> output;
+  output.reserve(CountParts(str, delimiter));
+  std::string error;
+  ForEachPart(str, delimiter, [&](StringView part) {
+    if (!error.empty())
+    {
+      return;
+    }
+    if (auto value = ParseNumber<T>(part))
+    {
+      output.push_back(value.value());
+    }
+    else
+    {
+      error = value.error();
+    }
+  });
+  if (!error.empty())
+  {
+    return nonstd::make_unexpected(error);
+  }
+  return output;
+}
+
+/**
+ * @brief Same as ParseNumbers(), but the numbers are pushed into a
+ * std::shared_ptr<std::deque<T>>, the SharedQueue<T> consumed by LoopNode.
+ *
+ * The convertFromString<SharedQueue<T>> specializations of loop_node.h are
+ * compiled into the library too and stay as they are: use this function
+ * explicitly, for instance to fill the queue of a LoopNode from a string.
+ */
+template <typename T>
+[[nodiscard]] inline Expected<std::shared_ptr<std::deque<T>>>
+ParseNumbersQueue(StringView str, char delimiter = ';')
+{
+  auto output = std::make_shared<std::deque<T>>();
+  std::string error;
+  ForEachPart(str, delimiter, [&](StringView part) {
+    if (!error.empty())
+    {
+      return;
+    }
+    if (auto value = ParseNumber<T>(part))
+    {
+      output->push_back(value.value());
+    }
+    else
+    {
+      error = value.error();
+    }
+  });
+  if (!error.empty())
+  {
+    return nonstd::make_unexpected(error);
+  }
+  return output;
+}
+
+}   // namespace BT
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(__linux__) && !defined(BTCPP_DISABLE_PERF_EVENTS)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BT_PERF_EVENTS_SUPPORTED
+#endif
+
+namespace BT
+{
+
+/**
+ * @brief PerfCounters reads the hardware (and software) performance counters
+ * of the calling thread, using perf_event_open on Linux.
+ *
+ * The counters are opened as a single group, read with one system call.
+ * The events that the CPU, the hypervisor or /proc/sys/kernel/perf_event_paranoid
+ * don't allow are skipped: check isAvailable(). On other platforms, or compiling
+ * with BTCPP_DISABLE_PERF_EVENTS, no event is available.
+ *
+ * The hardware events count only the user space; the context switches
+ * are counted by the kernel.
+ *
+ * An instance must be used only by the thread that created it.
+ */
+class PerfCounters
+{
+public:
+  enum Event : uint8_t
+  {
+    CYCLES = 0,
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    BRANCH_MISSES,
+    CONTEXT_SWITCHES,
+    COUNT_
+  };
+
+  using Values = std::array<uint64_t, COUNT_>;
+
+  static const char* toStr(Event event)
+  {
+    switch (event)
+    {
+      case CYCLES:
+        return "cycles";
+      case INSTRUCTIONS:
+        return "instructions";
+      case CACHE_MISSES:
+        return "cache_misses";
+      case BRANCH_MISSES:
+        return "branch_misses";
+      case CONTEXT_SWITCHES:
+        return "context_switches";
+      default:
+        return "unknown";
+    }
+  }
+
+  PerfCounters()
+  {
+    fds_.fill(-1);
+#ifdef BT_PERF_EVENTS_SUPPORTED
+    const std::pair<uint32_t, uint64_t> configs[COUNT_] = {
+      { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+      { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+      { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+      { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+      { PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+    };
+    for (size_t i = 0; i < COUNT_; i++)
+    {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = configs[i].first;
+      attr.config = configs[i].second;
+      attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID;
+      attr.exclude_kernel = (attr.type == PERF_TYPE_HARDWARE) ? 1 : 0;
+      attr.exclude_hv = 1;
+      attr.disabled = (leader_ < 0) ? 1 : 0;
+      const int fd = int(::syscall(SYS_perf_event_open, &attr, 0, -1, leader_, 0));
+      if (fd < 0)
+      {
+        continue;
+      }
+      uint64_t id = 0;
+      if (::ioctl(fd, PERF_EVENT_IOC_ID, &id) != 0)
+      {
+        ::close(fd);
+        continue;
+      }
+      fds_[i] = fd;
+      ids_[i] = id;
+      if (leader_ < 0)
+      {
+        leader_ = fd;
+      }
+      count_++;
+    }
+    if (leader_ >= 0)
+    {
+      ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+
+  ~PerfCounters()
+  {
+#ifdef BT_PERF_EVENTS_SUPPORTED
+    // the leader last
+    for (size_t i = COUNT_; i-- > 0;)
+    {
+      if (fds_[i] >= 0 && fds_[i] != leader_)
+      {
+        ::close(fds_[i]);
+      }
+    }
+    if (leader_ >= 0)
+    {
+      ::close(leader_);
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  /// Counters of the calling thread, opened the first time it is used.
+  static PerfCounters& thread()
+  {
+    static thread_local PerfCounters counters;
+    return counters;
+  }
+
+  [[nodiscard]] bool isAvailable() const
+  {
+    return count_ > 0;
+  }
+
+  [[nodiscard]] bool isAvailable(Event event) const
+  {
+    return event < COUNT_ && fds_[event] >= 0;
+  }
+
+  /**
+   * @brief Current value of the counters, since they were opened.
+   * The events that are not available are 0.
+   */
+  bool read(Values& values) const
+  {
+    values.fill(0);
+#ifdef BT_PERF_EVENTS_SUPPORTED
+    if (leader_ < 0)
+    {
+      return false;
+    }
+    // { nr, { value, id } * nr }
+    uint64_t buffer[1 + 2 * COUNT_];
+    if (::read(leader_, buffer, sizeof(buffer)) <= 0)
+    {
+      return false;
+    }
+    const uint64_t nr = buffer[0];
+    for (uint64_t n = 0; n < nr && n < COUNT_; n++)
+    {
+      const uint64_t value = buffer[1 + 2 * n];
+      const uint64_t id = buffer[2 + 2 * n];
+      for (size_t i = 0; i < COUNT_; i++)
+      {
+        if (fds_[i] >= 0 && ids_[i] == id)
+        {
+          values[i] = value;
+          break;
+        }
+      }
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+private:
+  std::array<int, COUNT_> fds_;
+  std::array<uint64_t, COUNT_> ids_ = {};
+  int leader_ = -1;
+  size_t count_ = 0;
+};
+
+}   // namespace BT
+
+#undef BT_PERF_EVENTS_SUPPORTED
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "behaviortree_cpp/tree_node.h"
+
+namespace BT
+{
+
+/**
+ * The index of a plugin lists the manifests of the nodes registered by its
+ * BT_RegisterNodesFromPlugin(), so that they can be registered without
+ * loading the library (see FactoryExtensions::registerFromPluginDeferred).
+ *
+ * It is a text file, one record per line and fields separated by tabs:
+ *
+ *   btcpp_plugin_index  1
+ *   node  <ID>  <type>  <description>
+ *   port  <direction>  <name>  <type name>  <default value>  <description>
+ *
+ * where the "port" lines belong to the previous "node".
+ */
+constexpr const char* PLUGIN_INDEX_HEADER = "btcpp_plugin_index";
+constexpr int PLUGIN_INDEX_VERSION = 1;
+constexpr const char* PLUGIN_INDEX_SUFFIX = ".btindex";
+
+namespace details
+{
+inline std::string EscapeIndexField(const std::string& str)
+{
+  std::string out;
+  out.reserve(str.size());
+  for (char c : str)
+  {
+    switch (c)
+    {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      default:
+        out += c;
+    }
+  }
+  return out;
+}
+
+inline std::vector<std::string> SplitIndexLine(const std::string& line)
+{
+  std::vector<std::string> fields(1);
+  for (size_t i = 0; i < line.size(); i++)
+  {
+    const char c = line[i];
+    if (c == '\t')
+    {
+      fields.emplace_back();
+    }
+    else if (c == '\\' && i + 1 < line.size())
+    {
+      const char next = line[++i];
+      fields.back() += (next == 't') ? '\t' : (next == 'n') ? '\n' : (next == 'r') ? '\r' : next;
+    }
+    else
+    {
+      fields.back() += c;
+    }
+  }
+  return fields;
+}
+
+// the types of the ports that can be restored from their name
+template <typename T>
+inline bool ParseIndexPortType(const std::string& type_name, PortDirection direction,
+                               PortInfo& info)
+{
+  if (type_name != DemangledName(typeid(T)))
+  {
+    return false;
+  }
+  info = PortInfo(direction, typeid(T), GetAnyFromStringFunctor<T>());
+  return true;
+}
+
+inline PortInfo ParseIndexPort(const std::string& type_name, PortDirection direction)
+{
+  PortInfo info(direction);
+  (void)(ParseIndexPortType<std::string>(type_name, direction, info) ||
+         ParseIndexPortType<bool>(type_name, direction, info) ||
+         ParseIndexPortType<int>(type_name, direction, info) ||
+         ParseIndexPortType<unsigned>(type_name, direction, info) ||
+         ParseIndexPortType<long>(type_name, direction, info) ||
+         ParseIndexPortType<unsigned long>(type_name, direction, info) ||
+         ParseIndexPortType<long long>(type_name, direction, info) ||
+         ParseIndexPortType<unsigned long long>(type_name, direction, info) ||
+         ParseIndexPortType<float>(type_name, direction, info) ||
+         ParseIndexPortType<double>(type_name, direction, info));
+  return info;
+}
+}   // namespace details
+
+/// Write the manifests in the format read by ReadPluginIndex().
+inline void WritePluginIndex(std::ostream& out, const std::vector<TreeNodeManifest>& manifests)
+{
+  using details::EscapeIndexField;
+  out << PLUGIN_INDEX_HEADER << '\t' << PLUGIN_INDEX_VERSION << '\n';
+  for (const auto& manifest : manifests)
+  {
+    out << "node\t" << EscapeIndexField(manifest.registration_ID) << '\t'
+        << toStr(manifest.type) << '\t' << EscapeIndexField(manifest.description) << '\n';
+    for (const auto& [name, info] : manifest.ports)
+    {
+      out << "port\t" << toStr(info.direction()) << '\t' << EscapeIndexField(name) << '\t'
+          << EscapeIndexField(info.isStronglyTyped() ? info.typeName() : std::string()) << '\t'
+          << EscapeIndexField(info.defaultValueString()) << '\t'
+          << EscapeIndexField(info.description()) << '\n';
+    }
+  }
+}
+
+/**
+ * @brief Read an index written by WritePluginIndex(). The ports which type is
+ * not a number, bool or std::string are not strongly typed.
+ * Throws RuntimeError if the index is not valid.
+ */
+inline std::vector<TreeNodeManifest> ReadPluginIndex(std::istream& in,
+                                                     const std::string& source_name)
+{
+  std::vector<TreeNodeManifest> manifests;
+  std::string line;
+  int line_number = 0;
+  bool header = false;
+  auto error = [&](const std::string& message) {
+    return RuntimeError("Invalid plugin index [", source_name, "] at line ",
+                        std::to_string(line_number), ": ", message);
+  };
+
+  while (std::getline(in, line))
+  {
+    line_number++;
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    if (line.empty())
+    {
+      continue;
+    }
+    const auto fields = details::SplitIndexLine(line);
+    if (!header)
+    {
+      if (fields.size() != 2 || fields[0] != PLUGIN_INDEX_HEADER ||
+          fields[1] != std::to_string(PLUGIN_INDEX_VERSION))
+      {
+        throw error("unsupported header or version");
+      }
+      header = true;
+      continue;
+    }
+    try
+    {
+      if (fields[0] == "node" && fields.size() == 4)
+      {
+        TreeNodeManifest manifest;
+        manifest.registration_ID = fields[1];
+        manifest.type = convertFromString<NodeType>(fields[2]);
+        manifest.description = fields[3];
+        manifests.push_back(std::move(manifest));
+      }
+      else if (fields[0] == "port" && fields.size() == 6)
+      {
+        if (manifests.empty())
+        {
+          throw error("port without node");
+        }
+        const auto direction = convertFromString<PortDirection>(fields[1]);
+        auto info = details::ParseIndexPort(fields[3], direction);
+        info.setDescription(fields[5]);
+        if (!fields[4].empty())
+        {
+          info.setDefaultValue(fields[4]);
+        }
+        manifests.back().ports.insert({ fields[2], std::move(info) });
+      }
+      else
+      {
+        throw error("unknown record");
+      }
+    }
+    catch (RuntimeError&)
+    {
+      throw;
+    }
+    catch (std::exception& ex)
+    {
+      throw error(ex.what());
+    }
+  }
+  if (!header)
+  {
+    throw error("empty file");
+  }
+  return manifests;
+}
+
+}   // namespace BT
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+namespace BT
+{
+
+/**
+ * @brief SeqLockCell stores a trivially copyable value that is read often
+ * and written rarely (a pose, a goal, a small struct).
+ *
+ * Readers never block writers or each other: if a write happens during
+ * a read, the reader simply retries. Writers are serialized with each other.
+ *
+ * The value is stored in atomic words, therefore concurrent accesses are
+ * not a data race.
+ */
+template <typename T>
+class SeqLockCell
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLockCell requires a trivially copyable type");
+  static_assert(std::is_default_constructible<T>::value,
+                "SeqLockCell requires a default constructible type");
+
+public:
+  SeqLockCell()
+  {
+    store(T{});
+  }
+
+  explicit SeqLockCell(const T& value)
+  {
+    store(value);
+  }
+
+  SeqLockCell(const SeqLockCell&) = delete;
+  SeqLockCell& operator=(const SeqLockCell&) = delete;
+
+  /// Never blocks a writer; it retries if a store() happens concurrently
+  [[nodiscard]] T load() const
+  {
+    Word buffer[NUM_WORDS];
+    while (true)
+    {
+      const uint64_t seq_before = seq_.load(std::memory_order_acquire);
+      if (seq_before & 1)
+      {
+        // a writer is active
+        std::this_thread::yield();
+        continue;
+      }
+      for (size_t i = 0; i < NUM_WORDS; i++)
+      {
+        buffer[i] = words_[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == seq_before)
+      {
+        break;
+      }
+    }
+    T out;
+    std::memcpy(&out, buffer, sizeof(T));
+    return out;
+  }
+
+  void store(const T& value)
+  {
+    Word buffer[NUM_WORDS] = {};
+    std::memcpy(buffer, &value, sizeof(T));
+
+    // acquire the "write lock", making the sequence number odd
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    while (true)
+    {
+      if ((seq & 1) == 0 &&
+          seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+      {
+        break;
+      }
+      std::this_thread::yield();
+      seq = seq_.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < NUM_WORDS; i++)
+    {
+      words_[i].store(buffer[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  /// Incremented at each store(). Can be used to detect changes cheaply.
+  [[nodiscard]] uint64_t version() const
+  {
+    return seq_.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  using Word = uint64_t;
+  static constexpr size_t NUM_WORDS = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+  std::atomic<uint64_t> seq_ = 0;
+  std::atomic<Word> words_[NUM_WORDS];
+};
+
+/**
+ * @brief AtomicCell stores a scalar (bool, integer, double, enum) in a
+ * std::atomic: counters, flags and modes that many threads read and write.
+ *
+ * Both load() and store() are wait-free. Only the types that std::atomic
+ * implements without a lock are accepted; use SeqLockCell for the others.
+ */
+template <typename T>
+class AtomicCell
+{
+  static_assert(std::is_trivially_copyable<T>::value,
+                "AtomicCell requires a trivially copyable type");
+  static_assert(std::atomic<T>::is_always_lock_free,
+                "AtomicCell requires a lock-free std::atomic<T>, use SeqLockCell");
+
+public:
+  AtomicCell() : value_(T{})
+  {}
+
+  explicit AtomicCell(T value) : value_(value)
+  {}
+
+  AtomicCell(const AtomicCell&) = delete;
+  AtomicCell& operator=(const AtomicCell&) = delete;
+
+  [[nodiscard]] T load() const
+  {
+    return value_.load(std::memory_order_acquire);
+  }
+
+  void store(T value)
+  {
+    value_.store(value, std::memory_order_release);
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  /// Store the value and return the previous one.
+  T exchange(T value)
+  {
+    const T previous = value_.exchange(value, std::memory_order_acq_rel);
+    version_.fetch_add(1, std::memory_order_release);
+    return previous;
+  }
+
+  /// Integral types only. Concurrent calls don't lose increments.
+  T fetchAdd(T delta)
+  {
+    static_assert(std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                  "AtomicCell::fetchAdd requires an integral type");
+    const T previous = value_.fetch_add(delta, std::memory_order_acq_rel);
+    version_.fetch_add(1, std::memory_order_release);
+    return previous;
+  }
+
+  /// Incremented at each store(). Can be used to detect changes cheaply.
+  [[nodiscard]] uint64_t version() const
+  {
+    return version_.load(std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<T> value_;
+  std::atomic<uint64_t> version_ = 0;
+};
+
+/**
+ * @brief RcuCell stores a large value that is read often and
+ * written rarely (a map, a path, a point cloud).
+ *
+ * The value is immutable: a writer publishes a new version,
+ * swapping a std::shared_ptr<const T>. Readers get a snapshot that
+ * remains valid (and unchanged) as long as they hold it; they never wait
+ * for a writer to complete the copy of the value.
+ */
+template <typename T>
+class RcuCell
+{
+public:
+  using ConstPtr = std::shared_ptr<const T>;
+
+  RcuCell() = default;
+
+  explicit RcuCell(ConstPtr value) : value_(std::move(value))
+  {}
+
+  RcuCell(const RcuCell&) = delete;
+  RcuCell& operator=(const RcuCell&) = delete;
+
+  /// Snapshot of the current value. May be nullptr, if never stored.
+  [[nodiscard]] ConstPtr load() const
+  {
+    return std::atomic_load_explicit(&value_, std::memory_order_acquire);
+  }
+
+  void store(ConstPtr value)
+  {
+    std::atomic_store_explicit(&value_, std::move(value), std::memory_order_release);
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  void store(T value)
+  {
+    store(std::make_shared<const T>(std::move(value)));
+  }
+
+  /**
+   * @brief Read-copy-update: apply a function to a copy of the current value
+   * and publish the result. Concurrent calls to update() don't lose changes.
+   */
+  template <typename Func>
+  void update(Func&& func)
+  {
+    ConstPtr current = load();
+    while (true)
+    {
+      auto modified = current ? std::make_shared<T>(*current) : std::make_shared<T>();
+      func(*modified);
+      ConstPtr desired = std::move(modified);
+      if (std::atomic_compare_exchange_weak_explicit(&value_, &current, desired,
+                                                     std::memory_order_acq_rel,
+                                                     std::memory_order_acquire))
+      {
+        break;
+      }
+    }
+    version_.fetch_add(1, std::memory_order_release);
+  }
+
+  /// Incremented at each store(). Can be used to detect changes cheaply.
+  [[nodiscard]] uint64_t version() const
+  {
+    return version_.load(std::memory_order_acquire);
+  }
+
+private:
+  ConstPtr value_;
+  std::atomic<uint64_t> version_ = 0;
+};
+
+}   // namespace BT
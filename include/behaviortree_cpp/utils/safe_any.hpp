@@ -150,6 +150,20 @@ class Any
       return _any.type() == typeid(T);
     }
 
+    /// Pointer to the stored value, if it is exactly of type T (no conversion).
+    /// Return nullptr otherwise. The pointer is valid as long as Any is not modified.
+    template <typename T>
+    T* castPtr() noexcept
+    {
+      return linb::any_cast<T>(&_any);
+    }
+
+    template <typename T>
+    const T* castPtr() const noexcept
+    {
+      return linb::any_cast<T>(&_any);
+    }
+
     // copy the value (casting into dst). We preserve the destination type.
     void copyInto(Any& dst)
     {
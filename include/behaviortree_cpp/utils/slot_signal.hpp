@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <vector>
+
+namespace BT
+{
+/**
+ * @brief Same interface as Signal, for the signals of the application
+ * (the status of the nodes uses Signal, that is part of the library).
+ * The subscriber is active until it goes out of scope or Subscriber::reset() is called.
+ *
+ * The SlotSignal owns the callbacks: notify() doesn't lock any weak_ptr, it
+ * only checks a flag per subscriber, that is cleared when the last copy of the
+ * Subscriber is destroyed. Inactive callbacks are removed after the emission.
+ *
+ * empty() is a single atomic load: the emitter can skip the preparation of
+ * the arguments (for instance reading the clock) when nobody is subscribed.
+ */
+template <typename... CallableArgs>
+class SlotSignal
+{
+public:
+  using CallableFunction = std::function<void(CallableArgs...)>;
+  using Subscriber = std::shared_ptr<CallableFunction>;
+
+  void notify(CallableArgs... args)
+  {
+    if (empty())
+    {
+      // all the slots, if any, are inactive
+      slots_.clear();
+      return;
+    }
+    bool expired = false;
+    // a callback may subscribe: don't keep references to the vector
+    for (size_t i = 0; i < slots_.size(); i++)
+    {
+      Slot& slot = *slots_[i];
+      if (slot.active.load(std::memory_order_acquire))
+      {
+        slot.callback(args...);
+      }
+      else
+      {
+        expired = true;
+      }
+    }
+    if (expired)
+    {
+      removeExpired();
+    }
+  }
+
+  Subscriber subscribe(CallableFunction func)
+  {
+    auto slot = std::make_shared<Slot>(std::move(func));
+    active_count_->fetch_add(1, std::memory_order_release);
+    // the Subscriber doesn't own the callback: when its last copy is
+    // destroyed, the slot is only marked as inactive.
+    // The counter is shared, because the Subscriber may outlive the SlotSignal
+    std::shared_ptr<void> token(nullptr, [slot, count = active_count_](void*) {
+      slot->active.store(false, std::memory_order_release);
+      count->fetch_sub(1, std::memory_order_release);
+    });
+    Subscriber sub(token, &slot->callback);
+    slots_.push_back(std::move(slot));
+    return sub;
+  }
+
+  /// True if there are no active subscribers.
+  [[nodiscard]] bool empty() const
+  {
+    return active_count_->load(std::memory_order_acquire) == 0;
+  }
+
+private:
+  struct Slot
+  {
+    explicit Slot(CallableFunction func) : callback(std::move(func))
+    {}
+    CallableFunction callback;
+    std::atomic<bool> active = true;
+  };
+
+  void removeExpired()
+  {
+    for (size_t i = 0; i < slots_.size();)
+    {
+      if (slots_[i]->active.load(std::memory_order_acquire))
+      {
+        i++;
+      }
+      else
+      {
+        slots_.erase(slots_.begin() + i);
+      }
+    }
+  }
+
+  std::vector<std::shared_ptr<Slot>> slots_;
+  std::shared_ptr<std::atomic<size_t>> active_count_ =
+      std::make_shared<std::atomic<size_t>>(0);
+};
+}   // namespace BT
@@ -0,0 +1,347 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "behaviortree_cpp/contrib/json.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief StartupProfiler records how long the cold start of an application
+ * takes: registration of the nodes, loading of the plugins, reading,
+ * validating and parsing the XML files, compiling the scripts and creating
+ * the trees.
+ *
+ * Attach it to the FactoryExtensions before registering anything:
+ *
+ *   auto profiler = std::make_shared<StartupProfiler>();
+ *   extensions.setStartupProfiler(profiler);
+ *   extensions.registerNodeType<MyAction>("MyAction");
+ *   extensions.registerBehaviorTreesFromDirectory("trees");
+ *   auto tree = extensions.createTreeInArena("MainTree");
+ *   profiler->setEnabled(false);
+ *   std::ofstream("startup.json") << profiler->toJSON().dump(2);
+ *
+ * The events can also be written in the Trace Event format (writeTraceEvents),
+ * that chrome://tracing and Perfetto display as a timeline, one row per thread.
+ *
+ * Measure with measure() the steps that the extensions don't record themselves,
+ * for instance createTree() or the application-specific initialization:
+ *
+ *   {
+ *     auto scope = profiler->measure(StartupProfiler::Phase::CREATE_TREE, "MainTree");
+ *     tree = factory.createTree("MainTree");
+ *   }
+ *
+ * It is thread-safe. At most max_events events are stored; the totals of the
+ * phases include all of them. The totals are inclusive: an INSTANTIATE_NODE
+ * is also part of the CREATE_TREE that contains it.
+ */
+class StartupProfiler
+{
+public:
+  using Ptr = std::shared_ptr<StartupProfiler>;
+  using Clock = std::chrono::steady_clock;
+
+  enum class Phase : uint8_t
+  {
+    REGISTER_NODE = 0,
+    LOAD_PLUGIN,
+    READ_FILE,
+    VALIDATE_XML,
+    PARSE_XML,
+    COMPILE_SCRIPT,
+    CREATE_TREE,
+    INSTANTIATE_NODE,
+    USER,
+    COUNT_
+  };
+
+  static const char* toStr(Phase phase)
+  {
+    switch (phase)
+    {
+      case Phase::REGISTER_NODE:
+        return "register_node";
+      case Phase::LOAD_PLUGIN:
+        return "load_plugin";
+      case Phase::READ_FILE:
+        return "read_file";
+      case Phase::VALIDATE_XML:
+        return "validate_xml";
+      case Phase::PARSE_XML:
+        return "parse_xml";
+      case Phase::COMPILE_SCRIPT:
+        return "compile_script";
+      case Phase::CREATE_TREE:
+        return "create_tree";
+      case Phase::INSTANTIATE_NODE:
+        return "instantiate_node";
+      case Phase::USER:
+        return "user";
+      default:
+        return "unknown";
+    }
+  }
+
+  struct Event
+  {
+    Phase phase = Phase::USER;
+    // ID of the node, path of the plugin or of the file, name of the tree...
+    std::string name;
+    // since the creation of the profiler
+    std::chrono::nanoseconds start = {};
+    std::chrono::nanoseconds duration = {};
+    // 0 is the first thread that recorded an event
+    uint32_t thread = 0;
+  };
+
+  struct PhaseTotal
+  {
+    Phase phase = Phase::USER;
+    uint64_t count = 0;
+    std::chrono::nanoseconds total = {};
+    std::chrono::nanoseconds max = {};
+    // name of the longest event
+    std::string slowest;
+  };
+
+  /// Measure the lifetime of the scope. A default-constructed Scope measures nothing.
+  class Scope
+  {
+  public:
+    Scope() = default;
+
+    Scope(StartupProfiler* profiler, Phase phase, std::string name) :
+      profiler_(profiler), phase_(phase), name_(std::move(name)), start_(Clock::now())
+    {}
+
+    Scope(Scope&& other) noexcept :
+      profiler_(std::exchange(other.profiler_, nullptr)),
+      phase_(other.phase_),
+      name_(std::move(other.name_)),
+      start_(other.start_)
+    {}
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    Scope& operator=(Scope&&) = delete;
+
+    ~Scope()
+    {
+      stop();
+    }
+
+    /// Record the event now, instead of at the end of the scope.
+    void stop()
+    {
+      if (profiler_)
+      {
+        std::exchange(profiler_, nullptr)->record(phase_, std::move(name_), start_, Clock::now());
+      }
+    }
+
+  private:
+    StartupProfiler* profiler_ = nullptr;
+    Phase phase_ = Phase::USER;
+    std::string name_;
+    Clock::time_point start_;
+  };
+
+  explicit StartupProfiler(size_t max_events = 100000) :
+    max_events_(max_events), origin_(Clock::now())
+  {}
+
+  StartupProfiler(const StartupProfiler&) = delete;
+  StartupProfiler& operator=(const StartupProfiler&) = delete;
+
+  /// Stop recording, typically at the end of the startup: the nodes created
+  /// later by the factory are not recorded anymore.
+  void setEnabled(bool enabled)
+  {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] bool isEnabled() const
+  {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] Scope measure(Phase phase, std::string name)
+  {
+    if (!isEnabled())
+    {
+      return {};
+    }
+    return Scope(this, phase, std::move(name));
+  }
+
+  void record(Phase phase, std::string name, Clock::time_point start, Clock::time_point end)
+  {
+    const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    std::scoped_lock lk(mutex_);
+    auto& total = totals_[size_t(phase)];
+    total.count++;
+    total.total += duration;
+    if (duration > total.max || total.count == 1)
+    {
+      total.max = duration;
+      total.slowest = name;
+    }
+    end_ = std::max(end_, end);
+    if (events_.size() >= max_events_)
+    {
+      dropped_++;
+      return;
+    }
+    Event event;
+    event.phase = phase;
+    event.name = std::move(name);
+    event.start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin_);
+    event.duration = duration;
+    event.thread = threadIndex();
+    events_.push_back(std::move(event));
+  }
+
+  /// The recorded events, sorted by start time.
+  [[nodiscard]] std::vector<Event> events() const
+  {
+    std::vector<Event> out;
+    {
+      std::scoped_lock lk(mutex_);
+      out = events_;
+    }
+    std::stable_sort(out.begin(), out.end(),
+                     [](const Event& a, const Event& b) { return a.start < b.start; });
+    return out;
+  }
+
+  /// Totals of the phases with at least one event.
+  [[nodiscard]] std::vector<PhaseTotal> totals() const
+  {
+    std::vector<PhaseTotal> out;
+    std::scoped_lock lk(mutex_);
+    for (size_t i = 0; i < totals_.size(); i++)
+    {
+      if (totals_[i].count > 0)
+      {
+        out.push_back(totals_[i]);
+        out.back().phase = Phase(i);
+      }
+    }
+    return out;
+  }
+
+  /// Time from the creation of the profiler to the end of the last event.
+  [[nodiscard]] std::chrono::nanoseconds elapsed() const
+  {
+    std::scoped_lock lk(mutex_);
+    return end_ > origin_ ? std::chrono::duration_cast<std::chrono::nanoseconds>(end_ - origin_) :
+                            std::chrono::nanoseconds(0);
+  }
+
+  /// Events not stored because max_events was reached.
+  [[nodiscard]] uint64_t droppedEvents() const
+  {
+    std::scoped_lock lk(mutex_);
+    return dropped_;
+  }
+
+  /**
+   * @brief The report, in microseconds:
+   *
+   *   { "elapsed_us": 1234.5, "dropped_events": 0,
+   *     "phases": [ { "phase": "parse_xml", "count": 3, "total_us": 456.7,
+   *                   "max_us": 300.1, "slowest": "trees/main.xml" }, ... ],
+   *     "events": [ { "phase": "parse_xml", "name": "trees/main.xml",
+   *                   "start_us": 12.3, "duration_us": 300.1, "thread": 0 }, ... ] }
+   *
+   * To compare two runs in CI, use the totals of the phases: the events
+   * depend on the scheduling of the threads.
+   */
+  [[nodiscard]] nlohmann::json toJSON() const
+  {
+    auto usec = [](std::chrono::nanoseconds ns) { return double(ns.count()) * 1e-3; };
+    nlohmann::json json;
+    json["elapsed_us"] = usec(elapsed());
+    json["dropped_events"] = droppedEvents();
+    json["phases"] = nlohmann::json::array();
+    for (const auto& total : totals())
+    {
+      json["phases"].push_back({ { "phase", toStr(total.phase) },
+                                 { "count", total.count },
+                                 { "total_us", usec(total.total) },
+                                 { "max_us", usec(total.max) },
+                                 { "slowest", total.slowest } });
+    }
+    json["events"] = nlohmann::json::array();
+    for (const auto& event : events())
+    {
+      json["events"].push_back({ { "phase", toStr(event.phase) },
+                                 { "name", event.name },
+                                 { "start_us", usec(event.start) },
+                                 { "duration_us", usec(event.duration) },
+                                 { "thread", event.thread } });
+    }
+    return json;
+  }
+
+  /// Write the events as "complete" events ("ph": "X") of the Trace Event format.
+  void writeTraceEvents(std::ostream& out) const
+  {
+    auto usec = [](std::chrono::nanoseconds ns) { return double(ns.count()) * 1e-3; };
+    nlohmann::json trace;
+    trace["displayTimeUnit"] = "ms";
+    trace["traceEvents"] = nlohmann::json::array();
+    for (const auto& event : events())
+    {
+      trace["traceEvents"].push_back({ { "name", event.name },
+                                       { "cat", toStr(event.phase) },
+                                       { "ph", "X" },
+                                       { "ts", usec(event.start) },
+                                       { "dur", usec(event.duration) },
+                                       { "pid", 1 },
+                                       { "tid", event.thread } });
+    }
+    out << trace.dump();
+  }
+
+private:
+  // must be called with the mutex locked
+  uint32_t threadIndex()
+  {
+    const auto id = std::this_thread::get_id();
+    auto it = threads_.find(id);
+    if (it == threads_.end())
+    {
+      it = threads_.insert({ id, uint32_t(threads_.size()) }).first;
+    }
+    return it->second;
+  }
+
+  const size_t max_events_;
+  const Clock::time_point origin_;
+  std::atomic<bool> enabled_ = true;
+
+  mutable std::mutex mutex_;
+  std::vector<Event> events_;
+  std::array<PhaseTotal, size_t(Phase::COUNT_)> totals_ = {};
+  std::unordered_map<std::thread::id, uint32_t> threads_;
+  Clock::time_point end_ = {};
+  uint64_t dropped_ = 0;
+};
+
+}   // namespace BT
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+namespace BT
+{
+
+/**
+ * @brief InternedString is a handle to a string stored once in a StringPool.
+ *
+ * It has the size of a pointer; copy, comparison and hashing use only the
+ * address of the string. Two handles are equal if (and only if) they were
+ * interned in the same pool from the same text.
+ */
+class InternedString
+{
+public:
+  InternedString() = default;
+
+  [[nodiscard]] const std::string& str() const
+  {
+    return str_ ? *str_ : emptyString();
+  }
+
+  [[nodiscard]] std::string_view view() const
+  {
+    return str();
+  }
+
+  operator const std::string&() const
+  {
+    return str();
+  }
+
+  [[nodiscard]] bool empty() const
+  {
+    return str().empty();
+  }
+
+  bool operator==(const InternedString& other) const
+  {
+    return str_ == other.str_;
+  }
+
+  bool operator!=(const InternedString& other) const
+  {
+    return str_ != other.str_;
+  }
+
+  [[nodiscard]] size_t hash() const
+  {
+    return std::hash<const std::string*>{}(str_);
+  }
+
+private:
+  friend class StringPool;
+
+  explicit InternedString(const std::string* str) : str_(str)
+  {}
+
+  static const std::string& emptyString()
+  {
+    static const std::string empty_str;
+    return empty_str;
+  }
+
+  const std::string* str_ = nullptr;
+};
+
+/**
+ * @brief StringPool stores a single copy of each identifier (node names,
+ * port names, blackboard keys) and returns an InternedString for it.
+ *
+ * The strings are released when the pool is destroyed; a handle must not
+ * outlive its pool. It is thread-safe.
+ */
+class StringPool
+{
+public:
+  using Ptr = std::shared_ptr<StringPool>;
+
+  StringPool() = default;
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  [[nodiscard]] InternedString intern(std::string_view str)
+  {
+    if (str.empty())
+    {
+      return {};
+    }
+    {
+      std::shared_lock lk(mutex_);
+#if defined(__cpp_lib_generic_unordered_lookup)
+      auto it = strings_.find(str);
+#else
+      auto it = strings_.find(std::string(str));
+#endif
+      if (it != strings_.end())
+      {
+        return InternedString(&(*it));
+      }
+    }
+    std::unique_lock lk(mutex_);
+    // the nodes of std::unordered_set are never moved: the address is stable
+    auto it = strings_.emplace(str).first;
+    return InternedString(&(*it));
+  }
+
+  [[nodiscard]] size_t size() const
+  {
+    std::shared_lock lk(mutex_);
+    return strings_.size();
+  }
+
+private:
+  // transparent lookup, to search a string_view without creating a std::string (C++20)
+  struct Hash
+  {
+    using is_transparent = void;
+    size_t operator()(std::string_view str) const
+    {
+      return std::hash<std::string_view>{}(str);
+    }
+  };
+
+  struct Equal
+  {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const
+    {
+      return a == b;
+    }
+  };
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_set<std::string, Hash, Equal> strings_;
+};
+
+}   // namespace BT
+
+template <>
+struct std::hash<BT::InternedString>
+{
+  size_t operator()(const BT::InternedString& str) const
+  {
+    return str.hash();
+  }
+};
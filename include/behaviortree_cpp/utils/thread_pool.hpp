@@ -0,0 +1,369 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "behaviortree_cpp/utils/cpu_topology.hpp"
+
+namespace BT
+{
+
+/**
+ * @brief Fixed size thread pool with work-stealing.
+ *
+ * Each worker owns a queue: tasks submitted by a worker are pushed
+ * into its own queue (and popped LIFO, to keep the caches warm), while
+ * tasks submitted from other threads are distributed round-robin.
+ * An idle worker steals the oldest tasks of the other workers.
+ *
+ * The workers can be pinned to CPUs or NUMA nodes (see Placement); then
+ * the tasks submitted from other threads go to a worker of the NUMA node
+ * of the caller, and the workers steal from the same node first.
+ *
+ * The destructor waits for the tasks already submitted to complete.
+ */
+class WorkStealingPool
+{
+public:
+  using Task = std::function<void()>;
+
+  enum class Pinning
+  {
+    /// the threads are scheduled freely by the OS
+    NONE,
+    /// each worker is bound to one CPU, filling a NUMA node before the next
+    CORE,
+    /// the workers are distributed evenly on the NUMA nodes, each bound
+    /// to all the CPUs of its node
+    NUMA_NODE
+  };
+
+  struct Placement
+  {
+    Pinning pinning = Pinning::NONE;
+    /// if false, a worker never steals the tasks of another NUMA node
+    bool steal_across_nodes = true;
+  };
+
+  /// Where a worker runs; -1 if it is not pinned.
+  struct WorkerPlacement
+  {
+    int cpu = -1;
+    int numa_node = -1;
+  };
+
+  /// @param num_threads  if 0, use std::thread::hardware_concurrency()
+  explicit WorkStealingPool(size_t num_threads = 0) :
+    WorkStealingPool(num_threads, Placement())
+  {}
+
+  WorkStealingPool(size_t num_threads, Placement placement) : placement_(placement)
+  {
+    if (num_threads == 0)
+    {
+      num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    placeWorkers(num_threads);
+    queues_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++)
+    {
+      queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; i++)
+    {
+      workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  ~WorkStealingPool()
+  {
+    {
+      std::scoped_lock lk(wake_mutex_);
+      stopping_ = true;
+    }
+    wake_cv_.notify_all();
+    for (auto& worker : workers_)
+    {
+      worker.join();
+    }
+  }
+
+  [[nodiscard]] size_t size() const
+  {
+    return workers_.size();
+  }
+
+  /// Number of tasks submitted, but not started yet.
+  [[nodiscard]] size_t pendingTasks() const
+  {
+    return pending_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] const std::vector<WorkerPlacement>& placement() const
+  {
+    return worker_placement_;
+  }
+
+  [[nodiscard]] bool isPinned() const
+  {
+    return placement_.pinning != Pinning::NONE;
+  }
+
+  /**
+   * @brief Thread-safe. Tasks must not throw: exceptions are caught and ignored.
+   *
+   * @param numa_node  prefer a worker of this node. If -1, the worker that
+   *                   submits the task, or a worker of the node of the caller.
+   */
+  void submit(Task task, int numa_node = -1)
+  {
+    const int self = currentWorkerIndex();
+    size_t index = 0;
+    if (numa_node < 0 && self >= 0 && currentPool() == this)
+    {
+      index = size_t(self);
+    }
+    else
+    {
+      if (numa_node < 0 && isPinned())
+      {
+        numa_node = CpuTopology::get().currentNode();
+      }
+      const size_t ticket = next_queue_.fetch_add(1, std::memory_order_relaxed);
+      const auto& local = (numa_node >= 0 && size_t(numa_node) < node_workers_.size()) ?
+                              node_workers_[size_t(numa_node)] :
+                              all_workers_;
+      index = local.empty() ? ticket % queues_.size() : local[ticket % local.size()];
+    }
+    push(index, std::move(task));
+  }
+
+  /// Push the task in the queue of a worker (for instance, the one pinned to
+  /// a given CPU). Other workers may still steal it, when they are idle.
+  void submitToWorker(size_t worker, Task task)
+  {
+    push(worker % queues_.size(), std::move(task));
+  }
+
+private:
+  void push(size_t index, Task task)
+  {
+    {
+      // increment first, so that pending_ never underflows
+      std::scoped_lock lk(wake_mutex_);
+      pending_++;
+    }
+    {
+      auto& queue = *queues_[index];
+      std::scoped_lock lk(queue.mutex);
+      queue.tasks.push_back(std::move(task));
+    }
+    if (!placement_.steal_across_nodes && isPinned())
+    {
+      // only the workers of the same node can execute it
+      wake_cv_.notify_all();
+    }
+    else
+    {
+      wake_cv_.notify_one();
+    }
+  }
+
+  struct WorkerQueue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  const Placement placement_;
+  std::vector<WorkerPlacement> worker_placement_;
+  // the workers of each NUMA node (empty if not pinned)
+  std::vector<std::vector<size_t>> node_workers_;
+  std::vector<size_t> all_workers_;
+  // for each worker, the queues to steal from: same node first
+  std::vector<std::vector<size_t>> steal_order_;
+
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> next_queue_ = 0;
+  std::atomic<size_t> pending_ = 0;
+
+  std::mutex wake_mutex_;
+  std::condition_variable wake_cv_;
+  bool stopping_ = false;
+
+  static int& currentWorkerIndex()
+  {
+    thread_local int index = -1;
+    return index;
+  }
+
+  static WorkStealingPool*& currentPool()
+  {
+    thread_local WorkStealingPool* pool = nullptr;
+    return pool;
+  }
+
+  bool popLocal(size_t index, Task& task)
+  {
+    auto& queue = *queues_[index];
+    std::scoped_lock lk(queue.mutex);
+    if (queue.tasks.empty())
+    {
+      return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+  }
+
+  void placeWorkers(size_t num_threads)
+  {
+    const auto& topology = CpuTopology::get();
+    worker_placement_.assign(num_threads, WorkerPlacement());
+    if (placement_.pinning == Pinning::CORE)
+    {
+      std::vector<int> cpus;
+      for (size_t node = 0; node < topology.numaNodes(); node++)
+      {
+        const auto& node_cpus = topology.cpusOfNode(node);
+        cpus.insert(cpus.end(), node_cpus.begin(), node_cpus.end());
+      }
+      for (size_t i = 0; i < num_threads && !cpus.empty(); i++)
+      {
+        const int cpu = cpus[i % cpus.size()];
+        worker_placement_[i] = { cpu, topology.nodeOfCpu(cpu) };
+      }
+    }
+    else if (placement_.pinning == Pinning::NUMA_NODE)
+    {
+      for (size_t i = 0; i < num_threads; i++)
+      {
+        worker_placement_[i].numa_node = int(i * topology.numaNodes() / num_threads);
+      }
+    }
+
+    all_workers_.clear();
+    for (size_t i = 0; i < num_threads; i++)
+    {
+      all_workers_.push_back(i);
+    }
+    node_workers_.assign(isPinned() ? topology.numaNodes() : 0, {});
+    for (size_t i = 0; i < num_threads && isPinned(); i++)
+    {
+      const int node = worker_placement_[i].numa_node;
+      if (node >= 0 && size_t(node) < node_workers_.size())
+      {
+        node_workers_[size_t(node)].push_back(i);
+      }
+    }
+
+    steal_order_.assign(num_threads, {});
+    for (size_t thief = 0; thief < num_threads; thief++)
+    {
+      const int node = worker_placement_[thief].numa_node;
+      std::vector<size_t> remote;
+      for (size_t i = 1; i < num_threads; i++)
+      {
+        const size_t victim = (thief + i) % num_threads;
+        if (worker_placement_[victim].numa_node == node)
+        {
+          steal_order_[thief].push_back(victim);
+        }
+        else if (placement_.steal_across_nodes)
+        {
+          remote.push_back(victim);
+        }
+      }
+      steal_order_[thief].insert(steal_order_[thief].end(), remote.begin(), remote.end());
+    }
+  }
+
+  void pinCurrentWorker(size_t index)
+  {
+    const auto& where = worker_placement_[index];
+    if (where.cpu >= 0)
+    {
+      SetCurrentThreadAffinity({ where.cpu });
+    }
+    else if (where.numa_node >= 0)
+    {
+      SetCurrentThreadAffinity(CpuTopology::get().cpusOfNode(size_t(where.numa_node)));
+    }
+  }
+
+  bool steal(size_t thief, Task& task)
+  {
+    for (size_t victim : steal_order_[thief])
+    {
+      auto& queue = *queues_[victim];
+      std::unique_lock lk(queue.mutex, std::try_to_lock);
+      if (lk.owns_lock() && !queue.tasks.empty())
+      {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void workerLoop(size_t index)
+  {
+    currentWorkerIndex() = int(index);
+    currentPool() = this;
+    pinCurrentWorker(index);
+
+    Task task;
+    while (true)
+    {
+      if (pending_.load(std::memory_order_acquire) > 0 &&
+          (popLocal(index, task) || steal(index, task)))
+      {
+        pending_--;
+        try
+        {
+          task();
+        }
+        catch (...)
+        {}
+        task = nullptr;
+        continue;
+      }
+
+      std::unique_lock lk(wake_mutex_);
+      if (stopping_ && pending_ == 0)
+      {
+        return;
+      }
+      if (pending_ == 0)
+      {
+        wake_cv_.wait(lk, [this] { return stopping_ || pending_ > 0; });
+      }
+      else if (!placement_.steal_across_nodes && isPinned())
+      {
+        // the pending tasks may belong to another node: don't spin
+        wake_cv_.wait_for(lk, std::chrono::microseconds(200));
+      }
+      else
+      {
+        // another worker owns the queue we failed to steal from, retry soon.
+        lk.unlock();
+        std::this_thread::yield();
+      }
+    }
+  }
+};
+
+}   // namespace BT
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <chrono>
+
+namespace BT
+{
+
+/**
+ * @brief TickBudget is the deadline of the tick in progress in the current
+ * thread, set by a TickBudget::Scope (see Tree::tickOnce(deadline)).
+ *
+ * Cooperative nodes can query it, for instance a StatefulActionNode that
+ * processes a long list of items in onRunning() can stop when the budget
+ * is spent and continue at the next tick:
+ *
+ *   while (hasWork() && !TickBudget::expired()) { doSomeWork(); }
+ *   return hasWork() ? NodeStatus::RUNNING : NodeStatus::SUCCESS;
+ *
+ * Without a scope, the budget is unlimited.
+ */
+class TickBudget
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  class Scope
+  {
+  public:
+    explicit Scope(Clock::time_point deadline) : previous_(current())
+    {
+      state_.deadline = deadline;
+      current() = &state_;
+    }
+
+    explicit Scope(Clock::duration budget) : Scope(Clock::now() + budget)
+    {}
+
+    ~Scope()
+    {
+      current() = previous_;
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    /// True if the deadline passed while the scope was active,
+    /// i.e. a node claimed the overrun.
+    [[nodiscard]] bool overrun() const
+    {
+      return state_.overrun_claimed;
+    }
+
+  private:
+    friend class TickBudget;
+    struct State
+    {
+      Clock::time_point deadline;
+      bool overrun_claimed = false;
+    };
+    State state_;
+    State* previous_;
+  };
+
+  [[nodiscard]] static bool active()
+  {
+    return current() != nullptr;
+  }
+
+  /// Deadline of the tick, Clock::time_point::max() without a scope.
+  [[nodiscard]] static Clock::time_point deadline()
+  {
+    const auto* state = current();
+    return state ? state->deadline : Clock::time_point::max();
+  }
+
+  /// Time left, negative if the deadline passed.
+  [[nodiscard]] static Clock::duration remaining()
+  {
+    const auto* state = current();
+    return state ? state->deadline - Clock::now() : Clock::duration::max();
+  }
+
+  [[nodiscard]] static bool expired()
+  {
+    return expiredAt(Clock::now());
+  }
+
+  /// Same as expired(), for a clock reading of the caller.
+  [[nodiscard]] static bool expiredAt(Clock::time_point now)
+  {
+    const auto* state = current();
+    return state && now >= state->deadline;
+  }
+
+  /**
+   * @brief Used to blame a single node for an overrun: the first call
+   * after the deadline returns true, the following ones false.
+   * Since a node returns before its parent, the deepest node that was
+   * executing when the deadline passed claims it.
+   */
+  static bool claimOverrun()
+  {
+    auto* state = current();
+    if (!state || state->overrun_claimed)
+    {
+      return false;
+    }
+    state->overrun_claimed = true;
+    return true;
+  }
+
+private:
+  static Scope::State*& current()
+  {
+    thread_local Scope::State* state = nullptr;
+    return state;
+  }
+};
+
+}   // namespace BT
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+
+#include "behaviortree_cpp/basic_types.h"
+
+namespace BT
+{
+
+/**
+ * @brief TickClock is the clock of the status changes: while a
+ * TickClock::Scope is active in the current thread, now() returns the time
+ * the scope was opened, i.e. the beginning of the tick, instead of reading
+ * the clock at each transition.
+ *
+ * All the transitions of one tick get the same timestamp, that loggers can
+ * compare to group them. TreeExecutor and TreeRunner open a scope for each tick.
+ *
+ * The emitters of the application can read the timestamp from here, and only
+ * when SlotSignal::empty() is false. TreeNode::setStatus() is library code and
+ * reads the clock itself.
+ */
+class TickClock
+{
+public:
+  using Clock = std::chrono::high_resolution_clock;
+
+  [[nodiscard]] static TimePoint now()
+  {
+    const TimePoint* tick = current();
+    return tick ? *tick : Clock::now();
+  }
+
+  class Scope
+  {
+  public:
+    explicit Scope(TimePoint tick_time = Clock::now()) :
+      tick_time_(tick_time), previous_(current())
+    {
+      current() = &tick_time_;
+    }
+
+    ~Scope()
+    {
+      current() = previous_;
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    TimePoint tick_time_;
+    const TimePoint* previous_;
+  };
+
+private:
+  static const TimePoint*& current()
+  {
+    thread_local const TimePoint* tick = nullptr;
+    return tick;
+  }
+};
+
+}   // namespace BT
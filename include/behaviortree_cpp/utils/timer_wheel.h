@@ -0,0 +1,568 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp/utils/lock_profiler.hpp"
+
+namespace BT
+{
+
+class SharedTimerQueue;
+
+/**
+ * @brief TimerWheel is a hierarchical timer wheel with a resolution of one
+ * millisecond, shared by many timing nodes (see SharedTimerQueue), instead
+ * of a thread for each TimerQueue.
+ *
+ * It is opt-in: SleepNode, DelayNode and TimeoutNode are compiled in the
+ * library and keep their own TimerQueue. The nodes of the application use
+ * a SharedTimerQueue, as CoAwaitActionNode and LoadTestNode do.
+ *
+ * Adding and cancelling a timer is O(1). The timers expiring within 256 ms
+ * are in the first wheel; the others in three wheels of 64 slots (up to
+ * about 18 hours) or in an overflow list, and they move to the lower wheels
+ * while time passes.
+ *
+ * The handlers are executed once, with aborted == true if cancelled, as in
+ * TimerQueue. They are executed either:
+ *
+ * - by the thread of the wheel (Service::THREAD), or
+ * - by the thread that calls poll() (Service::EXTERNAL), for instance
+ *   the thread that ticks the tree, between two ticks.
+ */
+class TimerWheel
+{
+public:
+  using Clock = std::chrono::steady_clock;
+  using Handler = std::function<void(bool)>;
+
+  enum class Service
+  {
+    THREAD,
+    EXTERNAL
+  };
+
+  explicit TimerWheel(Service service = Service::THREAD) :
+    service_(service), start_(Clock::now())
+  {
+    if (service_ == Service::THREAD)
+    {
+      thread_ = std::thread([this] { run(); });
+    }
+  }
+
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  /// The SharedTimerQueues own the wheel: none of their timers is left here.
+  ~TimerWheel()
+  {
+    {
+      std::unique_lock lk(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable())
+    {
+      thread_.join();
+    }
+  }
+
+  /// The wheel used by default, with its own thread.
+  [[nodiscard]] static const std::shared_ptr<TimerWheel>& global()
+  {
+    static const auto wheel = std::make_shared<TimerWheel>();
+    return wheel;
+  }
+
+  /// The wheel of the innermost TimerWheelScope of this thread, otherwise global().
+  [[nodiscard]] static std::shared_ptr<TimerWheel> current()
+  {
+    auto* scoped = currentScoped();
+    return scoped ? *scoped : global();
+  }
+
+  [[nodiscard]] Service service() const
+  {
+    return service_;
+  }
+
+  /// Number of timers waiting to expire.
+  [[nodiscard]] size_t size() const
+  {
+    std::unique_lock lk(mutex_);
+    return timers_.size();
+  }
+
+  /**
+   * @brief Execute the handlers of the timers expired or cancelled.
+   * Used with Service::EXTERNAL.
+   *
+   * @return the number of handlers executed
+   */
+  size_t poll()
+  {
+    std::unique_lock lk(mutex_);
+    advanceTo(floorTick(Clock::now()));
+    return runReady(lk);
+  }
+
+  /// When poll() should be called next, or nothing if there are no timers.
+  [[nodiscard]] std::optional<Clock::time_point> nextDeadline() const
+  {
+    std::unique_lock lk(mutex_);
+    if (!ready_.empty())
+    {
+      return Clock::now();
+    }
+    if (auto tick = nextTick())
+    {
+      return timeOf(*tick);
+    }
+    return std::nullopt;
+  }
+
+private:
+  friend class SharedTimerQueue;
+  friend class TimerWheelScope;
+
+  using Mutex = SiteMutex<std::mutex, LockSites::TimerWheel>;
+
+  // the timers of a SharedTimerQueue. Protected by mutex_
+  struct Owner
+  {
+    // added and not executed yet
+    size_t pending = 0;
+    ConditionVariableFor<Mutex> done;
+  };
+
+  struct Timer
+  {
+    uint64_t expiry;
+    Handler handler;
+    Owner* owner;
+  };
+
+  struct Ready
+  {
+    uint64_t id;
+    bool aborted;
+    Handler handler;
+    Owner* owner;
+  };
+
+  static constexpr uint64_t LEVEL0_BITS = 8;
+  static constexpr uint64_t LEVEL_BITS = 6;
+  static constexpr size_t LEVELS = 3;
+
+  static std::shared_ptr<TimerWheel>*& currentScoped()
+  {
+    thread_local std::shared_ptr<TimerWheel>* wheel = nullptr;
+    return wheel;
+  }
+
+  uint64_t floorTick(Clock::time_point time) const
+  {
+    return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(time - start_).count());
+  }
+
+  // a timer never expires before its time
+  uint64_t ceilTick(Clock::time_point time) const
+  {
+    const auto elapsed = time - start_;
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+    if (ms < elapsed)
+    {
+      ms += std::chrono::milliseconds(1);
+    }
+    return uint64_t(ms.count());
+  }
+
+  Clock::time_point timeOf(uint64_t tick) const
+  {
+    return start_ + std::chrono::milliseconds(tick);
+  }
+
+  uint64_t add(Owner& owner, std::chrono::milliseconds delay, Handler handler)
+  {
+    const uint64_t expiry = ceilTick(Clock::now() + delay);
+    std::unique_lock lk(mutex_);
+    const uint64_t id = ++id_counter_;
+    owner.pending++;
+    if (expiry <= current_tick_)
+    {
+      ready_.push_back({ id, false, std::move(handler), &owner });
+    }
+    else
+    {
+      timers_.emplace(id, Timer{ expiry, std::move(handler), &owner });
+      insert(id, expiry);
+    }
+    lk.unlock();
+    cv_.notify_one();
+    return id;
+  }
+
+  size_t cancel(Owner& owner, uint64_t id)
+  {
+    std::unique_lock lk(mutex_);
+    auto it = timers_.find(id);
+    if (it == timers_.end() || it->second.owner != &owner)
+    {
+      return 0;
+    }
+    // the slot keeps the id until it is visited
+    ready_.push_back({ id, true, std::move(it->second.handler), &owner });
+    timers_.erase(it);
+    lk.unlock();
+    cv_.notify_one();
+    return 1;
+  }
+
+  size_t cancelAll(Owner& owner)
+  {
+    std::unique_lock lk(mutex_);
+    const size_t count = cancelAllLocked(owner);
+    lk.unlock();
+    if (count > 0)
+    {
+      cv_.notify_one();
+    }
+    return count;
+  }
+
+  // cancel the timers of the owner, execute their handlers in this thread and
+  // wait for those executed by the service.
+  void release(Owner& owner)
+  {
+    std::unique_lock lk(mutex_);
+    if (owner.pending == 0)
+    {
+      return;
+    }
+    cancelAllLocked(owner);
+    std::vector<Ready> own;
+    for (auto it = ready_.begin(); it != ready_.end();)
+    {
+      if (it->owner == &owner)
+      {
+        own.push_back(std::move(*it));
+        it = ready_.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+    for (auto& item : own)
+    {
+      lk.unlock();
+      item.handler(item.aborted);
+      lk.lock();
+      owner.pending--;
+    }
+    // a handler may destroy its own timer queue
+    if (executing_ != std::this_thread::get_id())
+    {
+      owner.done.wait(lk, [&owner] { return owner.pending == 0; });
+    }
+  }
+
+  size_t cancelAllLocked(Owner& owner)
+  {
+    size_t count = 0;
+    if (owner.pending == 0)
+    {
+      return count;
+    }
+    for (auto it = timers_.begin(); it != timers_.end();)
+    {
+      if (it->second.owner == &owner)
+      {
+        ready_.push_back({ it->first, true, std::move(it->second.handler), &owner });
+        it = timers_.erase(it);
+        count++;
+      }
+      else
+      {
+        ++it;
+      }
+    }
+    return count;
+  }
+
+  std::vector<uint64_t>& slotOf(uint64_t expiry)
+  {
+    const uint64_t delta = expiry > current_tick_ ? expiry - current_tick_ : 0;
+    if (delta < (uint64_t(1) << LEVEL0_BITS))
+    {
+      return level0_[expiry & ((uint64_t(1) << LEVEL0_BITS) - 1)];
+    }
+    for (size_t level = 0; level < LEVELS; level++)
+    {
+      const uint64_t shift = LEVEL0_BITS + LEVEL_BITS * level;
+      if (delta < (uint64_t(1) << (shift + LEVEL_BITS)))
+      {
+        return levels_[level][(expiry >> shift) & ((uint64_t(1) << LEVEL_BITS) - 1)];
+      }
+    }
+    return overflow_;
+  }
+
+  void insert(uint64_t id, uint64_t expiry)
+  {
+    slotOf(expiry).push_back(id);
+  }
+
+  // move the timers of a slot to the lower wheels
+  void cascade(std::vector<uint64_t>& slot)
+  {
+    std::vector<uint64_t> ids;
+    ids.swap(slot);
+    for (uint64_t id : ids)
+    {
+      auto it = timers_.find(id);
+      if (it != timers_.end())
+      {
+        insert(id, it->second.expiry);
+      }
+    }
+  }
+
+  void advanceTo(uint64_t tick)
+  {
+    constexpr uint64_t mask0 = (uint64_t(1) << LEVEL0_BITS) - 1;
+    constexpr uint64_t mask = (uint64_t(1) << LEVEL_BITS) - 1;
+    while (current_tick_ < tick)
+    {
+      if (timers_.empty())
+      {
+        // stale ids of the cancelled timers may be left in the slots
+        current_tick_ = tick;
+        return;
+      }
+      const uint64_t t = ++current_tick_;
+      if ((t & mask0) == 0)
+      {
+        size_t level = 0;
+        for (; level < LEVELS; level++)
+        {
+          const uint64_t index = (t >> (LEVEL0_BITS + LEVEL_BITS * level)) & mask;
+          cascade(levels_[level][index]);
+          if (index != 0)
+          {
+            break;
+          }
+        }
+        if (level == LEVELS)
+        {
+          cascade(overflow_);
+        }
+      }
+
+      auto& slot = level0_[t & mask0];
+      std::vector<uint64_t> ids;
+      ids.swap(slot);
+      for (uint64_t id : ids)
+      {
+        auto it = timers_.find(id);
+        if (it == timers_.end())
+        {
+          continue;
+        }
+        if (it->second.expiry > t)
+        {
+          insert(id, it->second.expiry);
+          continue;
+        }
+        ready_.push_back({ id, false, std::move(it->second.handler), it->second.owner });
+        timers_.erase(it);
+      }
+    }
+  }
+
+  // the next tick to visit: the first expiry in the lower wheel or
+  // the next cascade of the other wheels.
+  std::optional<uint64_t> nextTick() const
+  {
+    if (timers_.empty())
+    {
+      return std::nullopt;
+    }
+    constexpr uint64_t size0 = uint64_t(1) << LEVEL0_BITS;
+    for (uint64_t t = current_tick_ + 1; t <= current_tick_ + size0; t++)
+    {
+      for (uint64_t id : level0_[t & (size0 - 1)])
+      {
+        auto it = timers_.find(id);
+        if (it != timers_.end() && it->second.expiry == t)
+        {
+          return t;
+        }
+      }
+      if ((t & (size0 - 1)) == 0)
+      {
+        return t;
+      }
+    }
+    return current_tick_ + size0;
+  }
+
+  size_t runReady(std::unique_lock<Mutex>& lk)
+  {
+    size_t count = 0;
+    while (!ready_.empty())
+    {
+      Ready item = std::move(ready_.front());
+      ready_.pop_front();
+      executing_ = std::this_thread::get_id();
+      lk.unlock();
+      item.handler(item.aborted);
+      lk.lock();
+      executing_ = std::thread::id();
+      if (--item.owner->pending == 0)
+      {
+        // under lock: the owner can't be destroyed before this
+        item.owner->done.notify_all();
+      }
+      count++;
+    }
+    return count;
+  }
+
+  void run()
+  {
+    std::unique_lock lk(mutex_);
+    while (!stop_)
+    {
+      advanceTo(floorTick(Clock::now()));
+      if (!ready_.empty())
+      {
+        runReady(lk);
+        continue;
+      }
+      if (auto tick = nextTick())
+      {
+        cv_.wait_until(lk, timeOf(*tick));
+      }
+      else
+      {
+        cv_.wait(lk);
+      }
+    }
+  }
+
+  const Service service_;
+  const Clock::time_point start_;
+
+  mutable Mutex mutex_;
+  ConditionVariableFor<Mutex> cv_;
+  bool stop_ = false;
+  std::thread thread_;
+  // the thread executing a handler
+  std::thread::id executing_;
+
+  uint64_t id_counter_ = 0;
+  uint64_t current_tick_ = 0;
+  std::unordered_map<uint64_t, Timer> timers_;
+  std::array<std::vector<uint64_t>, size_t(1) << LEVEL0_BITS> level0_;
+  std::array<std::array<std::vector<uint64_t>, size_t(1) << LEVEL_BITS>, LEVELS> levels_;
+  std::vector<uint64_t> overflow_;
+  std::deque<Ready> ready_;
+};
+
+/**
+ * @brief While a TimerWheelScope is alive, the SharedTimerQueues created
+ * by the current thread (in particular by the nodes of a tree being created)
+ * use the given wheel instead of TimerWheel::global().
+ *
+ * Scopes can be nested; the destructor restores the previous wheel.
+ */
+class TimerWheelScope
+{
+public:
+  explicit TimerWheelScope(std::shared_ptr<TimerWheel> wheel) :
+    wheel_(std::move(wheel)), previous_(TimerWheel::currentScoped())
+  {
+    TimerWheel::currentScoped() = &wheel_;
+  }
+
+  TimerWheelScope(const TimerWheelScope&) = delete;
+  TimerWheelScope& operator=(const TimerWheelScope&) = delete;
+
+  ~TimerWheelScope()
+  {
+    TimerWheel::currentScoped() = previous_;
+  }
+
+private:
+  std::shared_ptr<TimerWheel> wheel_;
+  std::shared_ptr<TimerWheel>* previous_;
+};
+
+/**
+ * @brief SharedTimerQueue has the same interface and guarantees of TimerQueue,
+ * but its timers are managed by a shared TimerWheel (by default, the one of
+ * the current TimerWheelScope or TimerWheel::global()): it doesn't start
+ * a thread.
+ *
+ * The destructor cancels the timers: their handlers are executed before
+ * it returns.
+ */
+class SharedTimerQueue
+{
+public:
+  SharedTimerQueue() : SharedTimerQueue(TimerWheel::current())
+  {}
+
+  explicit SharedTimerQueue(std::shared_ptr<TimerWheel> wheel) : wheel_(std::move(wheel))
+  {}
+
+  SharedTimerQueue(const SharedTimerQueue&) = delete;
+  SharedTimerQueue& operator=(const SharedTimerQueue&) = delete;
+
+  ~SharedTimerQueue()
+  {
+    wheel_->release(owner_);
+  }
+
+  //! Adds a new timer. Returns its ID, that can be used to cancel it.
+  uint64_t add(std::chrono::milliseconds milliseconds, std::function<void(bool)> handler)
+  {
+    return wheel_->add(owner_, milliseconds, std::move(handler));
+  }
+
+  //! Cancels a timer: its handler will be executed with aborted == true.
+  //! Returns 1 if the timer was cancelled, 0 if it was too late or the ID is not valid.
+  size_t cancel(uint64_t id)
+  {
+    return wheel_->cancel(owner_, id);
+  }
+
+  //! Cancels all the timers of this queue. Returns the number of timers cancelled.
+  size_t cancelAll()
+  {
+    return wheel_->cancelAll(owner_);
+  }
+
+  [[nodiscard]] const std::shared_ptr<TimerWheel>& wheel() const
+  {
+    return wheel_;
+  }
+
+private:
+  std::shared_ptr<TimerWheel> wheel_;
+  TimerWheel::Owner owner_;
+};
+
+}   // namespace BT
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+#include "behaviortree_cpp/utils/demangle_util.h"
+
+namespace BT
+{
+
+/**
+ * @brief TypeID is a compact identifier of a C++ type: a 32 bits integer,
+ * assigned the first time the type is seen and unique in the process.
+ *
+ * Comparing two TypeIDs is an integer comparison and the demangled name
+ * of the type is computed only once, when the type is registered.
+ *
+ *   TypeID::of<T>()          // cached in a static variable, no lookup
+ *   TypeID::of(any.type())   // lookup in the registry
+ */
+class TypeID
+{
+public:
+  /// The invalid TypeID, name "void"
+  TypeID() = default;
+
+  template <typename T>
+  [[nodiscard]] static TypeID of()
+  {
+    static const TypeID id = of(std::type_index(typeid(T)));
+    return id;
+  }
+
+  [[nodiscard]] static TypeID of(const std::type_index& type)
+  {
+    return TypeID(registry().find(type));
+  }
+
+  [[nodiscard]] static TypeID of(const std::type_info& type)
+  {
+    return of(std::type_index(type));
+  }
+
+  [[nodiscard]] uint32_t value() const
+  {
+    return id_;
+  }
+
+  [[nodiscard]] bool valid() const
+  {
+    return id_ != 0;
+  }
+
+  /// Demangled name of the type. The reference remains valid forever.
+  [[nodiscard]] const std::string& name() const
+  {
+    return registry().record(id_).name;
+  }
+
+  [[nodiscard]] std::type_index typeIndex() const
+  {
+    return registry().record(id_).type;
+  }
+
+  bool operator==(const TypeID& other) const
+  {
+    return id_ == other.id_;
+  }
+
+  bool operator!=(const TypeID& other) const
+  {
+    return id_ != other.id_;
+  }
+
+  bool operator<(const TypeID& other) const
+  {
+    return id_ < other.id_;
+  }
+
+private:
+  explicit TypeID(uint32_t id) : id_(id)
+  {}
+
+  struct Record
+  {
+    std::type_index type;
+    std::string name;
+  };
+
+  class Registry
+  {
+  public:
+    Registry()
+    {
+      records_.push_back({typeid(void), "void"});
+    }
+
+    uint32_t find(const std::type_index& type)
+    {
+      {
+        std::shared_lock lk(mutex_);
+        auto it = ids_.find(type);
+        if (it != ids_.end())
+        {
+          return it->second;
+        }
+      }
+      // demangle outside the lock; another thread may register the same type
+      std::string name = demangle(type);
+      std::unique_lock lk(mutex_);
+      auto [it, inserted] = ids_.emplace(type, uint32_t(records_.size()));
+      if (inserted)
+      {
+        records_.push_back({type, std::move(name)});
+      }
+      return it->second;
+    }
+
+    const Record& record(uint32_t id) const
+    {
+      // std::deque never moves its elements when growing at the end
+      std::shared_lock lk(mutex_);
+      return records_[id];
+    }
+
+  private:
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::type_index, uint32_t> ids_;
+    std::deque<Record> records_;
+  };
+
+  static Registry& registry()
+  {
+    static Registry registry;
+    return registry;
+  }
+
+  uint32_t id_ = 0;
+};
+
+/// Same as BT::demangle(), but the name is computed only once per type.
+[[nodiscard]] inline const std::string& DemangledName(const std::type_index& type)
+{
+  return TypeID::of(type).name();
+}
+
+}   // namespace BT
+
+template <>
+struct std::hash<BT::TypeID>
+{
+  size_t operator()(const BT::TypeID& id) const
+  {
+    return std::hash<uint32_t>{}(id.value());
+  }
+};
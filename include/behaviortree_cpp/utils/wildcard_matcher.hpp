@@ -0,0 +1,240 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace BT
+{
+
+// see bt_factory.h
+bool WildcardMatch(const std::string& str, std::string_view filter);
+
+/**
+ * @brief WildcardMatcher compiles a set of patterns, as accepted by
+ * WildcardMatch(), to find which ones match a string without testing
+ * all of them:
+ *
+ * - patterns without wildcards are stored in a hash table;
+ * - patterns with '*' and '?' are stored in a trie of their literal prefix:
+ *   only the ones which prefix is a prefix of the string are tested;
+ * - patterns with sets "[...]", alternatives "(a|b)" or escapes are tested
+ *   one by one with WildcardMatch().
+ *
+ * The patterns are identified by the index returned by add().
+ */
+class WildcardMatcher
+{
+public:
+  static constexpr size_t npos = size_t(-1);
+
+  WildcardMatcher()
+  {
+    trie_.emplace_back();
+  }
+
+  /// Add a pattern and return its index.
+  size_t add(std::string_view pattern)
+  {
+    const size_t index = patterns_.size();
+    patterns_.emplace_back(pattern);
+
+    if (pattern.find_first_of("[(\\") != std::string_view::npos)
+    {
+      complex_.push_back(uint32_t(index));
+      return index;
+    }
+    const size_t prefix = pattern.find_first_of("*?");
+    if (prefix == std::string_view::npos)
+    {
+      exact_[std::string(pattern)].push_back(uint32_t(index));
+      return index;
+    }
+    uint32_t node = 0;
+    for (size_t i = 0; i < prefix; i++)
+    {
+      node = addChild(node, pattern[i]);
+    }
+    trie_[node].patterns.push_back({ uint32_t(index), uint32_t(prefix) });
+    return index;
+  }
+
+  [[nodiscard]] size_t size() const
+  {
+    return patterns_.size();
+  }
+
+  [[nodiscard]] const std::string& pattern(size_t index) const
+  {
+    return patterns_.at(index);
+  }
+
+  /// Indices of the patterns without wildcards equal to str, sorted.
+  [[nodiscard]] const std::vector<uint32_t>& matchExact(std::string_view str) const
+  {
+    static const std::vector<uint32_t> none;
+#if defined(__cpp_lib_generic_unordered_lookup)
+    auto it = exact_.find(str);
+#else
+    auto it = exact_.find(std::string(str));
+#endif
+    return it == exact_.end() ? none : it->second;
+  }
+
+  /// Append to out the indices of the patterns that match str, sorted.
+  void matchAll(std::string_view str, std::vector<size_t>& out) const
+  {
+    const size_t first = out.size();
+    for (uint32_t index : matchExact(str))
+    {
+      out.push_back(index);
+    }
+    uint32_t node = 0;
+    for (size_t depth = 0;; depth++)
+    {
+      for (const auto& [index, prefix] : trie_[node].patterns)
+      {
+        if (Match(str.substr(prefix), std::string_view(patterns_[index]).substr(prefix)))
+        {
+          out.push_back(index);
+        }
+      }
+      if (depth == str.size() || (node = findChild(node, str[depth])) == 0)
+      {
+        break;
+      }
+    }
+    if (!complex_.empty())
+    {
+      const std::string str_copy(str);
+      for (uint32_t index : complex_)
+      {
+        if (WildcardMatch(str_copy, patterns_[index]))
+        {
+          out.push_back(index);
+        }
+      }
+    }
+    std::sort(out.begin() + std::ptrdiff_t(first), out.end());
+  }
+
+  /// Lowest index of the patterns that match str, npos if none
+  [[nodiscard]] size_t matchFirst(std::string_view str) const
+  {
+    thread_local std::vector<size_t> matches;
+    matches.clear();
+    matchAll(str, matches);
+    return matches.empty() ? npos : matches.front();
+  }
+
+  [[nodiscard]] bool matches(std::string_view str) const
+  {
+    return matchFirst(str) != npos;
+  }
+
+  /// Match a pattern with the wildcards '*' (any sequence) and '?' (any character).
+  static bool Match(std::string_view str, std::string_view pattern)
+  {
+    size_t s = 0;
+    size_t p = 0;
+    size_t star = std::string_view::npos;
+    size_t resume = 0;
+    while (s < str.size())
+    {
+      if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == str[s]))
+      {
+        s++;
+        p++;
+      }
+      else if (p < pattern.size() && pattern[p] == '*')
+      {
+        star = p++;
+        resume = s;
+      }
+      else if (star != std::string_view::npos)
+      {
+        // the last '*' absorbs one more character
+        p = star + 1;
+        s = ++resume;
+      }
+      else
+      {
+        return false;
+      }
+    }
+    while (p < pattern.size() && pattern[p] == '*')
+    {
+      p++;
+    }
+    return p == pattern.size();
+  }
+
+  /// Length of the part of the pattern before the first wildcard
+  static size_t LiteralPrefix(std::string_view pattern)
+  {
+    const size_t prefix = pattern.find_first_of("*?[(\\");
+    return prefix == std::string_view::npos ? pattern.size() : prefix;
+  }
+
+private:
+  struct TrieNode
+  {
+    std::vector<std::pair<char, uint32_t>> children;
+    // index of the pattern and length of its literal prefix
+    std::vector<std::pair<uint32_t, uint32_t>> patterns;
+  };
+
+  // 0 (the root) if the child does not exist
+  uint32_t findChild(uint32_t node, char c) const
+  {
+    for (const auto& [character, child] : trie_[node].children)
+    {
+      if (character == c)
+      {
+        return child;
+      }
+    }
+    return 0;
+  }
+
+  uint32_t addChild(uint32_t node, char c)
+  {
+    if (const uint32_t child = findChild(node, c))
+    {
+      return child;
+    }
+    const auto child = uint32_t(trie_.size());
+    trie_[node].children.push_back({ c, child });
+    trie_.emplace_back();
+    return child;
+  }
+
+  struct Hash
+  {
+    using is_transparent = void;
+    size_t operator()(std::string_view str) const
+    {
+      return std::hash<std::string_view>{}(str);
+    }
+  };
+
+  struct Equal
+  {
+    using is_transparent = void;
+    bool operator()(std::string_view a, std::string_view b) const
+    {
+      return a == b;
+    }
+  };
+
+  std::vector<std::string> patterns_;
+  std::unordered_map<std::string, std::vector<uint32_t>, Hash, Equal> exact_;
+  std::vector<TrieNode> trie_;
+  std::vector<uint32_t> complex_;
+};
+
+}   // namespace BT
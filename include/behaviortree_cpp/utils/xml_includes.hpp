@@ -0,0 +1,306 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "behaviortree_cpp/utils/strcat.hpp"
+#include "behaviortree_cpp/exceptions.h"
+
+namespace BT
+{
+
+/// An element <include path="..."/> found by ScanXMLIncludes().
+struct XMLInclude
+{
+  std::string path;
+  // empty if the attribute "ros_pkg" is not present
+  std::string ros_pkg;
+  // range of the element in the text, closing tag included
+  size_t begin = 0;
+  size_t end = 0;
+  // 1-based, as in the errors of the XML parser
+  int line = 1;
+};
+
+namespace details
+{
+inline std::string DecodeXMLEntities(const std::string& value)
+{
+  if (value.find('&') == std::string::npos)
+  {
+    return value;
+  }
+  static const std::pair<const char*, char> entities[] = {
+    { "&amp;", '&' }, { "&lt;", '<' }, { "&gt;", '>' }, { "&quot;", '"' }, { "&apos;", '\'' }
+  };
+  std::string out;
+  out.reserve(value.size());
+  for (size_t i = 0; i < value.size(); i++)
+  {
+    bool decoded = false;
+    if (value[i] == '&')
+    {
+      for (const auto& [entity, character] : entities)
+      {
+        const size_t length = std::strlen(entity);
+        if (value.compare(i, length, entity) == 0)
+        {
+          out += character;
+          i += length - 1;
+          decoded = true;
+          break;
+        }
+      }
+    }
+    if (!decoded)
+    {
+      out += value[i];
+    }
+  }
+  return out;
+}
+}   // namespace details
+
+/**
+ * @brief Find the elements <include> of a BehaviorTree XML, without building
+ * the DOM. Comments, CDATA sections and processing instructions are skipped.
+ *
+ * It is meant to discover the include graph quickly; the document must still
+ * be parsed and validated by XMLParser. Throws RuntimeError if an <include>
+ * has no attribute "path" or is not terminated.
+ */
+inline std::vector<XMLInclude> ScanXMLIncludes(const std::string& xml_text)
+{
+  std::vector<XMLInclude> includes;
+  size_t pos = 0;
+  int line = 1;
+  size_t line_pos = 0;
+  auto lineAt = [&](size_t target) {
+    for (; line_pos < target && line_pos < xml_text.size(); line_pos++)
+    {
+      if (xml_text[line_pos] == '\n')
+      {
+        line++;
+      }
+    }
+    return line;
+  };
+  auto skipUntil = [&](size_t from, const char* terminator) {
+    const size_t found = xml_text.find(terminator, from);
+    return (found == std::string::npos) ? xml_text.size() : found + std::strlen(terminator);
+  };
+
+  while ((pos = xml_text.find('<', pos)) != std::string::npos)
+  {
+    if (xml_text.compare(pos, 4, "<!--") == 0)
+    {
+      pos = skipUntil(pos + 4, "-->");
+      continue;
+    }
+    if (xml_text.compare(pos, 9, "<![CDATA[") == 0)
+    {
+      pos = skipUntil(pos + 9, "]]>");
+      continue;
+    }
+    if (xml_text.compare(pos, 2, "<?") == 0)
+    {
+      pos = skipUntil(pos + 2, "?>");
+      continue;
+    }
+    const bool is_include =
+        xml_text.compare(pos, 8, "<include") == 0 &&
+        (pos + 8 >= xml_text.size() || std::strchr(" \t\r\n/>", xml_text[pos + 8]));
+    if (!is_include)
+    {
+      pos++;
+      continue;
+    }
+
+    XMLInclude include;
+    include.begin = pos;
+    include.line = lineAt(pos);
+    bool has_path = false;
+    bool self_closing = false;
+    size_t cursor = pos + 8;
+    while (true)
+    {
+      while (cursor < xml_text.size() && std::strchr(" \t\r\n", xml_text[cursor]))
+      {
+        cursor++;
+      }
+      if (cursor >= xml_text.size())
+      {
+        throw RuntimeError("Error at line ", std::to_string(include.line),
+                           ": <include> is not terminated");
+      }
+      if (xml_text[cursor] == '>')
+      {
+        cursor++;
+        break;
+      }
+      if (xml_text.compare(cursor, 2, "/>") == 0)
+      {
+        cursor += 2;
+        self_closing = true;
+        break;
+      }
+      // attribute: name = "value"
+      const size_t name_begin = cursor;
+      while (cursor < xml_text.size() && !std::strchr(" \t\r\n=/>", xml_text[cursor]))
+      {
+        cursor++;
+      }
+      const std::string name = xml_text.substr(name_begin, cursor - name_begin);
+      while (cursor < xml_text.size() && std::strchr(" \t\r\n", xml_text[cursor]))
+      {
+        cursor++;
+      }
+      if (cursor >= xml_text.size() || xml_text[cursor] != '=')
+      {
+        throw RuntimeError("Error at line ", std::to_string(include.line),
+                           ": invalid attribute [", name, "] in <include>");
+      }
+      cursor++;
+      while (cursor < xml_text.size() && std::strchr(" \t\r\n", xml_text[cursor]))
+      {
+        cursor++;
+      }
+      const char quote = cursor < xml_text.size() ? xml_text[cursor] : '\0';
+      const size_t value_end =
+          (quote == '"' || quote == '\'') ? xml_text.find(quote, cursor + 1) :
+                                            std::string::npos;
+      if (value_end == std::string::npos)
+      {
+        throw RuntimeError("Error at line ", std::to_string(include.line),
+                           ": invalid attribute [", name, "] in <include>");
+      }
+      std::string value =
+          details::DecodeXMLEntities(xml_text.substr(cursor + 1, value_end - cursor - 1));
+      cursor = value_end + 1;
+      if (name == "path")
+      {
+        include.path = std::move(value);
+        has_path = true;
+      }
+      else if (name == "ros_pkg")
+      {
+        include.ros_pkg = std::move(value);
+      }
+    }
+    if (!self_closing)
+    {
+      const size_t closing = xml_text.find("</include>", cursor);
+      if (closing == std::string::npos)
+      {
+        throw RuntimeError("Error at line ", std::to_string(include.line),
+                           ": <include> is not terminated");
+      }
+      cursor = closing + 10;
+    }
+    if (!has_path)
+    {
+      throw RuntimeError("Error at line ", std::to_string(include.line),
+                         ": Missing attribute [path] in <include>");
+    }
+    include.end = cursor;
+    includes.push_back(std::move(include));
+    pos = cursor;
+  }
+  return includes;
+}
+
+/// Replace the elements found by ScanXMLIncludes() with spaces, keeping the
+/// line numbers of the rest of the document.
+inline std::string RemoveXMLIncludes(std::string xml_text,
+                                     const std::vector<XMLInclude>& includes)
+{
+  for (const auto& include : includes)
+  {
+    for (size_t i = include.begin; i < include.end && i < xml_text.size(); i++)
+    {
+      if (xml_text[i] != '\n')
+      {
+        xml_text[i] = ' ';
+      }
+    }
+  }
+  return xml_text;
+}
+
+/// Content of the element <root> found by FindXMLRoot().
+struct XMLRoot
+{
+  // range of the children of <root>, in the text
+  size_t begin = 0;
+  size_t end = 0;
+  // value of the attribute BTCPP_format, empty if not present
+  std::string format;
+};
+
+/**
+ * @brief Find the element <root> of a BehaviorTree XML, without building the
+ * DOM, to merge many documents into one. Comments and processing
+ * instructions before it are skipped. Throws RuntimeError if there is no
+ * <root> or it is not terminated.
+ */
+inline XMLRoot FindXMLRoot(const std::string& xml_text)
+{
+  size_t pos = 0;
+  while ((pos = xml_text.find('<', pos)) != std::string::npos)
+  {
+    if (xml_text.compare(pos, 4, "<!--") == 0)
+    {
+      const size_t found = xml_text.find("-->", pos + 4);
+      pos = (found == std::string::npos) ? xml_text.size() : found + 3;
+      continue;
+    }
+    if (xml_text.compare(pos, 2, "<?") == 0 || xml_text.compare(pos, 2, "<!") == 0)
+    {
+      const size_t found = xml_text.find('>', pos + 2);
+      pos = (found == std::string::npos) ? xml_text.size() : found + 1;
+      continue;
+    }
+    break;
+  }
+  const bool is_root = pos != std::string::npos && xml_text.compare(pos, 5, "<root") == 0 &&
+                       pos + 5 < xml_text.size() && std::strchr(" \t\r\n/>", xml_text[pos + 5]);
+  if (!is_root)
+  {
+    throw RuntimeError("The XML must have a root node called <root>");
+  }
+  const size_t tag_end = xml_text.find('>', pos);
+  if (tag_end == std::string::npos)
+  {
+    throw RuntimeError("The element <root> is not terminated");
+  }
+
+  XMLRoot root;
+  const std::string tag = xml_text.substr(pos, tag_end - pos);
+  const size_t attribute = tag.find("BTCPP_format");
+  if (attribute != std::string::npos)
+  {
+    const size_t quote = tag.find_first_of("\"'", attribute);
+    const size_t value_end =
+        (quote == std::string::npos) ? std::string::npos : tag.find(tag[quote], quote + 1);
+    if (value_end != std::string::npos)
+    {
+      root.format = tag.substr(quote + 1, value_end - quote - 1);
+    }
+  }
+  root.begin = tag_end + 1;
+  if (xml_text[tag_end - 1] == '/')
+  {
+    // <root/>
+    root.end = root.begin;
+    return root;
+  }
+  root.end = xml_text.rfind("</root>");
+  if (root.end == std::string::npos || root.end < root.begin)
+  {
+    throw RuntimeError("The element <root> is not terminated");
+  }
+  return root;
+}
+
+}   // namespace BT
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace BT
+{
+
+/**
+ * @brief XMLStreamWriter writes an XML document to a std::ostream while it
+ * is visited, without building a DOM in memory.
+ *
+ * The output has the same layout of tinyxml2::XMLPrinter: one element per
+ * line, 4 spaces of indentation, elements without content closed with "/>"
+ * and the text on the same line of its element.
+ *
+ *   XMLStreamWriter writer(out);
+ *   writer.openElement("root");
+ *   writer.attribute("BTCPP_format", "4");
+ *   writer.openElement("BehaviorTree");
+ *   ...
+ *   writer.closeElement();
+ *   writer.closeElement();
+ */
+class XMLStreamWriter
+{
+public:
+  explicit XMLStreamWriter(std::ostream& out) : out_(out)
+  {}
+
+  XMLStreamWriter(const XMLStreamWriter&) = delete;
+  XMLStreamWriter& operator=(const XMLStreamWriter&) = delete;
+
+  /// Close the elements that are still open.
+  ~XMLStreamWriter()
+  {
+    while (!stack_.empty())
+    {
+      closeElement();
+    }
+  }
+
+  void openElement(std::string_view name)
+  {
+    if (!stack_.empty())
+    {
+      finishStartTag(true);
+    }
+    indent(stack_.size());
+    out_ << '<' << name;
+    stack_.push_back({ std::string(name) });
+  }
+
+  /// Add an attribute to the element opened last; it must be called
+  /// before its children and its text.
+  void attribute(std::string_view name, std::string_view value)
+  {
+    out_ << ' ' << name << "=\"";
+    escape(value, true);
+    out_ << '"';
+  }
+
+  void attribute(std::string_view name, const char* value)
+  {
+    attribute(name, std::string_view(value));
+  }
+
+  void attribute(std::string_view name, long long value)
+  {
+    out_ << ' ' << name << "=\"" << value << '"';
+  }
+
+  /// Set the text of the element opened last.
+  void text(std::string_view value)
+  {
+    finishStartTag(false);
+    stack_.back().has_text = true;
+    escape(value, false);
+  }
+
+  void closeElement()
+  {
+    const Element& element = stack_.back();
+    if (!element.start_closed)
+    {
+      out_ << "/>\n";
+    }
+    else
+    {
+      if (!element.has_text)
+      {
+        indent(stack_.size() - 1);
+      }
+      out_ << "</" << element.name << ">\n";
+    }
+    stack_.pop_back();
+  }
+
+private:
+  struct Element
+  {
+    std::string name;
+    bool start_closed = false;
+    bool has_text = false;
+  };
+
+  void finishStartTag(bool newline)
+  {
+    Element& element = stack_.back();
+    if (!element.start_closed)
+    {
+      out_ << '>';
+      if (newline)
+      {
+        out_ << '\n';
+      }
+      element.start_closed = true;
+    }
+  }
+
+  void indent(size_t depth)
+  {
+    for (size_t i = 0; i < depth; i++)
+    {
+      out_ << "    ";
+    }
+  }
+
+  // the same entities escaped by tinyxml2
+  void escape(std::string_view str, bool is_attribute)
+  {
+    size_t begin = 0;
+    for (size_t i = 0; i < str.size(); i++)
+    {
+      const char* entity = nullptr;
+      switch (str[i])
+      {
+        case '&':
+          entity = "&amp;";
+          break;
+        case '<':
+          entity = "&lt;";
+          break;
+        case '>':
+          entity = "&gt;";
+          break;
+        case '"':
+          entity = is_attribute ? "&quot;" : nullptr;
+          break;
+        case '\'':
+          entity = is_attribute ? "&apos;" : nullptr;
+          break;
+        default:
+          break;
+      }
+      if (entity)
+      {
+        out_.write(str.data() + begin, std::streamsize(i - begin));
+        out_ << entity;
+        begin = i + 1;
+      }
+    }
+    out_.write(str.data() + begin, std::streamsize(str.size() - begin));
+  }
+
+  std::ostream& out_;
+  std::vector<Element> stack_;
+};
+
+}   // namespace BT
@@ -2,8 +2,11 @@
 #define XML_PARSING_BT_H
 
 #include "behaviortree_cpp/bt_parser.h"
+#include "behaviortree_cpp/utils/xml_stream_writer.hpp"
 
 #include <filesystem>
+#include <map>
+#include <ostream>
 #include <unordered_map>
 
 namespace BT
@@ -74,6 +77,182 @@ std::string writeTreeNodesModelXML(const BehaviorTreeFactory& factory,
 [[nodiscard]]
 std::string WriteTreeToXML(const Tree& tree, bool add_metadata, bool add_builtin_models);
 
+/**
+ * @brief Same as writeTreeNodesModelXML(), but the XML is written to a stream
+ * while the manifests are visited, without building the document in memory.
+ */
+void writeTreeNodesModelXML(std::ostream& out, const BehaviorTreeFactory& factory,
+                            bool include_builtin = false);
+
+/**
+ * @brief Same as WriteTreeToXML(), but the XML is written to a stream
+ * while the nodes are visited, without building the document in memory.
+ */
+void WriteTreeToXML(std::ostream& out, const Tree& tree, bool add_metadata,
+                    bool add_builtin_models);
+
+//--------------------------------------------
+
+namespace details
+{
+inline void WriteNodeModelXML(XMLStreamWriter& writer, const TreeNodeManifest& model)
+{
+  writer.openElement(toStr(model.type));
+  writer.attribute("ID", model.registration_ID);
+
+  for (const auto& [port_name, port_info] : model.ports)
+  {
+    switch (port_info.direction())
+    {
+      case PortDirection::INPUT:
+        writer.openElement("input_port");
+        break;
+      case PortDirection::OUTPUT:
+        writer.openElement("output_port");
+        break;
+      case PortDirection::INOUT:
+        writer.openElement("inout_port");
+        break;
+    }
+    writer.attribute("name", port_name);
+    writer.attribute("type", port_info.typeName());
+    if (!port_info.defaultValue().empty())
+    {
+      writer.attribute("default", port_info.defaultValueString());
+    }
+    if (!port_info.description().empty())
+    {
+      writer.text(port_info.description());
+    }
+    writer.closeElement();
+  }
+
+  if (!model.description.empty())
+  {
+    writer.openElement("description");
+    writer.text(model.description);
+    writer.closeElement();
+  }
+  writer.closeElement();
+}
+
+inline void WriteNodeModelsXML(XMLStreamWriter& writer,
+                               const std::unordered_map<std::string, TreeNodeManifest>& manifests,
+                               const std::set<std::string>& builtin, bool include_builtin)
+{
+  std::map<std::string, const TreeNodeManifest*> ordered_models;
+  for (const auto& [registration_ID, model] : manifests)
+  {
+    if (include_builtin || builtin.count(registration_ID) == 0)
+    {
+      ordered_models.insert({ registration_ID, &model });
+    }
+  }
+  writer.openElement("TreeNodesModel");
+  for (const auto& [registration_ID, model] : ordered_models)
+  {
+    WriteNodeModelXML(writer, *model);
+  }
+  writer.closeElement();
+}
+
+inline void WriteNodeXML(XMLStreamWriter& writer, const TreeNode& node, bool add_metadata)
+{
+  writer.openElement(node.registrationName());
+  if (auto subtree = dynamic_cast<const SubTreeNode*>(&node))
+  {
+    writer.attribute("ID", subtree->subtreeID());
+    if (add_metadata)
+    {
+      writer.attribute("_fullpath", subtree->config().path);
+    }
+  }
+  else
+  {
+    writer.attribute("name", node.name());
+  }
+  if (add_metadata)
+  {
+    writer.attribute("_uid", node.UID());
+  }
+
+  const auto& config = node.config();
+  for (const auto& [name, value] : config.input_ports)
+  {
+    writer.attribute(name, value);
+  }
+  for (const auto& [name, value] : config.output_ports)
+  {
+    // avoid duplicates, in the case of INOUT ports
+    if (config.input_ports.count(name) == 0)
+    {
+      writer.attribute(name, value);
+    }
+  }
+  for (const auto& [pre, script] : config.pre_conditions)
+  {
+    writer.attribute(toStr(pre), script);
+  }
+  for (const auto& [post, script] : config.post_conditions)
+  {
+    writer.attribute(toStr(post), script);
+  }
+
+  if (auto control = dynamic_cast<const ControlNode*>(&node))
+  {
+    for (const TreeNode* child : control->children())
+    {
+      WriteNodeXML(writer, *child, add_metadata);
+    }
+  }
+  else if (auto decorator = dynamic_cast<const DecoratorNode*>(&node))
+  {
+    if (decorator->type() != NodeType::SUBTREE && decorator->child())
+    {
+      WriteNodeXML(writer, *decorator->child(), add_metadata);
+    }
+  }
+  writer.closeElement();
+}
+}   // namespace details
+
+inline void writeTreeNodesModelXML(std::ostream& out, const BehaviorTreeFactory& factory,
+                                   bool include_builtin)
+{
+  XMLStreamWriter writer(out);
+  writer.openElement("root");
+  writer.attribute("BTCPP_format", "4");
+  details::WriteNodeModelsXML(writer, factory.manifests(), factory.builtinNodes(),
+                              include_builtin);
+  writer.closeElement();
+}
+
+inline void WriteTreeToXML(std::ostream& out, const Tree& tree, bool add_metadata,
+                           bool add_builtin_models)
+{
+  XMLStreamWriter writer(out);
+  writer.openElement("root");
+  writer.attribute("BTCPP_format", "4");
+  for (const auto& subtree : tree.subtrees)
+  {
+    writer.openElement("BehaviorTree");
+    writer.attribute("ID", subtree->tree_ID);
+    writer.attribute("_fullpath", subtree->instance_name);
+    if (!subtree->nodes.empty())
+    {
+      details::WriteNodeXML(writer, *subtree->nodes.front(), add_metadata);
+    }
+    writer.closeElement();
+  }
+
+  static const std::set<std::string> builtin = [] {
+    const BehaviorTreeFactory temp_factory;
+    return temp_factory.builtinNodes();
+  }();
+  details::WriteNodeModelsXML(writer, NodeManifests(tree), builtin, add_builtin_models);
+  writer.closeElement();
+}
+
 }   // namespace BT
 
 #endif   // XML_PARSING_BT_H
@@ -1,76 +1,35 @@
 #include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/factory_extensions.h"
+#include "behaviortree_cpp/loggers/bt_text_sink.h"
+#include "behaviortree_cpp/tree_template.h"
+#include "sample_nodes.h"
 
 using namespace BT;
 
-// clang-format off
-static const char* xml_text = R"(
+// generated at build time from main_tree.xml (see btcpp_compile_tree in CMakeLists.txt)
+#include "register_main_tree.h"
 
- <root BTCPP_format="4" >
-
-     <BehaviorTree ID="MainTree">
-        <Sequence name="root">
-            <AlwaysSuccess/>
-            <SaySomething   message="this works too" />
-            <ThinkWhatToSay text="{the_answer}"/>
-            <SaySomething   message="{the_answer}" />
-        </Sequence>
-     </BehaviorTree>
-
- </root>
- )";
-// clang-format on
-
-class SaySomething : public BT::SyncActionNode
+int main()
 {
-  public:
-  SaySomething(const std::string& name, const BT::NodeConfig& config) :
-        BT::SyncActionNode(name, config)
-  {}
-
-  BT::NodeStatus tick() override
-  {
-    std::string msg;
-    getInput("message", msg);
-    std::cout << msg << std::endl;
-    return BT::NodeStatus::SUCCESS;
-  }
 
-  static BT::PortsList providedPorts()
-  {
-    return {BT::InputPort<std::string>("message")};
-  }
-};
+  BehaviorTreeFactory factory;
 
-class ThinkWhatToSay : public BT::SyncActionNode
-{
-  public:
-  ThinkWhatToSay(const std::string& name, const BT::NodeConfig& config) :
-        BT::SyncActionNode(name, config)
-  {}
+  RegisterSampleNodes(factory);
 
-  BT::NodeStatus tick() override
-  {
-    setOutput("text", "The answer is 42");
-    return BT::NodeStatus::SUCCESS;
-  }
+  // the tree was validated and precompiled at build time: no XML is parsed here
+  FactoryExtensions extensions(factory);
+  register_main_tree(extensions);
 
-  static BT::PortsList providedPorts()
+  Tree tree;
   {
-    return {BT::OutputPort<std::string>("text")};
+    // the nodes of sample_nodes.h are allocated contiguously in a single arena
+    MonotonicArena arena;
+    ArenaScope scope(arena);
+    tree = extensions.createPrecompiledTree("MainTree");
   }
-};
-
-int main()
-{
-
-  BehaviorTreeFactory factory;
-
-  factory.registerNodeType<SaySomething>("SaySomething");
-  factory.registerNodeType<ThinkWhatToSay>("ThinkWhatToSay");
-
-  auto tree = factory.createTreeFromText(xml_text);
 
   tree.tickWhileRunning();
+  DefaultTextSink()->flush();
 
   return 0;
 }
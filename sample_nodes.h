@@ -0,0 +1,71 @@
+#pragma once
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/loggers/bt_text_sink.h"
+#include "behaviortree_cpp/port_handle.h"
+#include "behaviortree_cpp/utils/arena.hpp"
+
+// The nodes of the sample, used by main.cpp and by tools/btcpp_sample_nodes_index.cpp,
+// that writes their index to validate main_tree.xml at build time.
+
+class SaySomething : public BT::SyncActionNode
+{
+  public:
+  SaySomething(const std::string& name, const BT::NodeConfig& config) :
+        BT::SyncActionNode(name, config)
+  {
+    // resolve the port once, instead of at each tick
+    message_.bind(*this, "message");
+  }
+
+  // allocated in the arena of the tree, see main()
+  BT_ARENA_ALLOCATED_CLASS
+
+  BT::NodeStatus tick() override
+  {
+    std::string msg;
+    if (auto res = message_.get(msg); !res)
+    {
+      BT::DefaultTextSink()->log(BT::LogLevel::ERROR, "SaySomething: " + res.error());
+      return BT::NodeStatus::FAILURE;
+    }
+    // written by the thread of the sink: the tick doesn't wait for the console
+    BT::DefaultTextSink()->log(BT::LogLevel::INFO, msg);
+    return BT::NodeStatus::SUCCESS;
+  }
+
+  static BT::PortsList providedPorts()
+  {
+    return {BT::InputPort<std::string>("message")};
+  }
+
+  private:
+  BT::PortHandle<std::string> message_;
+};
+
+class ThinkWhatToSay : public BT::SyncActionNode
+{
+  public:
+  ThinkWhatToSay(const std::string& name, const BT::NodeConfig& config) :
+        BT::SyncActionNode(name, config)
+  {}
+
+  BT_ARENA_ALLOCATED_CLASS
+
+  BT::NodeStatus tick() override
+  {
+    setOutput("text", "The answer is 42");
+    return BT::NodeStatus::SUCCESS;
+  }
+
+  static BT::PortsList providedPorts()
+  {
+    return {BT::OutputPort<std::string>("text")};
+  }
+};
+
+inline void RegisterSampleNodes(BT::BehaviorTreeFactory& factory)
+{
+  factory.registerNodeType<SaySomething>("SaySomething");
+  factory.registerNodeType<ThinkWhatToSay>("ThinkWhatToSay");
+}
@@ -0,0 +1,117 @@
+// After the warm-up, a tree of builtin nodes and of nodes using PortHandle
+// must tick without allocating memory (see AllocationTracker for the list
+// of the allocation-free paths).
+
+#include <cstdio>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/port_handle.h"
+#include "behaviortree_cpp/utils/allocation_counter.hpp"
+
+BTCPP_ALLOCATION_COUNTER_HOOKS()
+
+namespace
+{
+
+class WriteCounter : public BT::SyncActionNode
+{
+public:
+  WriteCounter(const std::string& name, const BT::NodeConfig& config) :
+    BT::SyncActionNode(name, config)
+  {
+    out_.bind(*this, "out");
+  }
+
+  BT::NodeStatus tick() override
+  {
+    return out_.set(++counter_) ? BT::NodeStatus::SUCCESS : BT::NodeStatus::FAILURE;
+  }
+
+  static BT::PortsList providedPorts()
+  {
+    return {BT::OutputPort<int>("out")};
+  }
+
+private:
+  BT::PortHandle<int> out_;
+  int counter_ = 0;
+};
+
+class ReadCounter : public BT::SyncActionNode
+{
+public:
+  ReadCounter(const std::string& name, const BT::NodeConfig& config) :
+    BT::SyncActionNode(name, config)
+  {
+    in_.bind(*this, "in");
+  }
+
+  BT::NodeStatus tick() override
+  {
+    int value = 0;
+    return (in_.get(value) && value > 0) ? BT::NodeStatus::SUCCESS : BT::NodeStatus::FAILURE;
+  }
+
+  static BT::PortsList providedPorts()
+  {
+    return {BT::InputPort<int>("in")};
+  }
+
+private:
+  BT::PortHandle<int> in_;
+};
+
+const char* kTreeXML = R"(
+<root BTCPP_format="4">
+  <BehaviorTree ID="Main">
+    <Sequence>
+      <WriteCounter out="{counter}"/>
+      <ReadCounter in="{counter}"/>
+      <Fallback>
+        <AlwaysFailure/>
+        <Inverter><AlwaysFailure/></Inverter>
+      </Fallback>
+      <ForceSuccess><AlwaysFailure/></ForceSuccess>
+    </Sequence>
+  </BehaviorTree>
+</root>)";
+
+}   // namespace
+
+int main()
+{
+  if (!BT::AllocationCounter::hooksInstalled())
+  {
+    std::fprintf(stderr, "the allocation counter hooks are not installed\n");
+    return 1;
+  }
+
+  BT::BehaviorTreeFactory factory;
+  factory.registerNodeType<WriteCounter>("WriteCounter");
+  factory.registerNodeType<ReadCounter>("ReadCounter");
+  auto tree = factory.createTreeFromText(kTreeXML);
+
+  // warm-up: the blackboard entries are created by the first ticks
+  for (int i = 0; i < 10; i++)
+  {
+    tree.tickOnce();
+  }
+
+  BT::AllocationScope scope;
+  for (int i = 0; i < 1000; i++)
+  {
+    if (tree.tickOnce() != BT::NodeStatus::SUCCESS)
+    {
+      std::fprintf(stderr, "unexpected status of the tree at tick %d\n", i);
+      return 1;
+    }
+  }
+  if (scope.allocations() != 0)
+  {
+    std::fprintf(stderr, "1000 ticks allocated memory %llu times (%llu bytes)\n",
+                 static_cast<unsigned long long>(scope.allocations()),
+                 static_cast<unsigned long long>(scope.bytes()));
+    return 1;
+  }
+  return 0;
+}
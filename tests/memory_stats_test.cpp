@@ -0,0 +1,42 @@
+// Tree::memoryStats() must count the heap memory of the strings stored
+// in the blackboard.
+
+#include <cstdio>
+#include <string>
+
+#include "behaviortree_cpp/bt_factory.h"
+
+namespace
+{
+
+const char* kTreeXML = R"(
+<root BTCPP_format="4">
+  <BehaviorTree ID="Main">
+    <AlwaysSuccess/>
+  </BehaviorTree>
+</root>)";
+
+size_t BlackboardBytes(const std::string& text)
+{
+  BT::BehaviorTreeFactory factory;
+  auto blackboard = BT::Blackboard::create();
+  blackboard->set("text", text);
+  auto tree = factory.createTreeFromText(kTreeXML, blackboard);
+  return tree.memoryStats().blackboard_bytes;
+}
+
+}   // namespace
+
+int main()
+{
+  // the short string is stored inline in the Any, the long one on the heap
+  const size_t short_bytes = BlackboardBytes("short");
+  const size_t long_bytes = BlackboardBytes(std::string(1000, 'x'));
+  if (long_bytes < short_bytes + 1000)
+  {
+    std::fprintf(stderr, "a string of 1000 characters counted as %zu bytes (%zu bytes for \"short\")\n",
+                 long_bytes, short_bytes);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+// Tree::reload() must keep the reused SubTrees connected to the blackboards
+// of their new parents.
+
+#include <cstdio>
+
+#include "behaviortree_cpp/bt_factory.h"
+
+namespace
+{
+
+class WriteValue : public BT::SyncActionNode
+{
+public:
+  WriteValue(const std::string& name, const BT::NodeConfig& config) :
+    BT::SyncActionNode(name, config)
+  {}
+
+  BT::NodeStatus tick() override
+  {
+    return setOutput("out", 42) ? BT::NodeStatus::SUCCESS : BT::NodeStatus::FAILURE;
+  }
+
+  static BT::PortsList providedPorts()
+  {
+    return {BT::OutputPort<int>("out")};
+  }
+};
+
+// Main -> Middle -> Leaf: the port of Leaf is remapped to "result" of Main
+const char* kTreeXML = R"(
+<root BTCPP_format="4">
+  <BehaviorTree ID="MainTree">
+    <SubTree ID="Middle" name="middle" value="{result}"/>
+  </BehaviorTree>
+  <BehaviorTree ID="Middle">
+    <Sequence>
+      <SubTree ID="Leaf" name="leaf" value="{value}"/>
+    </Sequence>
+  </BehaviorTree>
+  <BehaviorTree ID="Leaf">
+    <WriteValue out="{value}"/>
+  </BehaviorTree>
+</root>)";
+
+// only Middle changes
+const char* kReloadedXML = R"(
+<root BTCPP_format="4">
+  <BehaviorTree ID="MainTree">
+    <SubTree ID="Middle" name="middle" value="{result}"/>
+  </BehaviorTree>
+  <BehaviorTree ID="Middle">
+    <Sequence>
+      <AlwaysSuccess/>
+      <SubTree ID="Leaf" name="leaf" value="{value}"/>
+    </Sequence>
+  </BehaviorTree>
+  <BehaviorTree ID="Leaf">
+    <WriteValue out="{value}"/>
+  </BehaviorTree>
+</root>)";
+
+bool Check(bool condition, const char* what)
+{
+  if (!condition)
+  {
+    std::fprintf(stderr, "%s\n", what);
+  }
+  return condition;
+}
+
+}   // namespace
+
+int main()
+{
+  BT::BehaviorTreeFactory factory;
+  factory.registerNodeType<WriteValue>("WriteValue");
+  auto tree = factory.createTreeFromText(kTreeXML);
+  auto blackboard = tree.rootBlackboard();
+
+  bool ok = true;
+  ok &= Check(tree.tickWhileRunning() == BT::NodeStatus::SUCCESS, "the tree failed");
+  blackboard->set("result", 0);
+
+  // a different factory, not to register the trees twice
+  BT::BehaviorTreeFactory reload_factory;
+  reload_factory.registerNodeType<WriteValue>("WriteValue");
+  const auto stats = tree.reload(reload_factory.createTreeFromText(kReloadedXML, blackboard));
+  ok &= Check(stats.reused_subtrees == 2 && stats.rebuilt_subtrees == 1,
+              "only the middle SubTree should be rebuilt");
+
+  ok &= Check(tree.tickWhileRunning() == BT::NodeStatus::SUCCESS,
+              "the reloaded tree failed");
+  int result = 0;
+  ok &= Check(blackboard->get("result", result) && result == 42,
+              "the value written by the reused SubTree didn't reach the root blackboard");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// The trees instantiated from a TreeTemplate must behave as the ones
+// created by BehaviorTreeFactory::createTree.
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include "behaviortree_cpp/bt_factory.h"
+#include "behaviortree_cpp/tree_template.h"
+#include "behaviortree_cpp/flatbuffers/bt_flatbuffer_helper.h"
+
+namespace
+{
+
+class WriteValue : public BT::SyncActionNode
+{
+public:
+  WriteValue(const std::string& name, const BT::NodeConfig& config) :
+    BT::SyncActionNode(name, config)
+  {}
+
+  BT::NodeStatus tick() override
+  {
+    return setOutput("out", 42) ? BT::NodeStatus::SUCCESS : BT::NodeStatus::FAILURE;
+  }
+
+  static BT::PortsList providedPorts()
+  {
+    return {BT::OutputPort<int>("out")};
+  }
+};
+
+const char* kRemappingXML = R"(
+<root BTCPP_format="4">
+  <BehaviorTree ID="MainTree">
+    <Sequence>
+      <SubTree ID="Sub" value="{result}"/>
+    </Sequence>
+  </BehaviorTree>
+  <BehaviorTree ID="Sub">
+    <WriteValue out="{value}"/>
+  </BehaviorTree>
+</root>)";
+
+bool Check(bool condition, const char* test, const char* what)
+{
+  if (!condition)
+  {
+    std::fprintf(stderr, "%s: %s\n", test, what);
+  }
+  return condition;
+}
+
+// the SubTree writes its port "value", remapped to "result" of the parent
+bool TestRemappedSubtreePort()
+{
+  const char* test = "TestRemappedSubtreePort";
+  BT::BehaviorTreeFactory factory;
+  factory.registerNodeType<WriteValue>("WriteValue");
+  factory.registerBehaviorTreeFromText(kRemappingXML);
+  BT::FactoryExtensions extensions(factory);
+  const auto tmpl = BT::TreeTemplate::compile(extensions, "MainTree");
+
+  bool ok = true;
+  for (int i = 0; i < 2; i++)
+  {
+    auto tree = tmpl.instantiate(BT::Blackboard::create());
+    ok &= Check(tree.tickWhileRunning() == BT::NodeStatus::SUCCESS, test, "the tree failed");
+    int result = 0;
+    ok &= Check(tree.rootBlackboard()->get("result", result) && result == 42, test,
+                "the parent blackboard doesn't contain the value written by the SubTree");
+  }
+  return ok;
+}
+
+const char* kConditionsXML = R"(
+<root BTCPP_format="4">
+  <BehaviorTree ID="MainTree">
+    <Sequence>
+      <AlwaysFailure _successIf="flag == 1"/>
+      <SubTree ID="Sub" _autoremap="true"/>
+    </Sequence>
+  </BehaviorTree>
+  <BehaviorTree ID="Sub">
+    <Sequence>
+      <AlwaysSuccess/>
+      <WriteValue out="{value}"/>
+    </Sequence>
+  </BehaviorTree>
+</root>)";
+
+std::vector<uint16_t> NodeUIDs(BT::Tree& tree)
+{
+  std::vector<uint16_t> uids;
+  const std::function<void(const BT::TreeNode*)> visitor = [&uids](const BT::TreeNode* node) {
+    uids.push_back(node->UID());
+  };
+  tree.applyVisitor(visitor);
+  // the next one
+  uids.push_back(tree.getUID());
+  return uids;
+}
+
+// the templates, compiled or deserialized, create the same nodes of createTree,
+// with the same UIDs, and parse the conditions
+bool TestSameTreeAsCreateTree()
+{
+  const char* test = "TestSameTreeAsCreateTree";
+  BT::BehaviorTreeFactory factory;
+  factory.registerNodeType<WriteValue>("WriteValue");
+  factory.registerBehaviorTreeFromText(kConditionsXML);
+  BT::FactoryExtensions extensions(factory);
+  const auto binary = BT::SerializeBehaviorTrees(factory, { "MainTree" });
+  extensions.registerBehaviorTreeFromBinary(binary.data(), binary.size());
+  const auto tmpl = BT::TreeTemplate::compile(extensions, "MainTree");
+
+  auto blackboard = BT::Blackboard::create();
+  blackboard->set("flag", 1);
+  auto reference = factory.createTree("MainTree", blackboard);
+  const auto expected_uids = NodeUIDs(reference);
+
+  std::vector<BT::Tree> trees;
+  trees.push_back(tmpl.instantiate(blackboard));
+  trees.push_back(extensions.createPrecompiledTree("MainTree", blackboard));
+
+  bool ok = true;
+  for (auto& tree : trees)
+  {
+    ok &= Check(NodeUIDs(tree) == expected_uids, test,
+                "the UIDs are different from the ones of createTree");
+    ok &= Check(tree.tickWhileRunning() == BT::NodeStatus::SUCCESS, test,
+                "the condition _successIf was not applied");
+    int value = 0;
+    ok &= Check(blackboard->get("value", value) && value == 42, test,
+                "the SubTree didn't write the remapped port");
+    blackboard->set("value", 0);
+  }
+  return ok;
+}
+
+}   // namespace
+
+int main()
+{
+  bool ok = true;
+  ok &= TestRemappedSubtreePort();
+  ok &= TestSameTreeAsCreateTree();
+  return ok ? 0 : 1;
+}
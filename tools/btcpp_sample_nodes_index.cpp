@@ -0,0 +1,30 @@
+// Write the index of the nodes of sample_nodes.h, used by btcpp_compile_tree
+// to validate main_tree.xml at build time (see CMakeLists.txt).
+//
+//   btcpp_sample_nodes_index <nodes.btindex>
+
+#include <iostream>
+
+#include "behaviortree_cpp/factory_extensions.h"
+#include "sample_nodes.h"
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <nodes.btindex>\n";
+    return 1;
+  }
+  try
+  {
+    BT::BehaviorTreeFactory factory;
+    RegisterSampleNodes(factory);
+    BT::FactoryExtensions::writeNodesIndex(factory, argv[1]);
+  }
+  catch (std::exception& ex)
+  {
+    std::cerr << "btcpp_sample_nodes_index: " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
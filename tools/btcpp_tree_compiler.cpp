@@ -0,0 +1,121 @@
+// Validate behavior trees at build time and generate a C++ translation unit
+// with the precompiled trees (see behaviortree_cpp/tree_codegen.h).
+//
+//   btcpp_tree_compiler --output trees.cpp --header trees.h --function register_trees
+//                       [--index nodes.btindex]... [--tree ID]... tree.xml...
+//
+// The nodes that are not builtin are described by the index files, written by
+// FactoryExtensions::writePluginIndex() or FactoryExtensions::writeNodesIndex().
+
+#include <fstream>
+#include <iostream>
+
+#include "behaviortree_cpp/tree_codegen.h"
+
+namespace
+{
+void printUsage(const char* program)
+{
+  std::cerr << "Usage: " << program
+            << " --output <file.cpp> --header <file.h> --function <name>"
+               " [--index <file.btindex>]... [--tree <ID>]... <tree.xml>...\n";
+}
+
+void writeFile(const std::filesystem::path& path, const std::string& content)
+{
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.write(content.data(), std::streamsize(content.size())))
+  {
+    throw BT::RuntimeError("can't write [", path.string(), "]");
+  }
+}
+}   // namespace
+
+int main(int argc, char** argv)
+{
+  std::filesystem::path output;
+  std::filesystem::path header;
+  std::string function_name;
+  std::vector<std::filesystem::path> indices;
+  std::vector<std::string> tree_IDs;
+  std::vector<std::filesystem::path> xml_files;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool has_value = (i + 1 < argc);
+    if (arg == "--output" && has_value)
+    {
+      output = argv[++i];
+    }
+    else if (arg == "--header" && has_value)
+    {
+      header = argv[++i];
+    }
+    else if (arg == "--function" && has_value)
+    {
+      function_name = argv[++i];
+    }
+    else if (arg == "--index" && has_value)
+    {
+      indices.emplace_back(argv[++i]);
+    }
+    else if (arg == "--tree" && has_value)
+    {
+      tree_IDs.emplace_back(argv[++i]);
+    }
+    else if (!arg.empty() && arg[0] != '-')
+    {
+      xml_files.emplace_back(arg);
+    }
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (output.empty() || header.empty() || function_name.empty() || xml_files.empty())
+  {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  std::string source_name;
+  for (const auto& file : xml_files)
+  {
+    source_name += (source_name.empty() ? "" : ", ") + file.filename().string();
+  }
+
+  try
+  {
+    BT::BehaviorTreeFactory factory;
+    for (const auto& index_path : indices)
+    {
+      std::ifstream file(index_path);
+      if (!file)
+      {
+        throw BT::RuntimeError("can't open the index [", index_path.string(), "]");
+      }
+      BT::RegisterPlaceholderNodes(factory, BT::ReadPluginIndex(file, index_path.string()));
+    }
+    for (const auto& file : xml_files)
+    {
+      factory.registerBehaviorTreeFromFile(file);
+    }
+
+    std::ostringstream source;
+    BT::WriteCompiledTreesSource(source, factory, function_name,
+                                 header.filename().string(), source_name, tree_IDs);
+    std::ostringstream declaration;
+    BT::WriteCompiledTreesHeader(declaration, function_name, source_name);
+
+    writeFile(header, declaration.str());
+    writeFile(output, source.str());
+  }
+  catch (std::exception& ex)
+  {
+    std::cerr << "btcpp_tree_compiler: " << source_name << ": " << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}